@@ -228,6 +228,10 @@ VVA_OKUNUSED VVA_FORCEINLINE uint32_t GetTypeHash (const VCustomKeyInfo_NamedVal
 #include "minipng.h"
 
 #include "syslow.h"
+#include "workpool.h"
+#include "zoneprof.h"
+#include "lzfast.h"
+#include "framearena.h"
 
 #include "timsort.h"
 #include "smsort.h"
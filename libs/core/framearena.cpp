@@ -0,0 +1,295 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  per-frame bump allocator for transient data
+//**
+//**************************************************************************
+#include "core.h"
+
+
+#define VFA_MIN_CHUNK   (64*1024)
+#define VFA_ALIGN       (16)
+
+static_assert(sizeof(void *) <= VFA_ALIGN, "oops");
+
+
+static VFrameArena *vfaArenas = nullptr; // all arenas, protected by `vfaLock`
+static mythread_mutex vfaLock;
+static atomic_int vfaLockInited = 0;
+
+static atomic_int vfaEpoch = 0;
+static atomic_int vfaArenaCount = 0;
+static atomic_int vfaChunkAllocs = 0;
+static int vfaLastChunkAllocs = 0; // main thread only
+static vuint64 vfaFrames = 0; // main thread only
+static vuint64 vfaAllocFrames = 0; // main thread only
+
+static __thread VFrameArena *vfaCurrent = nullptr;
+
+
+//==========================================================================
+//
+//  vfaInitLock
+//
+//==========================================================================
+static void vfaInitLock () noexcept {
+  if (atomic_get(&vfaLockInited) == 2) return;
+  if (atomic_cmp_xchg(&vfaLockInited, 0, 1) == 0) {
+    mythread_mutex_init(&vfaLock);
+    atomic_store(&vfaLockInited, 2);
+  } else {
+    while (atomic_get(&vfaLockInited) != 2) Sys_YieldMicro(0);
+  }
+}
+
+
+//==========================================================================
+//
+//  vfaAlignSize
+//
+//==========================================================================
+static VVA_FORCEINLINE size_t vfaAlignSize (size_t size) noexcept {
+  return (size+(VFA_ALIGN-1))&~(size_t)(VFA_ALIGN-1);
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::VFrameArena
+//
+//==========================================================================
+VFrameArena::VFrameArena () noexcept
+  : first(nullptr)
+  , curr(nullptr)
+  , lastAlloc(nullptr)
+  , used(0)
+  , lastFrameUsed(0)
+  , peakUsed(0)
+  , capacity(0)
+  , generation(0)
+  , seenEpoch(0)
+  , inUse(false)
+  , nextArena(nullptr)
+{
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::NewChunk
+//
+//  appends new chunk to the list, and makes it current
+//
+//==========================================================================
+VFrameArena::Chunk *VFrameArena::NewChunk (size_t size) noexcept {
+  size = vfaAlignSize(size < VFA_MIN_CHUNK ? VFA_MIN_CHUNK : size);
+  Chunk *ck = (Chunk *)Z_Malloc(vfaAlignSize(sizeof(Chunk))+size);
+  ck->next = nullptr;
+  ck->size = size;
+  ck->used = 0;
+  if (curr) {
+    vassert(!curr->next);
+    curr->next = ck;
+  } else {
+    vassert(!first);
+    first = ck;
+  }
+  curr = ck;
+  capacity += size;
+  (void)atomic_increment(&vfaChunkAllocs);
+  return ck;
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::Reset
+//
+//==========================================================================
+void VFrameArena::Reset () noexcept {
+  ++generation;
+  lastAlloc = nullptr;
+  lastFrameUsed = used;
+  if (used > peakUsed) peakUsed = used;
+  used = 0;
+  if (!first) return;
+  if (first->next) {
+    // merge all chunks into one, so the next frame will fit
+    const size_t total = capacity;
+    while (first) {
+      Chunk *ck = first;
+      first = ck->next;
+      Z_Free(ck);
+    }
+    curr = nullptr;
+    capacity = 0;
+    (void)NewChunk(total);
+  } else {
+    first->used = 0;
+    curr = first;
+  }
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::Alloc
+//
+//==========================================================================
+void *VFrameArena::Alloc (size_t size) noexcept {
+  size = vfaAlignSize(size ? size : 1);
+  Chunk *ck = curr;
+  if (!ck || ck->size-ck->used < size) {
+    // double the arena
+    ck = NewChunk(capacity > size ? capacity : size*2);
+  }
+  void *res = ((vuint8 *)ck)+vfaAlignSize(sizeof(Chunk))+ck->used;
+  ck->used += size;
+  used += size;
+  lastAlloc = res;
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::Grow
+//
+//==========================================================================
+void *VFrameArena::Grow (void *ptr, size_t oldsize, size_t newsize) noexcept {
+  if (!ptr) return Alloc(newsize);
+  if (newsize <= oldsize) return ptr;
+  oldsize = vfaAlignSize(oldsize ? oldsize : 1);
+  newsize = vfaAlignSize(newsize);
+  if (ptr == lastAlloc && curr->size-(curr->used-oldsize) >= newsize) {
+    // grow in place
+    curr->used += newsize-oldsize;
+    used += newsize-oldsize;
+    return ptr;
+  }
+  void *res = Alloc(newsize);
+  memcpy(res, ptr, oldsize);
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::RegisterThread
+//
+//==========================================================================
+VFrameArena *VFrameArena::RegisterThread () noexcept {
+  vfaInitLock();
+  mythread_mutex_lock(&vfaLock);
+  VFrameArena *res = nullptr;
+  for (VFrameArena *a = vfaArenas; a; a = a->nextArena) {
+    if (!a->inUse) { res = a; break; }
+  }
+  if (!res) {
+    res = new VFrameArena();
+    res->nextArena = vfaArenas;
+    vfaArenas = res;
+    (void)atomic_increment(&vfaArenaCount);
+  }
+  res->inUse = true;
+  res->seenEpoch = atomic_get(&vfaEpoch);
+  res->Reset();
+  mythread_mutex_unlock(&vfaLock);
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::ReleaseThread
+//
+//==========================================================================
+void VFrameArena::ReleaseThread () noexcept {
+  VFrameArena *a = vfaCurrent;
+  if (!a) return;
+  vfaCurrent = nullptr;
+  mythread_mutex_lock(&vfaLock);
+  a->inUse = false;
+  mythread_mutex_unlock(&vfaLock);
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::Get
+//
+//==========================================================================
+VFrameArena *VFrameArena::Get () noexcept {
+  VFrameArena *a = vfaCurrent;
+  if (!a) a = vfaCurrent = RegisterThread();
+  const int ep = atomic_get(&vfaEpoch);
+  if (a->seenEpoch != ep) {
+    a->seenEpoch = ep;
+    a->Reset();
+  }
+  return a;
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::NewFrame
+//
+//==========================================================================
+void VFrameArena::NewFrame () noexcept {
+  ++vfaFrames;
+  const int ca = atomic_get(&vfaChunkAllocs);
+  if (ca != vfaLastChunkAllocs) {
+    vfaLastChunkAllocs = ca;
+    ++vfaAllocFrames;
+  }
+  (void)atomic_increment(&vfaEpoch);
+  (void)Get(); // reset our own arena
+}
+
+
+//==========================================================================
+//
+//  VFrameArena::GetStats
+//
+//  statistics from other threads can be slightly off, but who cares
+//
+//==========================================================================
+void VFrameArena::GetStats (Stats &st) noexcept {
+  memset((void *)&st, 0, sizeof(st));
+  st.frames = vfaFrames;
+  st.allocFrames = vfaAllocFrames;
+  st.chunkAllocs = (unsigned)atomic_get(&vfaChunkAllocs);
+  st.arenas = atomic_get(&vfaArenaCount);
+  if (vfaCurrent) st.lastFramePeak = vfaCurrent->lastFrameUsed;
+  vfaInitLock();
+  mythread_mutex_lock(&vfaLock);
+  for (VFrameArena *a = vfaArenas; a; a = a->nextArena) {
+    st.capacity += a->capacity;
+    st.peakUsed += (a->used > a->peakUsed ? a->used : a->peakUsed);
+  }
+  mythread_mutex_unlock(&vfaLock);
+}
@@ -0,0 +1,186 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  per-frame bump allocator for transient data
+//**
+//**************************************************************************
+
+// each thread has its own arena. `NewFrame()` starts a new frame: the
+// calling thread's arena is reset immediately, other arenas are reset on
+// their next `Get()`. so nothing allocated from the arena can live across
+// the frame boundary.
+//
+// when the frame needed more than one chunk, the chunks are merged into
+// one big chunk on reset, so steady-state frames don't touch the global
+// allocator at all.
+class VFrameArena {
+public:
+  struct Stats {
+    int arenas; // number of registered arenas
+    vuint64 frames; // number of `NewFrame()` calls
+    vuint64 allocFrames; // frames in which some arena allocated a new chunk
+    vuint64 chunkAllocs; // total number of chunk allocations
+    size_t capacity; // sum of all chunk sizes
+    size_t peakUsed; // sum of peak usage of all arenas
+    size_t lastFramePeak; // maximum usage in the previous frame (main thread)
+  };
+
+private:
+  struct Chunk {
+    Chunk *next;
+    size_t size; // data size, without the header
+    size_t used;
+  };
+
+  Chunk *first;
+  Chunk *curr;
+  void *lastAlloc; // for in-place growing
+  size_t used; // in this frame, in all chunks
+  size_t lastFrameUsed;
+  size_t peakUsed;
+  size_t capacity;
+  vuint32 generation; // incremented on each reset
+  int seenEpoch;
+  bool inUse; // owned by some thread
+  VFrameArena *nextArena;
+
+private:
+  VFrameArena () noexcept;
+
+  void Reset () noexcept;
+  Chunk *NewChunk (size_t size) noexcept;
+
+  static VFrameArena *RegisterThread () noexcept;
+
+public:
+  VV_DISABLE_COPY(VFrameArena)
+
+  // arena for the current thread, created on demand
+  static VFrameArena *Get () noexcept;
+
+  // should be called from the main thread at the start of each frame (or tick)
+  static void NewFrame () noexcept;
+
+  // release thread arena, so it can be reused by other threads
+  // should be called by the thread itself before exiting
+  static void ReleaseThread () noexcept;
+
+  static void GetStats (Stats &st) noexcept;
+
+  // returned memory is aligned to 16 bytes, and not cleared
+  void *Alloc (size_t size) noexcept;
+
+  // grows the block; it is done in-place if `ptr` is the last allocated block
+  // `ptr` can be `nullptr`
+  void *Grow (void *ptr, size_t oldsize, size_t newsize) noexcept;
+
+  VVA_FORCEINLINE vuint32 GetGeneration () const noexcept { return generation; }
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// array which takes memory from the frame arena of the thread that grows it
+// it is only for types that can be copied with `memcpy()` (no ctors/dtors)
+// the array should be `reset()` before using it in a new frame; stale data
+// from the previous frames is dropped then. there is nothing to free.
+template<class T> class TFrameArray {
+private:
+  T *ArrData;
+  int ArrNum;
+  int ArrSize;
+  VFrameArena *Arena;
+  vuint32 Generation;
+
+private:
+  void Grow (int minsize) noexcept {
+    VFrameArena *a = VFrameArena::Get();
+    // drop stale data (it should not happen if `reset()` was called properly)
+    if (Arena && Arena->GetGeneration() != Generation) { ArrData = nullptr; ArrNum = ArrSize = 0; Arena = nullptr; }
+    int newsize = (ArrSize ? ArrSize*2 : 64);
+    if (newsize < minsize) newsize = minsize;
+    T *nd;
+    if (Arena == a) {
+      nd = (T *)a->Grow(ArrData, (size_t)ArrSize*sizeof(T), (size_t)newsize*sizeof(T));
+    } else {
+      // another thread (or nothing yet)
+      nd = (T *)a->Alloc((size_t)newsize*sizeof(T));
+      if (ArrNum) memcpy((void *)nd, (const void *)ArrData, (size_t)ArrNum*sizeof(T));
+    }
+    ArrData = nd;
+    ArrSize = newsize;
+    Arena = a;
+    Generation = a->GetGeneration();
+  }
+
+public:
+  VV_DISABLE_COPY(TFrameArray)
+
+  VVA_FORCEINLINE TFrameArray () noexcept : ArrData(nullptr), ArrNum(0), ArrSize(0), Arena(nullptr), Generation(0) {}
+
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE int length () const noexcept { return ArrNum; }
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE int Num () const noexcept { return ArrNum; }
+
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE T *ptr () noexcept { return ArrData; }
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE const T *ptr () const noexcept { return ArrData; }
+
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE T &operator [] (int index) noexcept {
+    vassert(index >= 0 && index < ArrNum);
+    return ArrData[index];
+  }
+
+  VVA_FORCEINLINE VVA_CHECKRESULT VVA_PURE const T &operator [] (int index) const noexcept {
+    vassert(index >= 0 && index < ArrNum);
+    return ArrData[index];
+  }
+
+  // this also forgets the memory from the previous frames
+  inline void reset () noexcept {
+    ArrNum = 0;
+    if (Arena && Arena->GetGeneration() != Generation) { ArrData = nullptr; ArrSize = 0; Arena = nullptr; }
+  }
+
+  VVA_FORCEINLINE void resetNoDtor () noexcept { reset(); }
+  VVA_FORCEINLINE void clear () noexcept { reset(); }
+
+  // new elements are not initialised
+  inline void setLength (int newlen) noexcept {
+    vassert(newlen >= 0);
+    if (newlen > ArrSize) Grow(newlen);
+    ArrNum = newlen;
+  }
+
+  VVA_FORCEINLINE void setLengthNoResize (int newlen) noexcept { setLength(newlen); }
+
+  VVA_FORCEINLINE void append (const T &item) noexcept {
+    if (ArrNum == ArrSize) Grow(ArrNum+1);
+    ArrData[ArrNum++] = item;
+  }
+
+  VVA_FORCEINLINE T *begin () noexcept { return ArrData; }
+  VVA_FORCEINLINE const T *begin () const noexcept { return ArrData; }
+  VVA_FORCEINLINE T *end () noexcept { return (ArrData ? ArrData+ArrNum : nullptr); }
+  VVA_FORCEINLINE const T *end () const noexcept { return (ArrData ? ArrData+ArrNum : nullptr); }
+};
@@ -196,6 +196,7 @@ void FSysSavedState::save () {
   saved = true;
   svSearchPaths = fsysSearchPaths;
   fsysSearchPaths.reset();
+  fsysInvalidateLumpIndex();
   svwadfiles = fsysWadFileNames;
   fsysWadFileNames.reset();
 }
@@ -229,6 +230,7 @@ void FSysSavedState::restore () {
   if (!saved) Sys_Error("FSysSavedState: cannot restore empty save");
   saved = false;
   for (auto &&it : svSearchPaths) fsysSearchPaths.append(it);
+  fsysInvalidateLumpIndex();
   for (auto &&it : svwadfiles) fsysWadFileNames.append(it);
   svSearchPaths.clear();
   svwadfiles.clear();
@@ -270,6 +272,7 @@ void FSYS_Shutdown () {
   }
   fsysSearchPaths.Clear();
   fsysWadFileNames.Clear();
+  fsysInvalidateLumpIndex();
 }
 
 
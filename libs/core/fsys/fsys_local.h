@@ -343,6 +343,12 @@ VStream *FL_OpenFileReadBaseOnly_NoLock (VStr Name, int *lump);
 extern const VPK3ResDirInfo PK3ResourceDirs[];
 extern TArray<VSearchPath *> fsysSearchPaths;
 
+// global lump index (see "fsys_vfs.cpp")
+// call this when archive contents changed, or `fsysSearchPaths` was changed not by appending
+// (appended archives are merged into the index automatically)
+// must be called with `fsys_glock` held (or before any lump lookups)
+void fsysInvalidateLumpIndex ();
+
 //extern bool fsys_report_added_paks;
 //extern bool fsys_no_dup_reports;
 //extern int fsys_dev_dump_paks;
@@ -407,6 +407,7 @@ int VFileDirectory::appendAndRegister (const VPakFileInfo &fi) {
 //
 //==========================================================================
 void VFileDirectory::clear () {
+  fsysInvalidateLumpIndex();
   filemap.clear();
   lumpmap.clear();
   files.clear();
@@ -807,6 +808,7 @@ void VFileDirectory::buildNameMaps (bool rebuilding, VPakFileBase *pak) {
       }
     }
   }
+  fsysInvalidateLumpIndex();
   lumpmap.clear();
   filemap.clear();
   TMap<VStr, bool> dupsReported;
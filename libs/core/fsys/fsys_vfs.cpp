@@ -52,6 +52,72 @@ bool fsys_EnableAuxSearch = false;
 static inline int getSPCount () { return (AuxiliaryIndex >= 0 && !fsys_EnableAuxSearch ? AuxiliaryIndex : fsysSearchPaths.length()); }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// global lump index
+// caches results (including misses) of the global lump lookups, so we don't
+// have to ask every archive again. the index is valid for the current
+// `getSPCount()`; archives mounted on top of the searched ones are merged into
+// it, and everything else (unmounting, renaming, etc.) drops it.
+static TMapNC<vuint64, int> lumpIndexNames; // (name index, namespace) -> lump handle or -1
+static TMap<VStr, int> lumpIndexFiles; // file name -> lump handle or -1
+static int lumpIndexSPCount = 0; // number of searched archives
+static bool lumpIndexValid = false;
+
+
+//==========================================================================
+//
+//  fsysInvalidateLumpIndex
+//
+//==========================================================================
+void fsysInvalidateLumpIndex () {
+  lumpIndexValid = false;
+}
+
+
+//==========================================================================
+//
+//  makeLumpIndexKey
+//
+//==========================================================================
+static inline vuint64 makeLumpIndexKey (VName Name, EWadNamespace NS) noexcept {
+  return ((vuint64)(vuint32)Name.GetIndex()<<32)|(vuint32)NS;
+}
+
+
+//==========================================================================
+//
+//  syncLumpIndex
+//
+//  should be called with the global lock held
+//
+//==========================================================================
+static void syncLumpIndex () {
+  const int spc = getSPCount();
+  if (!lumpIndexValid || spc < lumpIndexSPCount) {
+    lumpIndexNames.reset();
+    lumpIndexFiles.reset();
+    lumpIndexSPCount = spc;
+    lumpIndexValid = true;
+    return;
+  }
+  if (spc == lumpIndexSPCount) return;
+  // new archives were mounted on top, update existing entries
+  for (int wi = lumpIndexSPCount; wi < spc; ++wi) {
+    VSearchPath *sp = fsysSearchPaths[wi];
+    for (auto it = lumpIndexNames.first(); it; ++it) {
+      const vuint64 key = it.getKey();
+      const int i = sp->CheckNumForName(VName::CreateWithIndex((int)(key>>32)), (EWadNamespace)(vuint32)key);
+      if (i >= 0) it.getValue() = MAKE_HANDLE(wi, i);
+    }
+    for (auto it = lumpIndexFiles.first(); it; ++it) {
+      const int i = sp->CheckNumForFileName(it.getKey());
+      if (i >= 0) it.getValue() = MAKE_HANDLE(wi, i);
+    }
+  }
+  lumpIndexSPCount = spc;
+}
+
+
 static int auxMarkCounter = 0;
 
 struct FSysAuxMark {
@@ -676,6 +742,28 @@ int W_AuxiliaryOpenedArchives () {
 }
 
 
+//==========================================================================
+//
+//  checkNumForNameIndexed
+//
+//  should be called with the global lock held
+//
+//==========================================================================
+static int checkNumForNameIndexed (VName Name, EWadNamespace NS) {
+  syncLumpIndex();
+  const vuint64 key = makeLumpIndexKey(Name, NS);
+  auto pp = lumpIndexNames.get(key);
+  if (pp) return *pp;
+  int res = -1;
+  for (int wi = getSPCount()-1; wi >= 0; --wi) {
+    int i = fsysSearchPaths[wi]->CheckNumForName(Name, NS);
+    if (i >= 0) { res = MAKE_HANDLE(wi, i); break; }
+  }
+  lumpIndexNames.put(key, res);
+  return res;
+}
+
+
 //==========================================================================
 //
 //  W_CheckNumForName
@@ -686,12 +774,7 @@ int W_AuxiliaryOpenedArchives () {
 int W_CheckNumForName (VName Name, EWadNamespace NS) {
   if (Name == NAME_None) return -1;
   MyThreadLocker glocker(&fsys_glock);
-  for (int wi = getSPCount()-1; wi >= 0; --wi) {
-    int i = fsysSearchPaths[wi]->CheckNumForName(Name, NS);
-    if (i >= 0) return MAKE_HANDLE(wi, i);
-  }
-  // not found
-  return -1;
+  return checkNumForNameIndexed(Name, NS);
 }
 
 
@@ -752,7 +835,7 @@ int W_CheckNumForNameInFile (VName Name, int File, EWadNamespace NS) {
 //==========================================================================
 int W_CheckNumForNameInFileOrLower (VName Name, int File, EWadNamespace NS) {
   MyThreadLocker glocker(&fsys_glock);
-  if (File >= getSPCount()) File = getSPCount()-1;
+  if (File >= getSPCount()-1) return (Name != NAME_None ? checkNumForNameIndexed(Name, NS) : -1);
   while (File >= 0) {
     int i = fsysSearchPaths[File]->CheckNumForName(Name, NS);
     if (i >= 0) return MAKE_HANDLE(File, i);
@@ -806,12 +889,16 @@ int W_CheckLastNumForNameInFile (VName Name, int File, EWadNamespace NS) {
 //==========================================================================
 int W_CheckNumForFileName (VStr Name) {
   MyThreadLocker glocker(&fsys_glock);
+  syncLumpIndex();
+  auto pp = lumpIndexFiles.get(Name);
+  if (pp) return *pp;
+  int res = -1;
   for (int wi = getSPCount()-1; wi >= 0; --wi) {
     int i = fsysSearchPaths[wi]->CheckNumForFileName(Name);
-    if (i >= 0) return MAKE_HANDLE(wi, i);
+    if (i >= 0) { res = MAKE_HANDLE(wi, i); break; }
   }
-  // not found
-  return -1;
+  lumpIndexFiles.put(Name, res);
+  return res;
 }
 
 
@@ -167,7 +167,7 @@ void VLog::RemoveListener (VLogListener *lst) noexcept {
   }
   if (lastCurr) {
     // i found her!
-    if (lastPrev) lastPrev = lastCurr->next; else Listeners = lastCurr->next;
+    if (lastPrev) lastPrev->next = lastCurr->next; else Listeners = lastCurr->next;
     Z_Free(lastCurr);
   }
 }
@@ -0,0 +1,209 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  fast LZ77 codec for the on-disk caches
+//**
+//**************************************************************************
+#include "core.h"
+
+
+enum {
+  LZF_MINMATCH = 4,
+  LZF_LASTLITERALS = 5, // last bytes are always literals
+  LZF_MFLIMIT = 12, // last match should start before this
+  LZF_MAXDIST = 65535,
+  LZF_HASHLOG = 13,
+};
+
+
+//==========================================================================
+//
+//  lzfRead32
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint32 lzfRead32 (const vuint8 *p) noexcept {
+  vuint32 v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+
+//==========================================================================
+//
+//  lzfHash
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint32 lzfHash (vuint32 v) noexcept {
+  return (v*2654435761u)>>(32-LZF_HASHLOG);
+}
+
+
+//==========================================================================
+//
+//  lzfPutLength
+//
+//  writes length extension bytes; `len` is the length minus 15
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint8 *lzfPutLength (vuint8 *op, int len) noexcept {
+  while (len >= 255) { *op++ = 255; len -= 255; }
+  *op++ = (vuint8)len;
+  return op;
+}
+
+
+//==========================================================================
+//
+//  VLZFast::Compress
+//
+//==========================================================================
+int VLZFast::Compress (const void *src, int srclen, void *dest, int destcap) noexcept {
+  if (srclen < 0 || destcap < 1 || !dest || (srclen && !src)) return -1;
+  const vuint8 *const sbase = (const vuint8 *)src;
+  const vuint8 *ip = sbase;
+  const vuint8 *anchor = sbase;
+  const vuint8 *const iend = sbase+srclen;
+  vuint8 *op = (vuint8 *)dest;
+  vuint8 *const oend = op+destcap;
+
+  if (srclen > LZF_MFLIMIT) {
+    const vuint8 *const mflimit = iend-LZF_MFLIMIT;
+    const vuint8 *const matchlimit = iend-LZF_LASTLITERALS;
+    int table[1<<LZF_HASHLOG];
+    for (auto &&t : table) t = -1;
+    unsigned misses = 0;
+    while (ip < mflimit) {
+      const vuint32 v = lzfRead32(ip);
+      const vuint32 h = lzfHash(v);
+      const int ref = table[h];
+      table[h] = (int)(ptrdiff_t)(ip-sbase);
+      if (ref < 0 || (ip-sbase)-ref > LZF_MAXDIST || lzfRead32(sbase+ref) != v) {
+        // skip faster over incompressible data
+        ip += 1+(misses++>>6);
+        continue;
+      }
+      misses = 0;
+      const vuint8 *match = sbase+ref;
+      // extend backwards
+      while (ip > anchor && match > sbase && ip[-1] == match[-1]) { --ip; --match; }
+      // extend forwards
+      const vuint8 *mp = ip+LZF_MINMATCH;
+      const vuint8 *rp = match+LZF_MINMATCH;
+      while (mp < matchlimit && *mp == *rp) { ++mp; ++rp; }
+
+      const int litlen = (int)(ptrdiff_t)(ip-anchor);
+      const int mlen = (int)(ptrdiff_t)(mp-ip)-LZF_MINMATCH;
+      if (oend-op < 1+litlen+litlen/255+1+2+mlen/255+1) return -1;
+
+      vuint8 *token = op++;
+      if (litlen >= 15) { *token = 15<<4; op = lzfPutLength(op, litlen-15); } else *token = (vuint8)(litlen<<4);
+      memcpy(op, anchor, litlen);
+      op += litlen;
+      const unsigned offset = (unsigned)(ptrdiff_t)(ip-match);
+      *op++ = (vuint8)offset;
+      *op++ = (vuint8)(offset>>8);
+      if (mlen >= 15) { *token |= 15; op = lzfPutLength(op, mlen-15); } else *token |= (vuint8)mlen;
+
+      ip = anchor = mp;
+      // remember a position inside the match, this improves ratio a little
+      if (ip < mflimit) table[lzfHash(lzfRead32(ip-2))] = (int)(ptrdiff_t)(ip-2-sbase);
+    }
+  }
+
+  // last literals
+  const int litlen = (int)(ptrdiff_t)(iend-anchor);
+  if (oend-op < 1+litlen+litlen/255+1) return -1;
+  if (litlen >= 15) { *op++ = 15<<4; op = lzfPutLength(op, litlen-15); } else *op++ = (vuint8)(litlen<<4);
+  if (litlen) memcpy(op, anchor, litlen);
+  op += litlen;
+  return (int)(ptrdiff_t)(op-(vuint8 *)dest);
+}
+
+
+//==========================================================================
+//
+//  VLZFast::Decompress
+//
+//==========================================================================
+int VLZFast::Decompress (const void *src, int srclen, void *dest, int destlen) noexcept {
+  if (srclen < 1 || destlen < 0 || !src || (destlen && !dest)) return -1;
+  const vuint8 *ip = (const vuint8 *)src;
+  const vuint8 *const iend = ip+srclen;
+  vuint8 *const obase = (vuint8 *)dest;
+  vuint8 *op = obase;
+  vuint8 *const oend = obase+destlen;
+
+  for (;;) {
+    if (ip >= iend) return -1;
+    const unsigned token = *ip++;
+
+    // literals
+    size_t litlen = token>>4;
+    if (litlen == 15) {
+      unsigned b;
+      do {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        litlen += b;
+      } while (b == 255);
+    }
+    if (litlen > (size_t)(iend-ip) || litlen > (size_t)(oend-op)) return -1;
+    if (litlen) memcpy(op, ip, litlen);
+    op += litlen;
+    ip += litlen;
+    if (ip == iend) break; // last sequence has no match
+
+    // match
+    if (iend-ip < 2) return -1;
+    const size_t offset = ip[0]|((unsigned)ip[1]<<8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op-obase)) return -1;
+    size_t mlen = token&15;
+    if (mlen == 15) {
+      unsigned b;
+      do {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        mlen += b;
+      } while (b == 255);
+    }
+    mlen += LZF_MINMATCH;
+    if (mlen > (size_t)(oend-op)) return -1;
+    const vuint8 *mp = op-offset;
+    if (offset >= mlen) {
+      memcpy(op, mp, mlen);
+      op += mlen;
+    } else if (offset >= 8) {
+      // overlapping, but 8-byte chunks are fine
+      while (mlen >= 8) { memcpy(op, mp, 8); op += 8; mp += 8; mlen -= 8; }
+      while (mlen--) *op++ = *mp++;
+    } else {
+      while (mlen--) *op++ = *mp++;
+    }
+  }
+
+  return (op == oend ? destlen : -1);
+}
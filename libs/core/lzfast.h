@@ -0,0 +1,48 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  fast LZ77 codec for the on-disk caches
+//**
+//**************************************************************************
+
+// this is LZ4 block format: decoding is several times faster than zlib
+// inflate, at the cost of worse compression ratio. it is used for cached
+// data, where decoding speed matters more than the file size.
+//
+// the compressor is a simple greedy matcher with one hash table slot per
+// bucket; there are no streaming modes, whole buffers only.
+class VLZFast {
+public:
+  // maximum compressed size for `srclen` bytes (incompressible data)
+  static VVA_FORCEINLINE VVA_CONST int CompressBound (int srclen) noexcept { return (srclen > 0 ? srclen+srclen/255+16 : 16); }
+
+  // returns compressed size, or -1 if `destcap` is not enough
+  static int Compress (const void *src, int srclen, void *dest, int destcap) noexcept;
+
+  // `destlen` is the exact decompressed size
+  // returns `destlen`, or -1 if the data is corrupted
+  static int Decompress (const void *src, int srclen, void *dest, int destlen) noexcept;
+};
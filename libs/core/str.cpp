@@ -115,6 +115,30 @@ static VVA_FORCEINLINE int vstrCalcInitialStoreSizeInt (int newlen) noexcept {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// immutable one-char strings; they are built at compile time, and
+// `setContent()` uses them instead of allocating a new store
+struct VStrCharStore {
+  VStr::Store st;
+  char data[16];
+};
+static_assert(sizeof(VStrCharStore) == sizeof(VStr::Store)+16, "invalid size for `VStrCharStore` struct");
+
+#define VSTR_CHAR1(n)   {{1, 1, -0x00ffffff/*immutable*/, 0}, {(char)(n)}}
+#define VSTR_CHAR4(n)   VSTR_CHAR1(n), VSTR_CHAR1((n)+1), VSTR_CHAR1((n)+2), VSTR_CHAR1((n)+3)
+#define VSTR_CHAR16(n)  VSTR_CHAR4(n), VSTR_CHAR4((n)+4), VSTR_CHAR4((n)+8), VSTR_CHAR4((n)+12)
+#define VSTR_CHAR64(n)  VSTR_CHAR16(n), VSTR_CHAR16((n)+16), VSTR_CHAR16((n)+32), VSTR_CHAR16((n)+48)
+
+static VStrCharStore vstrCharTable[256] = {
+  VSTR_CHAR64(0), VSTR_CHAR64(64), VSTR_CHAR64(128), VSTR_CHAR64(192),
+};
+
+#undef VSTR_CHAR64
+#undef VSTR_CHAR16
+#undef VSTR_CHAR4
+#undef VSTR_CHAR1
+
+
 #ifdef VCORE_USE_STRTODEX
 //==========================================================================
 //
@@ -852,8 +876,8 @@ void VStr::makeMutable () noexcept {
   // copy old data
   memcpy(dataptr, olddata, olen+1);
   //if (oldstore->rc > 0) --oldstore->rc; // decrement old refcounter
-  if (__atomic_load_n(&oldstore->rc, __ATOMIC_SEQ_CST) > 0) {
-    (void)__atomic_sub_fetch(&oldstore->rc, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&oldstore->rc, __ATOMIC_RELAXED) > 0) {
+    (void)__atomic_sub_fetch(&oldstore->rc, 1, __ATOMIC_ACQ_REL);
   }
 #ifdef VAVOOM_TEST_VSTR
   GLog.Logf(NAME_Debug, "VStr: makeMutable: old=%p(%d); new=%p(%d)", oldstore+1, oldstore->rc, dataptr, newdata->rc);
@@ -982,6 +1006,13 @@ void VStr::resize (int newlen) noexcept {
 void VStr::setContent (const char *s, int len) noexcept {
   if (s && s[0]) {
     if (len < 0) len = (int)strlen(s);
+    if (len == 1) {
+      // no need to allocate anything
+      const vuint8 ch = (vuint8)s[0];
+      clear();
+      dataptr = vstrCharTable[ch].data;
+      return;
+    }
     size_t newsz = vstrCalcInitialStoreSizeSizeT((size_t)len);
     Store *ns = (Store *)Z_MallocNoClearNoFail(sizeof(Store)+(size_t)newsz+1u);
     if (!ns) {
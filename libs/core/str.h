@@ -72,25 +72,34 @@ protected:
   VVA_CHECKRESULT VVA_FORCEINLINE Store *store () noexcept { return (dataptr ? (Store *)(dataptr-sizeof(Store)) : nullptr); }
   VVA_CHECKRESULT VVA_FORCEINLINE Store *store () const noexcept { return (dataptr ? (Store *)(dataptr-sizeof(Store)) : nullptr); }
 
+  // refcount memory ordering:
+  //   increments are relaxed (you can only increment rc if you already own a reference);
+  //   decrements are acq_rel, so the thread that frees the store sees all writes to it;
+  //   if we are the only owner, nobody else can touch rc, and no atomic op is required.
+
+  // should be called only when storage is available
+  // the address goes through an integer, so GCC doesn't think that we are poking before some known object
+  VVA_CHECKRESULT VVA_FORCEINLINE vint32 *rcptr () const noexcept { return &((Store *)((uintptr_t)dataptr-sizeof(Store)))->rc; }
+
   // should be called only when storage is available
-  VVA_CHECKRESULT VVA_FORCEINLINE int atomicGetRC () const noexcept { return __atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST); }
+  VVA_CHECKRESULT VVA_FORCEINLINE int atomicGetRC () const noexcept { return __atomic_load_n(rcptr(), __ATOMIC_ACQUIRE); }
   // should be called only when storage is available
-  VVA_FORCEINLINE void atomicSetRC (int newval) noexcept { __atomic_store_n(&((Store *)(dataptr-sizeof(Store)))->rc, newval, __ATOMIC_SEQ_CST); }
+  VVA_FORCEINLINE void atomicSetRC (int newval) noexcept { __atomic_store_n(rcptr(), newval, __ATOMIC_RELEASE); }
   // should be called only when storage is available
-  VVA_CHECKRESULT VVA_FORCEINLINE bool atomicIsImmutable () const noexcept { return (__atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST) < 0); }
+  VVA_CHECKRESULT VVA_FORCEINLINE bool atomicIsImmutable () const noexcept { return (__atomic_load_n(rcptr(), __ATOMIC_RELAXED) < 0); }
   // should be called only when storage is available
   // immutable strings aren't unique
-  VVA_CHECKRESULT VVA_FORCEINLINE bool atomicIsUnique () const noexcept { return (__atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST) == 1); }
+  VVA_CHECKRESULT VVA_FORCEINLINE bool atomicIsUnique () const noexcept { return (__atomic_load_n(rcptr(), __ATOMIC_ACQUIRE) == 1); }
   // should be called only when storage is available
   // returns new value
   // WARNING: will happily modify immutable RC!
-  VVA_FORCEINLINE void atomicIncRC () const noexcept { (void)__atomic_add_fetch(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
-  VVA_FORCEINLINE int atomicIncRCRetOld () const noexcept { return __atomic_fetch_add(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
+  VVA_FORCEINLINE void atomicIncRC () const noexcept { (void)__atomic_add_fetch(rcptr(), 1, __ATOMIC_RELAXED); }
+  VVA_FORCEINLINE int atomicIncRCRetOld () const noexcept { return __atomic_fetch_add(rcptr(), 1, __ATOMIC_RELAXED); }
   // should be called only when storage is available
   // returns new value
   // WARNING: will happily modify immutable RC!
-  VVA_FORCEINLINE int atomicDecRC () const noexcept { return __atomic_sub_fetch(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
-  VVA_FORCEINLINE void atomicDecRCVoid () const noexcept { (void)__atomic_sub_fetch(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
+  VVA_FORCEINLINE int atomicDecRC () const noexcept { return __atomic_sub_fetch(rcptr(), 1, __ATOMIC_ACQ_REL); }
+  VVA_FORCEINLINE void atomicDecRCVoid () const noexcept { (void)__atomic_sub_fetch(rcptr(), 1, __ATOMIC_ACQ_REL); }
 
   VVA_CHECKRESULT VVA_FORCEINLINE char *getData () noexcept { return dataptr; }
   VVA_CHECKRESULT VVA_FORCEINLINE const char *getData () const noexcept { return dataptr; }
@@ -102,7 +111,8 @@ protected:
   inline void decref () noexcept {
     if (dataptr) {
       if (!atomicIsImmutable()) {
-        if (atomicDecRC() == 0) {
+        // the only owner doesn't need an atomic decrement
+        if (atomicIsUnique() || atomicDecRC() == 0) {
           #ifdef VAVOOM_TEST_VSTR
           fprintf(stderr, "VStr: freeing %p\n", dataptr);
           #endif
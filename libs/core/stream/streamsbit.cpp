@@ -26,6 +26,120 @@
 #include "../core.h"
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// word access helpers
+// near the end of the buffer they fall back to byte access, so the buffers
+// don't need any padding
+
+//==========================================================================
+//
+//  bsLoadBytes
+//
+//  load `count` (0..8) bytes as little-endian number
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint64 bsLoadBytes (const vuint8 *src, int count) noexcept {
+  vuint64 res = 0;
+  #ifdef VAVOOM_BIG_ENDIAN
+  for (int f = 0; f < count; ++f) res |= ((vuint64)src[f])<<(f*8);
+  #else
+  memcpy(&res, src, (size_t)count);
+  #endif
+  return res;
+}
+
+
+//==========================================================================
+//
+//  bsStoreBytes
+//
+//==========================================================================
+static VVA_FORCEINLINE void bsStoreBytes (vuint8 *dst, vuint64 v, int count) noexcept {
+  #ifdef VAVOOM_BIG_ENDIAN
+  for (int f = 0; f < count; ++f, v >>= 8) dst[f] = (vuint8)v;
+  #else
+  memcpy(dst, &v, (size_t)count);
+  #endif
+}
+
+
+//==========================================================================
+//
+//  bsLoadWord
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint64 bsLoadWord (const vuint8 *buf, int bufLen, int bytepos) noexcept {
+  return bsLoadBytes(buf+bytepos, clampval(bufLen-bytepos, 0, 8));
+}
+
+
+//==========================================================================
+//
+//  bsStoreWord
+//
+//==========================================================================
+static VVA_FORCEINLINE void bsStoreWord (vuint8 *buf, int bufLen, int bytepos, vuint64 v) noexcept {
+  bsStoreBytes(buf+bytepos, v, clampval(bufLen-bytepos, 0, 8));
+}
+
+
+//==========================================================================
+//
+//  bsPutBits
+//
+//  put up to 57 bits at `bitpos`; the caller should check the buffer size
+//  bits around the destination range are not changed
+//
+//==========================================================================
+static VVA_FORCEINLINE void bsPutBits (vuint8 *buf, int bufLen, int bitpos, vuint64 val, int count) noexcept {
+  const int bytepos = (int)(((unsigned)bitpos)>>3);
+  const unsigned shift = bitpos&7;
+  const vuint64 mask = ((((vuint64)1)<<count)-1)<<shift;
+  vuint64 w = bsLoadWord(buf, bufLen, bytepos);
+  w = (w&~mask)|((val<<shift)&mask);
+  bsStoreWord(buf, bufLen, bytepos, w);
+}
+
+
+//==========================================================================
+//
+//  bsPeekBits
+//
+//  returns at least 57 bits starting from `bitpos` (less at the buffer end)
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint64 bsPeekBits (const vuint8 *buf, int bufLen, int bitpos) noexcept {
+  return bsLoadWord(buf, bufLen, (int)(((unsigned)bitpos)>>3))>>(bitpos&7);
+}
+
+
+//==========================================================================
+//
+//  bsCopyBits
+//
+//  copy bits from byte-aligned `src` to `dst` at `bitpos`
+//
+//==========================================================================
+static void bsCopyBits (vuint8 *dst, int dstLen, int bitpos, const vuint8 *src, int count) noexcept {
+  if ((bitpos&7) == 0 && count >= 8) {
+    const int bytes = count>>3;
+    memcpy(dst+(bitpos>>3), src, (size_t)bytes);
+    src += bytes;
+    bitpos += bytes<<3;
+    count &= 7;
+  } else {
+    // 7 bytes per step, so the shifted value always fits into the word
+    while (count >= 56) {
+      bsPutBits(dst, dstLen, bitpos, bsLoadBytes(src, 7), 56);
+      src += 7;
+      bitpos += 56;
+      count -= 56;
+    }
+  }
+  if (count > 0) bsPutBits(dst, dstLen, bitpos, bsLoadBytes(src, (count+7)>>3), count);
+}
+
+
 //**************************************************************************
 //
 // VBitStreamWriter
@@ -98,15 +212,7 @@ void VBitStreamWriter::cloneFrom (const VBitStreamWriter *wr) {
 //==========================================================================
 void VBitStreamWriter::CopyFromWS (const VBitStreamWriter &strm) noexcept {
   if (strm.Pos == 0) return;
-  const vuint8 *src = (const vuint8 *)strm.Data.ptr();
-  vuint8 mask = 0x01u;
-  for (int pos = 0; pos < strm.Pos; ++pos) {
-    WriteBit(src[0]&mask);
-    if ((mask<<=1) == 0) {
-      mask = 0x01u;
-      ++src;
-    }
-  }
+  SerialiseBits((void *)strm.Data.ptr(), strm.Pos);
 }
 
 
@@ -124,6 +230,46 @@ bool VBitStreamWriter::Expand () noexcept {
 }
 
 
+//==========================================================================
+//
+//  VBitStreamWriter::Reserve
+//
+//==========================================================================
+bool VBitStreamWriter::Reserve (int count) noexcept {
+  if (bError) return false;
+  if (Pos+count > Max) {
+    if (!bAllowExpand) { bError = true; return false; }
+    while (((Pos+count+7)>>3) > Data.length()) {
+      if (!Expand()) { bError = true; return false; }
+    }
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VBitStreamWriter::PutBits
+//
+//==========================================================================
+void VBitStreamWriter::PutBits (vuint64 val, int count) noexcept {
+  if (count <= 0 || !Reserve(count)) return;
+  bsPutBits(Data.ptr(), Data.length(), Pos, val, count);
+  Pos += count;
+}
+
+
+//==========================================================================
+//
+//  VBitStreamWriter::WriteBits
+//
+//==========================================================================
+void VBitStreamWriter::WriteBits (vuint32 val, int count) noexcept {
+  vassert(count >= 0 && count <= 32);
+  PutBits(val, count);
+}
+
+
 //==========================================================================
 //
 //  VBitStreamWriter::Serialise
@@ -142,78 +288,9 @@ void VBitStreamWriter::Serialise (void *data, int length) {
 void VBitStreamWriter::SerialiseBits (void *Src, int Length) {
   if (!Length) return;
   vassert(Length > 0);
-
-  #if 1
-  if (Pos+Length > Max) {
-    if (!bAllowExpand) { bError = true; return; }
-    // do it slow
-    const vuint8 *sb = (const vuint8 *)Src;
-    while (Length > 0) {
-      vuint8 currByte = *sb++;
-      for (int f = 0; f < 8 && Length > 0; ++f, --Length) {
-        WriteBit(!!(currByte&0x80));
-        currByte <<= 1;
-      }
-    }
-    return;
-  }
-
-  if (Length <= 8) {
-    const unsigned Byte1 = ((unsigned)Pos)>>3;
-    const unsigned Byte2 = ((unsigned)(Pos+Length-1))>>3;
-
-    const vuint8 Val = ((const vuint8 *)Src)[0]&((1u<<(Length&0x1f))-1);
-    const unsigned Shift = Pos&7;
-    if (Byte1 == Byte2) {
-      Data[Byte1] |= Val<<Shift;
-    } else {
-      Data[Byte1] |= Val<<Shift;
-      Data[Byte2] |= Val>>(8-Shift);
-    }
-    Pos += Length;
-    return;
-  }
-
-  const unsigned Bytes = ((unsigned)Length)>>3;
-  if (Bytes) {
-    if (Pos&7) {
-      const vuint8 *pSrc = (const vuint8 *)Src;
-      vuint8 *pDst = (vuint8*)Data.Ptr()+(Pos>>3);
-      for (unsigned i = 0; i < Bytes; ++i, ++pSrc, ++pDst) {
-        pDst[0] |= *pSrc<<(Pos&7);
-        pDst[1] |= *pSrc>>(8-(Pos&7));
-      }
-    } else {
-      memcpy(Data.Ptr()+((Pos+7)>>3), Src, Length>>3);
-    }
-    Pos += Length&~7;
-  }
-
-  if (Length&7) {
-    const unsigned Byte1 = ((unsigned)Pos)>>3;
-    const unsigned Byte2 = ((unsigned)(Pos+(Length&7)-1))>>3;
-    const vuint8 Val = ((const vuint8 *)Src)[Length>>3]&((1<<(Length&7))-1);
-    const unsigned Shift = Pos&7;
-    if (Byte1 == Byte2) {
-      Data[Byte1] |= Val<<Shift;
-    } else {
-      Data[Byte1] |= Val<<Shift;
-      Data[Byte2] |= Val>>(8-Shift);
-    }
-    Pos += Length&7;
-  }
-  #else
-  // do it slow
-  const vuint8 *sb = (const vuint8 *)Src;
-  while (Length > 0) {
-    const vuint8 currByte = *sb++;
-    vuint8 mask = 1u;
-    while (mask && Length-- > 0) {
-      WriteBit(currByte&mask);
-      mask <<= 1;
-    }
-  }
-  #endif
+  if (!Reserve(Length)) return;
+  bsCopyBits(Data.ptr(), Data.length(), Pos, (const vuint8 *)Src, Length);
+  Pos += Length;
 }
 
 
@@ -235,21 +312,20 @@ void VBitStreamWriter::SerialiseInt (vuint32 &Value) {
 void VBitStreamWriter::WriteInt (vint32 IVal) {
   // sign bit
   vuint32 Val = (vuint32)IVal;
+  vuint64 code = 0;
   if (Val&0x80000000u) {
-    WriteBit(true);
+    code = 1u;
     Val ^= 0xffffffffu;
-  } else {
-    WriteBit(false);
   }
-  // bytes
+  int bits = 1;
+  // nibbles: continue bit, and 4 data bits
   while (Val) {
-    WriteBit(true);
-    for (int cnt = 4; cnt > 0; --cnt) {
-      WriteBit(!!(Val&0x01));
-      Val >>= 1;
-    }
+    code |= ((vuint64)(1u|((Val&0x0fu)<<1)))<<bits;
+    bits += 5;
+    Val >>= 4;
   }
-  WriteBit(false); // stop bit
+  // zero stop bit; 42 bits max
+  PutBits(code, bits+1);
 }
 
 
@@ -259,15 +335,16 @@ void VBitStreamWriter::WriteInt (vint32 IVal) {
 //
 //==========================================================================
 void VBitStreamWriter::WriteUInt (vuint32 Val) {
-  // bytes
+  vuint64 code = 0;
+  int bits = 0;
+  // nibbles: continue bit, and 4 data bits
   while (Val) {
-    WriteBit(true);
-    for (int cnt = 4; cnt > 0; --cnt) {
-      WriteBit(!!(Val&0x01));
-      Val >>= 1;
-    }
+    code |= ((vuint64)(1u|((Val&0x0fu)<<1)))<<bits;
+    bits += 5;
+    Val >>= 4;
   }
-  WriteBit(false); // stop bit
+  // zero stop bit; 41 bits max
+  PutBits(code, bits+1);
 }
 
 
@@ -378,43 +455,27 @@ void VBitStreamReader::SerialiseBits (void *Dst, int Length) {
     return;
   }
 
-  #if 1
-  if (Pos&7) {
-    unsigned SrcPos = Pos>>3;
-    const unsigned Shift1 = Pos&7;
-    const unsigned Shift2 = 8-Shift1;
-    const unsigned Count = ((unsigned)Length)>>3;
-    for (unsigned i = 0; i < Count; ++i, ++SrcPos) {
-      ((vuint8 *)Dst)[i] = (Data[SrcPos]>>Shift1)|Data[SrcPos+1]<<Shift2;
-    }
-    if (Length&7) {
-      if ((Length&7) > Shift2) {
-        ((vuint8 *)Dst)[Count] = ((Data[SrcPos]>>Shift1)|Data[SrcPos+1]<<Shift2)&((1<<(Length&7))-1);
-      } else {
-        ((vuint8 *)Dst)[Count] = (Data[SrcPos]>>Shift1)&((1<<(Length&7))-1);
-      }
-    }
+  vuint8 *dst = (vuint8 *)Dst;
+  if ((Pos&7) == 0) {
+    const int Count = Length>>3;
+    memcpy(dst, Data.ptr()+(Pos>>3), Count);
+    dst += Count;
+    Pos += Count<<3;
+    Length &= 7;
   } else {
-    unsigned Count = ((unsigned)Length)>>3;
-    memcpy(Dst, Data.Ptr()+(Pos>>3), Count);
-    if (Length&7) {
-      ((vuint8 *)Dst)[Count] = Data[(Pos>>3)+Count]&((1<<(Length&7))-1);
+    // 7 bytes per step
+    while (Length >= 56) {
+      bsStoreBytes(dst, bsPeekBits(Data.ptr(), Data.length(), Pos), 7);
+      dst += 7;
+      Pos += 56;
+      Length -= 56;
     }
   }
-  Pos += Length;
-  #else
-  // do it slow
-  vuint8 *db = (vuint8 *)Dst;
-  while (Length > 0) {
-    vuint8 currByte = 0;
-    vuint8 mask = 1u;
-    while (mask && Length-- > 0) {
-      if (ReadBit()) currByte |= mask;
-      mask <<= 1;
-    }
-    *db++ = currByte;
+  if (Length > 0) {
+    const vuint64 v = bsPeekBits(Data.ptr(), Data.length(), Pos)&((((vuint64)1)<<Length)-1);
+    bsStoreBytes(dst, v, (Length+7)>>3);
+    Pos += Length;
   }
-  #endif
 }
 
 
@@ -434,6 +495,24 @@ void VBitStreamReader::SerialiseInt (vuint32 &Value) {
 //
 //==========================================================================
 vint32 VBitStreamReader::ReadInt () {
+  // the longest number is 42 bits; take the fast path if we surely have them
+  if (Num-Pos >= 42) {
+    vuint64 w = bsPeekBits(Data.ptr(), Data.length(), Pos);
+    const bool sign = (w&1u);
+    w >>= 1;
+    vuint32 Val = 0;
+    unsigned shift = 0;
+    while (w&1u) {
+      vassert(shift < 32);
+      Val |= ((vuint32)(w>>1)&0x0fu)<<shift;
+      shift += 4;
+      w >>= 5;
+    }
+    Pos += (int)(shift/4*5)+2; // sign bit, nibbles, stop bit
+    if (sign) Val ^= 0xffffffffu;
+    return (vint32)Val;
+  }
+
   bool sign = ReadBit();
   vuint32 Val = 0, Mask = 1u;
   // bytes
@@ -455,6 +534,21 @@ vint32 VBitStreamReader::ReadInt () {
 //
 //==========================================================================
 vuint32 VBitStreamReader::ReadUInt () {
+  // the longest number is 41 bits; take the fast path if we surely have them
+  if (Num-Pos >= 41) {
+    vuint64 w = bsPeekBits(Data.ptr(), Data.length(), Pos);
+    vuint32 Val = 0;
+    unsigned shift = 0;
+    while (w&1u) {
+      vassert(shift < 32);
+      Val |= ((vuint32)(w>>1)&0x0fu)<<shift;
+      shift += 4;
+      w >>= 5;
+    }
+    Pos += (int)(shift/4*5)+1; // nibbles, stop bit
+    return Val;
+  }
+
   vuint32 Val = 0, Mask = 1u;
   // bytes
   while (ReadBit()) {
@@ -468,6 +562,21 @@ vuint32 VBitStreamReader::ReadUInt () {
 }
 
 
+//==========================================================================
+//
+//  VBitStreamReader::ReadBits
+//
+//==========================================================================
+vuint32 VBitStreamReader::ReadBits (int count) noexcept {
+  vassert(count >= 0 && count <= 32);
+  if (count == 0) return 0;
+  if (Pos+count > Num) { bError = true; return 0; }
+  const vuint32 res = (vuint32)(bsPeekBits(Data.ptr(), Data.length(), Pos)&((((vuint64)1)<<count)-1));
+  Pos += count;
+  return res;
+}
+
+
 //==========================================================================
 //
 //  VBitStreamReader::AtEnd
@@ -523,16 +632,6 @@ void VBitStreamReader::CopyFromBuffer (const vuint8 *buf, int bitLength) noexcep
     Data.setLength(newByteLen);
     if (newByteLen > oldByteLen) memset(Data.ptr()+oldByteLen, 0, newByteLen-oldByteLen);
   }
-  // destination
-  vuint8 *d = Data.ptr()+(Num>>3);
-  vuint8 dmask = 1u<<(Num&7);
+  bsCopyBits(Data.ptr(), Data.length(), Num, buf, bitLength);
   Num += bitLength;
-  // source
-  vuint8 smask = 1u;
-  // copy
-  while (bitLength-- > 0) {
-    if (buf[0]&smask) d[0] |= dmask; else d[0] &= ~dmask;
-    if ((smask<<=1) == 0) { smask = 1u; ++buf; }
-    if ((dmask<<=1) == 0) { dmask = 1u; ++d; }
-  }
 }
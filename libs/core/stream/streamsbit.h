@@ -30,6 +30,10 @@
 //**
 //**    Handles byte ordering and avoids alignment errors
 //**
+//**  bits are stored LSB first: bit `n` is `(Data[n/8]>>(n%8))&1`.
+//**  multibit operations load and store the buffer in 64-bit words,
+//**  so up to 57 bits can be processed in one step.
+//**
 //**************************************************************************
 
 // WARNING! KEEP THIS IN SYNC WITH BITINT FORMAT IN `Write[U]Int()`/`Read[U]Int()`!
@@ -67,6 +71,12 @@ protected:
 protected:
   bool Expand () noexcept;
 
+  // make room for `count` more bits; sets error flag and returns `false` on failure
+  bool Reserve (int count) noexcept;
+
+  // write up to 57 bits at once; higher bits of `val` are ignored
+  void PutBits (vuint64 val, int count) noexcept;
+
   inline bool ReadBitInternal () noexcept {
     if (Pos >= Data.length()*8) {
       bError = true;
@@ -92,6 +102,8 @@ public:
   virtual void SerialiseInt (vuint32 &Value) override;
   void WriteInt (vint32 Val);
   void WriteUInt (vuint32 Val);
+  // write `count` (0..32) lower bits of `val`
+  void WriteBits (vuint32 val, int count) noexcept;
   inline vuint8 *GetData () noexcept { return Data.Ptr(); }
   inline int GetNumBits () const noexcept { return Pos; }
   inline int GetNumBytes () const noexcept { return (Pos+7)>>3; }
@@ -163,6 +175,8 @@ public:
   virtual void SerialiseInt (vuint32 &Value/*, vuint32 Max*/) override;
   vint32 ReadInt ();
   vuint32 ReadUInt ();
+  // read `count` (0..32) bits
+  vuint32 ReadBits (int count) noexcept;
   virtual bool AtEnd () override;
   inline vuint8 *GetData () noexcept { return Data.Ptr(); }
   inline int GetNumBits () const noexcept { return Num; }
@@ -0,0 +1,299 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  simple pool of worker threads for "parallel for" jobs
+//**
+//**************************************************************************
+#include "core.h"
+
+
+#define VWP_MAX_WORKERS  (64)
+
+static int wpMaxThreads = 0; // 0: all CPUs
+static int wpWorkerCount = 0; // number of running worker threads
+static mythread wpThreads[VWP_MAX_WORKERS];
+static bool wpInited = false;
+
+static mythread_mutex wpLock;
+static mythread_cond wpJobCond; // signalled when new job is posted
+static mythread_cond wpDoneCond; // signalled when the last worker finished its part
+
+// current job; protected by `wpLock`, except the batch counter
+static VWorkPool::BatchFn wpJobFn = nullptr;
+static void *wpJobData = nullptr;
+static int wpJobCount = 0;
+static int wpJobBatchSize = 0;
+static vuint32 wpJobSerial = 0; // incremented for each new job
+static int wpJobBusy = 0; // number of workers still processing the job
+static bool wpQuit = false;
+
+static atomic_int wpNextBatch = 0;
+static atomic_int wpRunning = 0; // non-zero if some job is in progress
+
+// job started with `StartJob()`; main thread only
+static VWorkPool::BatchFn wpAsyncFn = nullptr;
+static void *wpAsyncData = nullptr;
+static int wpAsyncCount = 0;
+static int wpAsyncBatchSize = 0;
+static bool wpAsyncPosted = false; // `false`: should be done in `FinishJob()`
+
+
+//==========================================================================
+//
+//  wpProcessBatches
+//
+//==========================================================================
+static void wpProcessBatches (VWorkPool::BatchFn fn, void *udata, int count, int batchSize, int worker) {
+  for (;;) {
+    const int bidx = atomic_increment(&wpNextBatch)-1;
+    const int start = bidx*batchSize;
+    if (start >= count || start < 0) break;
+    fn(udata, start, min2(count, start+batchSize), worker);
+  }
+}
+
+
+//==========================================================================
+//
+//  wpWorkerThread
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE wpWorkerThread (void *aidx) {
+  const int worker = (int)(intptr_t)aidx;
+  char tname[32];
+  snprintf(tname, sizeof(tname), "worker #%d", worker);
+  VZoneProf::SetThreadName(tname);
+  mythread_mutex_lock(&wpLock);
+  // workers can be recreated after some jobs were done; don't take the last finished job
+  vuint32 lastSerial = wpJobSerial;
+  for (;;) {
+    while (!wpQuit && lastSerial == wpJobSerial) mythread_cond_wait(&wpJobCond, &wpLock);
+    if (wpQuit) break;
+    lastSerial = wpJobSerial;
+    VWorkPool::BatchFn fn = wpJobFn;
+    void *udata = wpJobData;
+    const int count = wpJobCount;
+    const int batchSize = wpJobBatchSize;
+    mythread_mutex_unlock(&wpLock);
+
+    wpProcessBatches(fn, udata, count, batchSize, worker);
+
+    mythread_mutex_lock(&wpLock);
+    if (--wpJobBusy == 0) mythread_cond_signal(&wpDoneCond);
+  }
+  mythread_mutex_unlock(&wpLock);
+  VFrameArena::ReleaseThread();
+  VZoneProf::ReleaseThread();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  wpStartWorkers
+//
+//  called with the lock released, when no job is running
+//
+//==========================================================================
+static void wpStartWorkers (int count) {
+  if (!wpInited) {
+    mythread_mutex_init(&wpLock);
+    mythread_cond_init(&wpJobCond);
+    mythread_cond_init(&wpDoneCond);
+    wpInited = true;
+  }
+  if (count == wpWorkerCount) return;
+  VWorkPool::Shutdown();
+  mythread_mutex_lock(&wpLock);
+  wpQuit = false;
+  mythread_mutex_unlock(&wpLock);
+  while (wpWorkerCount < count) {
+    if (mythread_create(&wpThreads[wpWorkerCount], &wpWorkerThread, (void *)(intptr_t)(wpWorkerCount+1))) {
+      GLog.Logf(NAME_Warning, "cannot create worker thread #%d", wpWorkerCount+1);
+      break;
+    }
+    ++wpWorkerCount;
+  }
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::SetMaxThreads
+//
+//==========================================================================
+void VWorkPool::SetMaxThreads (int count) noexcept {
+  wpMaxThreads = clampval(count, 0, VWP_MAX_WORKERS+1);
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::GetThreadCount
+//
+//==========================================================================
+int VWorkPool::GetThreadCount () noexcept {
+  const int res = (wpMaxThreads > 0 ? wpMaxThreads : Sys_GetCPUCount());
+  return clampval(res, 1, VWP_MAX_WORKERS+1);
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::Shutdown
+//
+//==========================================================================
+void VWorkPool::Shutdown () noexcept {
+  if (!wpInited || wpWorkerCount == 0) return;
+  mythread_mutex_lock(&wpLock);
+  wpQuit = true;
+  mythread_cond_broadcast(&wpJobCond);
+  mythread_mutex_unlock(&wpLock);
+  for (int f = 0; f < wpWorkerCount; ++f) mythread_join(wpThreads[f]);
+  wpWorkerCount = 0;
+}
+
+
+//==========================================================================
+//
+//  wpPostJob
+//
+//  called with `wpRunning` set, and the workers started
+//
+//==========================================================================
+static void wpPostJob (int count, int batchSize, VWorkPool::BatchFn fn, void *udata) {
+  mythread_mutex_lock(&wpLock);
+  wpJobFn = fn;
+  wpJobData = udata;
+  wpJobCount = count;
+  wpJobBatchSize = batchSize;
+  wpJobBusy = wpWorkerCount;
+  atomic_store(&wpNextBatch, 0);
+  ++wpJobSerial;
+  mythread_cond_broadcast(&wpJobCond);
+  mythread_mutex_unlock(&wpLock);
+}
+
+
+//==========================================================================
+//
+//  wpWaitJob
+//
+//  helps the workers, waits for them, and resets `wpRunning`
+//
+//==========================================================================
+static void wpWaitJob (int count, int batchSize, VWorkPool::BatchFn fn, void *udata) {
+  // help the workers
+  wpProcessBatches(fn, udata, count, batchSize, 0);
+
+  // wait for the workers
+  mythread_mutex_lock(&wpLock);
+  while (wpJobBusy > 0) mythread_cond_wait(&wpDoneCond, &wpLock);
+  wpJobFn = nullptr;
+  wpJobData = nullptr;
+  mythread_mutex_unlock(&wpLock);
+
+  atomic_store(&wpRunning, 0);
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::ParallelFor
+//
+//==========================================================================
+void VWorkPool::ParallelFor (int count, int batchSize, BatchFn fn, void *udata) {
+  if (count <= 0 || !fn) return;
+
+  const int tcount = GetThreadCount();
+  if (batchSize < 1) batchSize = max2(1, count/(tcount*4));
+
+  // single batch, or nested call: do it in the calling thread
+  if (tcount < 2 || count <= batchSize || atomic_cmp_xchg(&wpRunning, 0, 1) != 0) {
+    fn(udata, 0, count, 0);
+    return;
+  }
+
+  wpStartWorkers(tcount-1);
+  if (wpWorkerCount == 0) {
+    atomic_store(&wpRunning, 0);
+    fn(udata, 0, count, 0);
+    return;
+  }
+
+  wpPostJob(count, batchSize, fn, udata);
+  wpWaitJob(count, batchSize, fn, udata);
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::StartJob
+//
+//==========================================================================
+void VWorkPool::StartJob (int count, int batchSize, BatchFn fn, void *udata) {
+  vassert(!wpAsyncFn);
+  if (count <= 0 || !fn) return;
+
+  const int tcount = GetThreadCount();
+  if (batchSize < 1) batchSize = max2(1, count/(tcount*4));
+
+  wpAsyncFn = fn;
+  wpAsyncData = udata;
+  wpAsyncCount = count;
+  wpAsyncBatchSize = batchSize;
+  wpAsyncPosted = false;
+
+  // unlike `ParallelFor()`, even a single batch should go to the workers
+  if (tcount < 2 || atomic_cmp_xchg(&wpRunning, 0, 1) != 0) return;
+
+  wpStartWorkers(tcount-1);
+  if (wpWorkerCount == 0) {
+    atomic_store(&wpRunning, 0);
+    return;
+  }
+
+  wpPostJob(count, batchSize, fn, udata);
+  wpAsyncPosted = true;
+}
+
+
+//==========================================================================
+//
+//  VWorkPool::FinishJob
+//
+//==========================================================================
+void VWorkPool::FinishJob () {
+  VWorkPool::BatchFn fn = wpAsyncFn;
+  if (!fn) return;
+  wpAsyncFn = nullptr;
+  if (wpAsyncPosted) {
+    wpAsyncPosted = false;
+    wpWaitJob(wpAsyncCount, wpAsyncBatchSize, fn, wpAsyncData);
+  } else {
+    fn(wpAsyncData, 0, wpAsyncCount, 0);
+  }
+}
@@ -0,0 +1,82 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  simple pool of worker threads for "parallel for" jobs
+//**
+//**************************************************************************
+
+// the job is split to batches, and the batches are processed by the calling
+// thread and the workers. `ParallelFor()` returns when all batches are done.
+// only one job can run at a time; nested or concurrent calls will run
+// the job in the calling thread.
+//
+// batch callback gets `[start..end)` range, and the worker index
+// (0 is the calling thread). it should not touch anything that other
+// batches can write to; if the results should be merged in a deterministic
+// order, store them by batch index (`start/batchSize`), and merge after
+// `ParallelFor()` returned.
+class VWorkPool {
+public:
+  typedef void (*BatchFn) (void *udata, int start, int end, int worker);
+
+public:
+  // 0 means "use all CPUs"; 1 disables threading
+  // this can be changed at any time, the workers will be recreated on the next job
+  static void SetMaxThreads (int count) noexcept;
+
+  // returns maximum number of threads that can process one job (including the calling thread)
+  static int GetThreadCount () noexcept;
+
+  // run `fn` for `[0..count)` in batches of `batchSize` items
+  // if `batchSize` is less than 1, it will be calculated automatically
+  static void ParallelFor (int count, int batchSize, BatchFn fn, void *udata);
+
+  // post the job to the worker threads, and return immediately, so the
+  // calling thread can do something else meanwhile (it should not touch
+  // anything the job is using). `FinishJob()` must be called after that;
+  // it processes the remaining batches, and waits for the workers.
+  // if there are no workers, or some job is already running, the whole
+  // job will be done in `FinishJob()`. only one job can be started.
+  static void StartJob (int count, int batchSize, BatchFn fn, void *udata);
+  static void FinishJob ();
+
+  // stop and join all worker threads
+  static void Shutdown () noexcept;
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// calls `VWorkPool::FinishJob()` on scope exit (including exceptions)
+class VWorkPoolJob {
+private:
+  bool active;
+
+public:
+  VV_DISABLE_COPY(VWorkPoolJob)
+  inline VWorkPoolJob (int count, int batchSize, VWorkPool::BatchFn fn, void *udata) : active(true) { VWorkPool::StartJob(count, batchSize, fn, udata); }
+  inline ~VWorkPoolJob () { Finish(); }
+  inline void Finish () { if (active) { active = false; VWorkPool::FinishJob(); } }
+};
@@ -0,0 +1,364 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  scoped zone profiler with chrome trace export
+//**
+//**************************************************************************
+#include "core.h"
+
+
+#define VZP_MAX_THREADS    (96)
+#define VZP_DEFAULT_RING   (1<<18)
+#define VZP_MIN_RING       (1<<10)
+#define VZP_MAX_RING       (1<<24)
+
+struct ZPEvent {
+  const char *cat;
+  const char *prefix;
+  const char *name;
+  vuint64 stime;
+  vuint64 etime;
+};
+
+
+// each thread owns one record; only the owner writes events
+struct ZPThread {
+  ZPEvent *events;
+  int size; // always power of 2
+  atomic_int head; // number of events written in this capture; published with "release"
+  atomic_int busy; // non-zero while the owner is writing an event
+  int tid; // index in `zpThreads`, plus one
+  bool used;
+  char name[32];
+};
+
+
+atomic_int VZoneProf::Mode = VZoneProf::Inactive;
+
+static ZPThread zpThreads[VZP_MAX_THREADS];
+static atomic_int zpThreadCount = 0; // number of initialised records
+static mythread_mutex zpLock; // protects thread registration
+static atomic_int zpLockInited = 0;
+
+static int zpRingSize = VZP_DEFAULT_RING;
+static int zpFramesLeft = 0; // main thread only
+static int zpCaptureMode = VZoneProf::Inactive;
+static bool zpComplete = false; // capture finished, and not written yet
+static vuint64 zpStartTime = 0;
+static vuint64 zpEndTime = 0;
+
+static __thread ZPThread *zpCurThread = nullptr;
+static __thread char zpCurThreadName[32] = {0};
+
+
+//==========================================================================
+//
+//  zpInitLock
+//
+//==========================================================================
+static void zpInitLock () noexcept {
+  if (atomic_get(&zpLockInited) == 2) return;
+  if (atomic_cmp_xchg(&zpLockInited, 0, 1) == 0) {
+    mythread_mutex_init(&zpLock);
+    atomic_store(&zpLockInited, 2);
+  } else {
+    while (atomic_get(&zpLockInited) != 2) Sys_YieldMicro(0);
+  }
+}
+
+
+//==========================================================================
+//
+//  zpRegisterThread
+//
+//  returns `nullptr` if there are no free records
+//
+//==========================================================================
+static ZPThread *zpRegisterThread () noexcept {
+  zpInitLock();
+  ZPThread *res = nullptr;
+  mythread_mutex_lock(&zpLock);
+  const int count = atomic_get(&zpThreadCount);
+  for (int f = 0; f < count; ++f) {
+    if (!zpThreads[f].used) { res = &zpThreads[f]; break; }
+  }
+  if (!res && count < VZP_MAX_THREADS) {
+    res = &zpThreads[count];
+    memset((void *)res, 0, sizeof(*res));
+    res->tid = count+1;
+    atomic_store(&zpThreadCount, count+1);
+  }
+  if (res) {
+    res->used = true;
+    if (zpCurThreadName[0]) {
+      strcpy(res->name, zpCurThreadName);
+    } else {
+      snprintf(res->name, sizeof(res->name), "thread #%d", res->tid);
+    }
+    // the capture cannot be started while we are holding the lock, so this is safe
+    if (!res->events || res->size != zpRingSize) {
+      Z_Free(res->events);
+      res->size = zpRingSize;
+      res->events = (ZPEvent *)Z_Malloc(res->size*(int)sizeof(ZPEvent));
+    }
+    atomic_store(&res->head, 0);
+  }
+  mythread_mutex_unlock(&zpLock);
+  return res;
+}
+
+
+//==========================================================================
+//
+//  zpWaitWriters
+//
+//  wait until all threads finished writing their current events
+//  `VZoneProf::Mode` should be already set to `Inactive`
+//
+//==========================================================================
+static void zpWaitWriters () noexcept {
+  const int count = atomic_get(&zpThreadCount);
+  for (int f = 0; f < count; ++f) {
+    while (atomic_get(&zpThreads[f].busy)) Sys_YieldMicro(0);
+  }
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::EndZone
+//
+//==========================================================================
+void VZoneProf::EndZone (const char *cat, const char *prefix, const char *name, vuint64 stime) noexcept {
+  const vuint64 etime = Sys_GetTimeNano();
+  ZPThread *th = zpCurThread;
+  if (!th) {
+    if (!IsActive()) return;
+    th = zpRegisterThread();
+    if (!th) return;
+    zpCurThread = th;
+  }
+  // the reader sets `Mode` first, and then checks `busy`; we are doing the opposite
+  atomic_store(&th->busy, 1);
+  if (atomic_get(&Mode) != Inactive && stime >= zpStartTime) {
+    const int head = __atomic_load_n(&th->head, __ATOMIC_RELAXED);
+    ZPEvent *ev = &th->events[head&(th->size-1)];
+    ev->cat = cat;
+    ev->prefix = prefix;
+    ev->name = (name ? name : "<unnamed>");
+    ev->stime = stime;
+    ev->etime = etime;
+    __atomic_store_n(&th->head, head+1, __ATOMIC_RELEASE);
+  }
+  atomic_store(&th->busy, 0);
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::SetThreadName
+//
+//==========================================================================
+void VZoneProf::SetThreadName (const char *name) noexcept {
+  if (!name) name = "";
+  snprintf(zpCurThreadName, sizeof(zpCurThreadName), "%s", name);
+  ZPThread *th = zpCurThread;
+  if (th) {
+    zpInitLock();
+    mythread_mutex_lock(&zpLock);
+    strcpy(th->name, zpCurThreadName);
+    mythread_mutex_unlock(&zpLock);
+  }
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::ReleaseThread
+//
+//==========================================================================
+void VZoneProf::ReleaseThread () noexcept {
+  ZPThread *th = zpCurThread;
+  if (!th) return;
+  zpCurThread = nullptr;
+  zpInitLock();
+  mythread_mutex_lock(&zpLock);
+  // keep the events, they may be still needed for the current capture;
+  // the new owner will reset the ring
+  th->used = false;
+  mythread_mutex_unlock(&zpLock);
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::StartCapture
+//
+//==========================================================================
+bool VZoneProf::StartCapture (int frames, bool vmcalls, int ringSize) noexcept {
+  if (IsCapturing()) return false;
+  if (ringSize <= 0) ringSize = VZP_DEFAULT_RING;
+  ringSize = clampval(ringSize, VZP_MIN_RING, VZP_MAX_RING);
+  // round up to power of 2
+  int rsz = VZP_MIN_RING;
+  while (rsz < ringSize) rsz <<= 1;
+
+  if (!zpCurThreadName[0]) SetThreadName("main");
+
+  zpInitLock();
+  mythread_mutex_lock(&zpLock);
+  zpWaitWriters();
+  zpRingSize = rsz;
+  const int count = atomic_get(&zpThreadCount);
+  for (int f = 0; f < count; ++f) {
+    ZPThread *th = &zpThreads[f];
+    if (th->used && th->size != zpRingSize) {
+      Z_Free(th->events);
+      th->size = zpRingSize;
+      th->events = (ZPEvent *)Z_Malloc(th->size*(int)sizeof(ZPEvent));
+    }
+    atomic_store(&th->head, 0);
+  }
+  zpFramesLeft = max2(1, frames)+1; // the current frame is not counted
+  zpComplete = false;
+  zpCaptureMode = (vmcalls ? ActiveVM : Active);
+  zpStartTime = Sys_GetTimeNano();
+  zpEndTime = zpStartTime;
+  atomic_store(&Mode, zpCaptureMode);
+  mythread_mutex_unlock(&zpLock);
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::StopCapture
+//
+//==========================================================================
+void VZoneProf::StopCapture () noexcept {
+  if (atomic_get(&Mode) != Inactive) {
+    atomic_store(&Mode, Inactive);
+    zpWaitWriters();
+  }
+  zpFramesLeft = 0;
+  zpComplete = false;
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::IsCapturing
+//
+//==========================================================================
+bool VZoneProf::IsCapturing () noexcept {
+  return (atomic_get(&Mode) != Inactive || zpComplete);
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::FrameMark
+//
+//==========================================================================
+bool VZoneProf::FrameMark () noexcept {
+  if (zpFramesLeft <= 0 || atomic_get(&Mode) == Inactive) return false;
+  if (--zpFramesLeft > 0) return false;
+  atomic_store(&Mode, Inactive);
+  zpWaitWriters();
+  zpEndTime = Sys_GetTimeNano();
+  zpComplete = true;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  zpWriteJsonStr
+//
+//==========================================================================
+static void zpWriteJsonStr (VStream *strm, const char *s) {
+  char buf[256];
+  size_t pos = 0;
+  for (; *s; ++s) {
+    if (pos >= sizeof(buf)-8) { strm->Serialise(buf, (int)pos); pos = 0; }
+    const vuint8 ch = (vuint8)*s;
+    if (ch == '"' || ch == '\\') {
+      buf[pos++] = '\\';
+      buf[pos++] = (char)ch;
+    } else if (ch < 32) {
+      pos += (size_t)snprintf(buf+pos, sizeof(buf)-pos, "\\u%04x", (unsigned)ch);
+    } else {
+      buf[pos++] = (char)ch;
+    }
+  }
+  if (pos) strm->Serialise(buf, (int)pos);
+}
+
+
+//==========================================================================
+//
+//  VZoneProf::WriteTrace
+//
+//==========================================================================
+int VZoneProf::WriteTrace (VStream *strm) {
+  if (!strm || !zpComplete) return 0;
+  zpComplete = false;
+
+  int total = 0, dropped = 0;
+  strm->writef("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  strm->writef("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"k8vavoom\"}}");
+
+  const int count = atomic_get(&zpThreadCount);
+  for (int f = 0; f < count; ++f) {
+    ZPThread *th = &zpThreads[f];
+    const int head = __atomic_load_n(&th->head, __ATOMIC_ACQUIRE);
+    if (head <= 0 || !th->events) continue;
+
+    strm->writef(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", th->tid);
+    zpWriteJsonStr(strm, th->name);
+    strm->writef("\"}}");
+
+    // if the ring wrapped, only the last `size` events are there
+    const int first = (head > th->size ? head-th->size : 0);
+    dropped += first;
+    for (int n = first; n < head; ++n) {
+      const ZPEvent *ev = &th->events[n&(th->size-1)];
+      if (ev->etime > zpEndTime) continue;
+      strm->writef(",\n{\"name\":\"");
+      if (ev->prefix) { zpWriteJsonStr(strm, ev->prefix); strm->writef("."); }
+      zpWriteJsonStr(strm, ev->name);
+      strm->writef("\",\"cat\":\"");
+      zpWriteJsonStr(strm, (ev->cat ? ev->cat : "zone"));
+      strm->writef("\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+        (double)(ev->stime-zpStartTime)/1000.0, (double)(ev->etime-ev->stime)/1000.0, th->tid);
+      ++total;
+    }
+  }
+
+  strm->writef("\n]}\n");
+  if (dropped) GLog.Logf(NAME_Warning, "zone profiler: %d old events were dropped (ring buffer is too small)", dropped);
+  return total;
+}
@@ -0,0 +1,114 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2010 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  scoped zone profiler with chrome trace export
+//**
+//**************************************************************************
+
+// zones are recorded only while the capture is running; otherwise entering
+// a zone costs one relaxed load. each thread writes finished zones to its
+// own ring buffer, so there are no locks on the hot path (the ring is
+// allocated when the thread records its first zone).
+//
+// zone names (and categories, and prefixes) are not copied, so they should
+// be string literals, or something else that lives forever (like `VName`
+// texts).
+//
+// the capture is started with `StartCapture()`, and stopped by `FrameMark()`
+// after the requested number of frames. then `WriteTrace()` can be used to
+// save the events as chrome trace json (it can be opened with perfetto,
+// or with "chrome://tracing").
+class VZoneProf {
+public:
+  enum {
+    Inactive = 0,
+    Active = 1, // record normal zones
+    ActiveVM = 2, // also record VM method calls
+  };
+
+  // current capture mode; should not be changed directly
+  static atomic_int Mode;
+
+public:
+  static VVA_FORCEINLINE bool IsActive () noexcept { return (__atomic_load_n(&Mode, __ATOMIC_RELAXED) != Inactive); }
+  static VVA_FORCEINLINE bool IsActiveVM () noexcept { return (__atomic_load_n(&Mode, __ATOMIC_RELAXED) >= ActiveVM); }
+
+  // record finished zone; `stime` is `Sys_GetTimeNano()` at the zone start
+  static void EndZone (const char *cat, const char *prefix, const char *name, vuint64 stime) noexcept;
+
+  // set name for the current thread (will be truncated to 31 chars)
+  // this can be called before the thread recorded any zones
+  static void SetThreadName (const char *name) noexcept;
+
+  // release thread ring buffer, so it can be reused by other threads
+  // should be called by the thread itself before exiting
+  static void ReleaseThread () noexcept;
+
+  // start capturing `frames` frames; `vmcalls` enables VM method zones
+  // the frame the capture was started in is not counted
+  // should be called from the main thread
+  // returns `false` if the capture is already running
+  static bool StartCapture (int frames, bool vmcalls=false, int ringSize=0) noexcept;
+
+  // abort the capture, if there is any
+  static void StopCapture () noexcept;
+
+  static bool IsCapturing () noexcept;
+
+  // should be called from the main thread at the end of each frame
+  // returns `true` if the capture is complete (and the trace can be written)
+  static bool FrameMark () noexcept;
+
+  // write captured events as chrome trace json
+  // returns number of written events
+  static int WriteTrace (VStream *strm);
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+class VZoneProfScope {
+private:
+  const char *cat;
+  const char *prefix;
+  const char *name;
+  vuint64 stime;
+
+public:
+  VV_DISABLE_COPY(VZoneProfScope)
+
+  VVA_FORCEINLINE VZoneProfScope (const char *acat, const char *aname) noexcept
+    : cat(acat), prefix(nullptr), name(aname), stime(VZoneProf::IsActive() ? Sys_GetTimeNano() : 0) {}
+  VVA_FORCEINLINE VZoneProfScope (const char *acat, const char *aprefix, const char *aname, bool enabled) noexcept
+    : cat(acat), prefix(aprefix), name(aname), stime(enabled ? Sys_GetTimeNano() : 0) {}
+  VVA_FORCEINLINE ~VZoneProfScope () noexcept { if (stime) VZoneProf::EndZone(cat, prefix, name, stime); }
+};
+
+
+#define VZP_CONCAT_INTR_(a_,b_)  a_##b_
+#define VZP_CONCAT_(a_,b_)  VZP_CONCAT_INTR_(a_, b_)
+
+// record the current scope as a zone
+#define VPROF_ZONE(cat_,name_)  VZoneProfScope VZP_CONCAT_(vzpscope_,__LINE__)((cat_), (name_))
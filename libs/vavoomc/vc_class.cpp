@@ -46,6 +46,8 @@ public:
 // ////////////////////////////////////////////////////////////////////////// //
 TArray<VName> VClass::GSpriteNames; // should be lowercase!
 TMapNC<VName, int> VClass::GSpriteNamesMap;
+bool VClass::HierarchyValid = false;
+vint32 VClass::StateLabelGen = 0;
 
 static TArray<mobjinfo_t> GMobjInfos;
 static TArray<mobjinfo_t> GScriptIds;
@@ -102,11 +104,14 @@ VClass::VClass (VName AName, VMemberBase *AOuter, const TLocation &ALoc)
   , ScriptIdExpr(nullptr)
   , Defined(true)
   , DefinedAsDependency(false)
+  , StateLabelMapGen(-1)
   , dfStateTexList()
   , dfStateTexDir()
   , dfStateTexDirSet(0)
   , ObjectFlags(0)
   , LinkNext(nullptr)
+  , HierFirst(0)
+  , HierLast(0)
   , ClassSize(0)
   , ClassUnalignedSize(0)
   , ClassFlags(0)
@@ -138,6 +143,7 @@ VClass::VClass (VName AName, VMemberBase *AOuter, const TLocation &ALoc)
   GClasses = this;
   ClassGameObjName = NAME_None;
   DecorateStateActionsBuilt = false;
+  StaticInvalidateHierarchy();
 }
 
 
@@ -159,8 +165,11 @@ VClass::VClass (ENativeConstructor, size_t ASize, vuint32 AClassFlags, VClass *A
   , ScriptIdExpr(nullptr)
   , Defined(true)
   , DefinedAsDependency(false)
-  , ObjectFlags(CLASSOF_Native)
+  , StateLabelMapGen(-1)
+  , ObjectFlags(CLASSOF_Native|(AClassFlags&CLASS_NativeReferences ? CLASSOF_NativeRefs : 0u))
   , LinkNext(nullptr)
+  , HierFirst(0)
+  , HierLast(0)
   , ClassSize(ASize)
   , ClassUnalignedSize(ASize)
   , ClassFlags(AClassFlags)
@@ -192,6 +201,7 @@ VClass::VClass (ENativeConstructor, size_t ASize, vuint32 AClassFlags, VClass *A
   GClasses = this;
   ClassGameObjName = NAME_None;
   DecorateStateActionsBuilt = false;
+  StaticInvalidateHierarchy();
 }
 
 
@@ -217,6 +227,8 @@ VClass::~VClass () {
 
   if (!GSystemInitialised || GSystemShuttingDown) return;
 
+  StaticInvalidateHierarchy();
+
   // unlink from classes list
   if (GClasses == this) {
     GClasses = LinkNext;
@@ -503,6 +515,81 @@ void VClass::StaticReinitStatesLookup () {
 }
 
 
+//==========================================================================
+//
+//  VClass::StaticRenumberHierarchy
+//
+//  assigns pre-order indicies to all classes; after this, `A` is a child
+//  of `B` if `A->HierFirst` is in `[B->HierFirst..B->HierLast]`
+//
+//==========================================================================
+void VClass::StaticRenumberHierarchy () {
+  if (HierarchyValid) return;
+
+  TArray<VClass *> list;
+  for (VClass *c = GClasses; c; c = c->LinkNext) {
+    c->HierFirst = list.length();
+    list.append(c);
+  }
+  const int count = list.length();
+  if (count == 0) return;
+
+  // build children lists
+  TArray<int> firstChild, nextSibling, order;
+  firstChild.setLength(count);
+  nextSibling.setLength(count);
+  for (int f = 0; f < count; ++f) firstChild[f] = nextSibling[f] = -1;
+  TArray<int> roots;
+  for (int f = count-1; f >= 0; --f) {
+    const VClass *parent = list[f]->ParentClass;
+    const int pidx = (parent ? parent->HierFirst : -1);
+    if (pidx >= 0 && pidx < count && list[pidx] == parent) {
+      nextSibling[f] = firstChild[pidx];
+      firstChild[pidx] = f;
+    } else {
+      roots.append(f);
+    }
+  }
+
+  // non-recursive dfs
+  order.setLength(count);
+  for (auto &&o : order) o = -1;
+  TArray<int> last;
+  last.setLength(count);
+  TArray<int> stack;
+  int counter = 0;
+  for (int ridx : roots) {
+    stack.append(ridx);
+    order[ridx] = counter++;
+    while (stack.length()) {
+      const int cidx = stack[stack.length()-1];
+      // next unvisited child; `firstChild` is used as a cursor here
+      const int child = firstChild[cidx];
+      if (child >= 0) {
+        firstChild[cidx] = nextSibling[child];
+        order[child] = counter++;
+        stack.append(child);
+      } else {
+        last[cidx] = counter-1;
+        stack.drop();
+      }
+    }
+  }
+
+  // classes in a parent loop are unreachable; this should not happen, but...
+  if (counter != count) {
+    GLog.Logf(NAME_Error, "VavoomC: cannot number class hierarchy (%d classes, %d numbered)", count, counter);
+    return;
+  }
+
+  for (int f = 0; f < count; ++f) {
+    list[f]->HierFirst = order[f];
+    list[f]->HierLast = last[f];
+  }
+  HierarchyValid = true;
+}
+
+
 //==========================================================================
 //
 //  VClass::Shutdown
@@ -522,6 +609,9 @@ void VClass::Shutdown () {
   RepInfos.Clear();
   SpriteEffects.Clear();
   StateLabels.Clear();
+  StateLabelMap.clear();
+  StateLabelCache.clear();
+  StaticInvalidateStateLabels();
   Structs.Clear();
   Constants.Clear();
   Properties.Clear();
@@ -948,13 +1038,73 @@ VState *VClass::FindStateChecked (VName AName) {
 }
 
 
+//==========================================================================
+//
+//  StateLabelKey
+//
+//==========================================================================
+static VVA_FORCEINLINE vuint64 StateLabelKey (VName lname, VName lsub) noexcept {
+  return ((vuint64)(vuint32)lname.GetIndex()<<32)|(vuint32)lsub.GetIndex();
+}
+
+
+//==========================================================================
+//
+//  VClass::BuildStateLabelMap
+//
+//  inherited labels are already copied to `StateLabels` by
+//  `EmitStateLabels()`, so we only need to index our own list
+//
+//==========================================================================
+void VClass::BuildStateLabelMap () {
+  StateLabelMap.reset();
+  StateLabelCache.reset();
+  for (auto &&lbl : StateLabels) {
+    if (lbl.Name == NAME_None) continue;
+    const VName lname = lbl.Name.GetLower();
+    // first label wins, as with the linear search
+    if (StateLabelMap.putNoReplace(StateLabelKey(lname, NAME_None), &lbl)) continue;
+    for (auto &&sub : lbl.SubLabels) {
+      if (sub.Name == NAME_None) continue;
+      StateLabelMap.putNoReplace(StateLabelKey(lname, sub.Name.GetLower()), &sub);
+    }
+  }
+  StateLabelMapGen = StateLabelGen;
+}
+
+
 //==========================================================================
 //
 //  VClass::FindStateLabel
 //
+//  results are cached per class, so repeated runtime lookups (`A_Jump`,
+//  `SetStateLabel`, pain/death states) don't do any string work
+//
 //==========================================================================
 VStateLabel *VClass::FindStateLabel (VName AName, VName SubLabel, bool Exact) {
   if (AName == NAME_None) return nullptr/*VState::GetNoJumpState()*/;
+
+  if (StateLabelMapGen != StateLabelGen) BuildStateLabelMap();
+  const vuint64 ckey = ((vuint64)(vuint32)AName.GetIndex()<<32)|((vuint64)(vuint32)SubLabel.GetIndex()<<1)|(Exact ? 1u : 0u);
+  VStateLabel **cached = StateLabelCache.get(ckey);
+  if (cached) return *cached;
+
+  VStateLabel *res = FindStateLabelNoCache(AName, SubLabel, Exact);
+  // resolving "Super::" or compound labels should not change anything, but let's be safe
+  if (StateLabelMapGen == StateLabelGen) {
+    if (StateLabelCache.length() >= 4096) StateLabelCache.reset();
+    StateLabelCache.put(ckey, res);
+  }
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VClass::FindStateLabelNoCache
+//
+//==========================================================================
+VStateLabel *VClass::FindStateLabelNoCache (VName AName, VName SubLabel, bool Exact) {
   if (IsNullStateName(*AName)) return nullptr/*VState::GetNoJumpState()*/;
 
   if (SubLabel == NAME_None) {
@@ -998,23 +1148,19 @@ VStateLabel *VClass::FindStateLabel (VName AName, VName SubLabel, bool Exact) {
     return FindStateLabel(names, Exact);
   }
 
-  for (int i = 0; i < StateLabels.length(); ++i) {
-    //fprintf(stderr, "%s:<%s>: i=%d; lname=%s\n", GetName(), *AName, i, *StateLabels[i].Name);
-    if (VStr::ICmp(*StateLabels[i].Name, *AName) == 0) {
-      if (SubLabel != NAME_None) {
-        TArray<VStateLabel> &SubList = StateLabels[i].SubLabels;
-        for (int j = 0; j < SubList.length(); ++j) {
-          if (VStr::ICmp(*SubList[j].Name, *SubLabel) == 0) return &SubList[j];
-        }
-        if (Exact /*&& VStr::ICmp(*SubLabel, "None") != 0*/) return nullptr; //k8:HACK! 'None' is nothing
-      }
-      //fprintf(stderr, "FOUND: %s:<%s>: i=%d; lname=%s (%s)\n", GetName(), *AName, i, *StateLabels[i].Name, *StateLabels[i].State->Loc.toStringNoCol());
-      return &StateLabels[i];
-    }
+  if (StateLabelMapGen != StateLabelGen) BuildStateLabelMap();
+  // all label names in the map are lowercased, so if there is no lowercased name, there is no label
+  const VName lname = AName.GetLowerNoCreate();
+  if (lname == NAME_None) return nullptr;
+  VStateLabel **lbl = StateLabelMap.get(StateLabelKey(lname, NAME_None));
+  if (!lbl) return nullptr;
+  if (SubLabel != NAME_None) {
+    const VName lsub = SubLabel.GetLowerNoCreate();
+    VStateLabel **sub = (lsub != NAME_None ? StateLabelMap.get(StateLabelKey(lname, lsub)) : nullptr);
+    if (sub) return *sub;
+    if (Exact /*&& VStr::ICmp(*SubLabel, "None") != 0*/) return nullptr; //k8:HACK! 'None' is nothing
   }
-
-  //if (AName == VName("Missile")) fprintf(stderr, "ERROR: '%s' state for '%s' not found! (parentclass=%s)\n", *AName, *GetFullName(), (ParentClass ? *ParentClass->GetFullName() : "<none>"));
-  return nullptr;
+  return *lbl;
 }
 
 
@@ -1026,15 +1172,27 @@ VStateLabel *VClass::FindStateLabel (VName AName, VName SubLabel, bool Exact) {
 VStateLabel *VClass::FindStateLabel (TArray<VName> &Names, bool Exact) {
   //if (Names.length() > 0 && (VStr::ICmp(*Names[0], "None") == 0 || VStr::ICmp(*Names[0], "Null") == 0)) return nullptr;
   if (Names.length() > 0 && IsNullStateName(*Names[0])) return nullptr/*VState::GetNoJumpState()*/;
-  TArray<VStateLabel> *List = &StateLabels;
+  if (StateLabelMapGen != StateLabelGen) BuildStateLabelMap();
   VStateLabel *Best = nullptr;
+  VName lname = NAME_None; // lowercased top-level label name
+  int depth = 0;
   for (int ni = 0; ni < Names.length(); ++ni) {
     if (Names[ni] == NAME_None) continue;
     VStateLabel *Lbl = nullptr;
-    for (int i = 0; i < List->Num(); ++i) {
-      if (VStr::ICmp(*(*List)[i].Name, *Names[ni]) == 0) {
-        Lbl = &(*List)[i];
-        break;
+    if (depth < 2) {
+      // first two levels are in the map
+      const VName ln = Names[ni].GetLowerNoCreate();
+      if (ln != NAME_None) {
+        VStateLabel **lp = StateLabelMap.get(depth == 0 ? StateLabelKey(ln, NAME_None) : StateLabelKey(lname, ln));
+        if (lp) Lbl = *lp;
+      }
+      if (depth == 0) lname = ln;
+    } else {
+      for (auto &&sub : Best->SubLabels) {
+        if (VStr::ICmp(*sub.Name, *Names[ni]) == 0) {
+          Lbl = &sub;
+          break;
+        }
       }
     }
     if (!Lbl) {
@@ -1042,7 +1200,7 @@ VStateLabel *VClass::FindStateLabel (TArray<VName> &Names, bool Exact) {
       break;
     } else {
       Best = Lbl;
-      List = &Lbl->SubLabels;
+      ++depth;
     }
   }
   return Best;
@@ -1252,6 +1410,7 @@ bool VClass::Define () {
 
   VClass *PrevParent = ParentClass;
   if (ParentClassName != NAME_None) {
+    StaticInvalidateHierarchy();
     ParentClass = StaticFindClass(ParentClassName);
     if (!ParentClass) {
       ParseError(ParentClassLoc, "No such class `%s`", *ParentClassName);
@@ -1885,6 +2044,7 @@ void VClass::DecorateEmit () {
 //
 //==========================================================================
 void VClass::EmitStateLabels () {
+  StaticInvalidateStateLabels();
   if (ParentClass && (ClassFlags&CLASS_SkipSuperStateLabels) == 0) {
     StateLabels = ParentClass->StateLabels;
   }
@@ -1982,6 +2142,7 @@ VState *VClass::ResolveStateLabel (const TLocation &Loc, VName LabelName, int Of
 //
 //==========================================================================
 void VClass::SetStateLabel (VName AName, VState *State) {
+  StaticInvalidateStateLabels();
   for (int i = 0; i < StateLabels.length(); ++i) {
     if (VStr::ICmp(*StateLabels[i].Name, *AName) == 0) {
       StateLabels[i].State = State;
@@ -2001,6 +2162,7 @@ void VClass::SetStateLabel (VName AName, VState *State) {
 //==========================================================================
 void VClass::SetStateLabel (const TArray<VName> &Names, VState *State) {
   if (!Names.length()) return;
+  StaticInvalidateStateLabels();
   TArray<VStateLabel> *List = &StateLabels;
   VStateLabel *Lbl = nullptr;
   for (int ni = 0; ni < Names.length(); ++ni) {
@@ -2329,6 +2491,35 @@ void VClass::InitReferences () {
         break;
     }
   }
+
+  InitGCReferences();
+}
+
+
+//==========================================================================
+//
+//  VClass::InitGCReferences
+//
+//  flatten reference list, so GC will not walk field list for each
+//  object, and mark classes without references
+//
+//==========================================================================
+void VClass::InitGCReferences () {
+  GCRefOffsets.reset();
+  GCComplexRefs.reset();
+  for (VField *F = ReferenceFields; F; F = F->NextReference) {
+    if (F->Type.Type == TYPE_Reference) {
+      GCRefOffsets.append(F->Ofs);
+    } else {
+      GCComplexRefs.append(F);
+    }
+  }
+
+  bool hasRefs = !!ReferenceFields;
+  for (VClass *c = this; c && !hasRefs; c = c->GetSuperClass()) {
+    if (c->ObjectFlags&CLASSOF_NativeRefs) hasRefs = true;
+  }
+  if (hasRefs) ObjectFlags &= ~CLASSOF_NoRefs; else ObjectFlags |= CLASSOF_NoRefs;
 }
 
 
@@ -2596,7 +2787,12 @@ void VClass::DeepCopyObject (vuint8 *Dst, const vuint8 *Src) {
 //==========================================================================
 void VClass::CleanObject (VObject *Obj) {
   if (Obj) {
-    for (VField *F = ReferenceFields; F; F = F->NextReference) VField::CleanField((vuint8 *)Obj+F->Ofs, F->Type);
+    vuint8 *data = (vuint8 *)Obj;
+    for (auto &&ofs : GCRefOffsets) {
+      VObject **ref = (VObject **)(data+ofs);
+      if (VObject::IsNonNullRefToCleanup(*ref)) *ref = nullptr;
+    }
+    for (auto &&F : GCComplexRefs) VField::CleanField(data+F->Ofs, F->Type);
   }
 }
 
@@ -2637,6 +2833,7 @@ VClass *VClass::CreateDerivedClass (VName AName, VMemberBase *AOuter, TArray<VDe
   }
   if (!NewClass) NewClass = new VClass(AName, AOuter, ALoc);
   NewClass->ParentClass = this;
+  StaticInvalidateHierarchy();
 
   if (uvlist.length()) {
     TArray<bool> ignores;
@@ -38,12 +38,16 @@ enum EClassFlags {
   // note that limiting is done by the main engine, VC does nothing with those flags
   //CLASS_LimitInstances        = 0x10000u, // limit number of instances of this class (this is not used)
   CLASS_LimitInstancesWithSub = 0x20000u, // limit number of instances of this class and all its subclasses
+  // native class keeps object references outside of VC fields (i.e. it overrides `ClearReferences()`)
+  CLASS_NativeReferences      = 0x40000u,
 };
 
 // flags describing a class instance
 enum EClassObjectFlags {
   CLASSOF_Native     = 0x00000001u, // native
   CLASSOF_PostLoaded = 0x00000002u, // `PostLoad()` has been called
+  CLASSOF_NativeRefs = 0x00000004u, // created with `CLASS_NativeReferences`
+  CLASSOF_NoRefs     = 0x00000008u, // instances cannot hold object references, so GC can skip them
 };
 
 
@@ -362,6 +366,16 @@ public:
   // contains both commands and autocompleters
   TMap<VStr, VMethod *> ConCmdListMts; // names are lowercased
 
+  // compiled state label lookup, rebuilt on demand (see `BuildStateLabelMap()`)
+  // keys are lowercased (label, sublabel) name indicies; sublabel is `NAME_None` for top-level labels
+  TMapNC<vuint64, VStateLabel *> StateLabelMap;
+  // cached `FindStateLabel()` results (including misses, "Super::" and compound labels)
+  TMapNC<vuint64, VStateLabel *> StateLabelCache;
+  vint32 StateLabelMapGen; // `StateLabelGen` the maps above were built for
+
+  // bumped on any state label change in any class; this invalidates all label lookup caches
+  static vint32 StateLabelGen;
+
   // new-style state options and textures
   TMap<VStr, TextureInfo> dfStateTexList;
   VStr dfStateTexDir;
@@ -371,6 +385,13 @@ public:
   vuint32 ObjectFlags; // private EClassObjectFlags used by object manager
   VClass *LinkNext; // next class in linked list
 
+  // class hierarchy numbering for O(1) `IsChildOf()`, see `StaticRenumberHierarchy()`
+  vint32 HierFirst; // pre-order index
+  vint32 HierLast; // last pre-order index in this class subtree
+
+  // reset when a class is created or destroyed, or when parent class is changed
+  static bool HierarchyValid;
+
   vint32 ClassSize;
   vint32 ClassUnalignedSize;
   vuint32 ClassFlags; // EClassFlags
@@ -380,6 +401,9 @@ public:
   vint32 ClassNumMethods;
 
   VField *ReferenceFields;
+  // `ReferenceFields` flattened for the garbage collector
+  TArray<vint32> GCRefOffsets; // plain object references
+  TArray<VField *> GCComplexRefs; // delegates, structs, arrays, dictionaries
   VField *DestructorFields;
   VField *NetFields;
   VMethod *NetMethods;
@@ -539,6 +563,12 @@ public:
   VStateLabel *FindStateLabel (VName AName, VName SubLabel=NAME_None, bool Exact=false);
   VStateLabel *FindStateLabel (TArray<VName> &Names, bool Exact);
 
+protected:
+  // `FindStateLabel()` without result caching
+  VStateLabel *FindStateLabelNoCache (VName AName, VName SubLabel, bool Exact);
+
+public:
+
   VMethod *FindDecorateStateActionExact (VStr actname); // but case-insensitive
   VMethod *FindDecorateStateAction (VStr actname);
   VName FindDecorateStateFieldTrans (VName dcname);
@@ -574,15 +604,28 @@ public:
 
   void EmitStateLabels ();
 
+  static inline void StaticInvalidateStateLabels () noexcept { ++StateLabelGen; }
+  // builds `StateLabelMap`, and resets `StateLabelCache`
+  void BuildStateLabelMap ();
+
   VState *ResolveStateLabel (const TLocation &, VName, int);
   void SetStateLabel (VName, VState *);
   void SetStateLabel (const TArray<VName> &, VState *);
 
   inline bool IsChildOf (const VClass *SomeBaseClass) const noexcept {
+    if (HierarchyValid) {
+      return (SomeBaseClass && (vuint32)(HierFirst-SomeBaseClass->HierFirst) <= (vuint32)(SomeBaseClass->HierLast-SomeBaseClass->HierFirst));
+    }
     for (const VClass *c = this; c; c = c->GetSuperClass()) if (SomeBaseClass == c) return true;
     return false;
   }
 
+  // this should be called after any hierarchy change (new classes, `ParentClass` assignments)
+  static inline void StaticInvalidateHierarchy () noexcept { HierarchyValid = false; }
+  // assigns pre-order interval numbers to all classes, so `IsChildOf()` becomes a range check
+  // should be called when class loading is complete; does nothing if the numbering is still valid
+  static void StaticRenumberHierarchy ();
+
   inline bool IsChildOfByName (VName name) const noexcept {
     if (name == NAME_None) return false;
     for (const VClass *c = this; c; c = c->GetSuperClass()) {
@@ -697,6 +740,7 @@ private:
   void CalcFieldOffsets ();
   void InitNetFields ();
   void InitReferences ();
+  void InitGCReferences (); // called from `InitReferences()`
   void InitDestructorFields ();
   void CreateVTable ();
   void CreateMethodMap (); // called from `CreateVTable()`
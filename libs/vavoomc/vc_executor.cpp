@@ -420,12 +420,30 @@ static inline VCvar *GetRTCVar (const vuint8 *ip, int nameidx, bool allownull=fa
 static char runerrmsgbuf[1024]; // sorry!
 
 
+static void RunFunctionBody (VMethod *func);
+static VVA_NOINLINE void RunFunctionZoned (VMethod *func);
+
+
 //==========================================================================
 //
 //  RunFunction
 //
+//  VM method zones are recorded only in "vm" capture mode; when there is
+//  no such capture, this is one relaxed load and a branch (there is no
+//  scope object to destroy on the normal path)
+//
+//==========================================================================
+static VVA_FORCEINLINE void RunFunction (VMethod *func) {
+  if (VZoneProf::IsActiveVM()) RunFunctionZoned(func); else RunFunctionBody(func);
+}
+
+
+//==========================================================================
+//
+//  RunFunctionBody
+//
 //==========================================================================
-static void RunFunction (VMethod *func) {
+static void RunFunctionBody (VMethod *func) {
 #if USE_COMPUTED_GOTO
     static const void *vm_labels[] = {
 # define DECLARE_OPC(name, args) &&Lbl_OPC_ ## name
@@ -523,6 +541,73 @@ static void RunFunction (VMethod *func) {
 
   const vuint8 *origip = nullptr;
 
+  // hot methods are compiled to native code
+  // native code returns to us for each call, and on any error (so the interpreter can report it)
+  if (VMethod::jitEnabled) {
+    if (!func->jitCode && func->jitState == VMethod::JIT_None && ++func->jitCallCount >= (vuint32)VMethod::jitThreshold) {
+      (void)func->JitCompile();
+    }
+    if (func->jitCode) {
+      const VMJitCode *jc = func->jitCode;
+      const vuint8 *resume = nullptr;
+      for (;;) {
+        const vuint64 ecode = jc->entry(local_vars, resume);
+        const unsigned ekind = (unsigned)(ecode&0x0fu);
+        if (ekind == VMethod::JIT_Exit_Return) {
+          VObject::pr_stackPtr = local_vars;
+          cstPop();
+          return;
+        }
+        if (ekind == VMethod::JIT_Exit_ReturnL) {
+          VObject::pr_stackPtr = local_vars+1;
+          cstPop();
+          return;
+        }
+        if (ekind == VMethod::JIT_Exit_ReturnV) {
+          VObject::pr_stackPtr = local_vars+3;
+          cstPop();
+          return;
+        }
+        const VMJitSite *site = &jc->sites[(unsigned)(ecode>>4)];
+        ip = func->vmCodeStart+site->ofs;
+        sp = local_vars+func->NumLocals+site->depth;
+        // bailout: continue in the interpreter
+        if (ekind != VMethod::JIT_Exit_Call) break;
+        // perform the call exactly as the interpreter does
+        VMethod *callee;
+        VObject::pr_stackPtr = sp;
+        if (*ip == OPC_Call) {
+          #ifdef CHECK_STACK_OVERFLOW_RT
+          if (sp >= &pr_stack[MAX_PROG_STACK-4]) {
+            cstDump(ip);
+            VPackage::InternalFatalError(va("ExecuteFunction: Stack overflow in `%s`", *func->GetFullName()));
+          }
+          #endif
+          callee = (VMethod *)ReadPtr(ip+1);
+          cstFixTopIPSP(ip);
+          ip += 1+sizeof(void *);
+        } else if (*ip == OPC_VCall) {
+          if (!sp[-ip[3]].p) { cstDump(ip); VPackage::InternalFatalError("Reference not set to an instance of an object"); }
+          callee = ((VObject *)sp[-ip[3]].p)->GetVFunctionIdx(ReadInt16(ip+1));
+          cstFixTopIPSP(ip);
+          ip += 4;
+        } else {
+          if (!sp[-ip[2]].p) { cstDump(ip); VPackage::InternalFatalError("Reference not set to an instance of an object"); }
+          callee = ((VObject *)sp[-ip[2]].p)->GetVFunctionIdx(ip[1]);
+          cstFixTopIPSP(ip);
+          ip += 3;
+        }
+        if (profOnlyFunc) mprof.timer.stop();
+        RunFunction(callee);
+        if (profOnlyFunc) mprof.timer.start();
+        sp = VObject::pr_stackPtr;
+        // resume native code if the stack is what we expected
+        if (site->resumeDepth < 0 || sp != local_vars+func->NumLocals+site->resumeDepth) break;
+        resume = jc->code+site->resumeOfs;
+      }
+    }
+  }
+
 #ifdef VCC_STUPID_TRACER_EXTRADUMP
   #if 1
   fprintf(stderr, "**** VM OPCODES: 0x%08x (%u) ****\n", (unsigned)func->vmCodeStart, func->vmCodeSize);
@@ -1408,11 +1493,13 @@ func_loop:
 
       PR_VM_CASE(OPC_Divide)
         if (!sp[-1].i) { cstDump(ip); VPackage::InternalFatalError("Division by 0"); }
+        if (sp[-1].i == -1 && sp[-2].i == MIN_VINT32) { cstDump(ip); VPackage::InternalFatalError("Integer overflow in division"); }
         BINOP_Q(i, /=);
         PR_VM_BREAK;
 
       PR_VM_CASE(OPC_Modulus)
         if (!sp[-1].i) { cstDump(ip); VPackage::InternalFatalError("Division by 0"); }
+        if (sp[-1].i == -1 && sp[-2].i == MIN_VINT32) { cstDump(ip); VPackage::InternalFatalError("Integer overflow in division"); }
         BINOP_Q(i, %=);
         PR_VM_BREAK;
 
@@ -1562,11 +1649,13 @@ func_loop:
 
       PR_VM_CASE(OPC_DivVarDrop)
         if (!sp[-1].i) { cstDump(ip); VPackage::InternalFatalError("Division by 0"); }
+        if (sp[-1].i == -1 && *(const vint32 *)sp[-2].p == MIN_VINT32) { cstDump(ip); VPackage::InternalFatalError("Integer overflow in division"); }
         ASSIGNOP(vint32, i, /=);
         PR_VM_BREAK;
 
       PR_VM_CASE(OPC_ModVarDrop)
         if (!sp[-1].i) { cstDump(ip); VPackage::InternalFatalError("Division by 0"); }
+        if (sp[-1].i == -1 && *(const vint32 *)sp[-2].p == MIN_VINT32) { cstDump(ip); VPackage::InternalFatalError("Integer overflow in division"); }
         ASSIGNOP(vint32, i, %=);
         PR_VM_BREAK;
 
@@ -2740,6 +2829,20 @@ func_loop:
 }
 
 
+//==========================================================================
+//
+//  RunFunctionZoned
+//
+//  records the call as "vm" zone; class and method names are `VName`s,
+//  so they will not go away
+//
+//==========================================================================
+static VVA_NOINLINE void RunFunctionZoned (VMethod *func) {
+  VZoneProfScope zprof("vm", (func && func->Outer ? *func->Outer->Name : nullptr), (func ? *func->Name : nullptr), !!func);
+  RunFunctionBody(func);
+}
+
+
 struct CurrFuncHolder {
   VMethod **place;
   VMethod *prevfunc;
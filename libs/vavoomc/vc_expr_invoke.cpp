@@ -2687,6 +2687,8 @@ VExpression *VInvocation::OptimizeBuiltin (VEmitContext &ec) {
       e = new VFloatLiteral(smoothstepPerlin(Args[0]->GetFloatConst(), Args[1]->GetFloatConst(), Args[2]->GetFloatConst()), Loc);
       break;
     case OPC_Builtin_NameToIIndex:
+      // name indicies are not stable between runs, so don't put them into cached code
+      if (VPackage::IsProgsCacheActive()) return this;
       if (!CheckSimpleConstArgs(1, (const int []){TYPE_Name})) return this;
       e = new VIntLiteral(Args[0]->GetNameConst().GetIndex(), Loc);
       break;
@@ -3060,7 +3062,9 @@ void VInvocation::Emit (VEmitContext &ec) {
 
   // some special functions will be converted to builtins
   if (builtIn >= 0) {
-    ec.AddBuiltin(builtIn, Loc);
+    // `NameToIIndex()` does nothing at runtime (names are pushed as their indicies), so don't emit it;
+    // this way, code with a name literal is as fast as the folded version, even if it was not folded
+    if (builtIn != OPC_Builtin_NameToIIndex) ec.AddBuiltin(builtIn, Loc);
   } else if (DirectCall) {
     ec.AddStatement(OPC_Call, Func, SelfOffset, Loc);
   } else if (DelegateField) {
@@ -667,13 +667,13 @@ bool VField::CleanField (vuint8 *Data, const VFieldType &Type) {
   bool res = false;
   switch (Type.Type) {
     case TYPE_Reference:
-      if (*(VObject **)Data && (*(VObject **)Data)->IsRefToCleanup()) {
+      if (VObject::IsNonNullRefToCleanup(*(VObject **)Data)) {
         *(VObject **)Data = nullptr;
         res = true;
       }
       break;
     case TYPE_Delegate:
-      if (((VObjectDelegate *)Data)->Obj && ((VObjectDelegate *)Data)->Obj->IsRefToCleanup()) {
+      if (VObject::IsNonNullRefToCleanup(((VObjectDelegate *)Data)->Obj)) {
         ((VObjectDelegate *)Data)->Obj = nullptr;
         ((VObjectDelegate *)Data)->Func = nullptr;
         res = true;
@@ -283,6 +283,7 @@ VStream *VLexer::doOpenFile (VStr filename) {
 //
 //==========================================================================
 void VLexer::OpenSource (VStr FileName) {
+  VPackage::ProgsCacheAddDefines(defines);
   // read file and prepare for compilation
   PushSource(FileName);
   sourceOpen = true;
@@ -296,6 +297,7 @@ void VLexer::OpenSource (VStr FileName) {
 //
 //==========================================================================
 void VLexer::OpenSource (VStream *astream, VStr FileName) {
+  VPackage::ProgsCacheAddDefines(defines);
   // read file and prepare for compilation
   PushSource(astream, FileName);
   sourceOpen = true;
@@ -349,6 +351,7 @@ void VLexer::PushSource (VStream *Strm, VStr FileName) {
   VStream::Destroy(Strm);
 
   totalSize += FileSize;
+  VPackage::ProgsCacheAddSource(FileName, NewSrc->FileStart, FileSize);
 
   NewSrc->FileStart[FileSize] = 0; // this is not really required, but let's make the whole buffer initialized
   NewSrc->FileEnd = NewSrc->FileStart+FileSize;
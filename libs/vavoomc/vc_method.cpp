@@ -522,7 +522,10 @@ VMethod::VMethod (VName AName, VMemberBase *AOuter, TLocation ALoc)
   , SelfTypeClass(nullptr)
   , defineResult(-1)
   , emitCalled(false)
-  , jited(false)
+  , jitCode(nullptr)
+  , jitCallCount(0)
+  , jitState(JIT_None)
+  , jitCallDelta(nullptr)
 {
   memset(ParamFlags, 0, sizeof(ParamFlags));
 }
@@ -536,6 +539,9 @@ VMethod::VMethod (VName AName, VMemberBase *AOuter, TLocation ALoc)
 VMethod::~VMethod() {
   delete ReturnTypeExpr; ReturnTypeExpr = nullptr;
   delete Statement; Statement = nullptr;
+  // native code itself lives in the JIT chunk pool, and is never freed
+  if (jitCode) { Z_Free(jitCode); jitCode = nullptr; }
+  if (jitCallDelta) { Z_Free(jitCallDelta); jitCallDelta = nullptr; }
 }
 
 
@@ -977,6 +983,10 @@ void VMethod::Emit () {
   //fprintf(stderr, "*** EMIT000: <%s> (%s); ParamsSize=%d; NumLocals=%d; NumParams=%d\n", *GetFullName(), *Loc.toStringNoCol(), ParamsSize, NumLocals, NumParams);
 
   VEmitContext ec(this);
+
+  // optimised IR can be taken from the persistent progs cache
+  if (VPackage::ProgsCacheRestoreMethod(this)) return;
+
   if (Flags&FUNC_NoVCalls) ec.VCallsDisabled = true;
 
   ec.ClearLocalDefs();
@@ -1072,6 +1082,7 @@ void VMethod::Emit () {
   else if (VObject::cliAsmDumpMethods.has(VStr(Name))) DumpAsm();
 
   OptimizeInstructions();
+  VPackage::ProgsCacheEmitMethodDone(this);
 
   // and dump it again for optimized case
        if (VMemberBase::doAsmDump) DumpAsm();
@@ -144,6 +144,35 @@ struct FInstruction {
 };
 
 
+//==========================================================================
+//
+//  VMJitCode
+//
+//  native code for a method, produced by the JIT (see "vc_method_jit.cpp")
+//  native code uses exactly the same stack layout as the interpreter, so
+//  execution can be transferred to the interpreter at any "site"
+//
+//==========================================================================
+struct VMJitSite {
+  vuint32 ofs; // bytecode offset of the instruction this exit belongs to
+  vint32 depth; // VM stack depth (over locals) before the instruction
+  vint32 resumeDepth; // for calls: expected VM stack depth after the call
+  vuint32 resumeOfs; // for calls: native code offset to continue at after the call
+};
+
+struct VMJitCode {
+  // `resume` is `nullptr` to start from the beginning
+  // result is `(siteindex<<4)|exitcode` (see `VMethod::JIT_Exit_XXX`)
+  typedef vuint64 (*EntryFn) (VStack *localVars, const vuint8 *resume);
+
+  EntryFn entry;
+  vuint8 *code;
+  vuint32 codeSize;
+  vuint32 siteCount;
+  VMJitSite *sites; // allocated in the same memory block
+};
+
+
 //==========================================================================
 //
 //  VMethodParam
@@ -237,14 +266,47 @@ public:
   int defineResult; // -1: not called yet; 0: error; 1: ok; 666: ok, don't show warning
   bool emitCalled;
 
+public:
+  enum {
+    JIT_None, // not compiled yet
+    JIT_Compiled,
+    JIT_Rejected, // cannot be compiled, always interpret
+  };
+
+  // native code exit codes
+  enum {
+    JIT_Exit_Return = 1,
+    JIT_Exit_ReturnL = 2,
+    JIT_Exit_ReturnV = 3,
+    JIT_Exit_Bail = 4, // continue in the interpreter
+    JIT_Exit_Call = 5, // perform the call, then resume native code
+  };
+
+  static int jitEnabled; // default is true (if JIT is supported on this platform)
+  static int jitThreshold; // compile method after this number of calls
+  static int jitCompiledCount; // number of successfully compiled methods
+  static int jitRejectedCount; // number of methods rejected by the JIT
+
+  VMJitCode *jitCode; // non-nullptr if the method was compiled
+  vuint32 jitCallCount;
+  vuint8 jitState; // JIT_XXX
+  // VM stack delta for each call site, in code order; built in `CompileToNativeCode()`
+  vint16 *jitCallDelta;
+
 protected:
-  bool jited;
   #ifdef USE_LIBJIT
   static /*jit_context_t*/void *jitc;
   #endif
 
+  // called from `GenerateCode()`, while the IR is still available
+  // this checks if the method can be compiled by the JIT at all
   void CompileToNativeCode ();
 
+public:
+  // called by the VM when `jitCallCount` reaches `jitThreshold`
+  // returns `true` if `jitCode` is ready
+  bool JitCompile ();
+
 public:
   static unsigned GetCodePoolCount () noexcept;
   static size_t GetTotalCodePoolSize () noexcept;
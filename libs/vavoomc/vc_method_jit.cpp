@@ -2,6 +2,17 @@
 //
 // JIT compiler
 //
+// this is simple template JIT for x86-64. it translates the VM bytecode of
+// hot methods to native code, one opcode at a time. native code keeps the
+// VM stack exactly as the interpreter does (all stack slots are at fixed
+// offsets from `local_vars`, as the stack depth is known for each
+// instruction), so it can transfer execution to the interpreter at any
+// instruction. this is used for calls (native code never calls anything,
+// so C++ exceptions never have to unwind through generated code), and for
+// all rare paths (null pointers, division by zero, bad conversions, etc.).
+//
+// methods with opcodes we don't know how to translate are never compiled.
+//
 //**************************************************************************
 #if 1 && defined(USE_LIBJIT)
 # undef USE_LIBJIT
@@ -10,5 +21,1423 @@
 #ifdef USE_LIBJIT
 # include "vc_method_jit_real.cpp"
 #else
-void VMethod::CompileToNativeCode () {}
+
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(__CYGWIN__)
+# define VC_JIT_X86_64
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+
+int VMethod::jitEnabled = 1;
+int VMethod::jitThreshold = 64;
+int VMethod::jitCompiledCount = 0;
+int VMethod::jitRejectedCount = 0;
+
+
+//==========================================================================
+//
+//  vmJitIsSupportedOpcode
+//
+//  checks opcodes, both in IR and in bytecode
+//
+//==========================================================================
+static bool vmJitIsSupportedOpcode (int opc) noexcept {
+  switch (opc) {
+    case OPC_Call: case OPC_VCall: case OPC_VCallB:
+    case OPC_Return: case OPC_ReturnL: case OPC_ReturnV:
+    case OPC_GotoB: case OPC_GotoNB: case OPC_Goto:
+    case OPC_IfGotoB: case OPC_IfGotoNB: case OPC_IfGoto:
+    case OPC_IfNotGotoB: case OPC_IfNotGotoNB: case OPC_IfNotGoto:
+    case OPC_CaseGotoB: case OPC_CaseGoto: case OPC_CaseGotoN:
+    case OPC_PushNumber0: case OPC_PushNumber1: case OPC_PushNumberB: case OPC_PushNumber:
+    case OPC_PushName: case OPC_PushNameS: case OPC_PushClassId: case OPC_PushFunc: case OPC_PushNull:
+    case OPC_LocalAddress0: case OPC_LocalAddress1: case OPC_LocalAddress2: case OPC_LocalAddress3:
+    case OPC_LocalAddress4: case OPC_LocalAddress5: case OPC_LocalAddress6: case OPC_LocalAddress7:
+    case OPC_LocalAddressB: case OPC_LocalAddressS: case OPC_LocalAddress:
+    case OPC_LocalValue0: case OPC_LocalValue1: case OPC_LocalValue2: case OPC_LocalValue3:
+    case OPC_LocalValue4: case OPC_LocalValue5: case OPC_LocalValue6: case OPC_LocalValue7:
+    case OPC_LocalValueB: case OPC_VLocalValueB:
+    case OPC_Offset: case OPC_OffsetS:
+    case OPC_FieldValue: case OPC_FieldValueS:
+    case OPC_VFieldValue: case OPC_VFieldValueS:
+    case OPC_PtrFieldValue: case OPC_PtrFieldValueS:
+    case OPC_ByteFieldValue: case OPC_ByteFieldValueS:
+    case OPC_Bool0FieldValue: case OPC_Bool0FieldValueS:
+    case OPC_Bool1FieldValue: case OPC_Bool1FieldValueS:
+    case OPC_Bool2FieldValue: case OPC_Bool2FieldValueS:
+    case OPC_Bool3FieldValue: case OPC_Bool3FieldValueS:
+    case OPC_CheckArrayBounds: case OPC_ArrayElement: case OPC_ArrayElementB:
+    case OPC_PushPointed: case OPC_VPushPointed: case OPC_PushPointedPtr: case OPC_PushPointedByte:
+    case OPC_PushBool0: case OPC_PushBool1: case OPC_PushBool2: case OPC_PushBool3:
+    case OPC_Add: case OPC_Subtract: case OPC_Multiply: case OPC_Divide: case OPC_Modulus:
+    case OPC_Equals: case OPC_NotEquals: case OPC_Less: case OPC_Greater: case OPC_LessEquals: case OPC_GreaterEquals:
+    case OPC_NegateLogical:
+    case OPC_AndBitwise: case OPC_OrBitwise: case OPC_XOrBitwise:
+    case OPC_LShift: case OPC_RShift: case OPC_URShift:
+    case OPC_UnaryMinus: case OPC_BitInverse:
+    case OPC_PreInc: case OPC_PreDec: case OPC_PostInc: case OPC_PostDec: case OPC_IncDrop: case OPC_DecDrop:
+    case OPC_AssignDrop: case OPC_AddVarDrop: case OPC_SubVarDrop: case OPC_MulVarDrop:
+    case OPC_DivVarDrop: case OPC_ModVarDrop: case OPC_AndVarDrop: case OPC_OrVarDrop: case OPC_XOrVarDrop:
+    case OPC_LShiftVarDrop: case OPC_RShiftVarDrop: case OPC_URShiftVarDrop:
+    case OPC_ByteIncDrop: case OPC_ByteDecDrop: case OPC_ByteAssignDrop:
+    case OPC_FAdd: case OPC_FSubtract: case OPC_FMultiply: case OPC_FDivide:
+    case OPC_FEquals: case OPC_FNotEquals: case OPC_FLess: case OPC_FGreater: case OPC_FLessEquals: case OPC_FGreaterEquals:
+    case OPC_FUnaryMinus:
+    case OPC_FAddVarDrop: case OPC_FSubVarDrop: case OPC_FMulVarDrop: case OPC_FDivVarDrop:
+    case OPC_VAdd: case OPC_VSubtract: case OPC_VEquals: case OPC_VNotEquals: case OPC_VUnaryMinus:
+    case OPC_VFixVecParam: case OPC_VectorDirect:
+    case OPC_VPreScale: case OPC_VPostScale:
+    case OPC_VAssignDrop: case OPC_VAddVarDrop: case OPC_VSubVarDrop:
+    case OPC_FloatToBool:
+    case OPC_PtrEquals: case OPC_PtrNotEquals: case OPC_PtrToBool:
+    case OPC_IntToFloat: case OPC_FloatToInt:
+    case OPC_Drop: case OPC_VDrop: case OPC_DupPOD: case OPC_DropPOD:
+    case OPC_AssignPtrDrop:
+    case OPC_AssignBool0: case OPC_AssignBool1: case OPC_AssignBool2: case OPC_AssignBool3:
+      return true;
+  }
+  return false;
+}
+
+
+//==========================================================================
+//
+//  vmJitInsnLength
+//
+//  returns bytecode instruction length for supported opcodes, or 0
+//
+//==========================================================================
+static int vmJitInsnLength (const vuint8 *ip) noexcept {
+  if (!vmJitIsSupportedOpcode(*ip)) return 0;
+  switch (StatementInfo[*ip].Args) {
+    case OPCARGS_None: return 1;
+    case OPCARGS_Member: return 1+(int)sizeof(void *);
+    case OPCARGS_Member_Int: return 1+(int)sizeof(void *); // int is not emited
+    case OPCARGS_BranchTargetB: return 2;
+    case OPCARGS_BranchTargetNB: return 2;
+    case OPCARGS_BranchTarget: return 5;
+    case OPCARGS_ByteBranchTarget: return 1+1+2;
+    case OPCARGS_IntBranchTarget: return 1+4+2;
+    case OPCARGS_NameBranchTarget: return 1+4+2;
+    case OPCARGS_Byte: return 2;
+    case OPCARGS_Short: return 3;
+    case OPCARGS_Int: return 5;
+    case OPCARGS_Name: return 5;
+    case OPCARGS_NameS: return 3;
+    case OPCARGS_FieldOffset: return 5;
+    case OPCARGS_FieldOffsetS: return 3;
+    case OPCARGS_FieldOffset_Byte: return 6;
+    case OPCARGS_FieldOffsetS_Byte: return 4;
+    case OPCARGS_VTableIndex_Byte: return 4;
+    case OPCARGS_VTableIndexB_Byte: return 3;
+    case OPCARGS_TypeSize: return 5;
+    case OPCARGS_TypeSizeB: return 2;
+  }
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  VMethod::CompileToNativeCode
+//
+//  we cannot compile the method here, because we don't know yet if it is
+//  hot. but we still have the IR, so reject methods with unsupported
+//  opcodes right away, and remember stack deltas for call sites (virtual
+//  calls don't have this info in the bytecode).
+//
+//==========================================================================
+void VMethod::CompileToNativeCode () {
+  #ifdef VC_JIT_X86_64
+  if (jitState != JIT_None) return;
+  if (!vmCodeStart || (Flags&FUNC_Native) != 0) { jitState = JIT_Rejected; return; }
+  int callCount = 0;
+  for (int i = 0; i < Instructions.length()-1; ++i) {
+    const FInstruction &insn = Instructions[i];
+    if (!vmJitIsSupportedOpcode(insn.Opcode)) { jitState = JIT_Rejected; return; }
+    if (insn.Opcode == OPC_Call || insn.Opcode == OPC_VCall || insn.Opcode == OPC_VCallB) {
+      // we don't know how many arguments varargs methods will take
+      if (!insn.Member || ((VMethod *)insn.Member)->IsVarArgs()) { jitState = JIT_Rejected; return; }
+      ++callCount;
+    }
+  }
+  if (callCount) {
+    jitCallDelta = (vint16 *)Z_Malloc(callCount*sizeof(jitCallDelta[0]));
+    int cidx = 0;
+    for (int i = 0; i < Instructions.length()-1; ++i) {
+      const FInstruction &insn = Instructions[i];
+      if (insn.Opcode == OPC_Call || insn.Opcode == OPC_VCall || insn.Opcode == OPC_VCallB) {
+        // the same as in the optimiser
+        const VMethod *mt = (const VMethod *)insn.Member;
+        int delta = -insn.Arg2+mt->ReturnType.GetStackSize();
+        if (mt->Flags&FUNC_Static) delta += 1;
+        jitCallDelta[cidx++] = (vint16)delta;
+      }
+    }
+  }
+  #else
+  jitState = JIT_Rejected;
+  #endif
+}
+
+
+#ifdef VC_JIT_X86_64
+// ////////////////////////////////////////////////////////////////////////// //
+// executable memory pool
+// each method gets its own pages, which were never executable before, and
+// only those pages are switched to RW and back to RX. other threads may be
+// running native code from the same chunk while we're compiling, so the
+// pages with already published code must stay RX all the time.
+#define VM_JIT_CHUNK_SIZE  (1024*256)
+
+struct VMJitChunk {
+  vuint8 *mem;
+  size_t used; // always page-aligned
+  size_t size;
+};
+
+static TArray<VMJitChunk> vmJitChunks;
+static size_t vmJitPageSize = 0;
+
+
+//==========================================================================
+//
+//  vmJitPutCode
+//
+//  returns `nullptr` on error
+//
+//==========================================================================
+static vuint8 *vmJitPutCode (const vuint8 *code, size_t len) {
+  if (!len || len > VM_JIT_CHUNK_SIZE) return nullptr;
+  if (!vmJitPageSize) {
+    const long psz = sysconf(_SC_PAGESIZE);
+    vmJitPageSize = (psz > 0 && VM_JIT_CHUNK_SIZE%psz == 0 ? (size_t)psz : 4096u);
+  }
+  const size_t alen = (len+vmJitPageSize-1)&~(vmJitPageSize-1);
+  if (alen > VM_JIT_CHUNK_SIZE) return nullptr;
+  VMJitChunk *ck = (vmJitChunks.length() ? &vmJitChunks[vmJitChunks.length()-1] : nullptr);
+  if (!ck || ck->size-ck->used < alen) {
+    void *mem = mmap(nullptr, VM_JIT_CHUNK_SIZE, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    ck = &vmJitChunks.alloc();
+    ck->mem = (vuint8 *)mem;
+    ck->used = 0;
+    ck->size = VM_JIT_CHUNK_SIZE;
+  }
+  vuint8 *res = ck->mem+ck->used;
+  // the pages are consumed even on error, so they will never be reused
+  ck->used += alen;
+  if (mprotect(res, alen, PROT_READ|PROT_WRITE) != 0) return nullptr;
+  memcpy(res, code, len);
+  // fill the rest of the page with `int3`
+  memset(res+len, 0xcc, alen-len);
+  if (mprotect(res, alen, PROT_READ|PROT_EXEC) != 0) return nullptr;
+  return res;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// x86-64 registers we are using
+enum {
+  JR_EAX = 0,
+  JR_ECX = 1,
+  JR_EDX = 2,
+  JR_ESI = 6,
+  JR_EDI = 7, // always holds `local_vars`
+};
+
+// condition codes
+enum {
+  JCC_B = 0x2,
+  JCC_AE = 0x3,
+  JCC_E = 0x4,
+  JCC_NE = 0x5,
+  JCC_A = 0x7,
+  JCC_P = 0xA,
+  JCC_NP = 0xB,
+  JCC_L = 0xC,
+  JCC_GE = 0xD,
+  JCC_LE = 0xE,
+  JCC_G = 0xF,
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// code emitter
+// all memory operands are `[reg+disp32]`, it is simpler this way
+// `reg` for memory operands must not be `esp` or `ebp`
+struct VMJitEmitter {
+  TArray<vuint8> code;
+
+  // patch requests for branches to bytecode instructions
+  struct Fixup {
+    int pos; // position of rel32
+    int insn; // target instruction index, or -1
+    int site; // target site stub index (if `insn` is -1)
+  };
+  TArray<Fixup> fixups;
+
+  inline int pos () const noexcept { return code.length(); }
+
+  inline void b (vuint8 v) { code.append(v); }
+  inline void b2 (vuint8 v0, vuint8 v1) { b(v0); b(v1); }
+  inline void b3 (vuint8 v0, vuint8 v1, vuint8 v2) { b(v0); b(v1); b(v2); }
+  inline void i32 (vint32 v) { b(v&0xff); b((v>>8)&0xff); b((v>>16)&0xff); b((v>>24)&0xff); }
+  inline void i64 (vuint64 v) { i32((vint32)(v&0xffffffffu)); i32((vint32)(v>>32)); }
+
+  inline void patch32 (int at, vint32 v) {
+    code[at+0] = v&0xff; code[at+1] = (v>>8)&0xff;
+    code[at+2] = (v>>16)&0xff; code[at+3] = (v>>24)&0xff;
+  }
+
+  // modrm for `[base+disp32]`
+  inline void mem (int reg, int base, vint32 disp) { b(0x80|((reg&7)<<3)|(base&7)); i32(disp); }
+
+  // 32-bit loads and stores
+  inline void ld32 (int reg, int base, vint32 disp) { b(0x8b); mem(reg, base, disp); }
+  inline void st32 (int base, vint32 disp, int reg) { b(0x89); mem(reg, base, disp); }
+  inline void st8 (int base, vint32 disp, int reg) { b(0x88); mem(reg, base, disp); }
+  inline void ld8zx (int reg, int base, vint32 disp) { b2(0x0f, 0xb6); mem(reg, base, disp); }
+  // 64-bit loads and stores
+  inline void ld64 (int reg, int base, vint32 disp) { b2(0x48, 0x8b); mem(reg, base, disp); }
+  inline void st64 (int base, vint32 disp, int reg) { b2(0x48, 0x89); mem(reg, base, disp); }
+  inline void lea64 (int reg, int base, vint32 disp) { b2(0x48, 0x8d); mem(reg, base, disp); }
+  // float loads and stores
+  inline void ldss (int xreg, int base, vint32 disp) { b3(0xf3, 0x0f, 0x10); mem(xreg, base, disp); }
+  inline void stss (int base, vint32 disp, int xreg) { b3(0xf3, 0x0f, 0x11); mem(xreg, base, disp); }
+
+  // immediates
+  inline void st32imm (int base, vint32 disp, vint32 v) { b(0xc7); mem(0, base, disp); i32(v); }
+  inline void mov32imm (int reg, vint32 v) { b(0xb8+reg); i32(v); }
+  inline void mov64imm (int reg, vuint64 v) { b2(0x48, 0xb8+reg); i64(v); }
+  inline void st64imm (int base, vint32 disp, vuint64 v) {
+    if ((vint64)v == (vint64)(vint32)v) {
+      b2(0x48, 0xc7); mem(0, base, disp); i32((vint32)v);
+    } else {
+      mov64imm(JR_EAX, v);
+      st64(base, disp, JR_EAX);
+    }
+  }
+
+  // register-register ops
+  inline void alu32 (vuint8 opc, int dst, int src) { b2(opc, 0xc0|(src<<3)|dst); }
+  inline void add32 (int dst, int src) { alu32(0x01, dst, src); }
+  inline void sub32 (int dst, int src) { alu32(0x29, dst, src); }
+  inline void and32 (int dst, int src) { alu32(0x21, dst, src); }
+  inline void or32 (int dst, int src) { alu32(0x09, dst, src); }
+  inline void xor32 (int dst, int src) { alu32(0x31, dst, src); }
+  inline void cmp32 (int dst, int src) { alu32(0x39, dst, src); }
+  inline void test32 (int dst, int src) { alu32(0x85, dst, src); }
+  inline void mov32 (int dst, int src) { alu32(0x89, dst, src); }
+  inline void imul32 (int dst, int src) { b3(0x0f, 0xaf, 0xc0|(dst<<3)|src); }
+  inline void cmp64 (int dst, int src) { b(0x48); alu32(0x39, dst, src); }
+  inline void test64 (int dst, int src) { b(0x48); alu32(0x85, dst, src); }
+  inline void add64 (int dst, int src) { b(0x48); alu32(0x01, dst, src); }
+  inline void movsxd64 (int dst, int src) { b3(0x48, 0x63, 0xc0|(dst<<3)|src); }
+
+  // register-immediate ops (`/n` is the opcode extension)
+  inline void alu32imm (int ext, int reg, vint32 v) { b2(0x81, 0xc0|(ext<<3)|reg); i32(v); }
+  inline void add32imm (int reg, vint32 v) { alu32imm(0, reg, v); }
+  inline void or32imm (int reg, vint32 v) { alu32imm(1, reg, v); }
+  inline void and32imm (int reg, vint32 v) { alu32imm(4, reg, v); }
+  inline void xor32imm (int reg, vint32 v) { alu32imm(6, reg, v); }
+  inline void cmp32imm (int reg, vint32 v) { alu32imm(7, reg, v); }
+  inline void test32imm (int reg, vint32 v) { b2(0xf7, 0xc0|reg); i32(v); }
+  inline void imul32imm (int dst, int src, vint32 v) { b2(0x69, 0xc0|(dst<<3)|src); i32(v); }
+  inline void add64imm (int reg, vint32 v) { b3(0x48, 0x81, 0xc0|reg); i32(v); }
+
+  // unary ops
+  inline void neg32 (int reg) { b2(0xf7, 0xd8|reg); }
+  inline void not32 (int reg) { b2(0xf7, 0xd0|reg); }
+  inline void cdq () { b(0x99); }
+  inline void idiv32 (int reg) { b2(0xf7, 0xf8|reg); }
+  // shifts by `cl`
+  inline void shl32cl (int reg) { b2(0xd3, 0xe0|reg); }
+  inline void sar32cl (int reg) { b2(0xd3, 0xf8|reg); }
+  inline void shr32cl (int reg) { b2(0xd3, 0xe8|reg); }
+
+  // `reg = (cc ? 1 : 0)`; only for eax/ecx/edx
+  inline void setcc (int cc, int reg) { b3(0x0f, 0x90|cc, 0xc0|reg); }
+  inline void movzx8 (int dst, int src) { b3(0x0f, 0xb6, 0xc0|(dst<<3)|src); }
+
+  // sse
+  inline void sseop (vuint8 opc, int dst, int src) { b3(0xf3, 0x0f, opc); b(0xc0|(dst<<3)|src); }
+  inline void addss (int dst, int src) { sseop(0x58, dst, src); }
+  inline void subss (int dst, int src) { sseop(0x5c, dst, src); }
+  inline void mulss (int dst, int src) { sseop(0x59, dst, src); }
+  inline void divss (int dst, int src) { sseop(0x5e, dst, src); }
+  inline void ucomiss (int a, int bb) { b3(0x0f, 0x2e, 0xc0|(a<<3)|bb); }
+  inline void cvtsi2ss (int xdst, int src) { sseop(0x2a, xdst, src); }
+  inline void cvttss2si (int dst, int xsrc) { sseop(0x2c, dst, xsrc); }
+  inline void movd2x (int xdst, int src) { b3(0x66, 0x0f, 0x6e); b(0xc0|(xdst<<3)|src); }
+  inline void movx2d (int dst, int xsrc) { b3(0x66, 0x0f, 0x7e); b(0xc0|(xsrc<<3)|dst); }
+
+  // branches; returns position of rel32
+  inline int jcc32 (int cc) { b2(0x0f, 0x80|cc); const int res = pos(); i32(0); return res; }
+  inline int jmp32 () { b(0xe9); const int res = pos(); i32(0); return res; }
+  // patch rel32 at `at` to point to the current position
+  inline void fixHere (int at) { patch32(at, pos()-(at+4)); }
+
+  inline void ret () { b(0xc3); }
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// method compiler
+struct VMJitCompiler {
+  VMethod *func;
+  VMJitEmitter em;
+
+  struct Insn {
+    vuint32 ofs;
+    int len;
+    int depth; // -1: unreachable
+    int callDelta; // for calls
+    int site; // bailout site at this instruction, -1 if not created yet
+    int nativeOfs;
+  };
+
+  TArray<Insn> insns;
+  TArray<int> ofs2insn; // bytecode offset -> instruction index (or -1)
+  TArray<VMJitSite> sites;
+  TArray<int> siteStubs; // native position of site exit stub; -1 for call sites
+
+  int curInsn; // instruction we are compiling now
+
+  VMJitCompiler (VMethod *afunc) : func(afunc), curInsn(-1) {}
+
+  // disp for `sp[idx]` for the current instruction
+  inline vint32 spd (int idx) const noexcept { return (func->NumLocals+insns[curInsn].depth+idx)*(vint32)sizeof(VStack); }
+
+  inline const vuint8 *ipc () const noexcept { return func->vmCodeStart+insns[curInsn].ofs; }
+
+  bool decode ();
+  bool calcDepth ();
+  bool emitAll ();
+  bool emitInsn ();
+
+  int getBailSite (int iidx);
+  // emit conditional jump to the bailout stub for the current instruction
+  inline void bailIf (int cc) {
+    const int site = getBailSite(curInsn);
+    const int at = em.jcc32(cc);
+    VMJitEmitter::Fixup &fx = em.fixups.alloc();
+    fx.pos = at;
+    fx.insn = -1;
+    fx.site = site;
+  }
+
+  // unconditional jump to the bailout stub for the current instruction
+  inline void bailAlways () {
+    const int site = getBailSite(curInsn);
+    const int at = em.jmp32();
+    VMJitEmitter::Fixup &fx = em.fixups.alloc();
+    fx.pos = at;
+    fx.insn = -1;
+    fx.site = site;
+  }
+
+  inline void jumpTo (int cc, int targetOfs) {
+    const int at = (cc < 0 ? em.jmp32() : em.jcc32(cc));
+    VMJitEmitter::Fixup &fx = em.fixups.alloc();
+    fx.pos = at;
+    fx.insn = ofs2insn[targetOfs];
+    fx.site = -1;
+  }
+
+  // check for `VObject::vmAbortBySignal` on backward jumps
+  inline void emitAbortCheck () {
+    em.mov64imm(JR_EAX, (vuint64)(uintptr_t)&VObject::vmAbortBySignal);
+    em.ld32(JR_EAX, JR_EAX, 0);
+    em.test32(JR_EAX, JR_EAX);
+    bailIf(JCC_NE);
+  }
+
+  // null pointer in `reg`? bail out, so the interpreter will report the error
+  inline void emitNullCheck (int reg) {
+    em.test64(reg, reg);
+    bailIf(JCC_E);
+  }
+
+  // `eax/ecx` would fault (division by zero, or `MIN_VINT32/-1`)? bail out, so the interpreter will report the error
+  inline void emitDivCheck () {
+    em.test32(JR_ECX, JR_ECX);
+    bailIf(JCC_E);
+    em.cmp32imm(JR_ECX, -1);
+    const int notMinusOne = em.jcc32(JCC_NE);
+    em.cmp32imm(JR_EAX, MIN_VINT32);
+    bailIf(JCC_E);
+    em.fixHere(notMinusOne);
+  }
+
+  // bail out if the float bits in `reg` are not finite (destroys `reg`)
+  inline void emitFiniteCheck (int reg) {
+    em.and32imm(reg, 0x7f800000);
+    em.cmp32imm(reg, 0x7f800000);
+    bailIf(JCC_E);
+  }
+
+  // bail out if float divisor at `sp[-1]` is zero, or not finite (destroys ecx and edx)
+  inline void emitFDivCheck () {
+    em.ld32(JR_ECX, JR_EDI, spd(-1));
+    em.mov32(JR_EDX, JR_ECX);
+    em.and32imm(JR_EDX, 0x7fffffff);
+    bailIf(JCC_E);
+    emitFiniteCheck(JR_ECX);
+  }
+
+  // zero `reg` if it is a denormal float (destroys edx)
+  inline void emitZeroDenormal (int reg) {
+    em.mov32(JR_EDX, reg);
+    em.and32imm(JR_EDX, 0x7f800000);
+    em.b2(0x75, 0x02); // jnz +2
+    em.xor32(reg, reg);
+  }
+
+  // check that xmm0..xmm2 are finite, and store them with denormals killed
+  // nothing is written if the check fails
+  inline void emitStoreVec (int base, vint32 disp, int stride) {
+    for (int f = 0; f < 3; ++f) {
+      em.movx2d(JR_ECX, f);
+      emitFiniteCheck(JR_ECX);
+    }
+    for (int f = 0; f < 3; ++f) {
+      em.movx2d(JR_ECX, f);
+      emitZeroDenormal(JR_ECX);
+      em.st32(base, disp+f*stride, JR_ECX);
+    }
+  }
+
+  inline void emitBoolResult (int cc, vint32 disp) {
+    em.setcc(cc, JR_EAX);
+    em.movzx8(JR_EAX, JR_EAX);
+    em.st32(JR_EDI, disp, JR_EAX);
+  }
+};
+
+
+//==========================================================================
+//
+//  VMJitCompiler::decode
+//
+//==========================================================================
+bool VMJitCompiler::decode () {
+  const vuint32 csize = func->vmCodeSize;
+  ofs2insn.setLength((int)csize+1);
+  for (int f = 0; f <= (int)csize; ++f) ofs2insn[f] = -1;
+  int callIdx = 0;
+  vuint32 ofs = 0;
+  while (ofs < csize) {
+    const vuint8 *ip = func->vmCodeStart+ofs;
+    const int len = vmJitInsnLength(ip);
+    if (len <= 0 || ofs+(vuint32)len > csize) return false;
+    ofs2insn[(int)ofs] = insns.length();
+    Insn &it = insns.alloc();
+    it.ofs = ofs;
+    it.len = len;
+    it.depth = -1;
+    it.callDelta = 0;
+    it.site = -1;
+    it.nativeOfs = -1;
+    if (*ip == OPC_Call || *ip == OPC_VCall || *ip == OPC_VCallB) {
+      if (!func->jitCallDelta) return false;
+      it.callDelta = func->jitCallDelta[callIdx++];
+    }
+    ofs += (vuint32)len;
+  }
+  return (insns.length() > 0);
+}
+
+
+//==========================================================================
+//
+//  VMJitCompiler::calcDepth
+//
+//  calculate VM stack depth for each reachable instruction
+//
+//==========================================================================
+bool VMJitCompiler::calcDepth () {
+  TArray<int> work;
+  insns[0].depth = 0;
+  work.append(0);
+
+  auto flowTo = [&] (vuint32 tofs, int depth) -> bool {
+    if (depth < 0 || tofs >= func->vmCodeSize) return false;
+    const int tidx = ofs2insn[(int)tofs];
+    if (tidx < 0) return false; // jump into the middle of instruction?!
+    if (insns[tidx].depth < 0) {
+      insns[tidx].depth = depth;
+      work.append(tidx);
+      return true;
+    }
+    return (insns[tidx].depth == depth);
+  };
+
+  while (work.length()) {
+    const int iidx = work.pop();
+    const Insn &it = insns[iidx];
+    const vuint8 *ip = func->vmCodeStart+it.ofs;
+    const vuint32 next = it.ofs+(vuint32)it.len;
+    const int d = it.depth;
+    int nd = d; // depth for the next instruction
+    switch (*ip) {
+      case OPC_Return: if (d != 0) return false; continue;
+      case OPC_ReturnL: if (d != 1) return false; continue;
+      case OPC_ReturnV: if (d != 3) return false; continue;
+
+      case OPC_GotoB: if (!flowTo(it.ofs+ip[1], d)) return false; continue;
+      case OPC_GotoNB: if (!flowTo(it.ofs-ip[1], d)) return false; continue;
+      case OPC_Goto: if (!flowTo(it.ofs+*(const vint32 *)(ip+1), d)) return false; continue;
+
+      case OPC_IfGotoB: case OPC_IfNotGotoB:
+        if (d < 1 || !flowTo(it.ofs+ip[1], d-1)) return false;
+        nd = d-1;
+        break;
+      case OPC_IfGotoNB: case OPC_IfNotGotoNB:
+        if (d < 1 || !flowTo(it.ofs-ip[1], d-1)) return false;
+        nd = d-1;
+        break;
+      case OPC_IfGoto: case OPC_IfNotGoto:
+        if (d < 1 || !flowTo(it.ofs+*(const vint32 *)(ip+1), d-1)) return false;
+        nd = d-1;
+        break;
+
+      // case jumps pop the value only when taken
+      case OPC_CaseGotoB:
+        if (d < 1 || !flowTo(it.ofs+*(const vint16 *)(ip+2), d-1)) return false;
+        break;
+      case OPC_CaseGoto: case OPC_CaseGotoN:
+        if (d < 1 || !flowTo(it.ofs+*(const vint16 *)(ip+5), d-1)) return false;
+        break;
+
+      case OPC_Call: case OPC_VCall: case OPC_VCallB:
+        nd = d+it.callDelta;
+        break;
+
+      case OPC_PushNumber0: case OPC_PushNumber1: case OPC_PushNumberB: case OPC_PushNumber:
+      case OPC_PushName: case OPC_PushNameS: case OPC_PushClassId: case OPC_PushFunc: case OPC_PushNull:
+      case OPC_LocalAddress0: case OPC_LocalAddress1: case OPC_LocalAddress2: case OPC_LocalAddress3:
+      case OPC_LocalAddress4: case OPC_LocalAddress5: case OPC_LocalAddress6: case OPC_LocalAddress7:
+      case OPC_LocalAddressB: case OPC_LocalAddressS: case OPC_LocalAddress:
+      case OPC_LocalValue0: case OPC_LocalValue1: case OPC_LocalValue2: case OPC_LocalValue3:
+      case OPC_LocalValue4: case OPC_LocalValue5: case OPC_LocalValue6: case OPC_LocalValue7:
+      case OPC_LocalValueB:
+        nd = d+1;
+        break;
+      case OPC_VLocalValueB:
+        nd = d+3;
+        break;
+      case OPC_DupPOD:
+        if (d < 1) return false;
+        nd = d+1;
+        break;
+
+      case OPC_VFieldValue: case OPC_VFieldValueS: case OPC_VPushPointed:
+        if (d < 1) return false;
+        nd = d+2;
+        break;
+
+      // [-1] -> [-1]
+      case OPC_Offset: case OPC_OffsetS:
+      case OPC_FieldValue: case OPC_FieldValueS:
+      case OPC_PtrFieldValue: case OPC_PtrFieldValueS:
+      case OPC_ByteFieldValue: case OPC_ByteFieldValueS:
+      case OPC_Bool0FieldValue: case OPC_Bool0FieldValueS:
+      case OPC_Bool1FieldValue: case OPC_Bool1FieldValueS:
+      case OPC_Bool2FieldValue: case OPC_Bool2FieldValueS:
+      case OPC_Bool3FieldValue: case OPC_Bool3FieldValueS:
+      case OPC_CheckArrayBounds:
+      case OPC_PushPointed: case OPC_PushPointedPtr: case OPC_PushPointedByte:
+      case OPC_PushBool0: case OPC_PushBool1: case OPC_PushBool2: case OPC_PushBool3:
+      case OPC_NegateLogical: case OPC_UnaryMinus: case OPC_BitInverse:
+      case OPC_PreInc: case OPC_PreDec: case OPC_PostInc: case OPC_PostDec:
+      case OPC_FUnaryMinus: case OPC_FloatToBool: case OPC_PtrToBool:
+      case OPC_IntToFloat: case OPC_FloatToInt:
+        if (d < 1) return false;
+        break;
+
+      // [-2], [-1] -> [-2]
+      case OPC_ArrayElement: case OPC_ArrayElementB:
+      case OPC_Add: case OPC_Subtract: case OPC_Multiply: case OPC_Divide: case OPC_Modulus:
+      case OPC_Equals: case OPC_NotEquals: case OPC_Less: case OPC_Greater: case OPC_LessEquals: case OPC_GreaterEquals:
+      case OPC_AndBitwise: case OPC_OrBitwise: case OPC_XOrBitwise:
+      case OPC_LShift: case OPC_RShift: case OPC_URShift:
+      case OPC_FAdd: case OPC_FSubtract: case OPC_FMultiply: case OPC_FDivide:
+      case OPC_FEquals: case OPC_FNotEquals: case OPC_FLess: case OPC_FGreater: case OPC_FLessEquals: case OPC_FGreaterEquals:
+      case OPC_PtrEquals: case OPC_PtrNotEquals:
+        if (d < 2) return false;
+        nd = d-1;
+        break;
+
+      case OPC_IncDrop: case OPC_DecDrop: case OPC_ByteIncDrop: case OPC_ByteDecDrop:
+      case OPC_Drop: case OPC_DropPOD:
+        if (d < 1) return false;
+        nd = d-1;
+        break;
+
+      case OPC_AssignDrop: case OPC_AddVarDrop: case OPC_SubVarDrop: case OPC_MulVarDrop:
+      case OPC_DivVarDrop: case OPC_ModVarDrop: case OPC_AndVarDrop: case OPC_OrVarDrop: case OPC_XOrVarDrop:
+      case OPC_LShiftVarDrop: case OPC_RShiftVarDrop: case OPC_URShiftVarDrop:
+      case OPC_ByteAssignDrop:
+      case OPC_FAddVarDrop: case OPC_FSubVarDrop: case OPC_FMulVarDrop: case OPC_FDivVarDrop:
+      case OPC_AssignPtrDrop:
+      case OPC_AssignBool0: case OPC_AssignBool1: case OPC_AssignBool2: case OPC_AssignBool3:
+        if (d < 2) return false;
+        nd = d-2;
+        break;
+
+      case OPC_VAdd: case OPC_VSubtract:
+        if (d < 6) return false;
+        nd = d-3;
+        break;
+      case OPC_VEquals: case OPC_VNotEquals:
+        if (d < 6) return false;
+        nd = d-5;
+        break;
+      case OPC_VUnaryMinus:
+        if (d < 3) return false;
+        break;
+      case OPC_VectorDirect:
+        if (d < 3) return false;
+        nd = d-2;
+        break;
+      case OPC_VFixVecParam:
+        break;
+      case OPC_VPreScale: case OPC_VPostScale:
+        if (d < 4) return false;
+        nd = d-1;
+        break;
+      case OPC_VAssignDrop: case OPC_VAddVarDrop: case OPC_VSubVarDrop:
+        if (d < 4) return false;
+        nd = d-4;
+        break;
+      case OPC_VDrop:
+        if (d < 3) return false;
+        nd = d-3;
+        break;
+
+      default:
+        return false;
+    }
+    if (!flowTo(next, nd)) return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VMJitCompiler::getBailSite
+//
+//==========================================================================
+int VMJitCompiler::getBailSite (int iidx) {
+  Insn &it = insns[iidx];
+  if (it.site < 0) {
+    it.site = sites.length();
+    VMJitSite &st = sites.alloc();
+    st.ofs = it.ofs;
+    st.depth = it.depth;
+    st.resumeDepth = -1;
+    st.resumeOfs = 0;
+    siteStubs.append(-1); // will be emited later
+  }
+  return it.site;
+}
+
+
+//==========================================================================
+//
+//  VMJitCompiler::emitInsn
+//
+//==========================================================================
+bool VMJitCompiler::emitInsn () {
+  const Insn &it = insns[curInsn];
+  const vuint8 *ip = ipc();
+  const vint32 slotSize = (vint32)sizeof(VStack);
+
+  // field access; returns offset, and puts non-null object pointer into `rax`
+  auto fieldPtr = [&] (bool isShort) -> vint32 {
+    em.ld64(JR_EAX, JR_EDI, spd(-1));
+    emitNullCheck(JR_EAX);
+    return (isShort ? (vint32)(*(const vint16 *)(ip+1)) : *(const vint32 *)(ip+1));
+  };
+
+  // int binary op: eax = [-2], ecx = [-1]
+  auto ldBin = [&] () {
+    em.ld32(JR_EAX, JR_EDI, spd(-2));
+    em.ld32(JR_ECX, JR_EDI, spd(-1));
+  };
+
+  // float binary op: xmm0 = [-2], xmm1 = [-1]
+  auto ldFBin = [&] () {
+    em.ldss(0, JR_EDI, spd(-2));
+    em.ldss(1, JR_EDI, spd(-1));
+  };
+
+  // assign op: rax = pointer at [-2], ecx = [-1], edx = *rax
+  auto ldAssign = [&] () {
+    em.ld64(JR_EAX, JR_EDI, spd(-2));
+    em.ld32(JR_ECX, JR_EDI, spd(-1));
+    em.ld32(JR_EDX, JR_EAX, 0);
+  };
+
+  auto boolMask = [&] (int shift, int argofs) -> vint32 { return (vint32)((vuint32)ip[argofs]<<shift); };
+
+  switch (*ip) {
+    // calls are done by the C++ code; see `RunFunction()`
+    case OPC_Call:
+    case OPC_VCall:
+    case OPC_VCallB:
+      {
+        const int site = sites.length();
+        VMJitSite &st = sites.alloc();
+        st.ofs = it.ofs;
+        st.depth = it.depth;
+        st.resumeDepth = it.depth+it.callDelta;
+        st.resumeOfs = 0; // will be fixed later
+        siteStubs.append(-1);
+        em.mov32imm(JR_EAX, (vint32)(((vuint32)site<<4)|VMethod::JIT_Exit_Call));
+        em.ret();
+      }
+      return true;
+
+    case OPC_Return:
+      em.mov32imm(JR_EAX, VMethod::JIT_Exit_Return);
+      em.ret();
+      return true;
+    case OPC_ReturnL:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.st64(JR_EDI, 0, JR_EAX);
+      em.mov32imm(JR_EAX, VMethod::JIT_Exit_ReturnL);
+      em.ret();
+      return true;
+    case OPC_ReturnV:
+      for (int f = 0; f < 3; ++f) {
+        em.ld64(JR_EAX, JR_EDI, spd(-3+f));
+        em.st64(JR_EDI, f*slotSize, JR_EAX);
+      }
+      em.mov32imm(JR_EAX, VMethod::JIT_Exit_ReturnV);
+      em.ret();
+      return true;
+
+    case OPC_GotoB: jumpTo(-1, it.ofs+ip[1]); return true;
+    case OPC_GotoNB: emitAbortCheck(); jumpTo(-1, it.ofs-ip[1]); return true;
+    case OPC_Goto:
+      {
+        const vint32 rel = *(const vint32 *)(ip+1);
+        if (rel <= 0) emitAbortCheck();
+        jumpTo(-1, it.ofs+rel);
+      }
+      return true;
+
+    case OPC_IfGotoB: case OPC_IfNotGotoB:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.test32(JR_EAX, JR_EAX);
+      jumpTo((*ip == OPC_IfGotoB ? JCC_NE : JCC_E), it.ofs+ip[1]);
+      return true;
+    case OPC_IfGotoNB: case OPC_IfNotGotoNB:
+      emitAbortCheck();
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.test32(JR_EAX, JR_EAX);
+      jumpTo((*ip == OPC_IfGotoNB ? JCC_NE : JCC_E), it.ofs-ip[1]);
+      return true;
+    case OPC_IfGoto: case OPC_IfNotGoto:
+      {
+        const vint32 rel = *(const vint32 *)(ip+1);
+        if (rel <= 0) emitAbortCheck();
+        em.ld32(JR_EAX, JR_EDI, spd(-1));
+        em.test32(JR_EAX, JR_EAX);
+        jumpTo((*ip == OPC_IfGoto ? JCC_NE : JCC_E), it.ofs+rel);
+      }
+      return true;
+
+    case OPC_CaseGotoB:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.cmp32imm(JR_EAX, (vint32)ip[1]);
+      jumpTo(JCC_E, it.ofs+*(const vint16 *)(ip+2));
+      return true;
+    case OPC_CaseGoto: case OPC_CaseGotoN:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.cmp32imm(JR_EAX, *(const vint32 *)(ip+1));
+      jumpTo(JCC_E, it.ofs+*(const vint16 *)(ip+5));
+      return true;
+
+    case OPC_PushNumber0: em.st32imm(JR_EDI, spd(0), 0); return true;
+    case OPC_PushNumber1: em.st32imm(JR_EDI, spd(0), 1); return true;
+    case OPC_PushNumberB: em.st32imm(JR_EDI, spd(0), (vint32)ip[1]); return true;
+    case OPC_PushNumber: case OPC_PushName: em.st32imm(JR_EDI, spd(0), *(const vint32 *)(ip+1)); return true;
+    case OPC_PushNameS: em.st32imm(JR_EDI, spd(0), (vint32)(*(const vint16 *)(ip+1))); return true;
+    case OPC_PushClassId: case OPC_PushFunc: em.st64imm(JR_EDI, spd(0), (vuint64)(uintptr_t)(*(void *const *)(ip+1))); return true;
+    case OPC_PushNull: em.st64imm(JR_EDI, spd(0), 0); return true;
+
+    case OPC_LocalAddress0: case OPC_LocalAddress1: case OPC_LocalAddress2: case OPC_LocalAddress3:
+    case OPC_LocalAddress4: case OPC_LocalAddress5: case OPC_LocalAddress6: case OPC_LocalAddress7:
+    case OPC_LocalAddressB: case OPC_LocalAddressS: case OPC_LocalAddress:
+      {
+        vint32 idx;
+             if (*ip == OPC_LocalAddressB) idx = ip[1];
+        else if (*ip == OPC_LocalAddressS) idx = *(const vint16 *)(ip+1);
+        else if (*ip == OPC_LocalAddress) idx = *(const vint32 *)(ip+1);
+        else idx = *ip-OPC_LocalAddress0;
+        em.lea64(JR_EAX, JR_EDI, idx*slotSize);
+        em.st64(JR_EDI, spd(0), JR_EAX);
+      }
+      return true;
+
+    case OPC_LocalValue0: case OPC_LocalValue1: case OPC_LocalValue2: case OPC_LocalValue3:
+    case OPC_LocalValue4: case OPC_LocalValue5: case OPC_LocalValue6: case OPC_LocalValue7:
+    case OPC_LocalValueB:
+      {
+        const vint32 idx = (*ip == OPC_LocalValueB ? (vint32)ip[1] : (vint32)(*ip-OPC_LocalValue0));
+        em.ld64(JR_EAX, JR_EDI, idx*slotSize);
+        em.st64(JR_EDI, spd(0), JR_EAX);
+      }
+      return true;
+
+    case OPC_VLocalValueB:
+      for (int f = 0; f < 3; ++f) {
+        em.ld32(JR_EAX, JR_EDI, (vint32)ip[1]*slotSize+f*4);
+        em.st32(JR_EDI, spd(f), JR_EAX);
+      }
+      return true;
+
+    case OPC_Offset: case OPC_OffsetS:
+      {
+        const vint32 ofs = fieldPtr(*ip == OPC_OffsetS);
+        em.add64imm(JR_EAX, ofs);
+        em.st64(JR_EDI, spd(-1), JR_EAX);
+      }
+      return true;
+
+    case OPC_FieldValue: case OPC_FieldValueS:
+      {
+        const vint32 ofs = fieldPtr(*ip == OPC_FieldValueS);
+        em.ld32(JR_ECX, JR_EAX, ofs);
+        em.st32(JR_EDI, spd(-1), JR_ECX);
+      }
+      return true;
+
+    case OPC_PtrFieldValue: case OPC_PtrFieldValueS:
+      {
+        const vint32 ofs = fieldPtr(*ip == OPC_PtrFieldValueS);
+        em.ld64(JR_ECX, JR_EAX, ofs);
+        em.st64(JR_EDI, spd(-1), JR_ECX);
+      }
+      return true;
+
+    case OPC_ByteFieldValue: case OPC_ByteFieldValueS:
+      {
+        const vint32 ofs = fieldPtr(*ip == OPC_ByteFieldValueS);
+        em.ld8zx(JR_ECX, JR_EAX, ofs);
+        em.st32(JR_EDI, spd(-1), JR_ECX);
+      }
+      return true;
+
+    case OPC_Bool0FieldValue: case OPC_Bool1FieldValue: case OPC_Bool2FieldValue: case OPC_Bool3FieldValue:
+      {
+        const vint32 ofs = fieldPtr(false);
+        em.ld32(JR_ECX, JR_EAX, ofs);
+        em.test32imm(JR_ECX, boolMask((*ip-OPC_Bool0FieldValue)/2*8, 5));
+        emitBoolResult(JCC_NE, spd(-1));
+      }
+      return true;
+    case OPC_Bool0FieldValueS: case OPC_Bool1FieldValueS: case OPC_Bool2FieldValueS: case OPC_Bool3FieldValueS:
+      {
+        const vint32 ofs = fieldPtr(true);
+        em.ld32(JR_ECX, JR_EAX, ofs);
+        em.test32imm(JR_ECX, boolMask((*ip-OPC_Bool0FieldValueS)/2*8, 3));
+        emitBoolResult(JCC_NE, spd(-1));
+      }
+      return true;
+
+    case OPC_VFieldValue: case OPC_VFieldValueS:
+      {
+        const vint32 ofs = fieldPtr(*ip == OPC_VFieldValueS);
+        for (int f = 0; f < 3; ++f) {
+          em.ld32(JR_ECX, JR_EAX, ofs+f*4);
+          em.st32(JR_EDI, spd(-1+f), JR_ECX);
+        }
+      }
+      return true;
+
+    case OPC_CheckArrayBounds:
+      // unsigned comparison catches negative indicies too
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.cmp32imm(JR_EAX, *(const vint32 *)(ip+1));
+      bailIf(JCC_AE);
+      return true;
+
+    case OPC_ArrayElement: case OPC_ArrayElementB:
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ld32(JR_ECX, JR_EDI, spd(-1));
+      em.imul32imm(JR_ECX, JR_ECX, (*ip == OPC_ArrayElementB ? (vint32)ip[1] : *(const vint32 *)(ip+1)));
+      em.movsxd64(JR_ECX, JR_ECX);
+      em.add64(JR_EAX, JR_ECX);
+      em.st64(JR_EDI, spd(-2), JR_EAX);
+      return true;
+
+    case OPC_PushPointed:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld32(JR_ECX, JR_EAX, 0);
+      em.st32(JR_EDI, spd(-1), JR_ECX);
+      return true;
+    case OPC_PushPointedPtr:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld64(JR_ECX, JR_EAX, 0);
+      em.st64(JR_EDI, spd(-1), JR_ECX);
+      return true;
+    case OPC_PushPointedByte:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld8zx(JR_ECX, JR_EAX, 0);
+      em.st32(JR_EDI, spd(-1), JR_ECX);
+      return true;
+    case OPC_VPushPointed:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      for (int f = 0; f < 3; ++f) {
+        em.ld32(JR_ECX, JR_EAX, f*4);
+        em.st32(JR_EDI, spd(-1+f), JR_ECX);
+      }
+      return true;
+    case OPC_PushBool0: case OPC_PushBool1: case OPC_PushBool2: case OPC_PushBool3:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld32(JR_ECX, JR_EAX, 0);
+      em.test32imm(JR_ECX, boolMask((*ip-OPC_PushBool0)*8, 1));
+      emitBoolResult(JCC_NE, spd(-1));
+      return true;
+
+    case OPC_Add: ldBin(); em.add32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_Subtract: ldBin(); em.sub32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_Multiply: ldBin(); em.imul32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_Divide: case OPC_Modulus:
+      ldBin();
+      emitDivCheck();
+      em.cdq();
+      em.idiv32(JR_ECX);
+      em.st32(JR_EDI, spd(-2), (*ip == OPC_Divide ? JR_EAX : JR_EDX));
+      return true;
+
+    case OPC_Equals: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_E, spd(-2)); return true;
+    case OPC_NotEquals: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_NE, spd(-2)); return true;
+    case OPC_Less: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_L, spd(-2)); return true;
+    case OPC_Greater: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_G, spd(-2)); return true;
+    case OPC_LessEquals: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_LE, spd(-2)); return true;
+    case OPC_GreaterEquals: ldBin(); em.cmp32(JR_EAX, JR_ECX); emitBoolResult(JCC_GE, spd(-2)); return true;
+
+    case OPC_NegateLogical:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.test32(JR_EAX, JR_EAX);
+      emitBoolResult(JCC_E, spd(-1));
+      return true;
+
+    case OPC_AndBitwise: ldBin(); em.and32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_OrBitwise: ldBin(); em.or32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_XOrBitwise: ldBin(); em.xor32(JR_EAX, JR_ECX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_LShift: ldBin(); em.shl32cl(JR_EAX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_RShift: ldBin(); em.sar32cl(JR_EAX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+    case OPC_URShift: ldBin(); em.shr32cl(JR_EAX); em.st32(JR_EDI, spd(-2), JR_EAX); return true;
+
+    case OPC_UnaryMinus:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.neg32(JR_EAX);
+      em.st32(JR_EDI, spd(-1), JR_EAX);
+      return true;
+    case OPC_BitInverse:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.not32(JR_EAX);
+      em.st32(JR_EDI, spd(-1), JR_EAX);
+      return true;
+
+    case OPC_PreInc: case OPC_PreDec:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld32(JR_ECX, JR_EAX, 0);
+      em.add32imm(JR_ECX, (*ip == OPC_PreInc ? 1 : -1));
+      em.st32(JR_EAX, 0, JR_ECX);
+      em.st32(JR_EDI, spd(-1), JR_ECX);
+      return true;
+    case OPC_PostInc: case OPC_PostDec:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld32(JR_ECX, JR_EAX, 0);
+      em.st32(JR_EDI, spd(-1), JR_ECX);
+      em.add32imm(JR_ECX, (*ip == OPC_PostInc ? 1 : -1));
+      em.st32(JR_EAX, 0, JR_ECX);
+      return true;
+    case OPC_IncDrop: case OPC_DecDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld32(JR_ECX, JR_EAX, 0);
+      em.add32imm(JR_ECX, (*ip == OPC_IncDrop ? 1 : -1));
+      em.st32(JR_EAX, 0, JR_ECX);
+      return true;
+
+    case OPC_AssignDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ld32(JR_ECX, JR_EDI, spd(-1));
+      em.st32(JR_EAX, 0, JR_ECX);
+      return true;
+    case OPC_AddVarDrop: ldAssign(); em.add32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_SubVarDrop: ldAssign(); em.sub32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_MulVarDrop: ldAssign(); em.imul32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_AndVarDrop: ldAssign(); em.and32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_OrVarDrop: ldAssign(); em.or32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_XOrVarDrop: ldAssign(); em.xor32(JR_EDX, JR_ECX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_LShiftVarDrop: ldAssign(); em.shl32cl(JR_EDX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_RShiftVarDrop: ldAssign(); em.sar32cl(JR_EDX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_URShiftVarDrop: ldAssign(); em.shr32cl(JR_EDX); em.st32(JR_EAX, 0, JR_EDX); return true;
+    case OPC_DivVarDrop: case OPC_ModVarDrop:
+      // `idiv` needs eax and edx, so keep the pointer in rsi
+      em.ld64(JR_ESI, JR_EDI, spd(-2));
+      em.ld32(JR_ECX, JR_EDI, spd(-1));
+      em.ld32(JR_EAX, JR_ESI, 0);
+      emitDivCheck();
+      em.cdq();
+      em.idiv32(JR_ECX);
+      em.st32(JR_ESI, 0, (*ip == OPC_DivVarDrop ? JR_EAX : JR_EDX));
+      return true;
+
+    case OPC_ByteIncDrop: case OPC_ByteDecDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.ld8zx(JR_ECX, JR_EAX, 0);
+      em.add32imm(JR_ECX, (*ip == OPC_ByteIncDrop ? 1 : -1));
+      em.st8(JR_EAX, 0, JR_ECX);
+      return true;
+    case OPC_ByteAssignDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ld32(JR_ECX, JR_EDI, spd(-1));
+      em.st8(JR_EAX, 0, JR_ECX);
+      return true;
+
+    case OPC_FAdd: ldFBin(); em.addss(0, 1); em.stss(JR_EDI, spd(-2), 0); return true;
+    case OPC_FSubtract: ldFBin(); em.subss(0, 1); em.stss(JR_EDI, spd(-2), 0); return true;
+    case OPC_FMultiply: ldFBin(); em.mulss(0, 1); em.stss(JR_EDI, spd(-2), 0); return true;
+    case OPC_FDivide: emitFDivCheck(); ldFBin(); em.divss(0, 1); em.stss(JR_EDI, spd(-2), 0); return true;
+
+    // `ucomiss` sets ZF, PF and CF on unordered, so NaNs are handled with `seta`/`setae` and parity
+    case OPC_FEquals:
+      ldFBin();
+      em.ucomiss(0, 1);
+      em.setcc(JCC_E, JR_EAX);
+      em.setcc(JCC_NP, JR_ECX);
+      em.b2(0x20, 0xc8); // and al, cl
+      em.movzx8(JR_EAX, JR_EAX);
+      em.st32(JR_EDI, spd(-2), JR_EAX);
+      return true;
+    case OPC_FNotEquals:
+      ldFBin();
+      em.ucomiss(0, 1);
+      em.setcc(JCC_NE, JR_EAX);
+      em.setcc(JCC_P, JR_ECX);
+      em.b2(0x08, 0xc8); // or al, cl
+      em.movzx8(JR_EAX, JR_EAX);
+      em.st32(JR_EDI, spd(-2), JR_EAX);
+      return true;
+    case OPC_FLess: ldFBin(); em.ucomiss(1, 0); emitBoolResult(JCC_A, spd(-2)); return true;
+    case OPC_FLessEquals: ldFBin(); em.ucomiss(1, 0); emitBoolResult(JCC_AE, spd(-2)); return true;
+    case OPC_FGreater: ldFBin(); em.ucomiss(0, 1); emitBoolResult(JCC_A, spd(-2)); return true;
+    case OPC_FGreaterEquals: ldFBin(); em.ucomiss(0, 1); emitBoolResult(JCC_AE, spd(-2)); return true;
+
+    case OPC_FUnaryMinus:
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.xor32imm(JR_EAX, (vint32)0x80000000u);
+      em.st32(JR_EDI, spd(-1), JR_EAX);
+      return true;
+
+    case OPC_FAddVarDrop: case OPC_FSubVarDrop: case OPC_FMulVarDrop: case OPC_FDivVarDrop:
+      if (*ip == OPC_FDivVarDrop) emitFDivCheck();
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ldss(0, JR_EAX, 0);
+      em.ldss(1, JR_EDI, spd(-1));
+      switch (*ip) {
+        case OPC_FAddVarDrop: em.addss(0, 1); break;
+        case OPC_FSubVarDrop: em.subss(0, 1); break;
+        case OPC_FMulVarDrop: em.mulss(0, 1); break;
+        default: em.divss(0, 1); break;
+      }
+      em.stss(JR_EAX, 0, 0);
+      return true;
+
+    case OPC_VAdd: case OPC_VSubtract:
+      for (int f = -6; f < 0; ++f) {
+        em.ld32(JR_ECX, JR_EDI, spd(f));
+        emitFiniteCheck(JR_ECX);
+      }
+      for (int f = 0; f < 3; ++f) {
+        em.ldss(0, JR_EDI, spd(-6+f));
+        em.ldss(1, JR_EDI, spd(-3+f));
+        if (*ip == OPC_VAdd) em.addss(0, 1); else em.subss(0, 1);
+        em.stss(JR_EDI, spd(-6+f), 0);
+      }
+      return true;
+
+    case OPC_VEquals: case OPC_VNotEquals:
+      // dl is 1 if all components are equal (and not nans)
+      em.mov32imm(JR_EDX, 1);
+      for (int f = 0; f < 3; ++f) {
+        em.ldss(0, JR_EDI, spd(-6+f));
+        em.ldss(1, JR_EDI, spd(-3+f));
+        em.ucomiss(0, 1);
+        em.setcc(JCC_E, JR_EAX);
+        em.setcc(JCC_NP, JR_ECX);
+        em.b2(0x20, 0xc8); // and al, cl
+        em.b2(0x20, 0xc2); // and dl, al
+      }
+      em.movzx8(JR_EAX, JR_EDX);
+      if (*ip == OPC_VNotEquals) em.xor32imm(JR_EAX, 1);
+      em.st32(JR_EDI, spd(-6), JR_EAX);
+      return true;
+
+    case OPC_VPreScale: case OPC_VPostScale:
+      {
+        for (int f = -4; f < 0; ++f) {
+          em.ld32(JR_ECX, JR_EDI, spd(f));
+          emitFiniteCheck(JR_ECX);
+        }
+        // scale in xmm3, vector in xmm0..xmm2
+        const int vofs = (*ip == OPC_VPreScale ? -3 : -4);
+        em.ld32(JR_ECX, JR_EDI, spd(*ip == OPC_VPreScale ? -4 : -1));
+        emitZeroDenormal(JR_ECX);
+        em.movd2x(3, JR_ECX);
+        for (int f = 0; f < 3; ++f) {
+          em.ldss(f, JR_EDI, spd(vofs+f));
+          em.mulss(f, 3);
+        }
+        emitStoreVec(JR_EDI, spd(-4), slotSize);
+      }
+      return true;
+
+    case OPC_VAssignDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-4));
+      for (int f = 0; f < 3; ++f) {
+        em.ld32(JR_ECX, JR_EDI, spd(-3+f));
+        emitZeroDenormal(JR_ECX);
+        em.st32(JR_EAX, f*4, JR_ECX);
+      }
+      return true;
+
+    case OPC_VAddVarDrop: case OPC_VSubVarDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-4));
+      for (int f = 0; f < 3; ++f) {
+        em.ld32(JR_ECX, JR_EAX, f*4);
+        emitFiniteCheck(JR_ECX);
+        em.ld32(JR_ECX, JR_EDI, spd(-3+f));
+        emitFiniteCheck(JR_ECX);
+      }
+      for (int f = 0; f < 3; ++f) {
+        em.ldss(f, JR_EAX, f*4);
+        em.ldss(3, JR_EDI, spd(-3+f));
+        if (*ip == OPC_VAddVarDrop) em.addss(f, 3); else em.subss(f, 3);
+      }
+      emitStoreVec(JR_EAX, 0, 4);
+      return true;
+
+    case OPC_VUnaryMinus:
+      for (int f = -3; f < 0; ++f) {
+        em.ld32(JR_EAX, JR_EDI, spd(f));
+        em.xor32imm(JR_EAX, (vint32)0x80000000u);
+        em.st32(JR_EDI, spd(f), JR_EAX);
+      }
+      return true;
+
+    case OPC_VFixVecParam:
+      // vector parameters are passed as three stack slots; pack them
+      em.ld32(JR_EAX, JR_EDI, ((vint32)ip[1]+1)*slotSize);
+      em.st32(JR_EDI, (vint32)ip[1]*slotSize+4, JR_EAX);
+      em.ld32(JR_EAX, JR_EDI, ((vint32)ip[1]+2)*slotSize);
+      em.st32(JR_EDI, (vint32)ip[1]*slotSize+8, JR_EAX);
+      return true;
+
+    case OPC_VectorDirect:
+      switch (ip[1]) {
+        case 0: break;
+        case 1: case 2:
+          em.ld32(JR_EAX, JR_EDI, spd(-3+(vint32)ip[1]));
+          em.st32(JR_EDI, spd(-3), JR_EAX);
+          break;
+        default: bailAlways(); break; // let the interpreter report the error
+      }
+      return true;
+
+    case OPC_FloatToBool:
+      // `false` for zero, inf and nan
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.mov32(JR_ECX, JR_EAX);
+      em.and32imm(JR_EAX, 0x7fffffff);
+      em.setcc(JCC_NE, JR_EDX); // not zero
+      em.and32imm(JR_ECX, 0x7f800000);
+      em.cmp32imm(JR_ECX, 0x7f800000);
+      em.setcc(JCC_NE, JR_EAX); // finite
+      em.b2(0x20, 0xd0); // and al, dl
+      em.movzx8(JR_EAX, JR_EAX);
+      em.st32(JR_EDI, spd(-1), JR_EAX);
+      return true;
+
+    case OPC_PtrEquals: case OPC_PtrNotEquals:
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ld64(JR_ECX, JR_EDI, spd(-1));
+      em.cmp64(JR_EAX, JR_ECX);
+      emitBoolResult((*ip == OPC_PtrEquals ? JCC_E : JCC_NE), spd(-2));
+      return true;
+    case OPC_PtrToBool:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.test64(JR_EAX, JR_EAX);
+      emitBoolResult(JCC_NE, spd(-1));
+      return true;
+
+    case OPC_IntToFloat:
+      // integers in [-2^24..2^24] are always exact; let the interpreter deal with the others
+      em.ld32(JR_EAX, JR_EDI, spd(-1));
+      em.b2(0x8d, 0x88); em.i32(0x1000000); // lea ecx, [rax+0x1000000]
+      em.cmp32imm(JR_ECX, 0x2000000);
+      bailIf(JCC_A);
+      em.cvtsi2ss(0, JR_EAX);
+      em.stss(JR_EDI, spd(-1), 0);
+      return true;
+    case OPC_FloatToInt:
+      // "integer indefinite" is returned for nan, inf, and out of range values
+      em.ldss(0, JR_EDI, spd(-1));
+      em.cvttss2si(JR_EAX, 0);
+      em.b(0x3d); em.i32((vint32)0x80000000u); // cmp eax, 0x80000000
+      bailIf(JCC_E);
+      em.st32(JR_EDI, spd(-1), JR_EAX);
+      return true;
+
+    case OPC_Drop: case OPC_VDrop: case OPC_DropPOD:
+      return true;
+    case OPC_DupPOD:
+      em.ld64(JR_EAX, JR_EDI, spd(-1));
+      em.st64(JR_EDI, spd(0), JR_EAX);
+      return true;
+
+    case OPC_AssignPtrDrop:
+      em.ld64(JR_EAX, JR_EDI, spd(-2));
+      em.ld64(JR_ECX, JR_EDI, spd(-1));
+      em.st64(JR_EAX, 0, JR_ECX);
+      return true;
+
+    case OPC_AssignBool0: case OPC_AssignBool1: case OPC_AssignBool2: case OPC_AssignBool3:
+      {
+        const vint32 mask = boolMask((*ip-OPC_AssignBool0)*8, 1);
+        ldAssign();
+        em.test32(JR_ECX, JR_ECX);
+        const int jz = em.jcc32(JCC_E);
+        em.or32imm(JR_EDX, mask);
+        const int jend = em.jmp32();
+        em.fixHere(jz);
+        em.and32imm(JR_EDX, ~mask);
+        em.fixHere(jend);
+        em.st32(JR_EAX, 0, JR_EDX);
+      }
+      return true;
+  }
+
+  return false;
+}
+
+
+//==========================================================================
+//
+//  VMJitCompiler::emitAll
+//
+//==========================================================================
+bool VMJitCompiler::emitAll () {
+  // prologue: rdi is `local_vars`, rsi is resume address (or nullptr)
+  em.test64(JR_ESI, JR_ESI);
+  em.b2(0x74, 0x02); // jz +2
+  em.b2(0xff, 0xe6); // jmp rsi
+
+  for (curInsn = 0; curInsn < insns.length(); ++curInsn) {
+    Insn &it = insns[curInsn];
+    if (it.depth < 0) continue; // unreachable
+    it.nativeOfs = em.pos();
+    if (!emitInsn()) return false;
+    // if the next instruction is unreachable, the code cannot fall through
+    // (the only case when this is valid is after unconditional jumps and returns)
+  }
+
+  // site stubs (bailouts)
+  for (int f = 0; f < sites.length(); ++f) {
+    if (sites[f].resumeDepth >= 0) continue; // call
+    siteStubs[f] = em.pos();
+    em.mov32imm(JR_EAX, (vint32)(((vuint32)f<<4)|VMethod::JIT_Exit_Bail));
+    em.ret();
+  }
+
+  // fix branches
+  for (auto &&fx : em.fixups) {
+    int dest;
+    if (fx.insn >= 0) {
+      dest = insns[fx.insn].nativeOfs;
+    } else {
+      dest = siteStubs[fx.site];
+    }
+    if (dest < 0) return false;
+    em.patch32(fx.pos, dest-(fx.pos+4));
+  }
+
+  // fix call resume points
+  for (curInsn = 0; curInsn < insns.length(); ++curInsn) {
+    const Insn &it = insns[curInsn];
+    if (it.depth < 0) continue;
+    const vuint8 op = func->vmCodeStart[it.ofs];
+    if (op != OPC_Call && op != OPC_VCall && op != OPC_VCallB) continue;
+    const vuint32 nofs = it.ofs+(vuint32)it.len;
+    const int nidx = (nofs < func->vmCodeSize ? ofs2insn[(int)nofs] : -1);
+    for (auto &&st : sites) {
+      if (st.ofs != it.ofs || st.resumeDepth < 0) continue;
+      if (nidx < 0 || insns[nidx].nativeOfs < 0) {
+        // cannot resume (the call is the last instruction?); continue in the interpreter
+        st.resumeDepth = -1;
+      } else {
+        st.resumeOfs = (vuint32)insns[nidx].nativeOfs;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VMethod::JitCompile
+//
+//==========================================================================
+bool VMethod::JitCompile () {
+  if (jitCode) return true;
+  if (jitState != JIT_None) return false;
+  jitState = JIT_Rejected; // in case of failure
+  if (!vmCodeStart || !vmCodeSize || (Flags&FUNC_Native) != 0) { ++jitRejectedCount; return false; }
+  static_assert(sizeof(VStack) == 8, "invalid VStack size for x86-64 JIT");
+
+  VMJitCompiler jc(this);
+  if (!jc.decode() || !jc.calcDepth() || !jc.emitAll()) { ++jitRejectedCount; return false; }
+
+  vuint8 *code = vmJitPutCode(jc.em.code.ptr(), (size_t)jc.em.code.length());
+  if (!code) { ++jitRejectedCount; return false; }
+
+  jitCode = (VMJitCode *)Z_Malloc(sizeof(VMJitCode)+jc.sites.length()*sizeof(VMJitSite));
+  jitCode->entry = (VMJitCode::EntryFn)(void *)code;
+  jitCode->code = code;
+  jitCode->codeSize = (vuint32)jc.em.code.length();
+  jitCode->siteCount = (vuint32)jc.sites.length();
+  jitCode->sites = (VMJitSite *)(jitCode+1);
+  if (jc.sites.length()) memcpy(jitCode->sites, jc.sites.ptr(), jc.sites.length()*sizeof(VMJitSite));
+
+  jitState = JIT_Compiled;
+  ++jitCompiledCount;
+  return true;
+}
+
+#else
+
+//==========================================================================
+//
+//  VMethod::JitCompile
+//
+//==========================================================================
+bool VMethod::JitCompile () {
+  if (jitState == JIT_None) { jitState = JIT_Rejected; ++jitRejectedCount; }
+  return false;
+}
+
+#endif
 #endif
@@ -87,6 +87,7 @@ TArray<VObject *> VObject::GObjObjects;
 // but Spelunky Remake *may* use "immediate delete" mode, so leave it here
 static int gObjFirstFree = 0; // frist free index in `GObjObjects`
 int VObject::GNumDeleted = 0;
+vuint32 VObject::gcDeadFilter[VObject::GCDeadFilterBits/32];
 bool VObject::GInGarbageCollection = false;
 static void *GNewObject = nullptr;
 bool VObject::GImmediadeDelete = true;
@@ -465,6 +466,12 @@ void VObject::StaticInitOptions (VParsedArgs &pargs) {
   pargs.RegisterFlagSet("-vc-lax-conversions", "!allow silent int<->float conversions", &VMemberBase::optDeprecatedLaxConversions);
   pargs.RegisterFlagReset("-vc-no-lax-conversions", "!do not allow silent int<->float conversions", &VMemberBase::optDeprecatedLaxConversions);
 
+  pargs.RegisterFlagSet("-vc-jit", "!compile hot VC methods to native code", &VMethod::jitEnabled);
+  pargs.RegisterFlagReset("-vc-no-jit", "!do not compile VC methods to native code", &VMethod::jitEnabled);
+
+  pargs.RegisterFlagSet("-vc-progs-cache", "!cache compiled VC code on disk", &VPackage::progsCacheEnabled);
+  pargs.RegisterFlagReset("-vc-no-progs-cache", "!do not cache compiled VC code on disk", &VPackage::progsCacheEnabled);
+
   pargs.RegisterFlagSet("-vc-allow-unsafe", "!allow unsafe VC operations", &VMemberBase::unsafeCodeAllowed);
   pargs.RegisterFlagReset("-vc-disable-unsafe", "!do not allow unsafe VC operations", &VMemberBase::unsafeCodeAllowed);
 
@@ -595,6 +602,8 @@ void VObject::SetFlags (vuint32 NewFlags) noexcept {
     // no need to remove from delayed deletion list, GC cycle will take care of that
     // set "cleanup ref" flag here, 'cause why not?
     NewFlags |= VObjFlag_CleanupRef;
+    const vuint32 bit = GetGCDeadFilterBit(this);
+    gcDeadFilter[bit>>5] |= 1u<<(bit&31);
     ++GNumDeleted;
     ++gcLastStats.markedDead;
     vdgclogf("marked object(%u) #%d: %p (%s)", UniqueId, Index, this, GetClass()->GetName());
@@ -691,6 +700,8 @@ void VObject::CollectGarbage (bool destroyDelayed) {
   if (!GNumDeleted && !destroyDelayed) return;
   vassert(GNumDeleted >= 0);
 
+  VPROF_ZONE("gc", "CollectGarbage");
+
   GInGarbageCollection = true;
 
   vdgclogf("collecting garbage");
@@ -709,7 +720,7 @@ void VObject::CollectGarbage (bool destroyDelayed) {
   }
 
   // no need to mark objects to be cleaned, `VObjFlag_CleanupRef` was set in `SetFlag()`
-  int alive = 0, bodycount = 0;
+  int alive = 0, bodycount = 0, skipped = 0;
   double lasttime = -Sys_Time();
 
   const int ilen = gObjFirstFree;
@@ -810,8 +821,8 @@ void VObject::CollectGarbage (bool destroyDelayed) {
 #ifdef VC_GARBAGE_COLLECTOR_CHECKS
       vassert(obj && (obj->ObjectFlags&VObjFlag_Destroyed) == 0 && obj->Index == itpos);
 #endif
-      // we have alive object, clear references
-      obj->ClearReferences();
+      // we have alive object, clear references (if it can hold any)
+      if (obj->Class->ObjectFlags&CLASSOF_NoRefs) ++skipped; else obj->ClearReferences();
       ++itpos; // move to the next object
     }
 
@@ -823,6 +834,10 @@ void VObject::CollectGarbage (bool destroyDelayed) {
     // update last free position; we cached it, so it is safe
     gObjFirstFree = itpos;
 
+    // all references are cleared, and marked objects are at the end of the list; forget their
+    // addresses before deleting them (destructors can mark more objects, keep those)
+    memset((void *)gcDeadFilter, 0, sizeof(gcDeadFilter));
+
     // use itpos to delete dead objects
     while (itpos < ilen) {
       VObject *obj = goptr[itpos];
@@ -859,6 +874,16 @@ void VObject::CollectGarbage (bool destroyDelayed) {
     gcLastStats.lastCollected = bodycount;
     gcLastStats.lastCollectDuration = lasttime;
   }
+  gcLastStats.lastVisited = alive-skipped;
+  gcLastStats.lastSkipped = skipped;
+  ++gcLastStats.collections;
+  gcLastStats.totalCollectDuration += lasttime;
+  if (gcLastStats.maxCollectDuration < lasttime) gcLastStats.maxCollectDuration = lasttime;
+  {
+    int bidx = 0;
+    while (bidx < GCStats::PauseHistSize-1 && lasttime >= GetGCPauseBucketLimit(bidx)) ++bidx;
+    ++gcLastStats.pauseHist[bidx];
+  }
   gcLastStats.poolSize = GObjObjects.length();
   gcLastStats.poolAllocated = GObjObjects.NumAllocated();
   gcLastStats.firstFree = gObjFirstFree;
@@ -512,6 +512,15 @@ public:
     int firstFree; // first free slot in pool
     double lastCollectDuration; // in seconds
     double lastCollectTime;
+    int lastVisited; // number of objects visited by the last collection
+    int lastSkipped; // number of objects skipped by the last collection (they cannot hold references)
+    // pause times, for all collections since startup
+    enum { PauseHistSize = 12 };
+    int collections; // total number of collections
+    double maxCollectDuration; // in seconds
+    double totalCollectDuration; // in seconds
+    // bucket `n` counts pauses shorter than `GetGCPauseBucketLimit(n)`; the last one counts everything else
+    int pauseHist[PauseHistSize];
   };
 
 private:
@@ -529,6 +538,11 @@ private:
 
   static GCStats gcLastStats;
 
+  // bitmap of addresses of objects marked for cleanup (set in `SetFlags()`, cleared by GC)
+  enum { GCDeadFilterBits = 65536 };
+  static vuint32 gcDeadFilter[GCDeadFilterBits/32];
+  static inline vuint32 GetGCDeadFilterBit (const VObject *obj) noexcept { return (vuint32)((((vuint64)(uintptr_t)obj>>4)*0x9e3779b97f4a7c15ull)>>48); }
+
 public:
   static bool GImmediadeDelete; // has any sense only for standalone executor
   static bool GGCMessagesAllowed;
@@ -587,6 +601,13 @@ public:
   void operator delete (void *, const char *, int);
 
   inline bool IsRefToCleanup () const noexcept { return !!(ObjectFlags&VObjFlag_CleanupRef); }
+  // the same as `obj && obj->IsRefToCleanup()`, but checks the address bitmap first, so
+  // references to alive objects are rejected without touching them (GC visits a lot of them)
+  static inline bool IsNonNullRefToCleanup (const VObject *obj) noexcept {
+    if (!obj) return false;
+    const vuint32 bit = GetGCDeadFilterBit(obj);
+    return ((gcDeadFilter[bit>>5]&(1u<<(bit&31))) && obj->IsRefToCleanup());
+  }
   inline bool IsDelayedDestroy () const noexcept { return !!(ObjectFlags&VObjFlag_DelayedDestroy); }
   inline bool IsGoingToDie () const noexcept { return !!(ObjectFlags&(VObjFlag_DelayedDestroy|VObjFlag_Destroyed)); }
   inline bool IsDestroyed () const noexcept { return !!(ObjectFlags&VObjFlag_Destroyed); }
@@ -601,6 +622,8 @@ public:
   virtual void SerialiseOther (VStream &); // this serialises other object internal data
   void Serialise (VStream &); // this calls field serialisation, then other serialisation (and writes metadata)
 
+  // native classes that override this should be declared with `CLASS_NativeReferences`,
+  // otherwise GC can skip their objects if they have no reference fields
   virtual void ClearReferences ();
   virtual bool ExecuteNetMethod (VMethod *);
 
@@ -651,10 +674,7 @@ public:
   // i.e. you can call `ConditionalDestroy()` as many times as you want to
   void ConditionalDestroy () noexcept;
 
-  inline bool IsA (VClass *SomeBaseClass) const noexcept {
-    for (const VClass *c = Class; c; c = c->GetSuperClass()) if (SomeBaseClass == c) return true;
-    return false;
-  }
+  inline bool IsA (VClass *SomeBaseClass) const noexcept { return (Class && Class->IsChildOf(SomeBaseClass)); }
 
   // accessors
   inline VClass *GetClass () const noexcept { return Class; }
@@ -670,6 +690,8 @@ public:
 
   inline static const GCStats &GetGCStats () noexcept { return gcLastStats; }
   inline static void ResetGCStatsLastCollected () noexcept { gcLastStats.lastCollected = 0; }
+  // upper limit of pause histogram bucket, in seconds (0.125 msec for the first one, doubled for each next)
+  static inline double GetGCPauseBucketLimit (int idx) noexcept { return 0.000125*(double)(1u<<(unsigned)clampval(idx, 0, GCStats::PauseHistSize-1)); }
 
   #include "vc_object_common.h"
 
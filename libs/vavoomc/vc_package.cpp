@@ -499,6 +499,8 @@ void VPackage::StaticEmitPackages () {
   }
 
   // emit classes
+  ProgsCacheStart();
+  double ett = -Sys_Time();
   for (auto &&pkg : PackagesToEmit) {
     if (pkg->ParsedClasses.length() > 0) {
       vdlogf("Emiting %d class%s for '%s'", pkg->ParsedClasses.length(), (pkg->ParsedClasses.length() != 1 ? "es" : ""), *pkg->Name);
@@ -509,6 +511,9 @@ void VPackage::StaticEmitPackages () {
       if (vcErrorCount) BailOut();
     }
   }
+  ett += Sys_Time();
+  if (VObject::cliShowPackageLoading) GLog.Logf(NAME_Init, "VavoomC: emitted IR in %s", secs2timestr(ett));
+  ProgsCacheFinish();
 
   // postload everything except structs
   //if (!VObject::compilerDisablePostloading)
@@ -573,6 +578,9 @@ void VPackage::StaticEmitPackages () {
   }
 
   PackagesToEmit.clear();
+
+  // new classes are complete, so we can renumber the hierarchy
+  VClass::StaticRenumberHierarchy();
 }
 
 
@@ -138,6 +138,43 @@ public:
 
   static void DumpCodeSizeStats ();
 
+public:
+  // persistent progs cache (see "vc_progs_cache.cpp")
+  static int progsCacheEnabled; // default is true
+
+  // called by the lexer
+  static void ProgsCacheAddSource (VStr filename, const void *data, int size);
+  static void ProgsCacheAddDefines (const TArray<VStr> &defines);
+
+  // the resolver should not bake name indicies into the code when this is `true`
+  static bool IsProgsCacheActive () noexcept;
+
+  // called from `VMethod::Emit()`; returns `true` if IR was restored from the cache
+  static bool ProgsCacheRestoreMethod (VMethod *mt);
+  // called from `VMethod::Emit()` when the method was emitted (i.e. not restored)
+  static void ProgsCacheEmitMethodDone (VMethod *mt);
+
+  // caching of methods emitted by the host (decorate, for example)
+  // members starting from `firstMember` are cached; the file name is `prefix` with progs packages suffix
+  static void ProgsCacheBeginExternal (const char *prefix, int firstMember);
+  // returns number of methods restored from the cache
+  static int ProgsCacheEndExternal ();
+
+  // should be implemented by the host; can return `nullptr` to disable caching
+  static VStream *OpenProgsCacheFile (VStr fname, bool forWriting);
+
+  // should be implemented by the host; this should change when the host binary changes
+  static VStr GetProgsCacheBuildTag ();
+
+private:
+  static void ProgsCacheCalcKey ();
+  static bool ProgsCacheLoad (VStream *strm);
+  static void ProgsCacheSave (VStream *strm);
+  static void ProgsCacheOpen ();
+  // called from `StaticEmitPackages()`
+  static void ProgsCacheStart ();
+  static void ProgsCacheFinish ();
+
 public:
   // returns `nullptr` on list end; starts with 0
   static const char *GetPkgImportFile (unsigned idx);
@@ -0,0 +1,1110 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+// persistent progs cache
+//
+// the cache stores optimised IR for all methods emitted by one call to
+// `StaticEmitPackages()`. on the next run, `VMethod::Emit()` takes IR from
+// the cache instead of resolving, emitting and optimising method bodies.
+// codegen (`PostLoad()`) is still done as usual, so field offsets, vtable
+// indicies and type sizes are always recalculated.
+//
+// cache key includes all source files seen by the lexer, lexer defines,
+// compiler options, VM opcode tables, host build tag, and the list of all
+// members known before emitting. any change in any of those invalidates
+// the whole cache.
+//
+// members are stored by their index in `GMembers`, source files are stored
+// by name. names, strings and types are stored in tables (by value), and
+// instructions refer to them by index. the whole data is unpacked into
+// memory before parsing, so loading is much faster than emitting.
+//
+// the host can also cache code emitted outside of `StaticEmitPackages()`
+// (decorate actions, for example) with `ProgsCacheBeginExternal()` and
+// `ProgsCacheEndExternal()`. such cache is stored in a separate file, and
+// only methods created after `firstMember` are stored there. source files
+// for it should be registered with `ProgsCacheAddSource()` before calling
+// `ProgsCacheBeginExternal()`.
+//
+// emit-time warnings (like unused locals) are recorded for each method, and
+// they are printed again when the method is taken from the cache.
+//
+// only method bodies are cached. parsing, `Define()` and `PostLoad()` still
+// run on each start: caching laid-out classes would mean serialising the
+// whole member graph (with native bindings and default objects), which is a
+// second compiler front end. emitting and optimising was the biggest part of
+// the startup time, and it is the part that doesn't depend on anything except
+// sources and compiler options, so it is safe to cache.
+//**************************************************************************
+#include "vc_local.h"
+
+
+static int constexpr cestlen (const char *s, int pos=0) noexcept { return (s && s[pos] ? 1+cestlen(s, pos+1) : 0); }
+static constexpr const char *PROGS_CACHE_SIGNATURE = "VAVOOM PROGS CACHE VERSION 003\n";
+enum { PCSLEN = cestlen(PROGS_CACHE_SIGNATURE) };
+static_assert(PCSLEN == 31, "oops!");
+
+
+int VPackage::progsCacheEnabled = 1;
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+struct PCMethodRec {
+  vint32 NumLocals;
+  TArray<FInstruction> Instructions;
+  TArray<VStr> Warnings; // emit-time warnings, will be printed on restore
+};
+
+// emit-time warning, recorded for saving
+struct PCWarning {
+  vint32 MemberIndex;
+  VStr Text;
+};
+
+
+static RIPEMD160_Ctx pcSourceCtx;
+static bool pcSourceCtxInited = false;
+
+static bool pcActive = false; // are we inside `StaticEmitPackages()`?
+static bool pcNeedSave = false;
+static vint32 pcMemberCount = 0; // number of members before emitting
+static vint32 pcMemberStart = 0; // first member to cache
+static vuint8 pcKey[RIPEMD160_BYTES];
+static VStr pcFileName;
+static VStr pcPackagesTag; // package names part of the file name; empty if the last round was not cached
+static TMapNC<vint32, PCMethodRec *> pcRestoreMap; // key is member index
+static int pcRestoredCount = 0;
+static TArray<PCWarning> pcWarnings; // warnings of emitted methods, in emit order
+static TArray<VMethod *> pcEmitStack; // methods being emitted (not restored), for warning recording
+
+
+// records warnings of the method being emitted
+class PCWarningRecorder : public VLogListener {
+public:
+  VStr Line; // current unfinished line
+
+  virtual void Serialise (const char *Text, EName Event) noexcept override {
+    if (Event != NAME_Warning || !Text || pcEmitStack.length() == 0) return;
+    for (const char *s = Text; *s; ++s) {
+      if (*s == '\n') {
+        if (Line.length()) {
+          PCWarning &w = pcWarnings.alloc();
+          w.MemberIndex = pcEmitStack[pcEmitStack.length()-1]->MemberIndex;
+          w.Text = Line;
+          Line.clear();
+        }
+      } else {
+        Line += *s;
+      }
+    }
+  }
+};
+
+static PCWarningRecorder pcWarnRecorder;
+static bool pcWarnRecorderActive = false;
+
+
+// fast reader for the method code; `VStream` is too slow for millions of small fields
+struct PCCodeReader {
+  const vuint8 *pos;
+  const vuint8 *end;
+  bool error;
+
+  inline PCCodeReader (const vuint8 *adata, int asize) noexcept : pos(adata), end(adata+asize), error(false) {}
+
+  inline vuint8 readByte () noexcept {
+    if (pos >= end) { error = true; return 0; }
+    return *pos++;
+  }
+
+  inline vint32 readIndex () noexcept {
+    if (pos >= end) { error = true; return 0; }
+    if ((*pos&0x80) == 0) return *pos++; // most values are small
+    const int len = decodeVarIntLength(*pos);
+    if (len > (int)(end-pos)) { error = true; return 0; }
+    const vuint32 res = decodeVarInt(pos);
+    pos += len;
+    return (vint32)res;
+  }
+
+  inline float readFloat () noexcept {
+    if (end-pos < 4) { error = true; return 0.0f; }
+    const vuint32 v = pos[0]|(pos[1]<<8)|(pos[2]<<16)|((vuint32)pos[3]<<24);
+    pos += 4;
+    float res;
+    memcpy(&res, &v, 4);
+    return res;
+  }
+};
+
+
+// key for the type table (used when saving)
+struct PCTypeKey {
+  vuint8 Types[6];
+  const void *KPtr;
+  const void *VPtr;
+
+  inline PCTypeKey (const VFieldType &t) noexcept
+    : KPtr((const void *)t.KClass)
+    , VPtr((const void *)t.Class)
+  {
+    Types[0] = t.Type;
+    Types[1] = t.InnerType;
+    Types[2] = t.ArrayInnerType;
+    Types[3] = t.KeyInnerType;
+    Types[4] = t.ValueInnerType;
+    Types[5] = t.PtrLevel;
+  }
+
+  inline bool operator == (const PCTypeKey &k) const noexcept {
+    return (memcmp(Types, k.Types, 6) == 0 && KPtr == k.KPtr && VPtr == k.VPtr);
+  }
+};
+
+static VVA_OKUNUSED inline uint32_t GetTypeHash (const PCTypeKey &k) noexcept {
+  return joaatHashBuf(k.Types, 6, hashU32((uint32_t)(uintptr_t)k.KPtr)^hashU32((uint32_t)(uintptr_t)k.VPtr));
+}
+
+
+// member reference kinds for `VFieldType` unions
+enum {
+  PCRef_Raw,
+  PCRef_Class,
+  PCRef_Struct,
+  PCRef_Method,
+};
+
+
+//==========================================================================
+//
+//  pcInitSourceCtx
+//
+//==========================================================================
+static void pcInitSourceCtx () {
+  if (pcSourceCtxInited) return;
+  pcSourceCtxInited = true;
+  ripemd160_init(&pcSourceCtx);
+}
+
+
+//==========================================================================
+//
+//  pcPutStr
+//
+//==========================================================================
+static inline void pcPutStr (RIPEMD160_Ctx *ctx, const char *s) {
+  if (!s) s = "";
+  ripemd160_put(ctx, s, strlen(s)+1); // with terminator
+}
+
+
+//==========================================================================
+//
+//  pcPutInt
+//
+//==========================================================================
+static inline void pcPutInt (RIPEMD160_Ctx *ctx, vint32 v) {
+  vuint8 buf[4];
+  buf[0] = (vuint8)v;
+  buf[1] = (vuint8)(v>>8);
+  buf[2] = (vuint8)(v>>16);
+  buf[3] = (vuint8)(v>>24);
+  ripemd160_put(ctx, buf, 4);
+}
+
+
+//==========================================================================
+//
+//  pcClearRestoreMap
+//
+//==========================================================================
+static void pcClearRestoreMap () {
+  for (auto it = pcRestoreMap.first(); it; ++it) delete it.getValue();
+  pcRestoreMap.clear();
+}
+
+
+//==========================================================================
+//
+//  pcStopWarningRecorder
+//
+//==========================================================================
+static void pcStopWarningRecorder () {
+  if (pcWarnRecorderActive) {
+    VLog::RemoveListener(&pcWarnRecorder);
+    pcWarnRecorderActive = false;
+  }
+  pcWarnRecorder.Line.clear();
+  pcWarnings.clear();
+  pcEmitStack.clear();
+}
+
+
+//==========================================================================
+//
+//  pcKeyRefKind
+//
+//  what is stored in `KClass` union
+//
+//==========================================================================
+static int pcKeyRefKind (const VFieldType &t) {
+  if (t.Type != TYPE_Dictionary) return PCRef_Raw;
+  if (t.KeyInnerType == TYPE_Reference || t.KeyInnerType == TYPE_Class) return PCRef_Class;
+  if (t.KeyInnerType == TYPE_Struct) return PCRef_Struct;
+  return PCRef_Raw;
+}
+
+
+//==========================================================================
+//
+//  pcValueRefKind
+//
+//  what is stored in `Class` union
+//
+//==========================================================================
+static int pcValueRefKind (const VFieldType &t) {
+  vuint8 rt = t.Type;
+       if (rt == TYPE_Array || rt == TYPE_DynamicArray || rt == TYPE_SliceArray) rt = t.ArrayInnerType;
+  else if (rt == TYPE_Dictionary) rt = t.ValueInnerType;
+  if (rt == TYPE_Pointer) rt = t.InnerType;
+  switch (rt) {
+    case TYPE_Reference: case TYPE_Class: return PCRef_Class;
+    case TYPE_Struct: case TYPE_Vector: return PCRef_Struct;
+    case TYPE_Delegate: return PCRef_Method;
+  }
+  return PCRef_Raw;
+}
+
+
+//==========================================================================
+//
+//  pcIsMemberCacheable
+//
+//  members created while emitting are not cacheable
+//
+//==========================================================================
+static bool pcIsMemberCacheable (const VMemberBase *m) {
+  if (!m) return true;
+  return (m->MemberIndex >= 0 && m->MemberIndex < pcMemberCount && VMemberBase::GMembers[m->MemberIndex] == m);
+}
+
+
+//==========================================================================
+//
+//  pcIsTypeCacheable
+//
+//==========================================================================
+static bool pcIsTypeCacheable (const VFieldType &t) {
+  if (pcKeyRefKind(t) == PCRef_Raw) {
+    // make sure that the value survives 32-bit roundtrip
+    if ((uintptr_t)t.KClass != (uintptr_t)(vuint32)t.ArrayDimInternal) return false;
+  } else {
+    if (!pcIsMemberCacheable(t.KClass)) return false;
+  }
+  if (pcValueRefKind(t) == PCRef_Raw) {
+    if ((uintptr_t)t.Class != (uintptr_t)t.BitMask) return false;
+  } else {
+    if (!pcIsMemberCacheable(t.Class)) return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  pcIsMethodCacheable
+//
+//==========================================================================
+static bool pcIsMethodCacheable (const VMethod *mt) {
+  if (mt->Instructions.length() == 0) return false;
+  for (auto &&insn : mt->Instructions) {
+    if ((unsigned)insn.Opcode >= (unsigned)NUM_OPCODES) return false;
+    if (!pcIsMemberCacheable(insn.Member)) return false;
+    if (!pcIsTypeCacheable(insn.TypeArg)) return false;
+    if (!pcIsTypeCacheable(insn.TypeArg1)) return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  pcWriteName
+//
+//==========================================================================
+static void pcWriteName (VStream &strm, VName n) {
+  VStr s;
+  if (n != NAME_None) s = VStr(*n);
+  strm << s;
+}
+
+
+//==========================================================================
+//
+//  pcReadName
+//
+//==========================================================================
+static VName pcReadName (VStream &strm) {
+  VStr s;
+  strm << s;
+  if (s.isEmpty()) return NAME_None;
+  return VName(*s);
+}
+
+
+//==========================================================================
+//
+//  pcWriteMemberRef
+//
+//==========================================================================
+static void pcWriteMemberRef (VStream &strm, const VMemberBase *m) {
+  vint32 idx = (m ? m->MemberIndex : -1);
+  strm << STRM_INDEX(idx);
+}
+
+
+//==========================================================================
+//
+//  pcReadMemberRef
+//
+//  returns `false` on error
+//
+//==========================================================================
+static bool pcReadMemberRef (VStream &strm, VMemberBase *&m, int kind) {
+  vint32 idx = -1;
+  strm << STRM_INDEX(idx);
+  if (strm.IsError()) return false;
+  if (idx == -1) { m = nullptr; return true; }
+  if (idx < 0 || idx >= pcMemberCount) return false;
+  m = VMemberBase::GMembers[idx];
+  if (!m) return false;
+  switch (kind) {
+    case PCRef_Class: return (m->MemberType == MEMBER_Class);
+    case PCRef_Struct: return (m->MemberType == MEMBER_Struct);
+    case PCRef_Method: return (m->MemberType == MEMBER_Method);
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  pcWriteType
+//
+//==========================================================================
+static void pcWriteType (VStream &strm, VFieldType &t) {
+  strm << t.Type << t.InnerType << t.ArrayInnerType << t.KeyInnerType << t.ValueInnerType << t.PtrLevel;
+  if (pcKeyRefKind(t) == PCRef_Raw) {
+    strm << STRM_INDEX(t.ArrayDimInternal);
+  } else {
+    pcWriteMemberRef(strm, t.KClass);
+  }
+  if (pcValueRefKind(t) == PCRef_Raw) {
+    vint32 bm = (vint32)t.BitMask;
+    strm << STRM_INDEX(bm);
+  } else {
+    pcWriteMemberRef(strm, t.Class);
+  }
+}
+
+
+//==========================================================================
+//
+//  pcReadType
+//
+//==========================================================================
+static bool pcReadType (VStream &strm, VFieldType &t) {
+  t = VFieldType();
+  strm << t.Type << t.InnerType << t.ArrayInnerType << t.KeyInnerType << t.ValueInnerType << t.PtrLevel;
+  if (strm.IsError()) return false;
+  const int kkind = pcKeyRefKind(t);
+  if (kkind == PCRef_Raw) {
+    t.KClass = nullptr;
+    strm << STRM_INDEX(t.ArrayDimInternal);
+  } else {
+    VMemberBase *m = nullptr;
+    if (!pcReadMemberRef(strm, m, kkind)) return false;
+    if (kkind == PCRef_Class) t.KClass = (VClass *)m; else t.KStruct = (VStruct *)m;
+  }
+  const int vkind = pcValueRefKind(t);
+  if (vkind == PCRef_Raw) {
+    vint32 bm = 0;
+    strm << STRM_INDEX(bm);
+    t.Class = nullptr;
+    t.BitMask = (vuint32)bm;
+  } else {
+    VMemberBase *m = nullptr;
+    if (!pcReadMemberRef(strm, m, vkind)) return false;
+         if (vkind == PCRef_Class) t.Class = (VClass *)m;
+    else if (vkind == PCRef_Struct) t.Struct = (VStruct *)m;
+    else t.Function = (VMethod *)m;
+  }
+  return !strm.IsError();
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheAddSource
+//
+//  called by the lexer for each loaded source file
+//
+//==========================================================================
+void VPackage::ProgsCacheAddSource (VStr filename, const void *data, int size) {
+  if (!progsCacheEnabled) return;
+  pcInitSourceCtx();
+  pcPutStr(&pcSourceCtx, *filename);
+  pcPutInt(&pcSourceCtx, size);
+  if (size > 0) ripemd160_put(&pcSourceCtx, data, (size_t)size);
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheAddDefines
+//
+//  called by the lexer when it opens the main source file
+//
+//==========================================================================
+void VPackage::ProgsCacheAddDefines (const TArray<VStr> &defines) {
+  if (!progsCacheEnabled) return;
+  pcInitSourceCtx();
+  pcPutInt(&pcSourceCtx, defines.length());
+  for (auto &&ds : defines) pcPutStr(&pcSourceCtx, *ds);
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheCalcKey
+//
+//==========================================================================
+void VPackage::ProgsCacheCalcKey () {
+  RIPEMD160_Ctx ctx;
+  ripemd160_init(&ctx);
+
+  pcPutStr(&ctx, PROGS_CACHE_SIGNATURE);
+  pcPutStr(&ctx, *GetProgsCacheBuildTag());
+  pcPutInt(&ctx, (vint32)sizeof(void *));
+
+  // VM tables
+  pcPutInt(&ctx, NUM_OPCODES);
+  for (int f = 0; f < NUM_OPCODES; ++f) {
+    pcPutStr(&ctx, StatementInfo[f].name);
+    pcPutInt(&ctx, StatementInfo[f].Args);
+  }
+  for (const VStatementBuiltinInfo *bi = StatementBuiltinInfo; bi->name; ++bi) pcPutStr(&ctx, bi->name);
+  for (const VStatementBuiltinInfo *bi = StatementDictDispatchInfo; bi->name; ++bi) pcPutStr(&ctx, bi->name);
+  for (const VStatementBuiltinInfo *bi = StatementDynArrayDispatchInfo; bi->name; ++bi) pcPutStr(&ctx, bi->name);
+
+  // compiler options
+  pcPutInt(&ctx, VMemberBase::optDeprecatedLaxOverride);
+  pcPutInt(&ctx, VMemberBase::optDeprecatedLaxStates);
+  pcPutInt(&ctx, VMemberBase::optDeprecatedLaxConversions);
+  pcPutInt(&ctx, VMemberBase::unsafeCodeAllowed);
+  pcPutInt(&ctx, VMemberBase::koraxCompatibility);
+  pcPutInt(&ctx, VObject::cliCaseSensitiveLocals);
+  pcPutInt(&ctx, VObject::cliCaseSensitiveFields);
+  pcPutInt(&ctx, VObject::cliVirtualiseDecorateMethods);
+  // options that gate emit-time warnings (recorded warnings are replayed from the cache)
+  pcPutInt(&ctx, VMemberBase::unsafeCodeWarning);
+  pcPutInt(&ctx, vcWarningsSilenced);
+
+  // sources; this accumulates all sources seen so far, so later packages depend on earlier ones
+  // (finish a copy, because the context is reused for the next round)
+  pcInitSourceCtx();
+  RIPEMD160_Ctx srcctx = pcSourceCtx;
+  vuint8 srchash[RIPEMD160_BYTES];
+  ripemd160_finish(&srcctx, srchash);
+  ripemd160_put(&ctx, srchash, RIPEMD160_BYTES);
+
+  // names are not hashed: they are stored by value, and the emitter may create new names,
+  // so name indicies are not stable between rounds
+
+  // all members
+  pcPutInt(&ctx, pcMemberStart);
+  pcPutInt(&ctx, pcMemberCount);
+  for (int f = 0; f < pcMemberCount; ++f) {
+    const VMemberBase *m = GMembers[f];
+    if (!m) { pcPutInt(&ctx, -1); continue; }
+    pcPutInt(&ctx, m->MemberType);
+    pcPutStr(&ctx, *m->Name);
+    pcPutInt(&ctx, (m->Outer ? m->Outer->MemberIndex : -1));
+  }
+
+  ripemd160_finish(&ctx, pcKey);
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheLoad
+//
+//  returns success flag
+//
+//==========================================================================
+bool VPackage::ProgsCacheLoad (VStream *strm) {
+  char sign[PCSLEN];
+  strm->Serialise(sign, PCSLEN);
+  if (strm->IsError() || memcmp(sign, PROGS_CACHE_SIGNATURE, PCSLEN) != 0) return false;
+
+  vuint8 key[RIPEMD160_BYTES];
+  strm->Serialise(key, RIPEMD160_BYTES);
+  if (strm->IsError() || memcmp(key, pcKey, RIPEMD160_BYTES) != 0) return false;
+
+  vint32 usize = -1;
+  *strm << STRM_INDEX(usize);
+  if (strm->IsError() || usize <= 0 || usize > 0x3fffffff) return false;
+
+  // unpack everything at once; parsing small fields from the unpacker is much slower
+  TArrayNC<vuint8> data;
+  data.setLength(usize);
+  {
+    VZLibStreamReader *zstrm = new VZLibStreamReader(true, strm, VZLibStreamReader::UNKNOWN_SIZE, (vuint32)usize);
+    zstrm->Serialise(data.ptr(), usize);
+    const bool zerr = zstrm->IsError();
+    delete zstrm;
+    if (zerr) return false;
+  }
+
+  VMemoryStreamRO rd("progscache", data.ptr(), usize);
+
+  vuint32 flags = 0x29a;
+  vint32 mcount = -1;
+  rd << flags << STRM_INDEX(mcount);
+  if (rd.IsError() || flags != 0 || mcount != pcMemberCount) return false;
+
+  // source file names
+  TArray<int> srcMap;
+  vint32 srccount = -1;
+  rd << STRM_INDEX(srccount);
+  if (rd.IsError() || srccount < 0 || srccount > 0xffff) return false;
+  srcMap.setLength(srccount);
+  for (int f = 0; f < srccount; ++f) {
+    VStr sname;
+    rd << sname;
+    if (rd.IsError()) return false;
+    srcMap[f] = (f == 0 ? 0 : TLocation::AddSourceFile(sname));
+  }
+
+  // names (index 0 is `NAME_None`)
+  TArray<VName> names;
+  vint32 namecount = -1;
+  rd << STRM_INDEX(namecount);
+  if (rd.IsError() || namecount < 0 || namecount > 0xffffff) return false;
+  names.setLength(namecount+1);
+  names[0] = NAME_None;
+  for (int f = 1; f <= namecount; ++f) {
+    names[f] = pcReadName(rd);
+    if (rd.IsError()) return false;
+  }
+
+  // strings
+  TArray<VStr> strings;
+  vint32 strcount = -1;
+  rd << STRM_INDEX(strcount);
+  if (rd.IsError() || strcount < 0 || strcount > 0xffffff) return false;
+  strings.setLength(strcount);
+  for (auto &&str : strings) {
+    rd << str;
+    if (rd.IsError()) return false;
+  }
+
+  // types
+  TArray<VFieldType> types;
+  vint32 typecount = -1;
+  rd << STRM_INDEX(typecount);
+  if (rd.IsError() || typecount < 0 || typecount > 0xffffff) return false;
+  types.setLength(typecount);
+  for (auto &&t : types) {
+    if (!pcReadType(rd, t)) return false;
+  }
+
+  // warnings
+  TArray<PCWarning> warnings;
+  vint32 warncount = -1;
+  rd << STRM_INDEX(warncount);
+  if (rd.IsError() || warncount < 0 || warncount > 0xffffff) return false;
+  warnings.setLength(warncount);
+  for (auto &&w : warnings) {
+    rd << STRM_INDEX(w.MemberIndex) << w.Text;
+    if (rd.IsError()) return false;
+  }
+
+  // methods
+  if (rd.IsError()) return false;
+  PCCodeReader cr(data.ptr()+rd.Tell(), usize-rd.Tell());
+  const vint32 mtcount = cr.readIndex();
+  if (cr.error || mtcount < 0 || mtcount > pcMemberCount) return false;
+  for (int mtn = 0; mtn < mtcount; ++mtn) {
+    const vint32 midx = cr.readIndex();
+    const vint32 numlocals = cr.readIndex();
+    const vint32 icount = cr.readIndex();
+    if (cr.error || midx < pcMemberStart || midx >= pcMemberCount || numlocals < 0 || icount <= 0 || icount > 0x1fffffff) return false;
+    VMemberBase *mm = GMembers[midx];
+    if (!mm || mm->MemberType != MEMBER_Method || pcRestoreMap.has(midx)) return false;
+    VMethod *mt = (VMethod *)mm;
+    VPackage *pkg = mt->GetPackage();
+
+    PCMethodRec *rec = new PCMethodRec;
+    pcRestoreMap.put(midx, rec);
+    rec->NumLocals = numlocals;
+    rec->Instructions.setLength(icount);
+    for (auto &&insn : rec->Instructions) {
+      const vint32 opc = cr.readIndex();
+      const vuint8 ifl = cr.readByte();
+      if (cr.error || opc < 0 || opc >= NUM_OPCODES) return false;
+      insn.Opcode = opc;
+      insn.Arg1IsFloat = !!(ifl&1);
+      // arguments
+      vint32 idx;
+      switch (StatementInfo[opc].Args) {
+        case OPCARGS_String:
+          idx = cr.readIndex();
+          if (idx < 0 || idx >= strcount) return false;
+          insn.Arg1 = pkg->FindString(strings[idx]);
+          break;
+        case OPCARGS_NameBranchTarget:
+          idx = cr.readIndex();
+          if (idx < 0 || idx > namecount) return false;
+          insn.Arg1 = names[idx].GetIndex();
+          break;
+        default:
+          if (insn.Arg1IsFloat) insn.Arg1F = cr.readFloat(); else insn.Arg1 = cr.readIndex();
+          break;
+      }
+      if (StatementInfo[opc].Args == OPCARGS_BuiltinCVar) {
+        idx = cr.readIndex();
+        if (idx < 0 || idx > namecount) return false;
+        insn.Arg2 = names[idx].GetIndex();
+      } else {
+        insn.Arg2 = cr.readIndex();
+      }
+      // member
+      idx = cr.readIndex();
+      if (idx == -1) {
+        insn.Member = nullptr;
+      } else {
+        if (idx < 0 || idx >= pcMemberCount || !GMembers[idx]) return false;
+        insn.Member = GMembers[idx];
+      }
+      const vint32 nidx = cr.readIndex();
+      const vint32 tidx0 = cr.readIndex();
+      const vint32 tidx1 = cr.readIndex();
+      if (nidx < 0 || nidx > namecount || tidx0 < 0 || tidx0 >= typecount || tidx1 < 0 || tidx1 >= typecount) return false;
+      insn.NameArg = names[nidx];
+      insn.TypeArg = types[tidx0];
+      insn.TypeArg1 = types[tidx1];
+      const vint32 sidx = cr.readIndex();
+      const vint32 line = cr.readIndex();
+      if (cr.error || sidx < 0 || sidx >= srccount) return false;
+      insn.loc = TLocationLine(srcMap[sidx], line);
+      // short name form can be invalid if name indicies were changed
+      if (insn.Opcode == OPC_PushNameS && insn.NameArg.GetIndex() >= MAX_VINT16) insn.Opcode = OPC_PushName;
+    }
+    if (rec->Instructions[icount-1].Opcode != OPC_Done) return false;
+  }
+
+  for (auto &&w : warnings) {
+    auto pp = pcRestoreMap.get(w.MemberIndex);
+    if (!pp) return false;
+    (*pp)->Warnings.append(w.Text);
+  }
+
+  return (!cr.error && cr.pos == cr.end);
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheSave
+//
+//  names, strings and types are stored in tables, and the code refers
+//  to them by index
+//
+//==========================================================================
+void VPackage::ProgsCacheSave (VStream *strm) {
+  // collect cacheable methods, and referenced source files
+  TArray<VMethod *> mlist;
+  TMapNC<vint32, bool> mset;
+  TArray<int> srcList; // new index -> source index
+  TMapNC<int, int> srcMap; // source index -> new index
+  srcList.append(0);
+  srcMap.put(0, 0);
+  for (int f = pcMemberStart; f < pcMemberCount; ++f) {
+    VMemberBase *m = GMembers[f];
+    if (!m || m->MemberType != MEMBER_Method) continue;
+    VMethod *mt = (VMethod *)m;
+    if (!mt->emitCalled || !pcIsMethodCacheable(mt)) continue;
+    mlist.append(mt);
+    mset.put(mt->MemberIndex, true);
+    for (auto &&insn : mt->Instructions) {
+      const int sidx = insn.loc.GetSrcIndex();
+      if (!srcMap.has(sidx)) {
+        srcMap.put(sidx, srcList.length());
+        srcList.append(sidx);
+      }
+    }
+  }
+
+  // write code first, collecting tables
+  TArray<VName> nameList;
+  TMapNC<VName, int> nameMap; // name -> index (0 is `NAME_None`)
+  TArray<VStr> strList;
+  TMap<VStr, int> strMap;
+  TArray<VFieldType> typeList;
+  TMapNC<PCTypeKey, int> typeMap;
+
+  VMemoryStream code;
+  vint32 mtcount = mlist.length();
+  code << STRM_INDEX(mtcount);
+  for (VMethod *mt : mlist) {
+    VPackage *pkg = mt->GetPackage();
+    vint32 midx = mt->MemberIndex;
+    vint32 icount = mt->Instructions.length();
+    code << STRM_INDEX(midx) << STRM_INDEX(mt->NumLocals) << STRM_INDEX(icount);
+    for (auto &&insn : mt->Instructions) {
+      vuint8 ifl = (insn.Arg1IsFloat ? 1 : 0);
+      code << STRM_INDEX(insn.Opcode) << ifl;
+      // collect names used in this instruction
+      VName iname[3] = { NAME_None, NAME_None, insn.NameArg };
+      if (StatementInfo[insn.Opcode].Args == OPCARGS_NameBranchTarget) iname[0] = VName::CreateWithIndexSafe(insn.Arg1);
+      if (StatementInfo[insn.Opcode].Args == OPCARGS_BuiltinCVar) iname[1] = VName::CreateWithIndexSafe(insn.Arg2);
+      vint32 nidx[3];
+      for (int f = 0; f < 3; ++f) {
+        if (iname[f] == NAME_None) { nidx[f] = 0; continue; }
+        auto np = nameMap.get(iname[f]);
+        if (np) {
+          nidx[f] = *np;
+        } else {
+          nameList.append(iname[f]);
+          nidx[f] = nameList.length();
+          nameMap.put(iname[f], nidx[f]);
+        }
+      }
+      // arguments
+      switch (StatementInfo[insn.Opcode].Args) {
+        case OPCARGS_String:
+          {
+            VStr s = pkg->GetStringByIndex(insn.Arg1);
+            auto sp = strMap.get(s);
+            vint32 sidx;
+            if (sp) {
+              sidx = *sp;
+            } else {
+              sidx = strList.length();
+              strList.append(s);
+              strMap.put(s, sidx);
+            }
+            code << STRM_INDEX(sidx);
+          }
+          break;
+        case OPCARGS_NameBranchTarget:
+          code << STRM_INDEX(nidx[0]);
+          break;
+        default:
+          if (insn.Arg1IsFloat) code << insn.Arg1F; else code << STRM_INDEX(insn.Arg1);
+          break;
+      }
+      if (StatementInfo[insn.Opcode].Args == OPCARGS_BuiltinCVar) {
+        code << STRM_INDEX(nidx[1]);
+      } else {
+        code << STRM_INDEX(insn.Arg2);
+      }
+      pcWriteMemberRef(code, insn.Member);
+      vint32 tidx[2];
+      for (int f = 0; f < 2; ++f) {
+        VFieldType &t = (f == 0 ? insn.TypeArg : insn.TypeArg1);
+        const PCTypeKey tkey(t);
+        auto tp = typeMap.get(tkey);
+        if (tp) {
+          tidx[f] = *tp;
+        } else {
+          tidx[f] = typeList.length();
+          typeList.append(t);
+          typeMap.put(tkey, tidx[f]);
+        }
+      }
+      code << STRM_INDEX(nidx[2]) << STRM_INDEX(tidx[0]) << STRM_INDEX(tidx[1]);
+      vint32 sidx = *srcMap.get(insn.loc.GetSrcIndex());
+      vint32 line = insn.loc.GetLine();
+      code << STRM_INDEX(sidx) << STRM_INDEX(line);
+    }
+  }
+
+  // now build the whole data
+  VMemoryStream wr;
+
+  vuint32 flags = 0;
+  wr << flags << STRM_INDEX(pcMemberCount);
+
+  vint32 srccount = srcList.length();
+  wr << STRM_INDEX(srccount);
+  for (int f = 0; f < srccount; ++f) {
+    VStr sname = (f == 0 ? VStr() : TLocation::GetSourceFileByIndex(srcList[f]));
+    wr << sname;
+  }
+
+  vint32 namecount = nameList.length();
+  wr << STRM_INDEX(namecount);
+  for (auto &&n : nameList) pcWriteName(wr, n);
+
+  vint32 strcount = strList.length();
+  wr << STRM_INDEX(strcount);
+  for (auto &&str : strList) wr << str;
+
+  vint32 typecount = typeList.length();
+  wr << STRM_INDEX(typecount);
+  for (auto &&t : typeList) pcWriteType(wr, t);
+
+  // warnings for methods that are not cached will be printed by the compiler anyway
+  vint32 warncount = 0;
+  for (auto &&w : pcWarnings) if (mset.has(w.MemberIndex)) ++warncount;
+  wr << STRM_INDEX(warncount);
+  for (auto &&w : pcWarnings) {
+    if (!mset.has(w.MemberIndex)) continue;
+    wr << STRM_INDEX(w.MemberIndex) << w.Text;
+  }
+
+  wr.Serialise(code.GetArray().ptr(), code.GetArray().length());
+
+  strm->Serialise(PROGS_CACHE_SIGNATURE, PCSLEN);
+  strm->Serialise(pcKey, RIPEMD160_BYTES);
+  vint32 usize = wr.GetArray().length();
+  *strm << STRM_INDEX(usize);
+
+  // fast compression level: higher levels gain ~20% in size, and they are several times slower
+  VZLibStreamWriter *zstrm = new VZLibStreamWriter(strm, 1);
+  zstrm->Serialise(wr.GetArray().ptr(), usize);
+  bool err = zstrm->IsError();
+  if (!zstrm->Close()) err = true;
+  delete zstrm;
+  strm->Flush();
+  if (err || strm->IsError()) {
+    GLog.Logf(NAME_Warning, "VavoomC: cannot write progs cache '%s'", *pcFileName);
+  } else if (VObject::cliShowPackageLoading) {
+    GLog.Logf(NAME_Init, "VavoomC: cached %d methods in '%s'", mlist.length(), *pcFileName);
+  }
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheStart
+//
+//  called from `StaticEmitPackages()` before emitting classes
+//
+//==========================================================================
+void VPackage::ProgsCacheStart () {
+  pcClearRestoreMap();
+  pcActive = false;
+  pcNeedSave = false;
+  pcRestoredCount = 0;
+  pcPackagesTag.clear();
+
+  if (!progsCacheEnabled || vcErrorCount) return;
+  // we need the full compilation for dumps
+  if (VMemberBase::doAsmDump || VObject::cliAsmDumpMethods.length()) return;
+  if (PackagesToEmit.length() == 0) return;
+
+  // build file name from package names
+  for (auto &&pkg : PackagesToEmit) {
+    pcPackagesTag += "_";
+    for (const char *s = *pkg->Name; *s; ++s) {
+      const char ch = VStr::locase1251(*s);
+      pcPackagesTag += ((ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') ? ch : '_');
+    }
+  }
+  pcFileName = VStr("progs")+pcPackagesTag+".cache";
+
+  pcMemberStart = 0;
+  ProgsCacheOpen();
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheOpen
+//
+//  calculates the key, and loads the cache file
+//  `pcFileName` and `pcMemberStart` should be set
+//
+//==========================================================================
+void VPackage::ProgsCacheOpen () {
+  double stt = -Sys_Time();
+  pcMemberCount = GMembers.length();
+  ProgsCacheCalcKey();
+
+  pcActive = true;
+  pcNeedSave = true;
+
+  VStream *strm = OpenProgsCacheFile(pcFileName, false);
+  if (strm) {
+    if (ProgsCacheLoad(strm)) {
+      pcNeedSave = false;
+    } else {
+      pcClearRestoreMap();
+      if (VObject::cliShowPackageLoading) GLog.Logf(NAME_Init, "VavoomC: progs cache '%s' is obsolete or in invalid format", *pcFileName);
+    }
+    VStream::Destroy(strm);
+  }
+  stt += Sys_Time();
+
+  // record emit-time warnings, so they could be printed on the next run
+  pcStopWarningRecorder();
+  if (pcNeedSave) {
+    VLog::AddListener(&pcWarnRecorder);
+    pcWarnRecorderActive = true;
+  }
+
+  if (!pcNeedSave && VObject::cliShowPackageLoading) {
+    GLog.Logf(NAME_Init, "VavoomC: loaded %d methods from progs cache '%s' in %s", pcRestoreMap.count(), *pcFileName, secs2timestr(stt));
+  }
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheFinish
+//
+//  called from `StaticEmitPackages()` after emitting classes
+//
+//==========================================================================
+void VPackage::ProgsCacheFinish () {
+  if (!pcActive) return;
+  pcActive = false;
+
+  // stop recording, but keep the warnings for saving
+  if (pcWarnRecorderActive) {
+    VLog::RemoveListener(&pcWarnRecorder);
+    pcWarnRecorderActive = false;
+  }
+
+  if (pcNeedSave && vcErrorCount == 0) {
+    VStream *strm = OpenProgsCacheFile(pcFileName, true);
+    if (strm) {
+      ProgsCacheSave(strm);
+      VStream::Destroy(strm);
+    }
+  }
+
+  if (pcRestoredCount && VObject::cliShowPackageLoading) {
+    GLog.Logf(NAME_Init, "VavoomC: %d methods restored from progs cache", pcRestoredCount);
+  }
+
+  pcClearRestoreMap();
+  pcStopWarningRecorder();
+  pcNeedSave = false;
+  pcRestoredCount = 0;
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheBeginExternal
+//
+//  starts caching methods emitted by the host
+//  members starting from `firstMember` will be cached
+//
+//==========================================================================
+void VPackage::ProgsCacheBeginExternal (const char *prefix, int firstMember) {
+  if (pcActive) ProgsCacheFinish();
+  pcClearRestoreMap();
+  pcNeedSave = false;
+  pcRestoredCount = 0;
+
+  if (!progsCacheEnabled || vcErrorCount) return;
+  if (VMemberBase::doAsmDump || VObject::cliAsmDumpMethods.length()) return;
+  // external code depends on progs, so don't bother if progs were not cached
+  if (pcPackagesTag.isEmpty() || !prefix || !prefix[0]) return;
+  if (firstMember < 0 || firstMember > GMembers.length()) return;
+
+  pcFileName = VStr(prefix)+pcPackagesTag+".cache";
+  pcMemberStart = firstMember;
+  ProgsCacheOpen();
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheEndExternal
+//
+//  returns number of methods restored from the cache
+//
+//==========================================================================
+int VPackage::ProgsCacheEndExternal () {
+  const int res = (pcActive ? pcRestoredCount : 0);
+  ProgsCacheFinish();
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VPackage::IsProgsCacheActive
+//
+//==========================================================================
+bool VPackage::IsProgsCacheActive () noexcept {
+  return pcActive;
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheRestoreMethod
+//
+//  called from `VMethod::Emit()`
+//  returns `true` if method IR was restored from the cache
+//
+//==========================================================================
+bool VPackage::ProgsCacheRestoreMethod (VMethod *mt) {
+  if (!pcActive || !mt) return false;
+  auto pp = (mt->MemberIndex >= 0 && mt->MemberIndex < pcMemberCount ? pcRestoreMap.get(mt->MemberIndex) : nullptr);
+  if (!pp) {
+    // this method will be emitted, record its warnings
+    if (pcWarnRecorderActive) pcEmitStack.append(mt);
+    return false;
+  }
+  PCMethodRec *rec = *pp;
+  pcRestoreMap.del(mt->MemberIndex);
+  mt->NumLocals = rec->NumLocals;
+  mt->Instructions.transferDataFrom(rec->Instructions);
+  for (auto &&w : rec->Warnings) GLog.Log(NAME_Warning, *w);
+  delete rec;
+  ++pcRestoredCount;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VPackage::ProgsCacheEmitMethodDone
+//
+//  called from `VMethod::Emit()` after the method was emitted
+//
+//==========================================================================
+void VPackage::ProgsCacheEmitMethodDone (VMethod *mt) {
+  if (pcEmitStack.length() && pcEmitStack[pcEmitStack.length()-1] == mt) pcEmitStack.drop();
+}
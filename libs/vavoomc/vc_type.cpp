@@ -1774,7 +1774,7 @@ bool VScriptDict::cleanRefs () {
     // cleanup key references
     if (kt.Type == TYPE_Reference) {
       VObject *obj = *(VObject **)it.getKey().value;
-      if (obj && obj->IsRefToCleanup()) {
+      if (VObject::IsNonNullRefToCleanup(obj)) {
         // this key must be removed
         res = true;
         //it.getKey().clear();
@@ -1795,7 +1795,7 @@ bool VScriptDict::cleanRefs () {
       }
     } else if (vt.Type == TYPE_Reference) {
       VObject *obj = *(VObject **)it.getValue().value;
-      if (obj && obj->IsRefToCleanup()) {
+      if (VObject::IsNonNullRefToCleanup(obj)) {
         res = true;
         it.getValue().clear();
       }
@@ -111,6 +111,7 @@ static VCvarB acs_debug_start_acs("acs_debug_start_acs", false, "Show some info
 
 static VCvarB dbg_acs_allow_unimplemented_opcodes("dbg_acs_allow_unimplemented_opcodes", false, "Override 'acs_halt_on_unimplemented_opcode', non-persistent", CVAR_PreInit|CVAR_NoShadow);
 
+static VCvarI acs_string_gc_threshold("acs_string_gc_threshold", "4096", "Reclaim unused ACS dynamic strings when there are more than this number of them (0: never).", CVAR_Archive|CVAR_NoShadow);
 static VCvarS acs_fake_player_class("acs_fake_player_class", "", "Return this fake player class instead of the real one.", /*CVAR_Archive|*/CVAR_PreInit|CVAR_NoShadow);
 
 extern VCvarF mouse_x_sensitivity;
@@ -275,6 +276,9 @@ struct VAcsInfo {
   VACSLocalArrays LocalArrays;
   VName Name; // NAME_None for unnamed scripts; lowercased
   VAcs *RunningScript;
+  // profiling
+  vuint32 RunCount; // number of `RunScript()` calls that executed some code
+  double RunTime; // total execution time, in seconds
 
   static const char *GetTypeName (int type) noexcept {
     switch (type) {
@@ -427,6 +431,12 @@ private:
 
   TArray<VAcsObject *> Imports;
 
+  // script lookup; built when the object is completely loaded
+  TMapNC<int, int> ScriptByNumber; // script number -> index in `Scripts`
+  TMapNC<int, int> ScriptByName; // name index -> index in `Scripts`
+  bool ScriptIndexReady;
+
+  void BuildScriptIndex ();
   void LoadOldObject ();
   void LoadEnhancedObject ();
   void UnencryptStrings ();
@@ -467,6 +477,7 @@ public:
   }
 
   inline int GetLibraryID () const { return LibraryID; }
+  inline int GetLumpNum () const { return LumpNum; }
 
   VAcsInfo *FindScript (int Number) const;
   VAcsInfo *FindScriptByName (int nameidx) const;
@@ -599,6 +610,21 @@ public:
 
   void TranslateSpecial (int &spec, int &arg1);
   int RunScript (float DeltaTime, bool immediate);
+
+  // values passed to VC code can be stored anywhere, so if some of them
+  // are dynamic string handles, those strings should never be reclaimed
+  inline void PinStrings (const vint32 *vals, int count) noexcept {
+    VAcsLevel *acslevel = ActiveObject->Level;
+    while (count-- > 0) acslevel->PinStringHandle(*vals++);
+  }
+
+  inline int ExecuteActionSpecial (int Special, int Arg1, int Arg2, int Arg3, int Arg4, int Arg5,
+                                   line_t *Line, int Side, VEntity *A)
+  {
+    const vint32 args[5] = { Arg1, Arg2, Arg3, Arg4, Arg5 };
+    PinStrings(args, 5);
+    return Level->eventExecuteActionSpecial(Special, Arg1, Arg2, Arg3, Arg4, Arg5, Line, Side, A);
+  }
   virtual void Tick (float) override;
   int CallFunction (line_t *line, int argCount, int funcIndex, vint32 *args);
 
@@ -775,6 +801,7 @@ VAcsObject::VAcsObject (VAcsLevel *ALevel, int Lump) : Functions(), Level(ALevel
   ArrayStore = nullptr;
   NumTotalArrays = 0;
   Arrays = nullptr;
+  ScriptIndexReady = false;
   memset((void *)MapVarStore, 0, sizeof(MapVarStore));
 
   VAcsHeader *header;
@@ -840,6 +867,8 @@ VAcsObject::VAcsObject (VAcsLevel *ALevel, int Lump) : Functions(), Level(ALevel
     LoadEnhancedObject();
   }
 
+  BuildScriptIndex();
+
   // dump all objects
   /*
   for (int i = 0; i < Level->LoadedObjects.length(); ++i) {
@@ -880,6 +909,27 @@ VAcsObject::~VAcsObject () {
 }
 
 
+//==========================================================================
+//
+//  VAcsObject::BuildScriptIndex
+//
+//  if there are several scripts with the same number (or name), the first
+//  one wins, like with the linear search
+//
+//==========================================================================
+void VAcsObject::BuildScriptIndex () {
+  ScriptByNumber.reset();
+  ScriptByName.reset();
+  for (int i = 0; i < NumScripts; ++i) {
+    const int num = Scripts[i].Number;
+    if (!ScriptByNumber.has(num)) ScriptByNumber.put(num, i);
+    const int nidx = Scripts[i].Name.GetIndex();
+    if (nidx && !ScriptByName.has(nidx)) ScriptByName.put(nidx, i);
+  }
+  ScriptIndexReady = true;
+}
+
+
 //==========================================================================
 //
 //  VAcsObject::LoadOldObject
@@ -1599,6 +1649,10 @@ VAcsInfo *VAcsObject::FindScript (int Number) const {
     Number = -(Number+SPECIAL_LOW_SCRIPT_NUMBER);
     return &Scripts[Number];
   }
+  if (ScriptIndexReady) {
+    auto ip = ScriptByNumber.get(Number);
+    return (ip ? Scripts+(*ip) : nullptr);
+  }
   for (int i = 0; i < NumScripts; ++i) {
     if (Scripts[i].Number == Number) return Scripts+i;
   }
@@ -1618,7 +1672,10 @@ VAcsInfo *VAcsObject::FindScriptByName (int nameidx) const {
     if (nameidx < 0) return nullptr;
   }
   //for (int i = 0; i < NumScripts; i++) fprintf(stderr, "#%d: index=%d; name=<%s>\n", i, Scripts[i].Number, *Scripts[i].Name); abort();
-  //FIXME: make this faster by using hash table
+  if (ScriptIndexReady) {
+    auto ip = ScriptByName.get(nameidx);
+    return (ip ? Scripts+(*ip) : nullptr);
+  }
   for (int i = 0; i < NumScripts; ++i) {
     if (Scripts[i].Name.GetIndex() == nameidx) return Scripts+i;
   }
@@ -1635,10 +1692,7 @@ VAcsInfo *VAcsObject::FindScriptByNameStr (VStr aname) const {
   if (aname.length() == 0) return nullptr;
   VName nn = VName(*aname, VName::FindLower);
   if (nn == NAME_None) return nullptr;
-  for (int i = 0; i < NumScripts; ++i) {
-    if (Scripts[i].Name == nn) return Scripts+i;
-  }
-  return nullptr;
+  return FindScriptByName(nn.GetIndex());
 }
 
 
@@ -1651,10 +1705,8 @@ int VAcsObject::FindScriptNumberByName (VStr aname) const {
   if (aname.length() == 0) return -1;
   VName nn = VName(*aname, VName::FindLower);
   if (nn == NAME_None) return -1;
-  for (int i = 0; i < NumScripts; ++i) {
-    if (Scripts[i].Name == nn) return -SPECIAL_LOW_SCRIPT_NUMBER-i;
-  }
-  return -1;
+  const VAcsInfo *info = FindScriptByName(nn.GetIndex());
+  return (info ? -SPECIAL_LOW_SCRIPT_NUMBER-(int)(ptrdiff_t)(info-Scripts) : -1);
 }
 
 
@@ -1743,6 +1795,16 @@ void VAcsObject::StartTypedACScripts (int Type, int Arg1, int Arg2, int Arg3, /*
 VAcsLevel::VAcsLevel (VLevel *ALevel)
   : stringMapByStr()
   , stringList()
+  , stringState()
+  , stringFree()
+  , stringMarks()
+  , stringLastGCTic(0)
+  , stringGCCount(0)
+  , stringGCFreed(0)
+  , stringGCTime(0)
+  , scriptsByNumber()
+  , scriptsByName()
+  , scriptIndexObjCount(-1)
   , XLevel(ALevel)
 {
 }
@@ -1797,14 +1859,135 @@ int VAcsLevel::PutNewString (VStr str) {
   auto idxp = stringMapByStr.get(str);
   if (idxp) return (*idxp)|(ACSLEVEL_INTERNAL_STRING_STORAGE_INDEX<<16);
   // add string
-  int idx = stringList.length();
-  if (idx == 0xffff) Host_Error("ACS dynamic string storage overflow");
-  stringList.append(str);
+  int idx;
+  if (stringFree.length()) {
+    idx = stringFree[stringFree.length()-1];
+    stringFree.setLengthNoResize(stringFree.length()-1);
+    stringList[idx] = str;
+  } else {
+    idx = stringList.length();
+    if (idx == 0xffff) Host_Error("ACS dynamic string storage overflow");
+    stringList.append(str);
+    stringState.append(STRS_Free);
+  }
+  stringState[idx] = STRS_Live;
   stringMapByStr.put(str, idx);
   return idx|(ACSLEVEL_INTERNAL_STRING_STORAGE_INDEX<<16);
 }
 
 
+//==========================================================================
+//
+//  VAcsLevel::MarkStringHandle
+//
+//==========================================================================
+void VAcsLevel::MarkStringHandle (int handle) noexcept {
+  if (((vuint32)handle>>16) != ACSLEVEL_INTERNAL_STRING_STORAGE_INDEX) return;
+  const int idx = handle&0xffff;
+  if (idx < stringMarks.length()) stringMarks[idx] = 1;
+}
+
+
+//==========================================================================
+//
+//  VAcsLevel::PinStringHandle
+//
+//==========================================================================
+void VAcsLevel::PinStringHandle (int handle) noexcept {
+  if (((vuint32)handle>>16) != ACSLEVEL_INTERNAL_STRING_STORAGE_INDEX) return;
+  const int idx = handle&0xffff;
+  if (idx < stringState.length() && stringState[idx] == STRS_Live) stringState[idx] = STRS_Pinned;
+}
+
+
+//==========================================================================
+//
+//  VAcsLevel::MarkScriptVars
+//
+//==========================================================================
+void VAcsLevel::MarkScriptVars (const vint32 *vars, int count) noexcept {
+  if (!vars) return;
+  while (count-- > 0) MarkStringHandle(*vars++);
+}
+
+
+//==========================================================================
+//
+//  VAcsLevel::CollectStrings
+//
+//  this is conservative: any variable value that looks like a string
+//  handle keeps the string alive. script stacks are always empty here,
+//  because scripts cannot delay with something on the stack. handles
+//  that were passed to VC code are pinned (see `PinStringHandle()`), as
+//  we cannot scan VC objects for them.
+//
+//==========================================================================
+void VAcsLevel::CollectStrings (bool force) {
+  const int count = stringList.length();
+  if (!force) {
+    const int threshold = acs_string_gc_threshold.asInt();
+    if (threshold <= 0 || count-stringFree.length() <= threshold) return;
+    // don't do it too often
+    if (XLevel->TicTime-stringLastGCTic < 35) return;
+  }
+  stringLastGCTic = XLevel->TicTime;
+  if (count == 0) return;
+
+  const double stt = Sys_Time();
+  stringMarks.setLengthNoResize(count);
+  memset(stringMarks.ptr(), 0, (size_t)count);
+
+  // map variables and arrays
+  for (auto &&obj : LoadedObjects) {
+    MarkScriptVars(obj->MapVarStore, MAX_ACS_MAP_VARS);
+    for (int f = 0; f < obj->NumArrays; ++f) MarkScriptVars(obj->ArrayStore[f].Data, obj->ArrayStore[f].Size);
+  }
+
+  // world and global variables and arrays, and script store arguments
+  if (XLevel->WorldInfo && XLevel->WorldInfo->Acs) XLevel->WorldInfo->Acs->MarkStrings(this);
+
+  // locals (with local arrays) of running scripts
+  for (auto &&sth : XLevel->scriptThinkers) {
+    if (!sth || sth->destroyed) continue;
+    VAcs *acs = (VAcs *)sth;
+    MarkScriptVars(acs->LocalVars, acs->LocalVarsCount);
+  }
+
+  // sweep
+  int freed = 0;
+  for (int f = 0; f < count; ++f) {
+    if (stringMarks[f] || stringState[f] != STRS_Live) continue;
+    auto idxp = stringMapByStr.get(stringList[f]);
+    if (idxp && *idxp == f) stringMapByStr.del(stringList[f]);
+    stringList[f].clear();
+    stringState[f] = STRS_Free;
+    stringFree.append(f);
+    ++freed;
+  }
+
+  ++stringGCCount;
+  stringGCFreed += (vuint32)freed;
+  stringGCTime += Sys_Time()-stt;
+}
+
+
+//==========================================================================
+//
+//  VAcsLevel::DumpStringPoolStats
+//
+//==========================================================================
+void VAcsLevel::DumpStringPoolStats () {
+  size_t bytes = 0;
+  for (auto &&s : stringList) bytes += (size_t)s.length();
+  int pinned = 0;
+  for (auto &&st : stringState) if (st == STRS_Pinned) ++pinned;
+  GCon->Logf("ACS dynamic strings: %d live (%d pinned), %d free slots, %d total slots (of 65535), %u bytes",
+    stringList.length()-stringFree.length(), pinned, stringFree.length(), stringList.length(), (unsigned)bytes);
+  GCon->Logf("  %u collections, %u strings reclaimed, %.3f msec total collection time",
+    stringGCCount, stringGCFreed, stringGCTime*1000.0);
+}
+
+
 //==========================================================================
 //
 //  VAcsLevel::LoadObject
@@ -1820,12 +2003,46 @@ VAcsObject *VAcsLevel::LoadObject (int Lump) {
 }
 
 
+//==========================================================================
+//
+//  VAcsLevel::UpdateScriptIndex
+//
+//  rebuilds the index if new objects were loaded
+//  returns `false` if some object is still loading (use linear search then)
+//
+//==========================================================================
+bool VAcsLevel::UpdateScriptIndex () {
+  if (scriptIndexObjCount == LoadedObjects.length()) return true;
+  for (auto &&obj : LoadedObjects) if (!obj->ScriptIndexReady && obj->NumScripts) return false;
+  scriptsByNumber.reset();
+  scriptsByName.reset();
+  for (int oidx = 0; oidx < LoadedObjects.length(); ++oidx) {
+    VAcsObject *obj = LoadedObjects[oidx];
+    // first object wins
+    for (auto it = obj->ScriptByNumber.first(); it; ++it) {
+      if (!scriptsByNumber.has(it.getKey())) scriptsByNumber.put(it.getKey(), ScriptRef(oidx, it.getValue()));
+    }
+    for (auto it = obj->ScriptByName.first(); it; ++it) {
+      if (!scriptsByName.has(it.getKey())) scriptsByName.put(it.getKey(), ScriptRef(oidx, it.getValue()));
+    }
+  }
+  scriptIndexObjCount = LoadedObjects.length();
+  return true;
+}
+
+
 //==========================================================================
 //
 //  VAcsLevel::FindScript
 //
 //==========================================================================
 VAcsInfo *VAcsLevel::FindScript (int Number, VAcsObject *&Object) {
+  if (Number > -SPECIAL_LOW_SCRIPT_NUMBER && UpdateScriptIndex()) {
+    auto rp = scriptsByNumber.get(Number);
+    if (!rp) return nullptr;
+    Object = LoadedObjects[rp->ObjIdx];
+    return &Object->Scripts[rp->ScriptIdx];
+  }
   for (int i = 0; i < LoadedObjects.length(); ++i) {
     VAcsInfo *Found = LoadedObjects[i]->FindScript(Number);
     if (Found) {
@@ -1843,6 +2060,13 @@ VAcsInfo *VAcsLevel::FindScript (int Number, VAcsObject *&Object) {
 //
 //==========================================================================
 VAcsInfo *VAcsLevel::FindScriptByName (int Number, VAcsObject *&Object) {
+  if (Number == 0) return nullptr;
+  if (UpdateScriptIndex()) {
+    auto rp = scriptsByName.get(Number < 0 ? -Number : Number);
+    if (!rp) return nullptr;
+    Object = LoadedObjects[rp->ObjIdx];
+    return &Object->Scripts[rp->ScriptIdx];
+  }
   for (int i = 0; i < LoadedObjects.length(); ++i) {
     VAcsInfo *Found = LoadedObjects[i]->FindScriptByName(Number);
     if (Found) {
@@ -1863,14 +2087,7 @@ VAcsInfo *VAcsLevel::FindScriptByNameStr (VStr aname, VAcsObject *&Object) {
   if (aname.length() == 0) return nullptr;
   VName nn = VName(*aname, VName::FindLower);
   if (nn == NAME_None) return nullptr;
-  for (int i = 0; i < LoadedObjects.length(); ++i) {
-    VAcsInfo *Found = LoadedObjects[i]->FindScriptByName(-nn.GetIndex());
-    if (Found) {
-      Object = LoadedObjects[i];
-      return Found;
-    }
-  }
-  return nullptr;
+  return FindScriptByName(nn.GetIndex(), Object);
 }
 
 
@@ -1881,6 +2098,14 @@ VAcsInfo *VAcsLevel::FindScriptByNameStr (VStr aname, VAcsObject *&Object) {
 //==========================================================================
 int VAcsLevel::FindScriptNumberByName (VStr aname, VAcsObject *&Object) {
   if (aname.length() == 0) return -1;
+  if (UpdateScriptIndex()) {
+    VName nn = VName(*aname, VName::FindLower);
+    if (nn == NAME_None) return -1;
+    auto rp = scriptsByName.get(nn.GetIndex());
+    if (!rp) return -1;
+    Object = LoadedObjects[rp->ObjIdx];
+    return -SPECIAL_LOW_SCRIPT_NUMBER-rp->ScriptIdx;
+  }
   for (int i = 0; i < LoadedObjects.length(); ++i) {
     int idx = LoadedObjects[i]->FindScriptNumberByName(aname);
     if (idx <= -SPECIAL_LOW_SCRIPT_NUMBER) {
@@ -1954,9 +2179,10 @@ void VAcsLevel::StartTypedACScripts (int Type, int Arg1, int Arg2, int Arg3,
 //
 //==========================================================================
 void VAcsLevel::Serialise (VStream &Strm) {
-  vuint8 xver = 1;
+  // version 2 saves dynamic string slot states
+  vuint8 xver = 2;
   Strm << xver;
-  if (xver != 1) Host_Error("invalid ACS level version in save file");
+  if (xver != 1 && xver != 2) Host_Error("invalid ACS level version in save file");
 
   //GCon->Logf("serializing ACS level");
 
@@ -1973,12 +2199,33 @@ void VAcsLevel::Serialise (VStream &Strm) {
   vint32 sllen = stringList.length();
   Strm << STRM_INDEX(sllen);
 
-  if (Strm.IsLoading()) stringList.setLength(sllen);
+  // free slots are saved as empty strings
+  if (Strm.IsLoading()) {
+    stringList.setLength(sllen);
+    stringState.setLength(sllen);
+  }
   for (int f = 0; f < sllen; ++f) Strm << stringList[f];
 
+  if (xver >= 2) {
+    for (int f = 0; f < sllen; ++f) {
+      Strm << stringState[f];
+      if (stringState[f] > STRS_Pinned) Host_Error("invalid ACS dynamic string state in save file");
+    }
+  } else {
+    // we don't know which handles were passed to VC code, so keep them all
+    for (int f = 0; f < sllen; ++f) stringState[f] = STRS_Pinned;
+  }
+
   if (Strm.IsLoading()) {
     stringMapByStr.clear();
-    for (int f = 0; f < sllen; ++f) stringMapByStr.put(stringList[f], f);
+    stringFree.clear();
+    for (int f = 0; f < sllen; ++f) {
+      if (stringState[f] == STRS_Free) {
+        stringFree.append(f);
+      } else {
+        stringMapByStr.put(stringList[f], f);
+      }
+    }
   }
 }
 
@@ -2149,6 +2396,8 @@ bool VAcsLevel::Start (int Number, int MapNum, int Arg1, int Arg2, int Arg3, int
       script->Destroy();
       delete script;
     }
+    // the result could be returned to VC code
+    PinStringHandle(res);
     if (realres) *realres = res;
     return !!res;
   }
@@ -2338,6 +2587,16 @@ void AcsTerminateScript (VAcsLevel *acslevel, int number, int map) {
 }
 
 
+//==========================================================================
+//
+//  AcsCollectStrings
+//
+//==========================================================================
+void AcsCollectStrings (VAcsLevel *acslevel) {
+  if (acslevel) acslevel->CollectStrings();
+}
+
+
 //==========================================================================
 //
 //  AcsHasScripts
@@ -3010,7 +3269,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
         //GCon->Logf(NAME_Debug, "***ACS:%d: LSPEC1: special=%d; args=(%d)", info->Number, special, sp[-1]);
-        Level->eventExecuteActionSpecial(special, sp[-1], 0, 0, 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, sp[-1], 0, 0, 0, 0, line, side, Activator);
         --sp;
       }
       ACSVM_BREAK;
@@ -3021,7 +3280,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
         //GCon->Logf(NAME_Debug, "***ACS:%d: LSPEC2: special=%d; args=(%d,%d)", info->Number, special, sp[-2], sp[-1]);
-        Level->eventExecuteActionSpecial(special, sp[-2], sp[-1], 0, 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, sp[-2], sp[-1], 0, 0, 0, line, side, Activator);
         sp -= 2;
       }
       ACSVM_BREAK;
@@ -3032,7 +3291,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
         //GCon->Logf(NAME_Debug, "***ACS:%d: LSPEC3: special=%d; args=(%d,%d,%d)", info->Number, special, sp[-3], sp[-2], sp[-1]);
-        Level->eventExecuteActionSpecial(special, sp[-3], sp[-2], sp[-1], 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, sp[-3], sp[-2], sp[-1], 0, 0, line, side, Activator);
         sp -= 3;
       }
       ACSVM_BREAK;
@@ -3043,7 +3302,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
         //GCon->Logf(NAME_Debug, "***ACS:%d: LSPEC4: special=%d; args=(%d,%d,%d,%d)", info->Number, special, sp[-4], sp[-3], sp[-2], sp[-1]);
-        Level->eventExecuteActionSpecial(special, sp[-4], sp[-3], sp[-2], sp[-1], 0, line, side, Activator);
+        ExecuteActionSpecial(special, sp[-4], sp[-3], sp[-2], sp[-1], 0, line, side, Activator);
         sp -= 4;
       }
       ACSVM_BREAK;
@@ -3054,7 +3313,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
         //GCon->Logf(NAME_Debug, "***ACS:%d: LSPEC5: special=%d; args=(%d,%d,%d,%d,%d)", info->Number, special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1]);
-        Level->eventExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
+        ExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
         sp -= 5;
       }
       ACSVM_BREAK;
@@ -3063,7 +3322,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
-        Level->eventExecuteActionSpecial(special, PEEK_INT32_AT(ip), 0, 0, 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, PEEK_INT32_AT(ip), 0, 0, 0, 0, line, side, Activator);
         ip += 4;
       }
       ACSVM_BREAK;
@@ -3072,7 +3331,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
-        Level->eventExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), 0, 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), 0, 0, 0, line, side, Activator);
         ip += 8;
       }
       ACSVM_BREAK;
@@ -3081,7 +3340,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
-        Level->eventExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), 0, 0, line, side, Activator);
+        ExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), 0, 0, line, side, Activator);
         ip += 12;
       }
       ACSVM_BREAK;
@@ -3090,7 +3349,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
-        Level->eventExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), PEEK_INT32_AT(ip+12), 0, line, side, Activator);
+        ExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), PEEK_INT32_AT(ip+12), 0, line, side, Activator);
         ip += 16;
       }
       ACSVM_BREAK;
@@ -3099,7 +3358,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_BYTEOR_INT32;
         INC_BYTE_OR_INT32;
-        Level->eventExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), PEEK_INT32_AT(ip+12), PEEK_INT32_AT(ip+16), line, side, Activator);
+        ExecuteActionSpecial(special, PEEK_INT32_AT(ip), PEEK_INT32_AT(ip+4), PEEK_INT32_AT(ip+8), PEEK_INT32_AT(ip+12), PEEK_INT32_AT(ip+16), line, side, Activator);
         ip += 20;
       }
       ACSVM_BREAK;
@@ -3870,6 +4129,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       ACSVM_CHECK_STACK_UNDER(7);
       {
         TranslateSpecial(sp[-6], sp[-5]);
+        PinStrings(sp-5, 5);
         int searcher = -1;
         for (line_t *line = XLevel->FindLine(sp[-7], &searcher); line != nullptr; line = XLevel->FindLine(sp[-7], &searcher)) {
           line->special = sp[-6];
@@ -4286,27 +4546,27 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       ACSVM_BREAK;
 
     ACSVM_CASE(PCD_LSpec1DirectB)
-      Level->eventExecuteActionSpecial(ip[0], ip[1], 0, 0, 0, 0, line, side, Activator);
+      ExecuteActionSpecial(ip[0], ip[1], 0, 0, 0, 0, line, side, Activator);
       ip += 2;
       ACSVM_BREAK;
 
     ACSVM_CASE(PCD_LSpec2DirectB)
-      Level->eventExecuteActionSpecial(ip[0], ip[1], ip[2], 0, 0, 0, line, side, Activator);
+      ExecuteActionSpecial(ip[0], ip[1], ip[2], 0, 0, 0, line, side, Activator);
       ip += 3;
       ACSVM_BREAK;
 
     ACSVM_CASE(PCD_LSpec3DirectB)
-      Level->eventExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], 0, 0, line, side, Activator);
+      ExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], 0, 0, line, side, Activator);
       ip += 4;
       ACSVM_BREAK;
 
     ACSVM_CASE(PCD_LSpec4DirectB)
-      Level->eventExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], ip[4], 0, line, side, Activator);
+      ExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], ip[4], 0, line, side, Activator);
       ip += 5;
       ACSVM_BREAK;
 
     ACSVM_CASE(PCD_LSpec5DirectB)
-      Level->eventExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], ip[4], ip[5], line, side, Activator);
+      ExecuteActionSpecial(ip[0], ip[1], ip[2], ip[3], ip[4], ip[5], line, side, Activator);
       ip += 6;
       ACSVM_BREAK;
 
@@ -4372,6 +4632,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       ACSVM_CHECK_STACK_UNDER(7);
       {
         TranslateSpecial(sp[-6], sp[-5]);
+        PinStrings(sp-5, 5);
         if (sp[-7] != 0) {
           for (VEntity *Ent = Level->FindMobjFromTID(sp[-7], nullptr); Ent; Ent = Level->FindMobjFromTID(sp[-7], Ent)) {
             Ent->Special = sp[-6];
@@ -5044,6 +5305,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
 
     ACSVM_CASE(PCD_SetActorProperty)
       ACSVM_CHECK_STACK_UNDER(3);
+      PinStrings(sp-1, 1);
       if (!sp[-3]) {
         if (Activator) {
           Activator->eventSetActorProperty(sp[-2], sp[-1], GetStr(sp[-1]));
@@ -5251,7 +5513,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
 
     ACSVM_CASE(PCD_LSpec5Result)
       ACSVM_CHECK_STACK_UNDER(5);
-      sp[-5] = Level->eventExecuteActionSpecial(PEEK_BYTEOR_INT32,
+      sp[-5] = ExecuteActionSpecial(PEEK_BYTEOR_INT32,
         sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side,
         Activator);
       INC_BYTE_OR_INT32;
@@ -6427,7 +6689,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_INT32_AT(ip);
         ip += 4;
-        Level->eventExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
+        ExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
         sp -= 5;
       }
       ACSVM_BREAK;
@@ -6437,7 +6699,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
       {
         int special = PEEK_INT32_AT(ip);
         ip += 4;
-        sp[-5] = Level->eventExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
+        sp[-5] = ExecuteActionSpecial(special, sp[-5], sp[-4], sp[-3], sp[-2], sp[-1], line, side, Activator);
         sp -= 4;
       }
       ACSVM_BREAK;
@@ -6515,6 +6777,9 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
 #if USE_COMPUTED_GOTO
 LblFuncStop:
 #endif
+  ++info->RunCount;
+  info->RunTime += Sys_Time()-sttime;
+
   //fprintf(stderr, "VAcs::RunScript:003: self name is '%s' (number is %d)\n", *info->Name, info->Number);
   if (action == SCRIPT_Terminate) {
     if (info->RunningScript == this) info->RunningScript = nullptr;
@@ -6572,6 +6837,23 @@ VAcsGlobal::VAcsGlobal () {
   //memset((void *)GlobalVars, 0, sizeof(GlobalVars));
 }
 
+//==========================================================================
+//
+//  VAcsGlobal::MarkStrings
+//
+//==========================================================================
+void VAcsGlobal::MarkStrings (VAcsLevel *level) {
+  auto mark = [level] (int value) { level->MarkStringHandle(value); };
+  WorldVars.forEachValue(mark);
+  GlobalVars.forEachValue(mark);
+  for (auto &&arr : WorldArrays) arr.forEachValue(mark);
+  for (auto &&arr : GlobalArrays) arr.forEachValue(mark);
+  for (auto &&st : Store) {
+    for (int f = 0; f < 4; ++f) level->MarkStringHandle(st.Args[f]);
+  }
+}
+
+
 // get gvar
 VStr VAcsGlobal::GetGlobalVarStr (VAcsLevel *level, int index) const {
   return (level && index >= 0 && index < MAX_ACS_GLOBAL_VARS ? level->GetString(GlobalVars.GetElemVal(index)) : VStr());
@@ -6865,6 +7147,75 @@ IMPLEMENT_FUNCTION(VLevel, RunNamedACSWithResult) {
 }
 
 
+//==========================================================================
+//
+//  ACSProfile
+//
+//  ACSProfile [reset]
+//
+//==========================================================================
+struct ACSProfInfo {
+  VAcsObject *obj;
+  VAcsInfo *info;
+};
+
+static int ACSProfInfoCmp (const void *a, const void *b, void * /*udata*/) {
+  if (a == b) return 0;
+  const double ta = ((const ACSProfInfo *)a)->info->RunTime;
+  const double tb = ((const ACSProfInfo *)b)->info->RunTime;
+  return (ta < tb ? 1 : ta > tb ? -1 : 0);
+}
+
+COMMAND(ACSProfile) {
+  if (!GLevel || !GLevel->Acs) {
+    GCon->Log(NAME_Error, "no level loaded");
+    return;
+  }
+
+  const bool doReset = (Args.length() > 1 && Args[1].strEquCI("reset"));
+
+  TArray<ACSProfInfo> list;
+  for (auto &&obj : GLevel->Acs->LoadedObjects) {
+    for (int f = 0; f < obj->GetNumScripts(); ++f) {
+      VAcsInfo &info = obj->GetScriptInfo(f);
+      if (doReset) {
+        info.RunCount = 0;
+        info.RunTime = 0;
+      } else if (info.RunCount) {
+        ACSProfInfo &pi = list.alloc();
+        pi.obj = obj;
+        pi.info = &info;
+      }
+    }
+  }
+  if (doReset) return;
+
+  smsort_r(list.ptr(), list.length(), sizeof(ACSProfInfo), &ACSProfInfoCmp, nullptr);
+  GCon->Logf("=== ACS profile: %d script%s executed ===", list.length(), (list.length() != 1 ? "s" : ""));
+  for (auto &&pi : list) {
+    GCon->Logf("  %9.3f msec in %6u runs: script %d (%s) in '%s'", pi.info->RunTime*1000.0, pi.info->RunCount,
+      pi.info->Number, (pi.info->Name != NAME_None ? *pi.info->Name : "unnamed"), *W_FullLumpName(pi.obj->GetLumpNum()));
+  }
+}
+
+
+//==========================================================================
+//
+//  ACSStringPool
+//
+//  ACSStringPool [gc]
+//
+//==========================================================================
+COMMAND(ACSStringPool) {
+  if (!GLevel || !GLevel->Acs) {
+    GCon->Log(NAME_Error, "no level loaded");
+    return;
+  }
+  if (Args.length() > 1 && Args[1].strEquCI("gc")) GLevel->Acs->CollectStrings(true);
+  GLevel->Acs->DumpStringPoolStats();
+}
+
+
 //==========================================================================
 //
 //  Puke
@@ -572,6 +572,7 @@ int VAcs::CallFunction (line_t *actline, int argCount, int funcIndex, vint32 *ar
           cvar->SetACS();
         }
         //GCon->Logf("ACSF: set cvar '%s' (%f)", *name, args[1]/65536.0f);
+        PinStrings(args+1, 1);
         cvar->Set(*name, args[1] /* /65536.0f */);
         return 1;
       }
@@ -603,6 +604,7 @@ int VAcs::CallFunction (line_t *actline, int argCount, int funcIndex, vint32 *ar
           cvar->SetACS();
         }
         //GCon->Logf("ACSF: set user cvar '%s' (%f)", *name, args[2]/65536.0f);
+        PinStrings(args+2, 1);
         cvar->Set(*name, args[2] /* /65536.0f */);
         return 1;
       }
@@ -940,6 +942,7 @@ int VAcs::CallFunction (line_t *actline, int argCount, int funcIndex, vint32 *ar
           return 0;
         }
         VName fldname = VName(*s);
+        PinStrings(args+2, 1);
         int count = 0;
         if (args[0] == 0) {
           if (doSetUserVarOrArray(Activator, fldname, args[2], false)) ++count;
@@ -979,6 +982,7 @@ int VAcs::CallFunction (line_t *actline, int argCount, int funcIndex, vint32 *ar
           return 0;
         }
         VName fldname = VName(*s);
+        PinStrings(args+3, 1);
         int count = 0;
         if (args[0] == 0) {
           if (doSetUserVarOrArray(Activator, fldname, args[3], true, args[2])) ++count;
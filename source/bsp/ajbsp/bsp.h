@@ -47,6 +47,9 @@ public:
 	bool fast;
 	bool warnings;	// NOTE: not currently used
 
+	// evaluate partition candidates on the worker pool (see PickNode)
+	bool parallel;
+
 	bool force_v5;
 	bool force_xnod;
 	bool force_compress;	// NOTE: only supported when HAVE_ZLIB is defined
@@ -73,6 +76,8 @@ public:
 		fast(false),
 		warnings(false),
 
+		parallel(false),
+
 		force_v5(false),
 		force_xnod(false),
 		force_compress(false),
@@ -47,6 +47,10 @@ namespace ajbsp
 
 #define SEG_FAST_THRESHHOLD  200
 
+// minimum number of segs in a group for evaluating partition
+// candidates on the worker pool
+#define SEG_PARALLEL_THRESHHOLD  256
+
 
 #define DEBUG_PICKNODE  0
 #define DEBUG_SPLIT     0
@@ -806,6 +810,112 @@ static bool PickNodeWorker(superblock_t *part_list,
 }
 
 
+//
+// Parallel version of PickNodeWorker().  The candidates are collected
+// in the same order the serial code visits them, and each worker batch
+// keeps its own running best cost.  That bound is never lower than the
+// serial one at the same candidate, so EvalPartition() either returns
+// the exact cost or rejects a seg the serial code would reject too.
+// Reducing the results in candidate order thus picks the same seg.
+//
+typedef struct pick_job_s
+{
+	superblock_t *seg_list;
+	seg_t **parts;
+	int *costs;
+	int best_cost;
+} pick_job_t;
+
+
+static void CollectPartCandidates(superblock_t *part_list,
+		std::vector<seg_t *> &parts)
+{
+	seg_t *part;
+
+	int num;
+
+	for (part=part_list->segs ; part ; part = part->next)
+	{
+		/* ignore minisegs as partition candidates */
+		if (part->linedef)
+			parts.push_back(part);
+	}
+
+	for (num=0 ; num < 2 ; num++)
+	{
+		if (part_list->subs[num])
+			CollectPartCandidates(part_list->subs[num], parts);
+	}
+}
+
+
+static void PickNodeBatch(void *udata, int start, int end, int /*worker*/)
+{
+	pick_job_t *job = (pick_job_t *)udata;
+
+	int best_cost = job->best_cost;
+
+	for (int f=start ; f < end ; f++)
+	{
+		int cost = EvalPartition(job->seg_list, job->parts[f], best_cost);
+
+		job->costs[f] = cost;
+
+		if (cost >= 0 && cost < best_cost)
+			best_cost = cost;
+	}
+}
+
+
+/* returns false if cancelled */
+static bool PickNodeParallel(superblock_t *seg_list,
+		seg_t ** best, int *best_cost)
+{
+	std::vector<seg_t *> parts;
+	std::vector<int> costs;
+
+	CollectPartCandidates(seg_list, parts);
+
+	if (parts.empty())
+		return true;
+
+	costs.resize(parts.size());
+
+	ajbsp_Progress(cur_info->donesegs, cur_info->totalsegs);
+
+	if (cur_info->cancelled)
+		return false;
+
+	pick_job_t job;
+
+	job.seg_list  = seg_list;
+	job.parts     = &parts[0];
+	job.costs     = &costs[0];
+	job.best_cost = *best_cost;
+
+	// smaller batches balance better, bigger ones prune better
+	int count = (int)parts.size();
+	int batch = count / (VWorkPool::GetThreadCount() * 4);
+
+	VWorkPool::ParallelFor(count, MAX2(batch, 1), &PickNodeBatch, &job);
+
+	if (cur_info->cancelled)
+		return false;
+
+	for (int f=0 ; f < count ; f++)
+	{
+		/* seg unsuitable or too costly ? */
+		if (costs[f] < 0 || costs[f] >= *best_cost)
+			continue;
+
+		(*best_cost) = costs[f];
+		(*best) = parts[f];
+	}
+
+	return true;
+}
+
+
 //
 // Find the best seg in the seg_list to use as a partition line.
 //
@@ -843,7 +953,20 @@ seg_t *PickNode(superblock_t *seg_list, int depth, const bbox_t *bbox)
 		}
 	}
 
-	if (! PickNodeWorker(seg_list, seg_list, &best, &best_cost))
+	bool ok;
+
+	if (cur_info->parallel &&
+		seg_list->real_num + seg_list->mini_num >= SEG_PARALLEL_THRESHHOLD &&
+		VWorkPool::GetThreadCount() > 1)
+	{
+		ok = PickNodeParallel(seg_list, &best, &best_cost);
+	}
+	else
+	{
+		ok = PickNodeWorker(seg_list, seg_list, &best, &best_cost);
+	}
+
+	if (! ok)
 	{
 		/* hack here : BuildNodes will detect the cancellation */
 		return NULL;
@@ -46,6 +46,10 @@ int SplitCost = 8;
 int AAPreference = 16;
 bool ShowWarnings = true;
 
+// Splitter candidates are scored on worker threads when the number of
+// candidates times the number of segs in the set reaches this.
+static const double ParallelSplitWork = 65536.0;
+
 
 #include "doomdata.cpp"
 
@@ -440,7 +444,7 @@ bool FNodeBuilder::ShoveSegBehind (DWORD set, node_t &node, DWORD seg, DWORD mat
     node.dx = -node.dx;
     node.dy = -node.dy;
   }
-  return Heuristic (node, set, false) > 0;
+  return Heuristic (node, set, false, Touched, Colinear) > 0;
 }
 
 // Splitters are chosen to coincide with segs in the given set. To reduce the
@@ -457,17 +461,23 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
   DWORD bestseg;
   DWORD seg;
   bool nosplitters = false;
+  unsigned int setsize, count, i;
+  int threads;
 
   bestvalue = 0;
   bestseg = DWORD_MAX;
 
   seg = set;
   stepleft = 0;
+  setsize = 0;
 
   memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+  SplitCandidates.Clear ();
 
   D(printf("Processing set %d\n", set));
 
+  // Pick the segs to score first: which ones are tried does not depend
+  // on the scores, so they can be computed in any order afterwards.
   while (seg != DWORD_MAX)
   {
     FPrivSeg *pseg = &Segs[seg];
@@ -485,28 +495,53 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
         }
 
         stepleft = step;
-        SetNodeFromSeg (node, pseg);
+        SplitCandidates.Push (seg);
+      }
+    }
 
-        int value = Heuristic (node, set, nosplit);
+    setsize++;
+    seg = pseg->next;
+  }
 
-        D(Printf ("Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg,
-          Segs[seg].linedef,
-          node.x>>16, node.y>>16,
-          (node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
+  count = SplitCandidates.Size();
+  SplitScores.Resize (count);
 
-        if (value > bestvalue)
-        {
-          bestvalue = value;
-          bestseg = seg;
-        }
-        else if (value < 0)
-        {
-          nosplitters = true;
-        }
-      }
+  if (count > 1 && (double)count*setsize >= ParallelSplitWork && (threads = ZDThreadCount()) > 1)
+  {
+    FSplitJob job;
+    job.Builder = this;
+    job.Set = set;
+    job.NoSplit = nosplit;
+    job.Scratch = new FSplitScratch[threads];
+    ZDParallelFor ((int)count, 1, &HeuristicBatch, &job);
+    delete[] job.Scratch;
+  }
+  else
+  {
+    for (i = 0; i < count; ++i)
+    {
+      SetNodeFromSeg (node, &Segs[SplitCandidates[i]]);
+      SplitScores[i] = Heuristic (node, set, nosplit, Touched, Colinear);
     }
+  }
 
-    seg = pseg->next;
+  // Reduce in the seg order, so the result does not depend on the threading
+  for (i = 0; i < count; ++i)
+  {
+    int value = SplitScores[i];
+    seg = SplitCandidates[i];
+
+    D(Printf ("Seg %5d, ld %d scores %d\n", seg, Segs[seg].linedef, value));
+
+    if (value > bestvalue)
+    {
+      bestvalue = value;
+      bestseg = seg;
+    }
+    else if (value < 0)
+    {
+      nosplitters = true;
+    }
   }
 
   if (bestseg == DWORD_MAX)
@@ -522,13 +557,28 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
   return 1;
 }
 
+// Scores a range of SplitCandidates; runs on the worker threads.
+void FNodeBuilder::HeuristicBatch (void *udata, int start, int end, int worker)
+{
+  FSplitJob *job = (FSplitJob *)udata;
+  FNodeBuilder *self = job->Builder;
+  FSplitScratch &scratch = job->Scratch[worker];
+  node_t node;
+
+  for (int i = start; i < end; ++i)
+  {
+    self->SetNodeFromSeg (node, &self->Segs[self->SplitCandidates[i]]);
+    self->SplitScores[i] = self->Heuristic (node, job->Set, job->NoSplit, scratch.Touched, scratch.Colinear);
+  }
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
   // Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
   int score = 1000000;
@@ -543,8 +593,8 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
   unsigned int max, m2, p, q;
   double frac;
 
-  Touched.Clear ();
-  Colinear.Clear ();
+  touched.Clear ();
+  colinear.Clear ();
 
   while (i != DWORD_MAX)
   {
@@ -571,32 +621,32 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
       {
         if ((sidev[0] | sidev[1]) != 0)
         {
-          max = Touched.Size();
+          max = touched.Size();
           for (p = 0; p < max; ++p)
           {
-            if (Touched[p] == test->loopnum)
+            if (touched[p] == test->loopnum)
             {
               break;
             }
           }
           if (p == max)
           {
-            Touched.Push (test->loopnum);
+            touched.Push (test->loopnum);
           }
         }
         else
         {
-          max = Colinear.Size();
+          max = colinear.Size();
           for (p = 0; p < max; ++p)
           {
-            if (Colinear[p] == test->loopnum)
+            if (colinear[p] == test->loopnum)
             {
               break;
             }
           }
           if (p == max)
           {
-            Colinear.Push (test->loopnum);
+            colinear.Push (test->loopnum);
           }
         }
       }
@@ -713,8 +763,8 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
   // seg of that sector must be crossing the container's corner and does not
   // actually split the container.
 
-  max = Touched.Size ();
-  m2 = Colinear.Size ();
+  max = touched.Size ();
+  m2 = colinear.Size ();
 
   // If honorNoSplit is false, then both these lists will be empty.
 
@@ -727,10 +777,10 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
 
   for (p = 0; p < max; ++p)
   {
-    int look = Touched[p];
+    int look = touched[p];
     for (q = 0; q < m2; ++q)
     {
-      if (look == Colinear[q])
+      if (look == colinear[q])
       {
         break;
       }
@@ -1,5 +1,9 @@
 extern void ZDWarn (const char *format, ...) __attribute__((format(printf, 1, 2)));
 extern void ZDProgress (int curr, int total); // total==-1: complete
+// should be implemented by the host; returning 1 disables parallel splitter evaluation
+extern int ZDThreadCount ();
+// should be implemented by the host; `worker` is in [0..ZDThreadCount())
+extern void ZDParallelFor (int count, int batchSize, void (*fn) (void *udata, int start, int end, int worker), void *udata);
 
 #include <math.h>
 #include "doomdata.h"
@@ -200,6 +204,8 @@ private:
 
   TArray<int> Touched;  // Loops a splitter touches on a vertex
   TArray<int> Colinear; // Loops with edges colinear to a splitter
+  TArray<DWORD> SplitCandidates;  // Segs SelectSplitter() wants to score
+  TArray<int> SplitScores;        // Heuristic() results for them
   FEventTree Events;    // Vertices intersected by the current splitter
   TArray<FSplitSharer> SplitSharers;  // Segs collinear with the current splitter
 
@@ -232,7 +238,24 @@ private:
   int SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int step, bool nosplit);
   void SplitSegs (DWORD set, node_t &node, DWORD splitseg, DWORD &outset0, DWORD &outset1, unsigned int &count0, unsigned int &count1);
   DWORD SplitSeg (DWORD segnum, int splitvert, int v1InFront);
-  int Heuristic (node_t &node, DWORD set, bool honorNoSplit);
+  int Heuristic (node_t &node, DWORD set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear);
+
+  // Per-worker state for scoring the splitter candidates in parallel
+  struct FSplitScratch
+  {
+    TArray<int> Touched;
+    TArray<int> Colinear;
+  };
+
+  struct FSplitJob
+  {
+    FNodeBuilder *Builder;
+    DWORD Set;
+    bool NoSplit;
+    FSplitScratch *Scratch;
+  };
+
+  static void HeuristicBatch (void *udata, int start, int end, int worker);
 
   // Returns:
   //  0 = seg is in front
@@ -298,6 +298,82 @@ static inline bool getDecorateDebug () { return !!cli_DecorateDebug; }
 static inline bool getIgnoreMoronicStateCommands () { return !!cli_DecorateMoronTolerant; }
 
 
+//==========================================================================
+//
+//  dcCacheAddScript
+//
+//  register script source for the decorate code cache key
+//
+//==========================================================================
+static void dcCacheAddScript (VScriptParser *sc) {
+  if (!sc) return;
+  VPackage::ProgsCacheAddSource((sc->SourceLump >= 0 ? W_FullLumpName(sc->SourceLump) : sc->GetScriptName()), sc->GetScriptBuffer(), sc->GetScriptSize());
+}
+
+
+//==========================================================================
+//
+//  dcCacheAddLump
+//
+//  register lump for the decorate code cache key
+//
+//==========================================================================
+static void dcCacheAddLump (int Lump) {
+  if (Lump < 0) return;
+  TArrayNC<vuint8> data;
+  W_LoadLumpIntoArrayIdx(Lump, data);
+  VPackage::ProgsCacheAddSource(W_FullLumpName(Lump), data.ptr(), data.length());
+}
+
+
+//==========================================================================
+//
+//  dcCacheCmpVStr
+//
+//==========================================================================
+static int dcCacheCmpVStr (const void *a, const void *b, void * /*udata*/) {
+  if (a == b) return 0;
+  return ((const VStr *)a)->Cmp(*(const VStr *)b);
+}
+
+
+//==========================================================================
+//
+//  dcCacheAddOptions
+//
+//  register options that can change decorate parsing for the decorate
+//  code cache key. should be called after all ignore lists are loaded.
+//
+//  the full key (see `VPackage::ProgsCacheCalcKey()`) consists of:
+//    build tag, pointer size, VM opcode and builtin tables;
+//    VC compiler options, and options that gate emit-time warnings;
+//    all VC progs sources and lexer defines;
+//    all DECORATE scripts and their includes (`dcCacheAddScript()`);
+//    decorate ignore lists, definition XML files, and line special
+//    definitions, DEHACKED and KEYCONF lumps (`dcCacheAddLump()`);
+//    this options blob;
+//    type, name and outer of every member, VC and decorate ones.
+//  anything else decorate reads (BDW class skipping, class ignore hacks,
+//  blood replacement directives) either comes from hashed sources, or only
+//  changes which members exist. actor defaults and flags are not cached,
+//  and parse-time warnings are printed anew on each run.
+//
+//==========================================================================
+static void dcCacheAddOptions () {
+  VStr opts = va("moron-tolerant=%d\nold-replacement=%d\nlax-parents=%d\nnonactor-replace=%d\nallow-unsafe=%d\n"
+                 "disable-blood-replaces=%d\nenable-known-blood=%d\nfail-on-unknown=%d\nrt-warnings=%d\n",
+    cli_DecorateMoronTolerant, cli_DecorateOldReplacement, cli_DecorateLaxParents, cli_DecorateNonActorReplace,
+    cli_DecorateAllowUnsafe, (int)disableBloodReplaces, (int)enableKnownBlood, (int)decorate_fail_on_unknown.asBool(),
+    (int)(cli_ShowClassRTRouting > 0));
+  // ignored actions; the map order is not stable, so sort them
+  TArray<VStr> ignored;
+  for (auto it = IgnoredDecorateActions.first(); it; ++it) ignored.append(it.getKey().toLowerCase());
+  if (ignored.length() > 1) smsort_r(ignored.ptr(), ignored.length(), sizeof(VStr), &dcCacheCmpVStr, nullptr);
+  for (auto &&act : ignored) { opts += "ignore="; opts += act; opts += "\n"; }
+  VPackage::ProgsCacheAddSource("<decorate options>", *opts, opts.length());
+}
+
+
 //==========================================================================
 //
 //  SkipSemicolonsToEOL
@@ -1748,6 +1824,7 @@ static bool ParseStates (VScriptParser *sc, VClass *Class, TArray<VState*> &Stat
       //GCon->Logf(NAME_Debug, "*** state include: %s", *W_FullLumpName(Lump));
       VScriptParser *nsp = VScriptParser::NewWithLump(Lump);
       dcTotalSourceSize += nsp->GetScriptSize();
+      dcCacheAddScript(nsp);
       ParseStatesStack.append(sc);
       sc = nsp;
       sc->SetCMode(true);
@@ -3212,6 +3289,7 @@ static void ParseActor (VScriptParser *sc, TArray<VClassFixup> &ClassFixups, TAr
             ActorClass->DeepCopyObject(Class->Defaults, ActorClass->Defaults);
             // copy state labels
             Class->StateLabels = ActorClass->StateLabels;
+            VClass::StaticInvalidateStateLabels();
             Class->ClassFlags |= CLASS_SkipSuperStateLabels;
             // drop items are reset back to the list of the parent class
             GetClassDropItems(Class) = GetClassDropItems(Class->ParentClass);
@@ -4100,6 +4178,7 @@ static void ParseDamageType (VScriptParser *sc) {
 //==========================================================================
 static void ParseDecorate (VScriptParser *sc, TArray<VClassFixup> &ClassFixups, TArray<VWeaponSlotFixups> &newWSlots) {
   dcTotalSourceSize += sc->GetScriptSize();
+  dcCacheAddScript(sc);
   while (!sc->AtEnd()) {
     if (sc->Check("#region") || sc->Check("#endregion")) {
       //GLog.Logf(NAME_Warning, "REGION: crossed=%d", (sc->Crossed ? 1 : 0));
@@ -4224,6 +4303,7 @@ void ReadLineSpecialInfos () {
   VStream *Strm = FL_OpenFileReadBaseOnly("line_specials.txt");
   if (!Strm) Sys_Error("'line_specials.txt' is required");
   VScriptParser *sc = new VScriptParser("line_specials.txt", Strm);
+  dcCacheAddScript(sc);
   while (!sc->AtEnd()) {
     ParseOneLineSpecialDefinition(sc, true/*warnings*/);
   }
@@ -4235,6 +4315,7 @@ void ReadLineSpecialInfos () {
     if (lump < 0) break;
     if (!W_RealLumpName(lump).strEquCI("k8vavoom/line_specials.rc")) continue;
     sc = VScriptParser::NewWithLump(lump);
+    dcCacheAddScript(sc);
     while (!sc->AtEnd()) {
       ParseOneLineSpecialDefinition(sc, false/*no warnings*/);
     }
@@ -4369,6 +4450,9 @@ static void SetupLimiters () {
 //
 //==========================================================================
 void ProcessDecorateScripts () {
+  // members created from now on belong to decorate
+  const int dcFirstMember = VMemberBase::GMembers.length();
+
 #ifndef VAVOOM_K8_DEVELOPER
   // no wai
   vcWarningsSilenced = 0;
@@ -4380,6 +4464,7 @@ void ProcessDecorateScripts () {
   for (int Lump = W_IterateFile(-1, "decorate_ignore.txt"); Lump != -1; Lump = W_IterateFile(Lump, "decorate_ignore.txt")) {
     GLog.Logf(NAME_Init, "Parsing DECORATE ignore file '%s'", *W_FullLumpName(Lump));
     VScriptParser *sc = VScriptParser::NewWithLump(Lump);
+    dcCacheAddScript(sc);
     while (sc->GetString()) {
       if (sc->String.length() == 0) continue;
       IgnoredDecorateActions.put(sc->String, true);
@@ -4393,6 +4478,7 @@ void ProcessDecorateScripts () {
       if (Strm) {
         GLog.Logf(NAME_Init, "Parsing DECORATE ignore file '%s'", *fname);
         VScriptParser *sc = new VScriptParser(fname, Strm);
+        dcCacheAddScript(sc);
         while (sc->GetString()) {
           if (sc->String.length() == 0) continue;
           IgnoredDecorateActions.put(sc->String, true);
@@ -4405,6 +4491,7 @@ void ProcessDecorateScripts () {
   GLog.Log(NAME_Init, "Parsing DECORATE definition files");
   for (int Lump = W_IterateFile(-1, "vavoom_decorate_defs.xml"); Lump != -1; Lump = W_IterateFile(Lump, "vavoom_decorate_defs.xml")) {
     //GLog.Logf(NAME_Init, "  %s", *W_FullLumpName(Lump));
+    dcCacheAddLump(Lump);
     VStream *Strm = W_CreateLumpReaderNum(Lump);
     vassert(Strm);
     VXmlDocument *Doc = new VXmlDocument();
@@ -4646,8 +4733,17 @@ void ProcessDecorateScripts () {
     newWSlots.clear();
   }
 
+  // dehacked and keyconf are processed after decorate, and they cannot change emitted code
+  // yet register them too, so any change in the mod invalidates the cache
+  for (auto &&it : WadNSIterator(WADNS_Global)) {
+    if (it.getName() == NAME_dehacked || it.getName() == NAME_keyconf) dcCacheAddLump(it.lump);
+  }
+
   GLog.Logf(NAME_Init, "Compiling decorate code");
   double dcCompileTime = -Sys_Time();
+  // emitted code can be taken from the progs cache
+  dcCacheAddOptions();
+  VPackage::ProgsCacheBeginExternal("decorate", dcFirstMember);
   // emit code
   for (auto &&dcls : DecPkg->ParsedClasses) {
     if (getDecorateDebug()) GLog.Logf("Emiting Class %s", *dcls->GetFullName());
@@ -4657,7 +4753,9 @@ void ProcessDecorateScripts () {
     for (VState *sts = dcls->States; sts; sts = sts->Next) sts->Emit();
     #endif
   }
+  const int dcCachedCount = VPackage::ProgsCacheEndExternal();
   dcCompileTime += Sys_Time();
+  if (dcCachedCount) GLog.Logf(NAME_Init, "%d decorate methods were taken from the cache", dcCachedCount);
 
   GLog.Logf(NAME_Init, "Generating decorate code");
   double dcCodegenTime = -Sys_Time();
@@ -4689,6 +4787,8 @@ void ProcessDecorateScripts () {
   //VMemberBase::StaticDumpMObjInfo();
 
   VClass::StaticReinitStatesLookup();
+  // decorate created new classes
+  VClass::StaticRenumberHierarchy();
 
   SetupLimiters();
 
@@ -0,0 +1,753 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "files.h"
+#include "cachestore.h"
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+#include <stdio.h> /* rename */
+
+
+static VCvarI cache_max_size_mb("cache_max_size_mb", "1024", "Maximum size of the data cache, in megabytes (<=0: unlimited).", CVAR_Archive|CVAR_NoShadow);
+static VCvarI cache_codec("cache_codec", "1", "Data cache compression: 0=none; 1=fast LZ; 2=zlib.", CVAR_Archive|CVAR_NoShadow);
+static VCvarI cache_zlib_level("cache_zlib_level", "6", "Data cache compression level for zlib codec [1..9].", CVAR_Archive|CVAR_NoShadow);
+
+
+// entry file header:
+//   char sign[8]     "K8VCACHE"
+//   vuint8 version   1
+//   vuint8 codec
+//   vuint16 reserved
+//   vuint32 rawsize
+//   vuint32 packsize (the rest of the file)
+//   vuint32 xxhash32 of unpacked data
+// all numbers are little-endian
+static const char CSEntrySign[8] = {'K','8','V','C','A','C','H','E'};
+enum {
+  CSEntryVersion = 1,
+  CSHeaderSize = 24,
+};
+
+static constexpr const char *CSIndexSignature = "K8VAVOOM DATA CACHE INDEX v1\n\x1a\x00\x00";
+enum { CSIndexSignLen = 32 };
+
+#define CS_ENTRY_EXT  ".vcc"
+#define CS_INDEX_NAME  "index.dat"
+
+
+struct CSEntry {
+  vint32 size; // file size
+  vint32 atime; // last access time, unix epoch
+  vint32 hits;
+};
+
+
+static mythread_mutex csLock;
+static struct CSLockInit { CSLockInit () { mythread_mutex_init(&csLock); } } csLockInit;
+
+struct CSLocker {
+  inline CSLocker () noexcept { mythread_mutex_lock(&csLock); }
+  inline ~CSLocker () noexcept { mythread_mutex_unlock(&csLock); }
+  CSLocker (const CSLocker &) = delete;
+  CSLocker &operator = (const CSLocker &) = delete;
+};
+
+// everything below is protected by `csLock`
+static bool csInited = false;
+static VStr csDir;
+static TMap<VStr, CSEntry> csIndex;
+static vint64 csTotalSize = 0;
+static bool csIndexDirty = false;
+static unsigned csTempCounter = 0;
+
+static vuint64 csStatHits = 0;
+static vuint64 csStatMisses = 0;
+static vuint64 csStatBroken = 0;
+static vuint64 csStatWrites = 0;
+static vuint64 csStatEvictions = 0;
+static vuint64 csStatBytesRead = 0; // unpacked
+static vuint64 csStatBytesWritten = 0; // packed
+static vuint64 csStatDecodeNano = 0;
+
+
+//==========================================================================
+//
+//  csPut32 / csGet32
+//
+//==========================================================================
+static inline void csPut32 (vuint8 *p, vuint32 v) noexcept {
+  p[0] = (vuint8)v;
+  p[1] = (vuint8)(v>>8);
+  p[2] = (vuint8)(v>>16);
+  p[3] = (vuint8)(v>>24);
+}
+
+static inline vuint32 csGet32 (const vuint8 *p) noexcept {
+  return (vuint32)p[0]|((vuint32)p[1]<<8)|((vuint32)p[2]<<16)|((vuint32)p[3]<<24);
+}
+
+
+//==========================================================================
+//
+//  CSIsValidName
+//
+//  entry names are used as file names, so keep them simple
+//
+//==========================================================================
+static bool CSIsValidName (VStr name) noexcept {
+  if (name.isEmpty() || name.length() > 200) return false;
+  if (name[0] == '.') return false;
+  for (const char ch : name) {
+    if (ch >= '0' && ch <= '9') continue;
+    if (ch >= 'a' && ch <= 'z') continue;
+    if (ch >= 'A' && ch <= 'Z') continue;
+    if (ch == '_' || ch == '-' || ch == '.') continue;
+    return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  CSEntryFileName
+//
+//==========================================================================
+static inline VStr CSEntryFileName (VStr name) {
+  return csDir+"/"+name+CS_ENTRY_EXT;
+}
+
+
+//==========================================================================
+//
+//  CSGetFileSize
+//
+//==========================================================================
+static int CSGetFileSize (VStr fname) {
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) return -1;
+  const int res = strm->TotalSize();
+  const bool err = strm->IsError();
+  VStream::Destroy(strm);
+  return (err ? -1 : res);
+}
+
+
+//==========================================================================
+//
+//  CSReplaceFile
+//
+//  atomically (where possible) replaces `dest` with `src`
+//
+//==========================================================================
+static bool CSReplaceFile (VStr src, VStr dest) {
+  #ifdef _WIN32
+  // windows cannot rename over existing file
+  Sys_FileDelete(dest);
+  #endif
+  if (rename(*src, *dest) != 0) {
+    Sys_FileDelete(src);
+    return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  CSRemoveLegacyCaches
+//
+//  old engine versions stored map and voxel caches in separate directories
+//
+//==========================================================================
+static void CSRemoveLegacyCaches (VStr cfgdir) {
+  TArray<VStr> dellist;
+  VStr dir = cfgdir+"/.mapcache";
+  void *dh = Sys_OpenDir(dir);
+  if (dh) {
+    for (;;) {
+      VStr fname = Sys_ReadDir(dh);
+      if (fname.isEmpty()) break;
+      if (!fname.startsWith("mapcache_")) continue;
+      if (!fname.endsWithCI(".cache") && !fname.endsWithCI(".cache.lmap") && !fname.endsWithCI(".cache.pvs")) continue;
+      dellist.append(dir+"/"+fname);
+    }
+    Sys_CloseDir(dh);
+  }
+  dir = cfgdir+"/.voxcache";
+  dh = Sys_OpenDir(dir);
+  if (dh) {
+    for (;;) {
+      VStr fname = Sys_ReadDir(dh);
+      if (fname.isEmpty()) break;
+      if (!fname.startsWith("voxmdl_") || !fname.endsWithCI(".cache")) continue;
+      dellist.append(dir+"/"+fname);
+    }
+    Sys_CloseDir(dh);
+  }
+  if (dellist.length()) {
+    GCon->Logf(NAME_Init, "cache: removing %d old cache file%s", dellist.length(), (dellist.length() != 1 ? "s" : ""));
+    for (auto &&fname : dellist) Sys_FileDelete(fname);
+  }
+}
+
+
+//==========================================================================
+//
+//  CSLoadIndex
+//
+//  called locked
+//
+//==========================================================================
+static void CSLoadIndex () {
+  VStream *strm = FL_OpenSysFileRead(csDir+"/" CS_INDEX_NAME);
+  if (!strm) return;
+  char sign[CSIndexSignLen];
+  strm->Serialise(sign, CSIndexSignLen);
+  if (!strm->IsError() && memcmp(sign, CSIndexSignature, CSIndexSignLen) == 0) {
+    vint32 count = 0;
+    *strm << STRM_INDEX(count);
+    for (int f = 0; f < count && !strm->IsError(); ++f) {
+      VStr name;
+      CSEntry e;
+      *strm << name << e.size << e.atime << e.hits;
+      if (strm->IsError()) break;
+      if (!CSIsValidName(name) || e.size < CSHeaderSize) continue;
+      csIndex.put(name, e);
+    }
+    if (strm->IsError()) csIndex.clear();
+  }
+  VStream::Destroy(strm);
+}
+
+
+//==========================================================================
+//
+//  CSSaveIndex
+//
+//  called locked
+//
+//==========================================================================
+static void CSSaveIndex () {
+  if (!csIndexDirty || csDir.isEmpty()) return;
+  csIndexDirty = false;
+  VStr fname = csDir+"/" CS_INDEX_NAME;
+  VStr tmpname = fname+".tmp";
+  VStream *strm = FL_OpenSysFileWrite(tmpname);
+  if (!strm) return;
+  strm->Serialise(CSIndexSignature, CSIndexSignLen);
+  vint32 count = csIndex.length();
+  *strm << STRM_INDEX(count);
+  for (auto &&it : csIndex.first()) {
+    VStr name = it.getKey();
+    CSEntry &e = it.getValue();
+    *strm << name << e.size << e.atime << e.hits;
+  }
+  bool err = strm->IsError();
+  if (!strm->Close()) err = true;
+  delete strm;
+  if (err) { Sys_FileDelete(tmpname); return; }
+  (void)CSReplaceFile(tmpname, fname);
+}
+
+
+//==========================================================================
+//
+//  CSInit
+//
+//  called locked; returns `false` if the store is not available
+//
+//==========================================================================
+static bool CSInit () {
+  if (csInited) return !csDir.isEmpty();
+  csInited = true;
+
+  VStr cfgdir = FL_GetConfigDir();
+  if (cfgdir.isEmpty()) return false;
+  CSRemoveLegacyCaches(cfgdir);
+
+  csDir = FL_GetDataCacheDir();
+  if (csDir.isEmpty()) return false;
+
+  CSLoadIndex();
+
+  // reconcile the index with the directory contents
+  TMap<VStr, bool> present;
+  TArray<VStr> dellist;
+  void *dh = Sys_OpenDir(csDir);
+  if (dh) {
+    for (;;) {
+      VStr fname = Sys_ReadDir(dh);
+      if (fname.isEmpty()) break;
+      // remove temp files left from crashed writes
+      if (fname.endsWith(".tmp")) { dellist.append(csDir+"/"+fname); continue; }
+      if (!fname.endsWith(CS_ENTRY_EXT)) continue;
+      VStr name = fname.left(fname.length()-(int)strlen(CS_ENTRY_EXT));
+      if (!CSIsValidName(name)) continue;
+      present.put(name, true);
+      if (csIndex.has(name)) continue;
+      CSEntry e;
+      e.size = CSGetFileSize(csDir+"/"+fname);
+      if (e.size < CSHeaderSize) { dellist.append(csDir+"/"+fname); continue; }
+      e.atime = Sys_FileTime(csDir+"/"+fname);
+      e.hits = 0;
+      csIndex.put(name, e);
+      csIndexDirty = true;
+    }
+    Sys_CloseDir(dh);
+  }
+  for (auto &&fname : dellist) Sys_FileDelete(fname);
+
+  TArray<VStr> missing;
+  csTotalSize = 0;
+  for (auto &&it : csIndex.first()) {
+    if (!present.has(it.getKey())) {
+      missing.append(it.getKey());
+    } else {
+      csTotalSize += it.getValue().size;
+    }
+  }
+  for (auto &&name : missing) csIndex.del(name);
+  if (missing.length()) csIndexDirty = true;
+
+  return true;
+}
+
+
+//==========================================================================
+//
+//  CSRemoveLocked
+//
+//==========================================================================
+static void CSRemoveLocked (VStr name) {
+  CSEntry *e = csIndex.get(name);
+  if (!e) return;
+  csTotalSize -= e->size;
+  csIndex.del(name);
+  csIndexDirty = true;
+  Sys_FileDelete(CSEntryFileName(name));
+}
+
+
+//==========================================================================
+//
+//  CSEvict
+//
+//  called locked; removes least recently used entries if the store is
+//  too big. `keep` will not be removed.
+//
+//==========================================================================
+static void CSEvict (VStr keep) {
+  const int limit = cache_max_size_mb.asInt();
+  if (limit <= 0) return;
+  const vint64 maxsize = (vint64)limit*1024*1024;
+  if (csTotalSize <= maxsize) return;
+  // shrink to 90%, so we won't do this on each write
+  const vint64 target = maxsize-maxsize/10;
+
+  struct LRUItem {
+    VStr name;
+    vint32 atime;
+  };
+  TArray<LRUItem> list;
+  list.resize(csIndex.length());
+  for (auto &&it : csIndex.first()) {
+    if (it.getKey() == keep) continue;
+    LRUItem &li = list.alloc();
+    li.name = it.getKey();
+    li.atime = it.getValue().atime;
+  }
+  xxsort_r(list.ptr(), list.length(), sizeof(LRUItem), [](const void *a, const void *b, void *) -> int {
+    const vint32 ta = ((const LRUItem *)a)->atime;
+    const vint32 tb = ((const LRUItem *)b)->atime;
+    return (ta < tb ? -1 : ta > tb ? 1 : 0);
+  }, nullptr);
+
+  int count = 0;
+  for (auto &&li : list) {
+    if (csTotalSize <= target) break;
+    CSRemoveLocked(li.name);
+    ++count;
+  }
+  csStatEvictions += (unsigned)count;
+  if (count) GCon->Logf(NAME_Debug, "cache: evicted %d entr%s", count, (count != 1 ? "ies" : "y"));
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+#if !defined(_WIN32)
+// stored entries are read directly from the file mapping
+class VCacheMappedStream : public VMemoryStreamRO {
+private:
+  void *Map;
+  size_t MapSize;
+
+public:
+  VCacheMappedStream (VStr aname, void *amap, size_t amapsize, int dataofs, int datasize)
+    : VMemoryStreamRO(aname, (const vuint8 *)amap+dataofs, datasize, false)
+    , Map(amap)
+    , MapSize(amapsize)
+  {}
+
+  virtual ~VCacheMappedStream () override {
+    Clear();
+    munmap(Map, MapSize);
+  }
+};
+#endif
+
+
+//==========================================================================
+//
+//  CSDecodeEntry
+//
+//  `fdata` is the whole entry file
+//  if `mapped` is not `nullptr`, stored entry will take ownership of the
+//  mapping (and the caller should not unmap it)
+//
+//==========================================================================
+static VStream *CSDecodeEntry (VStr name, const vuint8 *fdata, int fsize, bool *mapped) {
+  if (mapped) *mapped = false;
+  if (fsize < CSHeaderSize) return nullptr;
+  if (memcmp(fdata, CSEntrySign, 8) != 0 || fdata[8] != CSEntryVersion) return nullptr;
+  const int codec = fdata[9];
+  const vuint32 rawsize = csGet32(fdata+12);
+  const vuint32 packsize = csGet32(fdata+16);
+  const vuint32 hash = csGet32(fdata+20);
+  if (rawsize > 0x3fffffffu || packsize != (vuint32)(fsize-CSHeaderSize)) return nullptr;
+  const vuint8 *src = fdata+CSHeaderSize;
+
+  if (codec == VCacheStore::Codec_None) {
+    if (packsize != rawsize) return nullptr;
+    if (XXH32(src, rawsize, 0) != hash) return nullptr;
+    #if !defined(_WIN32)
+    if (mapped) {
+      *mapped = true;
+      return new VCacheMappedStream(name, (void *)fdata, (size_t)fsize, CSHeaderSize, (int)rawsize);
+    }
+    #endif
+    vuint8 *buf = (vuint8 *)Z_Malloc(rawsize ? rawsize : 1);
+    if (rawsize) memcpy(buf, src, rawsize);
+    return new VMemoryStreamRO(name, buf, (int)rawsize, true);
+  }
+
+  vuint8 *buf = (vuint8 *)Z_Malloc(rawsize ? rawsize : 1);
+  bool ok = false;
+  switch (codec) {
+    case VCacheStore::Codec_LZ:
+      ok = (VLZFast::Decompress(src, (int)packsize, buf, (int)rawsize) == (int)rawsize);
+      break;
+    case VCacheStore::Codec_ZLib:
+      {
+        mz_ulong destlen = rawsize;
+        ok = (mz_uncompress(buf, &destlen, src, (mz_ulong)packsize) == MZ_OK && destlen == rawsize);
+      }
+      break;
+    default: break;
+  }
+  if (!ok || XXH32(buf, rawsize, 0) != hash) { Z_Free(buf); return nullptr; }
+  return new VMemoryStreamRO(name, buf, (int)rawsize, true);
+}
+
+
+//==========================================================================
+//
+//  CSReadEntryFile
+//
+//==========================================================================
+static VStream *CSReadEntryFile (VStr name, VStr fname) {
+  #if !defined(_WIN32)
+  int fd = open(*fname, O_RDONLY|O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < CSHeaderSize || st.st_size > 0x7fffffff) { close(fd); return nullptr; }
+  const size_t fsize = (size_t)st.st_size;
+  void *mp = mmap(nullptr, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mp == MAP_FAILED) return nullptr;
+  bool mapped = false;
+  VStream *res = CSDecodeEntry(name, (const vuint8 *)mp, (int)fsize, &mapped);
+  if (!mapped) munmap(mp, fsize);
+  return res;
+  #else
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) return nullptr;
+  const int fsize = strm->TotalSize();
+  if (strm->IsError() || fsize < CSHeaderSize) { VStream::Destroy(strm); return nullptr; }
+  vuint8 *fdata = (vuint8 *)Z_Malloc(fsize);
+  strm->Serialise(fdata, fsize);
+  const bool err = strm->IsError();
+  VStream::Destroy(strm);
+  VStream *res = (err ? nullptr : CSDecodeEntry(name, fdata, fsize, nullptr));
+  Z_Free(fdata);
+  return res;
+  #endif
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::IsAvailable
+//
+//==========================================================================
+bool VCacheStore::IsAvailable () {
+  CSLocker lock;
+  return CSInit();
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Has
+//
+//==========================================================================
+bool VCacheStore::Has (VStr name) {
+  if (!CSIsValidName(name)) return false;
+  CSLocker lock;
+  if (!CSInit()) return false;
+  return csIndex.has(name);
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::OpenRead
+//
+//==========================================================================
+VStream *VCacheStore::OpenRead (VStr name) {
+  if (!CSIsValidName(name)) return nullptr;
+  VStr fname;
+  {
+    CSLocker lock;
+    if (!CSInit()) return nullptr;
+    if (!csIndex.has(name)) { ++csStatMisses; return nullptr; }
+    fname = CSEntryFileName(name);
+  }
+
+  // decode without holding the lock; writers replace files with `rename()`,
+  // so we'll see either old or new entry
+  const vuint64 stt = Sys_GetTimeNano();
+  VStream *res = CSReadEntryFile(name, fname);
+  const vuint64 ett = Sys_GetTimeNano();
+
+  CSLocker lock;
+  if (!res) {
+    GCon->Logf(NAME_Warning, "cache: removing broken entry '%s'", *name);
+    ++csStatBroken;
+    ++csStatMisses;
+    CSRemoveLocked(name);
+    return nullptr;
+  }
+  ++csStatHits;
+  csStatBytesRead += (unsigned)res->TotalSize();
+  csStatDecodeNano += ett-stt;
+  CSEntry *e = csIndex.get(name);
+  if (e) {
+    e->atime = Sys_CurrFileTime();
+    ++e->hits;
+    csIndexDirty = true;
+  }
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Write
+//
+//==========================================================================
+bool VCacheStore::Write (VStr name, const void *data, int size) {
+  if (!CSIsValidName(name) || size < 0 || (size && !data)) return false;
+  VStr fname, tmpname;
+  {
+    CSLocker lock;
+    if (!CSInit()) return false;
+    fname = CSEntryFileName(name);
+    tmpname = fname+va(".%u.tmp", ++csTempCounter);
+  }
+
+  // compress without holding the lock
+  int codec = clampval(cache_codec.asInt(), (int)Codec_None, (int)Codec_ZLib);
+  if (size < 64) codec = Codec_None; // not worth it
+  int packsize = -1;
+  TArrayNC<vuint8> buf;
+  if (codec == Codec_LZ) {
+    buf.setLength(CSHeaderSize+VLZFast::CompressBound(size));
+    packsize = VLZFast::Compress(data, size, buf.ptr()+CSHeaderSize, buf.length()-CSHeaderSize);
+  } else if (codec == Codec_ZLib) {
+    mz_ulong destlen = mz_compressBound((mz_ulong)size);
+    buf.setLength(CSHeaderSize+(int)destlen);
+    if (mz_compress2(buf.ptr()+CSHeaderSize, &destlen, (const vuint8 *)data, (mz_ulong)size, clampval(cache_zlib_level.asInt(), 1, 9)) == MZ_OK) {
+      packsize = (int)destlen;
+    }
+  }
+  // store incompressible data as is
+  if (packsize < 0 || packsize >= size) {
+    codec = Codec_None;
+    packsize = size;
+    buf.setLength(CSHeaderSize+size);
+    if (size) memcpy(buf.ptr()+CSHeaderSize, data, size);
+  }
+
+  vuint8 *hdr = buf.ptr();
+  memcpy(hdr, CSEntrySign, 8);
+  hdr[8] = CSEntryVersion;
+  hdr[9] = (vuint8)codec;
+  hdr[10] = hdr[11] = 0;
+  csPut32(hdr+12, (vuint32)size);
+  csPut32(hdr+16, (vuint32)packsize);
+  csPut32(hdr+20, XXH32(data, (size_t)size, 0));
+  const int fsize = CSHeaderSize+packsize;
+
+  VStream *strm = FL_OpenSysFileWrite(tmpname);
+  if (!strm) return false;
+  strm->Serialise(buf.ptr(), fsize);
+  bool err = strm->IsError();
+  if (!strm->Close()) err = true;
+  delete strm;
+  if (err) { Sys_FileDelete(tmpname); return false; }
+
+  CSLocker lock;
+  if (!CSReplaceFile(tmpname, fname)) {
+    GCon->Logf(NAME_Warning, "cache: cannot write entry '%s'", *name);
+    CSRemoveLocked(name);
+    return false;
+  }
+  CSEntry *e = csIndex.get(name);
+  if (e) {
+    csTotalSize -= e->size;
+    e->size = fsize;
+    e->atime = Sys_CurrFileTime();
+  } else {
+    CSEntry ne;
+    ne.size = fsize;
+    ne.atime = Sys_CurrFileTime();
+    ne.hits = 0;
+    csIndex.put(name, ne);
+  }
+  csTotalSize += fsize;
+  csIndexDirty = true;
+  ++csStatWrites;
+  csStatBytesWritten += (unsigned)fsize;
+  CSEvict(name);
+  CSSaveIndex();
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Write
+//
+//==========================================================================
+bool VCacheStore::Write (VStr name, VMemoryStream *strm) {
+  if (!strm || strm->IsError()) return false;
+  const TArrayNC<vuint8> &arr = strm->GetArray();
+  return Write(name, arr.ptr(), arr.length());
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Remove
+//
+//==========================================================================
+void VCacheStore::Remove (VStr name) {
+  if (!CSIsValidName(name)) return;
+  CSLocker lock;
+  if (!CSInit()) return;
+  CSRemoveLocked(name);
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Clear
+//
+//==========================================================================
+void VCacheStore::Clear () {
+  CSLocker lock;
+  if (!CSInit()) return;
+  for (auto &&it : csIndex.first()) Sys_FileDelete(CSEntryFileName(it.getKey()));
+  csIndex.clear();
+  csTotalSize = 0;
+  csIndexDirty = true;
+  CSSaveIndex();
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::Shutdown
+//
+//==========================================================================
+void VCacheStore::Shutdown () {
+  CSLocker lock;
+  if (!csInited) return;
+  CSSaveIndex();
+}
+
+
+//==========================================================================
+//
+//  VCacheStore::DumpStats
+//
+//==========================================================================
+void VCacheStore::DumpStats () {
+  CSLocker lock;
+  if (!CSInit()) { GCon->Log("data cache is not available"); return; }
+  GCon->Logf("data cache directory: %s", *csDir);
+  GCon->Logf("  %d entr%s, %.2f MB (limit: %d MB)", csIndex.length(), (csIndex.length() != 1 ? "ies" : "y"), (double)csTotalSize/(1024.0*1024.0), cache_max_size_mb.asInt());
+  GCon->Logf("  hits: %u; misses: %u; broken: %u; writes: %u; evictions: %u",
+    (unsigned)csStatHits, (unsigned)csStatMisses, (unsigned)csStatBroken, (unsigned)csStatWrites, (unsigned)csStatEvictions);
+  GCon->Logf("  read: %.2f MB in %.3f msecs; written: %.2f MB",
+    (double)csStatBytesRead/(1024.0*1024.0), (double)csStatDecodeNano/1000000.0, (double)csStatBytesWritten/(1024.0*1024.0));
+}
+
+
+//==========================================================================
+//
+//  CacheStoreInfo
+//
+//==========================================================================
+COMMAND(CacheStoreInfo) {
+  VCacheStore::DumpStats();
+}
+
+
+//==========================================================================
+//
+//  CacheStoreClear
+//
+//==========================================================================
+COMMAND(CacheStoreClear) {
+  VCacheStore::Clear();
+  GCon->Log("data cache cleared");
+}
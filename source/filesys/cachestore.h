@@ -0,0 +1,79 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  unified on-disk cache for the data derived from game files
+//**
+//**************************************************************************
+#ifndef VAVOOM_CACHESTORE_HEADER
+#define VAVOOM_CACHESTORE_HEADER
+
+
+// entries are named by the producer, and the name should contain a hash of
+// the source data (like "map_<ripemd160>"), so entries never need to be
+// invalidated, only evicted. each entry is one file in the store directory;
+// the store keeps an index with entry sizes and access times, and removes
+// least recently used entries when the store grows above `cache_max_size_mb`.
+//
+// data is compressed with the fast LZ codec by default (see `cache_codec`).
+// entry files are mapped into memory for reading; stored (uncompressed)
+// entries are read directly from the mapping.
+//
+// all functions are thread-safe.
+class VCacheStore {
+public:
+  enum {
+    Codec_None = 0,
+    Codec_LZ = 1,
+    Codec_ZLib = 2,
+  };
+
+public:
+  // returns `false` if there is no store directory
+  static bool IsAvailable ();
+
+  static bool Has (VStr name);
+
+  // returns entry data stream, or `nullptr` if there is no such entry
+  // broken entries are removed
+  static VStream *OpenRead (VStr name);
+
+  // compresses and stores the entry (replaces old one); returns `false` on error
+  static bool Write (VStr name, const void *data, int size);
+  static bool Write (VStr name, VMemoryStream *strm);
+
+  static void Remove (VStr name);
+
+  // removes everything
+  static void Clear ();
+
+  // saves the index; should be called on shutdown
+  static void Shutdown ();
+
+  static void DumpStats ();
+};
+
+
+#endif
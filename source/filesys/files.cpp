@@ -3094,13 +3094,13 @@ VStr FL_GetConfigDir () {
 
 //==========================================================================
 //
-//  FL_GetMapCacheDir
+//  FL_GetDataCacheDir
 //
 //==========================================================================
-VStr FL_GetMapCacheDir () {
+VStr FL_GetDataCacheDir () {
   VStr res = FL_GetConfigDir();
   if (res.isEmpty()) return res;
-  res += "/.mapcache";
+  res += "/.datacache";
   Sys_CreateDirectory(res);
   return res;
 }
@@ -3108,13 +3108,13 @@ VStr FL_GetMapCacheDir () {
 
 //==========================================================================
 //
-//  FL_GetVoxelCacheDir
+//  FL_GetProgsCacheDir
 //
 //==========================================================================
-VStr FL_GetVoxelCacheDir () {
+VStr FL_GetProgsCacheDir () {
   VStr res = FL_GetConfigDir();
   if (res.isEmpty()) return res;
-  res += "/.voxcache";
+  res += "/.progscache";
   Sys_CreateDirectory(res);
   return res;
 }
@@ -48,8 +48,8 @@ VStream *FL_OpenSysFileWrite (VStr Name);
 
 
 VStr FL_GetConfigDir ();
-VStr FL_GetMapCacheDir ();
-VStr FL_GetVoxelCacheDir ();
+VStr FL_GetDataCacheDir ();
+VStr FL_GetProgsCacheDir ();
 VStr FL_GetSavesDir ();
 VStr FL_GetScreenshotsDir ();
 VStr FL_GetUserDataDir (bool shouldCreate);
@@ -49,6 +49,7 @@
 #include "language.h"
 #include "mapinfo.h"
 #include "filesys/files.h"
+#include "filesys/cachestore.h"
 #include "sound/sound.h"
 
 // we need it to init some data even in the server
@@ -157,8 +158,13 @@ VCvarI host_max_skip_frames("dbg_host_max_skip_frames", "12", "Process no more t
 static VCvarB host_show_skip_limit("dbg_host_show_skip_limit", false, "Show skipframe limit hits? (DEBUG CVAR, DON'T USE!)", CVAR_PreInit|CVAR_NoShadow);
 static VCvarB host_show_skip_frames("dbg_host_show_skip_frames", false, "Show skipframe hits? (DEBUG CVAR, DON'T USE!)", CVAR_PreInit|CVAR_NoShadow);
 
+static VCvarI sys_worker_threads("sys_worker_threads", "0", "Number of threads for parallel jobs, including the main one (0: all CPUs; 1: don't use worker threads).", CVAR_Archive|CVAR_NoShadow);
+
 static VCvarF host_gc_timeout("host_gc_timeout", "0.5", "Timeout in seconds between garbage collections.", CVAR_Archive|CVAR_NoShadow);
 
+static VCvarB vm_jit("vm_jit", true, "Compile hot VC methods to native code?", CVAR_NoShadow);
+static VCvarI vm_jit_threshold("vm_jit_threshold", "64", "Compile VC method to native code after this number of calls.", CVAR_Archive|CVAR_NoShadow);
+
 static VCvarB randomclass("RandomClass", false, "Random player class?", 0); // checkparm of -randclass
 VCvarB respawnparm("RespawnMonsters", false, "Respawn monsters?", 0/*|CVAR_PreInit*/); // checkparm of -respawn
 VCvarI fastparm("g_fast_monsters", "0", "Fast(1), slow(2), normal(0) monsters?", 0/*|CVAR_PreInit*/); // checkparm of -fast
@@ -397,6 +403,7 @@ void Host_Init () {
   if (Sys_TimeMaxPeriodMS()) GCon->Logf(NAME_Init, "timeBeginPeriod maximum: %d", Sys_TimeMaxPeriodMS());
 
   if (cli_AsmDump > 0) VMemberBase::doAsmDump = true;
+  if (!VMethod::jitEnabled) vm_jit = false;
 
   if (cli_SetDeveloperDefine > 0) VMemberBase::StaticAddDefine("K8_DEVELOPER");
 
@@ -846,6 +853,35 @@ static void Host_UpdateLanguage () {
 
 static double lastNetFrameTime = 0;
 
+static VStr profCaptureFileName;
+
+
+//==========================================================================
+//
+//  Host_ProfFrameMark
+//
+//  writes the trace when zone profiler capture is complete
+//
+//==========================================================================
+static void Host_ProfFrameMark () {
+  if (!VZoneProf::FrameMark()) return;
+  VStream *strm = CreateDiskStreamWrite(profCaptureFileName);
+  if (!strm) {
+    VZoneProf::StopCapture();
+    GCon->Logf(NAME_Error, "cannot create profiler trace file \"%s\"", *profCaptureFileName);
+    return;
+  }
+  const int count = VZoneProf::WriteTrace(strm);
+  bool err = strm->IsError();
+  if (!strm->Close()) err = true;
+  delete strm;
+  if (err) {
+    GCon->Logf(NAME_Error, "cannot write profiler trace file \"%s\"", *profCaptureFileName);
+  } else {
+    GCon->Logf("profiler: %d zones written to \"%s\"", count, *profCaptureFileName);
+  }
+}
+
 //==========================================================================
 //
 //  Host_Frame
@@ -913,6 +949,13 @@ void Host_Frame () {
 
     lastNetFrameTime = host_systime;
 
+    // frame boundary for the zone profiler; the trace is written here too
+    Host_ProfFrameMark();
+    VFrameArena::NewFrame();
+    // the pool recreates its workers on the next job if the number was changed
+    VWorkPool::SetMaxThreads(sys_worker_threads.asInt());
+    VPROF_ZONE("host", "Host_Frame");
+
     if (GSoundManager) GSoundManager->Process();
 
     Host_UpdateLanguage();
@@ -944,6 +987,8 @@ void Host_Frame () {
       #ifdef SERVER
       if (GGameInfo->NetMode != NM_None && GGameInfo->NetMode != NM_Client) {
         // server operations
+        // outgoing datagrams are sent in batches at the end of the frame
+        VNetWriteBatchScope netBatch;
         SV_ServerFrame();
       }
       # ifndef CLIENT
@@ -979,6 +1024,9 @@ void Host_Frame () {
 
     Host_CollectGarbage();
 
+    VMethod::jitEnabled = (vm_jit.asBool() ? 1 : 0);
+    VMethod::jitThreshold = clampval(vm_jit_threshold.asInt(), 1, 0x7fffffff);
+
     if (show_time) {
       pass1 = (int)((time1-time3)*1000);
       time3 = Sys_Time();
@@ -1094,6 +1142,91 @@ COMMAND(Version) {
 }
 
 
+//==========================================================================
+//
+//  COMMAND GCStats
+//
+//==========================================================================
+COMMAND(GCStats) {
+  const VObject::GCStats &stats = VObject::GetGCStats();
+  GCon->Logf("GC: %d alive objects (%d visited, %d skipped on last collection)", stats.alive, stats.lastVisited, stats.lastSkipped);
+  if (stats.collections == 0) return;
+  GCon->Logf("GC: %d collections; average pause: %g msecs; max pause: %g msecs", stats.collections,
+    stats.totalCollectDuration*1000.0/(double)stats.collections, stats.maxCollectDuration*1000.0);
+  for (int f = 0; f < VObject::GCStats::PauseHistSize; ++f) {
+    if (!stats.pauseHist[f]) continue;
+    if (f < VObject::GCStats::PauseHistSize-1) {
+      GCon->Logf("  <%8.3f msecs: %d", VObject::GetGCPauseBucketLimit(f)*1000.0, stats.pauseHist[f]);
+    } else {
+      GCon->Logf("  >=%7.3f msecs: %d", VObject::GetGCPauseBucketLimit(f-1)*1000.0, stats.pauseHist[f]);
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  COMMAND FrameArenaInfo
+//
+//==========================================================================
+COMMAND(FrameArenaInfo) {
+  VFrameArena::Stats st;
+  VFrameArena::GetStats(st);
+  GCon->Logf("frame arena: %d arenas, %u KB total capacity, %u KB peak usage (%u KB in the last frame)",
+    st.arenas, (unsigned)(st.capacity/1024), (unsigned)(st.peakUsed/1024), (unsigned)(st.lastFramePeak/1024));
+  GCon->Logf("frame arena: %u chunk allocations in %u of %u frames",
+    (unsigned)st.chunkAllocs, (unsigned)st.allocFrames, (unsigned)st.frames);
+}
+
+
+//==========================================================================
+//
+//  COMMAND ProfCapture
+//
+//  ProfCapture [frames] [vm] [filename]
+//  ProfCapture stop
+//
+//==========================================================================
+COMMAND(ProfCapture) {
+  if (Args.length() > 1 && Args[1].strEquCI("stop")) {
+    if (VZoneProf::IsCapturing()) {
+      VZoneProf::StopCapture();
+      GCon->Log("profiler: capture aborted");
+    }
+    return;
+  }
+
+  if (VZoneProf::IsCapturing()) {
+    GCon->Log("profiler: capture is already in progress");
+    return;
+  }
+
+  int frames = 60;
+  bool vmcalls = false;
+  VStr fname;
+  for (int f = 1; f < Args.length(); ++f) {
+    int n;
+    if (VStr::convertInt(*Args[f], &n)) {
+      if (n < 1) { GCon->Logf(NAME_Error, "profiler: invalid frame count: %d", n); return; }
+      frames = n;
+    } else if (Args[f].strEquCI("vm")) {
+      vmcalls = true;
+    } else {
+      fname = Args[f];
+    }
+  }
+
+  if (fname.isEmpty()) fname = "proftrace.json";
+  if (!fname.extractFileExtension().strEquCI(".json")) fname += ".json";
+  if (!fname.isAbsolutePath()) fname = FL_GetUserDataDir(true).appendPath(fname);
+  profCaptureFileName = fname;
+
+  if (VZoneProf::StartCapture(frames, vmcalls)) {
+    GCon->Logf("profiler: capturing %d frame%s%s", frames, (frames != 1 ? "s" : ""), (vmcalls ? " (with VM calls)" : ""));
+  }
+}
+
+
 //==========================================================================
 //
 //  Host_GetConfigDir
@@ -1295,6 +1428,12 @@ void Host_Shutdown () {
     GSoundManager = nullptr;
   }
 
+  if (developer) GLog.Log(NAME_Dev, "shutting down worker threads");
+  SAFE_SHUTDOWN(VWorkPool::Shutdown, ())
+
+  if (developer) GLog.Log(NAME_Dev, "shutting down data cache");
+  SAFE_SHUTDOWN(VCacheStore::Shutdown, ())
+
   if (cli_DumpAllVars > 0) VCvar::DumpAllVars();
   //k8:no need to do this:SAFE_SHUTDOWN(R_ShutdownTexture, ()) // texture manager
   //k8:no need to do this:SAFE_SHUTDOWN(R_ShutdownData, ()) // various game tables
@@ -471,6 +471,8 @@ void VLevel::KillAllMapDecals () {
 //
 //==========================================================================
 void VLevel::ClearAllMapData () {
+  KillPVS();
+
   delete UserLineKeyInfo;
   UserLineKeyInfo = nullptr;
 
@@ -548,6 +550,7 @@ void VLevel::ClearAllMapData () {
 
   delete[] BlockLinks;
   BlockLinks = nullptr;
+  FreeBlockProxies();
 
   delete[] RejectMatrix;
   RejectMatrix = nullptr;
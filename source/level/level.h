@@ -199,6 +199,7 @@ struct VCameraTextureInfo {
 class VLevel;
 class VLevelInfo;
 struct VPathTraverseWorkData;
+struct VLevelPVSBuilder;
 
 
 class VLevelScriptThinker : public VSerialisable {
@@ -229,6 +230,7 @@ extern VLevelScriptThinker *AcsCreateEmptyThinker ();
 extern void AcsSuspendScript (VAcsLevel *acslevel, int number, int map);
 extern void AcsTerminateScript (VAcsLevel *acslevel, int number, int map);
 extern bool AcsHasScripts (VAcsLevel *acslevel);
+extern void AcsCollectStrings (VAcsLevel *acslevel);
 
 
 //==========================================================================
@@ -355,9 +357,23 @@ struct VDecalList {
 };
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// compact copy of one blockmap thing chain, kept as separate arrays
+// items are in reverse chain order (the last item is the chain head)
+// this is used to reject far things before the full collision test
+struct VBlockThingProxies {
+  float *OrgX;
+  float *OrgY;
+  float *Radius; // move radius; snapshots are refreshed by `VBlockThingsNearIterator`
+  VEntity **Ents;
+  int Count;
+  int Alloted; // always a multiple of 4
+};
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 class VLevel : public VGameObject {
-  DECLARE_CLASS(VLevel, VGameObject, 0)
+  DECLARE_CLASS(VLevel, VGameObject, CLASS_NativeReferences)
   NO_DEFAULT_CONSTRUCTOR(VLevel)
 
   friend class VUdmfParser;
@@ -430,6 +446,8 @@ class VLevel : public VGameObject {
   float BlockMapOrgX; // origin of block map
   float BlockMapOrgY;
   VEntity **BlockLinks;   // for thing chains
+  VBlockThingProxies *BlockProxies; // compact copies of thing chains
+  vint32 BlockProxyCount;
   polyblock_t **PolyBlockMap;
 
   // REJECT
@@ -538,9 +556,10 @@ class VLevel : public VGameObject {
   vint32 validcountSZCache;
 
   // set in `LoadMap()`, can be used by renderer to load/save lightmap cache
-  VStr cacheFileBase; // can be empty, otherwise it is path and file name w/o extension
+  VStr cacheFileBase; // can be empty, otherwise it is path and file name w/o extension (or cache store entry name)
   enum {
     CacheFlag_Ignore = 1u<<0,
+    CacheFlag_Store = 1u<<1, // `cacheFileBase` is a cache store entry name (see "filesys/cachestore.h")
   };
   vuint32 cacheFlags;
 
@@ -589,6 +608,17 @@ class VLevel : public VGameObject {
   // unified list for floor and ceiling decals
   VDecalList *subsectorDecalList;
 
+  // precomputed subsector PVS (see "level_pvs.cpp")
+  // `NumSubsectors` rows, `PVSRowSize` bytes each; `nullptr` if there is no PVS (yet)
+  vuint8 *PVSData;
+  vint32 PVSRowSize;
+  // background PVS builder; owned
+  VLevelPVSBuilder *PVSBuilder;
+
+public:
+  // per-thread light tracing state (see `CastLightRay()`)
+  struct LightTraceContext;
+
 public:
   // sorry for those globals
   static TMapNC<VName, bool> baddecals;
@@ -916,6 +946,22 @@ public:
     return 0x00; // this is REJECT matrix, not ACCEPT
   }
 
+  inline bool HasPVS () const noexcept { return !!PVSData; }
+
+  // returns PVS row for the given subsector, or `nullptr` if there is no PVS
+  // bit `n` is set if subsector `n` may be visible from `sub`
+  inline const vuint8 *LeafPVS (const subsector_t *sub) const noexcept {
+    return (PVSData && sub ? PVSData+(unsigned)(ptrdiff_t)(sub-Subsectors)*(unsigned)PVSRowSize : nullptr);
+  }
+
+  // returns `false` only if there is no 2d line of sight between subsectors
+  // this is PVS, not REJECT; if there is no PVS, everything is visible
+  inline bool IsLeafPotentiallyVisible (const subsector_t *from, const subsector_t *dest) const noexcept {
+    if (!PVSData || !from || !dest) return true;
+    const unsigned s2 = (unsigned)(ptrdiff_t)(dest-Subsectors);
+    return !!(PVSData[(unsigned)(ptrdiff_t)(from-Subsectors)*(unsigned)PVSRowSize+(s2>>3)]&(1u<<(s2&7)));
+  }
+
   void ResetStaticLights ();
 
   // returns static light id
@@ -996,7 +1042,12 @@ public:
                    const TVec &dest, float radius, float height, bool skipBaseRegion, const subsector_t *DestSubSector,
                    bool allowBetterSight, bool ignoreBlockAll, bool ignoreFakeFloors);
   // this is used to trace light rays (via blockmap)
-  bool CastLightRay (bool textureCheck, const subsector_t *SubSector, const TVec &org, const TVec &dest, const subsector_t *DestSubSector=nullptr);
+  // `ctx` can be used to trace from worker threads (the level must not be changed while tracing)
+  bool CastLightRay (bool textureCheck, const subsector_t *SubSector, const TVec &org, const TVec &dest, const subsector_t *DestSubSector=nullptr, LightTraceContext *ctx=nullptr);
+
+  // per-thread state for `CastLightRay()`
+  LightTraceContext *NewLightTraceContext ();
+  static void DeleteLightTraceContext (LightTraceContext *ctx);
 
   void SetCameraToTexture (VEntity *, VName, int);
 
@@ -1390,6 +1441,13 @@ public:
 
   inline VAllBlockThings allBlockThings (int bmx, int bmy) const noexcept { return VAllBlockThings(this, bmx, bmy); }
 
+  // blockmap thing proxies; called by entity blockmap link/unlink code
+  // `cell` is real cell index
+  void AllocBlockProxies ();
+  void FreeBlockProxies ();
+  void LinkBlockProxy (VEntity *e, unsigned cell);
+  void UnlinkBlockProxy (VEntity *e, unsigned cell);
+
 private:
   // map loaders
   void LoadVertexes (int Lump);
@@ -1426,10 +1484,6 @@ private:
 
   void BuildDecalsVVList ();
 
-  // cache
-  static VStr getCacheDir ();
-  static void doCacheCleanup ();
-
   // map loading helpers
   int TexNumForName (const char *name, int Type, bool CMap=false) const;
   int TexNumOrColor (const char *, int, bool &, vuint32 &) const;
@@ -1438,6 +1492,7 @@ private:
   void CreateRepBase ();
   void CreateBlockMap ();
   void CleanupBlockMap ();
+  static void CleanupBlockMapJob (void *udata, int start, int end, int worker); // `VWorkPool` callback
 
   enum { BSP_AJ, BSP_ZD };
   int GetNodesBuilder () const; // valid only after `LevelFlags` are set
@@ -1445,10 +1500,13 @@ private:
   void BuildNodesZD ();
   void BuildNodes ();
 
-  bool CreatePortals (void *pvsinfo);
-  void SimpleFlood (/*portal_t*/void *srcportalp, int leafnum, void *pvsinfo);
-  bool LeafFlow (int leafnum, void *pvsinfo);
-  void BasePortalVis (void *pvsinfo);
+  // PVS (see "level_pvs.cpp")
+  // `cacheFileName` is the main cache store entry name (can be empty)
+  void StartPVSBuilder (VStr cacheFileName);
+  // adopts PVS if the builder is complete; `noThread` means that the builder has no thread to join
+  void PollPVSBuilder (bool noThread=false);
+  // aborts the builder, and frees PVS
+  void KillPVS ();
   void HashSectors ();
   void HashLines ();
   void BuildSectorLists ();
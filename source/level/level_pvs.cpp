@@ -0,0 +1,723 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2023 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+// subsector PVS builder
+//
+// GL subsectors are convex, and they are connected with "portals" (two-sided
+// segs and minisegs), so we can do the good old 2d portal flow, like "vis"
+// did in the Quake days. the result is conservative: if some subsector is
+// not marked as visible, there is no 2d line of sight to it (and therefore
+// no 3d line of sight too).
+//
+// building is done in a separate thread, on a snapshot of map geometry, so
+// the level can be played while PVS is not ready yet (all queries will return
+// "visible" in this case).
+//
+// polyobjects can move, so any connected map area that contains polyobject
+// segs is marked as "wild" (everything in it can see everything).
+//
+#include "../gamedefs.h"
+#include "../filesys/cachestore.h"
+
+
+static VCvarB loader_pvs_build("loader_pvs_build", true, "Build subsector PVS after map loading?", CVAR_Archive|CVAR_NoShadow);
+static VCvarI loader_pvs_max_memory("loader_pvs_max_memory", "128", "Do not build PVS if it will take more than this number of megabytes.", CVAR_Archive|CVAR_NoShadow);
+static VCvarF loader_pvs_time_limit("loader_pvs_time_limit", "60", "Use rough PVS for the rest of the map if building took more than this number of seconds.", CVAR_Archive|CVAR_NoShadow);
+static VCvarF loader_cache_time_limit_pvs("loader_cache_time_limit_pvs", "0.5", "Cache PVS data if building took more than this number of seconds.", CVAR_Archive|CVAR_NoShadow);
+
+extern VCvarB loader_cache_data;
+
+
+static int constexpr cestlen (const char *s, int pos=0) noexcept { return (s && s[pos] ? 1+cestlen(s, pos+1) : 0); }
+static constexpr const char *PVS_CACHE_SIGNATURE = "VAVOOM CACHED PVS DATA VER 002.\n";
+enum { PVSCDSLEN = cestlen(PVS_CACHE_SIGNATURE) };
+static_assert(PVSCDSLEN == 32, "oops!");
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+struct VLevelPVSBuilder {
+public:
+  enum {
+    MaxFlowSteps = 1024*1024, // per source subsector; rough PVS will be used for the subsector if this is exceeded
+    MaxFlowDepth = 4096,
+  };
+
+  // distance, in map units
+  static constexpr double ON_EPS = 0.00001;
+  static constexpr double CLIP_EPS = 0.01;
+
+  struct Portal {
+    double x0, y0, x1, y1;
+    // destination subsector is on the positive side of this line
+    double nx, ny, dist;
+    vint32 leaf; // subsector we are leaving
+    vint32 dest; // subsector we are entering
+  };
+
+  struct Winding {
+    double x0, y0, x1, y1;
+  };
+
+public:
+  int NumLeafs;
+  int RowSize; // in bytes, always a multiple of 8
+  TArrayNC<Portal> Portals; // sorted by `leaf`
+  TArrayNC<int> LeafPortals; // first portal index for each leaf, has `NumLeafs+1` items
+  TArrayNC<int> Component; // connected area index for each leaf
+  TArrayNC<vuint8> WildComponent; // by component index
+  vuint32 GeoHash;
+
+  VStr CacheFileName; // cache store entry name; empty: don't write cache
+  double CacheTimeLimit;
+  double TimeLimit;
+
+  vuint8 *MightSee; // rough visibility for each portal
+  vuint8 *Result; // `NumLeafs` rows
+
+  // flow state
+  vuint8 *CurrVis;
+  TArrayNC<vuint8> InPath;
+  TArray<vuint8 *> MightStack; // temporary buffers for each flow depth
+  double SrcNX, SrcNY, SrcDist; // source portal line
+  int Steps;
+  int StepLimit;
+
+  mythread Thread;
+  atomic_int Done;
+  atomic_int Abort;
+
+  // stats
+  double BuildTime;
+  int RoughLeafs;
+  bool Success;
+
+public:
+  VV_DISABLE_COPY(VLevelPVSBuilder)
+
+  VLevelPVSBuilder ()
+    : NumLeafs(0), RowSize(0), GeoHash(0), CacheTimeLimit(0), TimeLimit(0)
+    , MightSee(nullptr), Result(nullptr), CurrVis(nullptr), SrcNX(0), SrcNY(0), SrcDist(0)
+    , Steps(0), StepLimit(MaxFlowSteps), Done(0), Abort(0), BuildTime(0), RoughLeafs(0), Success(false)
+  {}
+
+  ~VLevelPVSBuilder () {
+    delete[] MightSee;
+    delete[] Result;
+    for (auto &&buf : MightStack) delete[] buf;
+  }
+
+  static VVA_FORCEINLINE bool TestBit (const vuint8 *row, int n) noexcept { return !!(row[(unsigned)n>>3]&(1u<<((unsigned)n&7))); }
+  static VVA_FORCEINLINE void SetBit (vuint8 *row, int n) noexcept { row[(unsigned)n>>3] |= (vuint8)(1u<<((unsigned)n&7)); }
+
+  VVA_FORCEINLINE vuint8 *PortalMightSee (int pidx) const noexcept { return MightSee+(size_t)pidx*(unsigned)RowSize; }
+  VVA_FORCEINLINE vuint8 *LeafRow (int leaf) const noexcept { return Result+(size_t)leaf*(unsigned)RowSize; }
+
+  bool Setup (VLevel *Level, VStr &errmsg);
+
+  bool LoadCache (VStream *strm);
+  bool SaveCache (VStream *strm);
+
+  void Build ();
+
+private:
+  static VVA_FORCEINLINE double PointSide (double nx, double ny, double dist, double x, double y) noexcept { return nx*x+ny*y-dist; }
+
+  static bool ClipWinding (Winding &w, double nx, double ny, double dist) noexcept;
+  static bool ClipToSeparators (const Winding &src, const Winding &pass, Winding &target) noexcept;
+
+  bool CanPortalSeePortal (const Portal &from, const Portal &to) const noexcept;
+  void CalcMightSee (int pidx, TArrayNC<int> &stack);
+  bool Flow (int leaf, const Winding &src, const Winding *pass, const vuint8 *might, int depth);
+  void BuildLeaf (int leaf, TArrayNC<int> &wildFirst);
+};
+
+
+//==========================================================================
+//
+//  pvsFindRoot
+//
+//==========================================================================
+static int pvsFindRoot (TArrayNC<int> &parent, int n) noexcept {
+  while (parent[n] != n) {
+    parent[n] = parent[parent[n]];
+    n = parent[n];
+  }
+  return n;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::Setup
+//
+//  collects portals; this should be called from the main thread
+//
+//==========================================================================
+bool VLevelPVSBuilder::Setup (VLevel *Level, VStr &errmsg) {
+  NumLeafs = Level->NumSubsectors;
+  if (NumLeafs < 1) { errmsg = "no subsectors"; return false; }
+  RowSize = ((NumLeafs+63)/64)*8;
+
+  // seg -> subsector
+  TArrayNC<int> segLeaf;
+  segLeaf.setLength(Level->NumSegs);
+  for (auto &&sl : segLeaf) sl = -1;
+  for (int f = 0; f < NumLeafs; ++f) {
+    const subsector_t *sub = &Level->Subsectors[f];
+    for (int sn = 0; sn < sub->numlines; ++sn) segLeaf[sub->firstline+sn] = f;
+  }
+
+  TArrayNC<int> parent;
+  parent.setLength(NumLeafs);
+  for (int f = 0; f < NumLeafs; ++f) parent[f] = f;
+  TArrayNC<vuint8> wildLeaf;
+  wildLeaf.setLength(NumLeafs);
+  memset(wildLeaf.ptr(), 0, NumLeafs);
+
+  LeafPortals.setLength(NumLeafs+1);
+  for (int f = 0; f < NumLeafs; ++f) {
+    LeafPortals[f] = Portals.length();
+    const subsector_t *sub = &Level->Subsectors[f];
+    for (int sn = 0; sn < sub->numlines; ++sn) {
+      const seg_t *seg = &Level->Segs[sub->firstline+sn];
+      const bool isPObj = (seg->pobj || (seg->linedef && seg->linedef->pobj()));
+      if (isPObj) wildLeaf[f] = 1;
+      // one-sided wall?
+      if (seg->linedef && !seg->backsector) continue;
+      const seg_t *partner = seg->partner;
+      if (!partner) {
+        if (isPObj) continue;
+        errmsg = va("%s #%d has no partner", (seg->linedef ? "seg" : "miniseg"), (int)(ptrdiff_t)(seg-Level->Segs));
+        return false;
+      }
+      const int dest = segLeaf[(int)(ptrdiff_t)(partner-Level->Segs)];
+      if (dest < 0) { errmsg = va("seg #%d partner is not in any subsector", (int)(ptrdiff_t)(seg-Level->Segs)); return false; }
+      if (dest == f) continue;
+      // connect areas
+      const int r0 = pvsFindRoot(parent, f);
+      const int r1 = pvsFindRoot(parent, dest);
+      if (r0 != r1) parent[r1] = r0;
+      if (isPObj || partner->pobj) {
+        // this can move, so it is not a real portal
+        wildLeaf[f] = wildLeaf[dest] = 1;
+        continue;
+      }
+      const double x0 = seg->v1->x, y0 = seg->v1->y;
+      const double x1 = seg->v2->x, y1 = seg->v2->y;
+      const double len = sqrt((x1-x0)*(x1-x0)+(y1-y0)*(y1-y0));
+      if (len < ON_EPS) continue;
+      // subsector is on the front side of its segs, so destination is on the back side
+      Portal &pt = Portals.alloc();
+      pt.x0 = x0; pt.y0 = y0;
+      pt.x1 = x1; pt.y1 = y1;
+      pt.nx = (y0-y1)/len;
+      pt.ny = (x1-x0)/len;
+      pt.dist = pt.nx*x0+pt.ny*y0;
+      if (seg->PointOnSide2(TVec((float)(x0+pt.nx), (float)(y0+pt.ny), 0.0f)) != 1) {
+        // segs are always clockwise, so this should not happen
+        pt.nx = -pt.nx;
+        pt.ny = -pt.ny;
+        pt.dist = -pt.dist;
+      }
+      pt.leaf = f;
+      pt.dest = dest;
+    }
+  }
+  LeafPortals[NumLeafs] = Portals.length();
+
+  // connected areas
+  Component.setLength(NumLeafs);
+  TArrayNC<int> rootComp;
+  rootComp.setLength(NumLeafs);
+  for (auto &&rc : rootComp) rc = -1;
+  for (int f = 0; f < NumLeafs; ++f) {
+    const int root = pvsFindRoot(parent, f);
+    if (rootComp[root] < 0) {
+      rootComp[root] = WildComponent.length();
+      WildComponent.append(0);
+    }
+    Component[f] = rootComp[root];
+    if (wildLeaf[f]) WildComponent[rootComp[root]] = 1;
+  }
+
+  const size_t memNeeded = ((size_t)Portals.length()+(size_t)NumLeafs)*(size_t)RowSize;
+  const size_t memLimit = (size_t)max2(0, loader_pvs_max_memory.asInt())*1024u*1024u;
+  if (memNeeded > memLimit) {
+    errmsg = va("it needs %u megabytes of memory (the limit is %d)", (unsigned)(memNeeded/1024u/1024u)+1u, loader_pvs_max_memory.asInt());
+    return false;
+  }
+
+  GeoHash = joaatHashBuf(&NumLeafs, sizeof(NumLeafs));
+  if (Portals.length()) GeoHash = joaatHashBuf(Portals.ptr(), (size_t)Portals.length()*sizeof(Portal), GeoHash);
+  for (int f = 0; f < NumLeafs; ++f) {
+    const vuint8 wild = WildComponent[Component[f]];
+    GeoHash = joaatHashBuf(&wild, 1, GeoHash);
+  }
+
+  TimeLimit = loader_pvs_time_limit.asFloat();
+  CacheTimeLimit = loader_cache_time_limit_pvs.asFloat();
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::LoadCache
+//
+//==========================================================================
+bool VLevelPVSBuilder::LoadCache (VStream *strm) {
+  if (!strm) return false;
+  char sign[PVSCDSLEN];
+  strm->Serialise(sign, PVSCDSLEN);
+  if (strm->IsError() || memcmp(sign, PVS_CACHE_SIGNATURE, PVSCDSLEN) != 0) return false;
+
+  vint32 leafs = -1, portals = -1, rowsize = -1;
+  vuint32 hash = 0;
+  *strm << leafs << portals << hash << rowsize;
+  if (strm->IsError() || leafs != NumLeafs || portals != Portals.length() || hash != GeoHash || rowsize != RowSize) return false;
+
+  Result = new vuint8[(size_t)NumLeafs*(unsigned)RowSize];
+  strm->Serialise(Result, NumLeafs*RowSize);
+  if (strm->IsError()) {
+    delete[] Result;
+    Result = nullptr;
+    return false;
+  }
+  Success = true;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::SaveCache
+//
+//==========================================================================
+bool VLevelPVSBuilder::SaveCache (VStream *strm) {
+  if (!strm || !Result) return false;
+  strm->Serialise(PVS_CACHE_SIGNATURE, PVSCDSLEN);
+
+  // the data is not compressed here, the cache store will do it
+  vint32 portals = Portals.length();
+  *strm << NumLeafs << portals << GeoHash << RowSize;
+  strm->Serialise(Result, NumLeafs*RowSize);
+  return !strm->IsError();
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::ClipWinding
+//
+//  keeps the part on the positive side
+//  returns `false` if nothing left
+//
+//==========================================================================
+bool VLevelPVSBuilder::ClipWinding (Winding &w, double nx, double ny, double dist) noexcept {
+  const double d0 = PointSide(nx, ny, dist, w.x0, w.y0);
+  const double d1 = PointSide(nx, ny, dist, w.x1, w.y1);
+  if (d0 >= -CLIP_EPS && d1 >= -CLIP_EPS) return true;
+  if (d0 < -CLIP_EPS && d1 < -CLIP_EPS) return false;
+  const double t = d0/(d0-d1);
+  const double ix = w.x0+(w.x1-w.x0)*t;
+  const double iy = w.y0+(w.y1-w.y0)*t;
+  if (d0 < -CLIP_EPS) {
+    w.x0 = ix;
+    w.y0 = iy;
+  } else {
+    w.x1 = ix;
+    w.y1 = iy;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::ClipToSeparators
+//
+//  clips `target` to the area that can be seen from `src` through `pass`
+//
+//  separating line goes through one `src` endpoint and one `pass`
+//  endpoint, and has `src` and `pass` on the different sides. any line
+//  of sight that crosses `src`, then `pass`, will end up on the `pass`
+//  side of it.
+//
+//==========================================================================
+bool VLevelPVSBuilder::ClipToSeparators (const Winding &src, const Winding &pass, Winding &target) noexcept {
+  const double sx[2] = { src.x0, src.x1 };
+  const double sy[2] = { src.y0, src.y1 };
+  const double px[2] = { pass.x0, pass.x1 };
+  const double py[2] = { pass.y0, pass.y1 };
+  for (unsigned i = 0; i < 2; ++i) {
+    for (unsigned j = 0; j < 2; ++j) {
+      const double dx = px[j]-sx[i];
+      const double dy = py[j]-sy[i];
+      const double len = sqrt(dx*dx+dy*dy);
+      if (len < ON_EPS) continue;
+      double nx = dy/len;
+      double ny = -dx/len;
+      double dist = nx*sx[i]+ny*sy[i];
+      const double ds = PointSide(nx, ny, dist, sx[i^1], sy[i^1]);
+      const double dp = PointSide(nx, ny, dist, px[j^1], py[j^1]);
+      if (ds < -ON_EPS && dp > ON_EPS) {
+        // keep positive side
+      } else if (ds > ON_EPS && dp < -ON_EPS) {
+        nx = -nx;
+        ny = -ny;
+        dist = -dist;
+      } else {
+        continue;
+      }
+      if (!ClipWinding(target, nx, ny, dist)) return false;
+    }
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::CanPortalSeePortal
+//
+//  rough check: `to` should have some part in front of `from`, and `from`
+//  should have some part behind `to`
+//
+//==========================================================================
+bool VLevelPVSBuilder::CanPortalSeePortal (const Portal &from, const Portal &to) const noexcept {
+  if (PointSide(from.nx, from.ny, from.dist, to.x0, to.y0) <= ON_EPS &&
+      PointSide(from.nx, from.ny, from.dist, to.x1, to.y1) <= ON_EPS)
+  {
+    return false;
+  }
+  if (PointSide(to.nx, to.ny, to.dist, from.x0, from.y0) >= -ON_EPS &&
+      PointSide(to.nx, to.ny, to.dist, from.x1, from.y1) >= -ON_EPS)
+  {
+    return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::CalcMightSee
+//
+//  flood fill through the portals that can be seen from the given one
+//
+//==========================================================================
+void VLevelPVSBuilder::CalcMightSee (int pidx, TArrayNC<int> &stack) {
+  const Portal &pt = Portals[pidx];
+  vuint8 *row = PortalMightSee(pidx);
+  memset(row, 0, (unsigned)RowSize);
+  SetBit(row, pt.dest);
+  stack.resetNoDtor();
+  stack.append(pt.dest);
+  while (stack.length()) {
+    const int leaf = stack.pop();
+    for (int qi = LeafPortals[leaf]; qi < LeafPortals[leaf+1]; ++qi) {
+      const Portal &qt = Portals[qi];
+      if (TestBit(row, qt.dest)) continue;
+      if (!CanPortalSeePortal(pt, qt)) continue;
+      SetBit(row, qt.dest);
+      stack.append(qt.dest);
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::Flow
+//
+//  `src` is a part of the source portal, `pass` is the portal we came
+//  through into `leaf` (`nullptr` for the first step)
+//
+//  returns `false` if step limit is exceeded
+//
+//==========================================================================
+bool VLevelPVSBuilder::Flow (int leaf, const Winding &src, const Winding *pass, const vuint8 *might, int depth) {
+  if (++Steps > StepLimit || depth >= MaxFlowDepth) return false;
+  if ((Steps&0x3ff) == 0 && atomic_get(&Abort)) return false;
+
+  while (MightStack.length() <= depth) MightStack.append(new vuint8[(unsigned)RowSize]);
+  vuint64 *newMight = (vuint64 *)MightStack[depth];
+  const unsigned words = (unsigned)RowSize/8u;
+
+  InPath[leaf] = 1;
+  for (int pi = LeafPortals[leaf]; pi < LeafPortals[leaf+1]; ++pi) {
+    const Portal &pt = Portals[pi];
+    if (InPath[pt.dest] || !TestBit(might, pt.dest)) continue;
+
+    // is there anything new to see through this portal?
+    const vuint64 *m0 = (const vuint64 *)might;
+    const vuint64 *m1 = (const vuint64 *)PortalMightSee(pi);
+    const vuint64 *vis = (const vuint64 *)CurrVis;
+    vuint64 more = 0;
+    for (unsigned w = 0; w < words; ++w) {
+      const vuint64 nm = m0[w]&m1[w];
+      newMight[w] = nm;
+      more |= nm&~vis[w];
+    }
+    if (!more && TestBit(CurrVis, pt.dest)) continue;
+
+    Winding target;
+    target.x0 = pt.x0; target.y0 = pt.y0;
+    target.x1 = pt.x1; target.y1 = pt.y1;
+    // the line of sight can cross the source portal line only once
+    if (!ClipWinding(target, SrcNX, SrcNY, SrcDist)) continue;
+    Winding newSrc = src;
+    if (pass) {
+      if (!ClipToSeparators(src, *pass, target)) continue;
+      // and the source part that can see the target through the pass
+      if (!ClipToSeparators(target, *pass, newSrc)) continue;
+    }
+
+    SetBit(CurrVis, pt.dest);
+    if (!Flow(pt.dest, newSrc, &target, (const vuint8 *)newMight, depth+1)) {
+      InPath[leaf] = 0;
+      return false;
+    }
+  }
+  InPath[leaf] = 0;
+
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::BuildLeaf
+//
+//==========================================================================
+void VLevelPVSBuilder::BuildLeaf (int leaf, TArrayNC<int> &wildFirst) {
+  vuint8 *row = LeafRow(leaf);
+  const int comp = Component[leaf];
+
+  if (WildComponent[comp]) {
+    // everything in this area can see everything
+    if (wildFirst[comp] >= 0) {
+      memcpy(row, LeafRow(wildFirst[comp]), (unsigned)RowSize);
+    } else {
+      memset(row, 0, (unsigned)RowSize);
+      for (int f = 0; f < NumLeafs; ++f) if (Component[f] == comp) SetBit(row, f);
+      wildFirst[comp] = leaf;
+    }
+    return;
+  }
+
+  memset(row, 0, (unsigned)RowSize);
+  SetBit(row, leaf);
+  CurrVis = row;
+  Steps = 0;
+
+  bool ok = true;
+  InPath[leaf] = 1;
+  for (int pi = LeafPortals[leaf]; pi < LeafPortals[leaf+1]; ++pi) {
+    const Portal &pt = Portals[pi];
+    SetBit(row, pt.dest);
+    if (!ok) continue;
+    SrcNX = pt.nx;
+    SrcNY = pt.ny;
+    SrcDist = pt.dist;
+    Winding src;
+    src.x0 = pt.x0; src.y0 = pt.y0;
+    src.x1 = pt.x1; src.y1 = pt.y1;
+    ok = Flow(pt.dest, src, nullptr, PortalMightSee(pi), 0);
+  }
+  InPath[leaf] = 0;
+
+  if (!ok) {
+    // too complex; use rough visibility
+    ++RoughLeafs;
+    vuint64 *vis = (vuint64 *)row;
+    const unsigned words = (unsigned)RowSize/8u;
+    for (int pi = LeafPortals[leaf]; pi < LeafPortals[leaf+1]; ++pi) {
+      const vuint64 *m = (const vuint64 *)PortalMightSee(pi);
+      for (unsigned w = 0; w < words; ++w) vis[w] |= m[w];
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VLevelPVSBuilder::Build
+//
+//  this is called from the builder thread
+//
+//==========================================================================
+void VLevelPVSBuilder::Build () {
+  const double stt = Sys_Time();
+
+  TArrayNC<int> stack;
+  MightSee = new vuint8[(size_t)max2(1, Portals.length())*(unsigned)RowSize];
+  for (int f = 0; f < Portals.length(); ++f) {
+    if ((f&0xff) == 0 && atomic_get(&Abort)) return;
+    CalcMightSee(f, stack);
+  }
+
+  Result = new vuint8[(size_t)NumLeafs*(unsigned)RowSize];
+  InPath.setLength(NumLeafs);
+  memset(InPath.ptr(), 0, NumLeafs);
+  TArrayNC<int> wildFirst;
+  wildFirst.setLength(WildComponent.length());
+  for (auto &&wf : wildFirst) wf = -1;
+
+  for (int f = 0; f < NumLeafs; ++f) {
+    if (atomic_get(&Abort)) return;
+    // too long? use rough visibility for the rest
+    if (StepLimit && TimeLimit > 0 && Sys_Time()-stt > TimeLimit) StepLimit = 0;
+    BuildLeaf(f, wildFirst);
+  }
+
+  delete[] MightSee;
+  MightSee = nullptr;
+  for (auto &&buf : MightStack) delete[] buf;
+  MightStack.clear();
+
+  BuildTime = Sys_Time()-stt;
+  Success = true;
+
+  if (!CacheFileName.isEmpty() && BuildTime >= CacheTimeLimit) {
+    // cache store is thread-safe
+    VMemoryStream *strm = new VMemoryStream(CacheFileName);
+    if (!SaveCache(strm) || !VCacheStore::Write(CacheFileName, strm)) VCacheStore::Remove(CacheFileName);
+    delete strm;
+  }
+}
+
+
+//==========================================================================
+//
+//  pvsBuilderThread
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE pvsBuilderThread (void *abuilder) {
+  VLevelPVSBuilder *builder = (VLevelPVSBuilder *)abuilder;
+  builder->Build();
+  atomic_store(&builder->Done, 1);
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  VLevel::StartPVSBuilder
+//
+//  called by map loader; `cacheFileName` is main cache store entry name (can be empty)
+//
+//==========================================================================
+void VLevel::StartPVSBuilder (VStr cacheFileName) {
+  KillPVS();
+  if (!loader_pvs_build) return;
+
+  VLevelPVSBuilder *builder = new VLevelPVSBuilder();
+  VStr errmsg;
+  if (!builder->Setup(this, errmsg)) {
+    GCon->Logf(NAME_Warning, "PVS: not building: %s", *errmsg);
+    delete builder;
+    return;
+  }
+
+  if (loader_cache_data && !cacheFileName.isEmpty()) {
+    builder->CacheFileName = cacheFileName+".pvs";
+    VStream *strm = VCacheStore::OpenRead(builder->CacheFileName);
+    if (strm) {
+      const bool ok = builder->LoadCache(strm);
+      VStream::Destroy(strm);
+      if (ok) {
+        PVSData = builder->Result;
+        PVSRowSize = builder->RowSize;
+        builder->Result = nullptr;
+        delete builder;
+        GCon->Logf("PVS: loaded from cache (%d subsectors)", NumSubsectors);
+        return;
+      }
+      GCon->Log("PVS: invalid cache entry, rebuilding");
+      VCacheStore::Remove(builder->CacheFileName);
+    }
+  }
+
+  if (mythread_create(&builder->Thread, &pvsBuilderThread, builder)) {
+    // no thread, build it right here
+    GCon->Logf(NAME_Warning, "cannot create PVS builder thread");
+    builder->Build();
+    atomic_store(&builder->Done, 1);
+    PVSBuilder = builder;
+    PollPVSBuilder(true);
+    return;
+  }
+  PVSBuilder = builder;
+}
+
+
+//==========================================================================
+//
+//  VLevel::PollPVSBuilder
+//
+//  adopts PVS if the builder is complete
+//  should be called from the main thread
+//
+//==========================================================================
+void VLevel::PollPVSBuilder (bool noThread) {
+  if (!PVSBuilder || !atomic_get(&PVSBuilder->Done)) return;
+  VLevelPVSBuilder *builder = PVSBuilder;
+  PVSBuilder = nullptr;
+  if (!noThread) mythread_join(builder->Thread);
+  if (builder->Success && builder->Result) {
+    PVSData = builder->Result;
+    PVSRowSize = builder->RowSize;
+    builder->Result = nullptr;
+    if (builder->RoughLeafs) {
+      GCon->Logf("PVS: built for %d subsectors (%d portals) in %d msecs (%d subsectors are too complex)",
+                 builder->NumLeafs, builder->Portals.length(), (int)(builder->BuildTime*1000.0), builder->RoughLeafs);
+    } else {
+      GCon->Logf("PVS: built for %d subsectors (%d portals) in %d msecs", builder->NumLeafs, builder->Portals.length(), (int)(builder->BuildTime*1000.0));
+    }
+  }
+  delete builder;
+}
+
+
+//==========================================================================
+//
+//  VLevel::KillPVS
+//
+//  aborts the builder, and frees PVS data
+//
+//==========================================================================
+void VLevel::KillPVS () {
+  if (PVSBuilder) {
+    VLevelPVSBuilder *builder = PVSBuilder;
+    PVSBuilder = nullptr;
+    atomic_store(&builder->Abort, 1);
+    mythread_join(builder->Thread);
+    delete builder;
+  }
+  delete[] PVSData;
+  PVSData = nullptr;
+  PVSRowSize = 0;
+}
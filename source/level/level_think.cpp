@@ -53,10 +53,24 @@ static VCvarB dbg_force_replacements("dbg_force_replacements", false, "Dumb forc
 
 static VCvarI gm_corpse_limit("gm_corpse_limit", "-1", "Limit number of corpses per map (-1: no limit)?", CVAR_Archive);
 
+static VCvarB sv_parallel_think("sv_parallel_think", false, "Run native-only parts of the world tick in worker threads?", CVAR_Archive|CVAR_NoShadow);
+
 double worldThinkTimeVM = -1.0;
 double worldThinkTimeDecal = -1.0;
 
-static TArrayNC<VEntity *> corpseQueue;
+static TFrameArray<VEntity *> corpseQueue;
+
+// for parallel "notick" runs
+enum {
+  TCF_Limiter = 1u<<0,
+  TCF_Corpse = 1u<<1,
+  TCF_Died = 1u<<2, // `TickNoTickGrav()` asked to destroy the entity
+};
+
+static float tickedDeltaTime = 0.0f;
+
+static TFrameArray<VThinker *> tickedThinkers;
+static TFrameArray<vuint8> tickedCollect;
 
 int dbgEntityTickTotal = 0;
 int dbgEntityTickSimple = 0;
@@ -352,6 +366,7 @@ void VLevel::UpdateThinkersLevelInfo () {
 //==========================================================================
 void VLevel::RunScriptThinkers (float DeltaTime) {
   if (DeltaTime <= 0.0f) return;
+  VPROF_ZONE("world", "RunScriptThinkers");
   // run script thinkers
   // do not run newly spawned scripts on this frame, though
   //const int sclenOrig = scriptThinkers.length();
@@ -402,6 +417,8 @@ void VLevel::RunScriptThinkers (float DeltaTime) {
     //GCon->Logf("  SHRINKING ACS from %d to %d", sclen, firstEmpty);
     scriptThinkers.setLength<false>(firstEmpty); // don't resize
   }
+  // no scripts are running now, so it is safe to reclaim unused dynamic strings
+  AcsCollectStrings(Acs);
 }
 
 
@@ -429,6 +446,126 @@ void VLevel::TickDecals (float DeltaTime) {
 }
 
 
+//==========================================================================
+//
+//  isLimiterCandidate
+//
+//  `InstanceLimitWithSub` should be set up
+//
+//==========================================================================
+static VVA_FORCEINLINE bool isLimiterCandidate (const VThinker *c) {
+  VClass *lcls = c->GetClass();
+  if (!lcls->GetLimitInstancesWithSub()) return false;
+  lcls = (lcls->InstanceLimitBaseClass ?: lcls);
+  vassert(lcls);
+  return (lcls->InstanceLimitWithSub > 0 && lcls->InstanceCountWithSub > lcls->InstanceLimitWithSub);
+}
+
+
+//==========================================================================
+//
+//  isCorpseCandidate
+//
+//==========================================================================
+static VVA_FORCEINLINE bool isCorpseCandidate (VThinker *c) {
+  if (!c->IsA(VEntity::StaticClass())) return false;
+  VEntity *e = (VEntity *)c;
+  // check if it is really dead, and not moving
+  if (e->IsRealCorpse() && e->StateTime < 0 && fabsf(e->Velocity.x) < 0.01f && fabsf(e->Velocity.y) < 0.01f) {
+    // if the corpse is on a floor, it is safe to remove it
+    if (e->Origin.z <= e->FloorZ) {
+      // notick corpses are fading out
+      return ((e->FlagsEx&(VEntity::EFEX_NoTickGrav|VEntity::EFEX_NoTickGravLT)) != (VEntity::EFEX_NoTickGrav|VEntity::EFEX_NoTickGravLT));
+    }
+  }
+  return false;
+}
+
+
+//==========================================================================
+//
+//  isParallelNoTick
+//
+//  "notick" entities only change themselves, and read level geometry,
+//  so a run of them can be ticked in worker threads. the ones that will
+//  die in this tick are not included, because destroying runs VM code.
+//
+//==========================================================================
+static VVA_FORCEINLINE bool isParallelNoTick (VThinker *c, float deltaTime) {
+  if (c->IsGoingToDie() || !c->IsA(VEntity::StaticClass())) return false;
+  VEntity *e = (VEntity *)c;
+  return ((e->FlagsEx&VEntity::EFEX_NoTickGrav) && !e->NoTickGravWillDie(deltaTime));
+}
+
+
+//==========================================================================
+//
+//  collectTickedBatch
+//
+//  worker callback
+//  it ticks "notick" entities, and collects limiter and corpse candidates
+//
+//==========================================================================
+static void collectTickedBatch (void *udata, int start, int end, int /*worker*/) {
+  VPROF_ZONE("world", "collectTickedBatch");
+  // the caller times the whole job
+  VEntityPhysTimer::Mute physMute;
+  const bool doCorpses = *(const bool *)udata;
+  VThinker **tl = tickedThinkers.ptr()+start;
+  vuint8 *res = tickedCollect.ptr()+start;
+  for (int f = start; f < end; ++f, ++tl, ++res) {
+    VEntity *e = (VEntity *)(*tl);
+    e->DataGameTime = e->XLevel->Time+tickedDeltaTime;
+    if (!e->TickNoTickGrav(tickedDeltaTime)) { *res = (vuint8)TCF_Died; continue; }
+    unsigned flags = 0;
+    if (isLimiterCandidate(e)) flags |= TCF_Limiter;
+    if (doCorpses && isCorpseCandidate(e)) flags |= TCF_Corpse;
+    *res = (vuint8)flags;
+  }
+}
+
+
+//==========================================================================
+//
+//  tickNoTickRun
+//
+//  ticks collected "notick" run, and commits the results in thinker
+//  list order; returns `true` if some limiter candidates were found
+//
+//==========================================================================
+static bool tickNoTickRun (int corpseLimit) {
+  const int count = tickedThinkers.length();
+  if (!count) return false;
+  VPROF_ZONE("world", "CollectTicked");
+  bool doCorpses = (corpseLimit >= 0);
+  tickedCollect.setLength(count);
+  {
+    VEntityPhysTimer physTimer;
+    VWorkPool::ParallelFor(count, 512, &collectTickedBatch, &doCorpses);
+  }
+  bool res = false;
+  const vuint8 *cflags = tickedCollect.ptr();
+  for (VThinker *c : tickedThinkers) {
+    const unsigned flags = *cflags++;
+    ++dbgEntityTickTotal;
+    ++dbgEntityTickNoTick;
+    // this should not happen, as dying entities are not in the run
+    // if it does, it will be removed from the list on the next tick
+    if (flags&TCF_Died) { c->DestroyThinker(); continue; }
+    if (flags&TCF_Limiter) {
+      VClass *lcls = c->GetClass();
+      lcls = (lcls->InstanceLimitBaseClass ?: lcls);
+      lcls->InstanceLimitList.append(c);
+      res = true;
+    }
+    if (flags&TCF_Corpse) corpseQueue.append((VEntity *)c);
+  }
+  tickedThinkers.reset();
+  tickedCollect.reset();
+  return res;
+}
+
+
 //==========================================================================
 //
 //  cmpLimInstance
@@ -459,12 +596,17 @@ void VLevel::TickWorld (float DeltaTime, bool allowVCPause) {
   CheckAndRecalcWorldBBoxes();
   //if (pathInterceptsUsed) GCon->Logf(NAME_Debug, "unbalanced path iterators; used=%d", pathInterceptsUsed);
   ResetAllPathIntercepts();
+  // thinker lists are allocated from the frame arena
+  VFrameArena::NewFrame();
+  if (PVSBuilder) PollPVSBuilder();
 
   // paused for VC UI?
   if (allowVCPause && !eventIsWorldTickAllowed()) {
     return; // nothing to do here
   }
 
+  VPROF_ZONE("world", "TickWorld");
+
   double stimet = 0.0;
 
   NextTime = Time+DeltaTime;
@@ -533,12 +675,31 @@ void VLevel::TickWorld (float DeltaTime, bool allowVCPause) {
   #endif
 
   bool shouldProcessLimiters = false;
+  // in parallel mode, runs of "notick" entities are ticked in worker threads. a run ends
+  // before anything that can execute VM code, and it is committed in thinker list order
+  // right there, so the outcome is the same as in serial mode.
+  const bool parallelThink = sv_parallel_think.asBool() && VWorkPool::GetThreadCount() > 1;
+  tickedThinkers.reset();
+  tickedCollect.reset();
+  tickedDeltaTime = DeltaTime;
   //GCon->Log(NAME_Debug, "========================");
   VThinker *Th = ThinkerHead;
   if (!dbg_vm_disable_thinkers) {
     while (Th) {
       VThinker *c = Th;
       Th = c->Next;
+      if (parallelThink) {
+        #ifdef CLIENT
+        if (c != plrmo && isParallelNoTick(c, DeltaTime))
+        #else
+        if (isParallelNoTick(c, DeltaTime))
+        #endif
+        {
+          tickedThinkers.append(c);
+          continue;
+        }
+        if (tickNoTickRun(corpseLimit)) shouldProcessLimiters = true;
+      }
       #ifdef CLIENT
       if (c != plrmo)
       #endif
@@ -560,34 +721,19 @@ void VLevel::TickWorld (float DeltaTime, bool allowVCPause) {
         c->ConditionalDestroy();
       } else {
         // collect instances for limiters
-        VClass *lcls = c->GetClass();
-        if (lcls->GetLimitInstancesWithSub()) {
+        if (isLimiterCandidate(c)) {
+          VClass *lcls = c->GetClass();
           lcls = (lcls->InstanceLimitBaseClass ?: lcls);
-          vassert(lcls);
-          if (lcls->InstanceLimitWithSub > 0 && lcls->InstanceCountWithSub > lcls->InstanceLimitWithSub) {
-            lcls->InstanceLimitList.append(c);
-            shouldProcessLimiters = true;
-            //GCon->Logf(NAME_Debug, ":ADDING:%s: count=%d; limit=%d (lcls=%s)", c->GetClass()->GetName(), lcls->InstanceCountWithSub, lcls->InstanceLimitWithSub, lcls->GetName());
-          }
+          lcls->InstanceLimitList.append(c);
+          shouldProcessLimiters = true;
+          //GCon->Logf(NAME_Debug, ":ADDING:%s: count=%d; limit=%d (lcls=%s)", c->GetClass()->GetName(), lcls->InstanceCountWithSub, lcls->InstanceLimitWithSub, lcls->GetName());
         }
         // collect corpses
-        if (corpseLimit >= 0) {
-          if (c->IsA(VEntity::StaticClass())) {
-            VEntity *e = (VEntity *)c;
-            // check if it is really dead, and not moving
-            if (e->IsRealCorpse() && e->StateTime < 0 && fabsf(e->Velocity.x) < 0.01f && fabsf(e->Velocity.y) < 0.01f) {
-              // if the corpse is on a floor, it is safe to remove it
-              if (e->Origin.z <= e->FloorZ) {
-                // notick corpses are fading out
-                if ((e->FlagsEx&(VEntity::EFEX_NoTickGrav|VEntity::EFEX_NoTickGravLT)) != (VEntity::EFEX_NoTickGrav|VEntity::EFEX_NoTickGravLT)) {
-                  corpseQueue.append(e);
-                }
-              }
-            }
-          }
-        }
+        if (corpseLimit >= 0 && isCorpseCandidate(c)) corpseQueue.append((VEntity *)c);
       }
     }
+    // the last run
+    if (tickNoTickRun(corpseLimit)) shouldProcessLimiters = true;
   } else {
     // thinkers are disabled
     if (dbg_vm_enable_secthink) {
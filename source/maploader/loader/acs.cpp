@@ -58,6 +58,7 @@ void VLevel::LoadLoadACS (int lacsLump, int /*XMapLump*/) {
 //
 //==========================================================================
 void VLevel::LoadACScripts (int Lump, int XMapLump) {
+  VPROF_ZONE("mapload", "LoadACScripts");
   Acs = new VAcsLevel(this);
 
   if (developer) GCon->Logf(NAME_Dev, "ACS: BEHAVIOR lump: %d", Lump);
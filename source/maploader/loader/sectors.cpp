@@ -111,6 +111,7 @@ void VLevel::LoadSectors (int Lump) {
 //
 //==========================================================================
 void VLevel::GroupLines () {
+  VPROF_ZONE("mapload", "GroupLines");
   if (NumSectors > 0) {
     if (Sectors[0].lines) delete[] Sectors[0].lines;
     if (Sectors[0].nbsecs) delete[] Sectors[0].nbsecs;
@@ -34,6 +34,7 @@
 # include "../automap.h"
 #endif
 #include "../mapinfo.h"
+#include "../filesys/cachestore.h"
 
 
 static VCvarB dbg_show_map_hash("dbg_show_map_hash", false, "Show map hash?", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
@@ -219,32 +220,6 @@ void VLevel::FixKnownMapErrors () {
 }
 
 
-//==========================================================================
-//
-//  hashLump
-//
-//==========================================================================
-static bool hashLump (RIPEMD160_Ctx *ripectx, MD5Context *md5ctx, int lumpnum) {
-  if (lumpnum < 0) return false;
-  static vuint8 buf[65536];
-  VStream *strm = W_CreateLumpReaderNum(lumpnum);
-  if (!strm) return false;
-  VCheckedStream st(strm);
-  auto left = st.TotalSize();
-  while (left > 0) {
-    int rd = left;
-    if (rd > (int)sizeof(buf)) rd = (int)sizeof(buf);
-    st.Serialise(buf, rd);
-    if (st.IsError()) { VStream::Destroy(strm); return false; }
-    if (ripectx) ripemd160_put(ripectx, buf, (unsigned)rd);
-    if (md5ctx) md5ctx->Update(buf, (unsigned)rd);
-    //if (xxhash) XXH32_update(xxhash, buf, (unsigned)rd);
-    left -= rd;
-  }
-  return true;
-}
-
-
 // ////////////////////////////////////////////////////////////////////////// //
 struct MapLumps {
   int TextMapLump;
@@ -262,6 +237,19 @@ struct MapLumps {
   //md5: gzdoom-compatible hash (only for non-UDMF, UDMF hashes are not compatible)
   RIPEMD160_Ctx ripectx;
   MD5Context md5ctx;
+  // lump data to hash; it is read by `CheckValidMapWad()`, and hashed by `HashMapLumps()`
+  enum { MaxHashParts = 8 };
+  struct HashPart {
+    int ofs;
+    int size;
+    bool ripe;
+    bool md5;
+  };
+  HashPart hashParts[MaxHashParts];
+  int hashPartCount;
+  TArrayNC<vuint8> hashData;
+  double ripeTime;
+  double md5Time;
 
   inline MapLumps () noexcept { Clear(); }
 
@@ -279,12 +267,68 @@ struct MapLumps {
     mapHashValid = false;
     ripemd160_init(&ripectx);
     md5ctx.Init();
+    hashPartCount = 0;
+    hashData.clear();
+    ripeTime = md5Time = 0;
   }
 
   inline bool IsValid () const noexcept { return mapHashValid; }
 };
 
 
+//==========================================================================
+//
+//  hashLump
+//
+//  reads lump data; it will be hashed later, in `HashMapLumps()`
+//
+//==========================================================================
+static bool hashLump (MapLumps *nfo, bool ripe, bool md5, int lumpnum) {
+  if (lumpnum < 0) return false;
+  if (nfo->hashPartCount == MapLumps::MaxHashParts) return false;
+  VStream *strm = W_CreateLumpReaderNum(lumpnum);
+  if (!strm) return false;
+  VCheckedStream st(strm);
+  const int size = st.TotalSize();
+  if (size < 0) { VStream::Destroy(strm); return false; }
+  MapLumps::HashPart &hp = nfo->hashParts[nfo->hashPartCount++];
+  hp.ofs = nfo->hashData.length();
+  hp.size = size;
+  hp.ripe = ripe;
+  hp.md5 = md5;
+  nfo->hashData.setLength(hp.ofs+size);
+  if (size) st.Serialise(nfo->hashData.ptr()+hp.ofs, size);
+  if (st.IsError()) { VStream::Destroy(strm); return false; }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  HashMapLumps
+//
+//  worker callback; item 0 is ripemd-160, item 1 is md5
+//  it is started before parsing map lumps, and runs in parallel with it
+//
+//==========================================================================
+static void HashMapLumps (void *udata, int start, int end, int /*worker*/) {
+  VPROF_ZONE("mapload", "HashMapLumps");
+  MapLumps *nfo = (MapLumps *)udata;
+  for (int item = start; item < end; ++item) {
+    double stime = -Sys_Time();
+    for (int f = 0; f < nfo->hashPartCount; ++f) {
+      const MapLumps::HashPart &hp = nfo->hashParts[f];
+      if (!hp.size) continue;
+      const vuint8 *data = nfo->hashData.ptr()+hp.ofs;
+      if (item == 0 && hp.ripe) ripemd160_put(&nfo->ripectx, data, (unsigned)hp.size);
+      if (item == 1 && hp.md5) nfo->md5ctx.Update(data, (unsigned)hp.size);
+    }
+    stime += Sys_Time();
+    if (item == 0) nfo->ripeTime = stime; else nfo->md5Time = stime;
+  }
+}
+
+
 //==========================================================================
 //
 //  CheckValidMapWad
@@ -321,8 +365,8 @@ static bool CheckValidMapWad (int lumpbase, MapLumps *nfo) {
     validMap = (validMap && LName == NAME_endmap);
 
     if (validMap) {
-      bool okhash = hashLump(nullptr, &nfo->md5ctx, lumpbase); // hash map header
-      okhash = okhash && hashLump(&nfo->ripectx, &nfo->md5ctx, lumpbase + 1); // hash map text
+      bool okhash = hashLump(nfo, false, true, lumpbase); // hash map header
+      okhash = okhash && hashLump(nfo, true, true, lumpbase + 1); // hash map text
       if (okhash) {
         nfo->mapHashValid = true;
       } else {
@@ -375,14 +419,14 @@ static bool CheckValidMapWad (int lumpbase, MapLumps *nfo) {
       #if 1
       GCon->Logf(NAME_Debug, "calculating map hash...");
       #endif
-      bool okhash = hashLump(nullptr, &nfo->md5ctx, lumpbase); // map header: only in md5
-      okhash = okhash && hashLump(nullptr, &nfo->md5ctx, nfo->ThingsLump); // things: only in md5
-      okhash = okhash && hashLump(&nfo->ripectx, &nfo->md5ctx, nfo->LinesLump); // lines: both
-      okhash = okhash && hashLump(&nfo->ripectx, &nfo->md5ctx, nfo->SidesLump); // sides: both
-      okhash = okhash && hashLump(&nfo->ripectx, nullptr, nfo->VertexesLump); // vertices: only RIPE
-      okhash = okhash && hashLump(&nfo->ripectx, &nfo->md5ctx, nfo->SectorsLump); // sectors: both
+      bool okhash = hashLump(nfo, false, true, lumpbase); // map header: only in md5
+      okhash = okhash && hashLump(nfo, false, true, nfo->ThingsLump); // things: only in md5
+      okhash = okhash && hashLump(nfo, true, true, nfo->LinesLump); // lines: both
+      okhash = okhash && hashLump(nfo, true, true, nfo->SidesLump); // sides: both
+      okhash = okhash && hashLump(nfo, true, false, nfo->VertexesLump); // vertices: only RIPE
+      okhash = okhash && hashLump(nfo, true, true, nfo->SectorsLump); // sectors: both
       if (okhash && nfo->BehaviorLump != -1) {
-        okhash = okhash && hashLump(nullptr, &nfo->md5ctx, nfo->BehaviorLump); // compiled scrips: only md5
+        okhash = okhash && hashLump(nfo, false, true, nfo->BehaviorLump); // compiled scrips: only md5
       }
       if (okhash) {
         nfo->mapHashValid = true;
@@ -438,6 +482,29 @@ static int OpenMapContainer (VStream *lstrm) {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+struct BlockMapCleanupInfo {
+  VLevel *level;
+  double time;
+
+  inline BlockMapCleanupInfo (VLevel *alevel) noexcept : level(alevel), time(0) {}
+};
+
+
+//==========================================================================
+//
+//  VLevel::CleanupBlockMapJob
+//
+//==========================================================================
+void VLevel::CleanupBlockMapJob (void *udata, int /*start*/, int /*end*/, int /*worker*/) {
+  VPROF_ZONE("mapload", "CleanupBlockMap");
+  BlockMapCleanupInfo *nfo = (BlockMapCleanupInfo *)udata;
+  nfo->time = -Sys_Time();
+  nfo->level->CleanupBlockMap();
+  nfo->time += Sys_Time();
+}
+
+
 //==========================================================================
 //
 //  VLevel::LoadMap
@@ -446,6 +513,7 @@ static int OpenMapContainer (VStream *lstrm) {
 void VLevel::LoadMap (VName AMapName) {
   fsys_report_added_paks_logtype = NAME_Log; // it is time for this...
   AuxiliaryCloser auxCloser;
+  VPROF_ZONE("mapload", "LoadMap");
 
   bool killCache = loader_cache_ignore_one;
   cacheFlags = (loader_cache_ignore_one ? CacheFlag_Ignore : 0);
@@ -566,8 +634,7 @@ load_again:
   bool NeedNodesBuild = true;
   const VMapInfo &MInfo = P_GetMapInfo(MapName);
 
-  VStr cacheFileName;
-  VStr cacheDir = getCacheDir();
+  VStr cacheFileName; // cache store entry name
 
   //ripemd-160: k8vavoom hash
   //md5: gzdoom-compatible hash (only for non-UDMF, UDMF hashes are not compatible)
@@ -587,49 +654,6 @@ load_again:
   if (AuxiliaryMap) GCon->Log(NAME_Debug, "loading map from container");
 
   vassert(nfo.mapHashValid);
-  {
-    vuint8 ripe[RIPEMD160_BYTES];
-    ripemd160_finish(&nfo.ripectx, ripe);
-    MapHash = VStr::buf2hex(ripe, RIPEMD160_BYTES);
-
-    vuint8 md5digest[MD5Context::DIGEST_SIZE];
-    nfo.md5ctx.Final(md5digest);
-    MapHashMD5 = VStr::buf2hex(md5digest, MD5Context::DIGEST_SIZE);
-
-    if (dbg_show_map_hash) {
-      GCon->Logf("map hash, md5: %s", *MapHashMD5);
-      GCon->Logf("map hash, ripemd-160: %s", *MapHash);
-    } else if (developer) {
-      GCon->Logf(NAME_Dev, "map hash, md5: %s", *MapHashMD5);
-      GCon->Logf(NAME_Dev, "map hash, ripemd-160: %s", *MapHash);
-    }
-    // BadApple.wad hack
-    // md5: 3cca5044d82cf1d1a91eca7933d5b4f6
-    if (MapHashMD5 == "3cca5044d82cf1d1a91eca7933d5b4f6") LevelFlags |= LF_IsBadApple;
-  }
-
-  bool cachedDataLoaded = false;
-  bool mapHashValid = true; //k8: i am too lazy to rename it
-
-  if (cacheDir.length()) {
-    cacheFileName = VStr("mapcache_")+MapHash+".cache";
-    cacheFileName = cacheDir+"/"+cacheFileName;
-  } else {
-    mapHashValid = false;
-  }
-
-  bool hasCacheFile = false;
-
-  //FIXME: load cache file into temp buffer, and process it later
-  if (mapHashValid) {
-    if (killCache) {
-      Sys_FileDelete(cacheFileName);
-    } else {
-      VStream *strm = FL_OpenSysFileRead(cacheFileName);
-      hasCacheFile = !!strm;
-      VStream::Destroy(strm);
-    }
-  }
 
   double VertexTime = 0;
   double SectorsTime = 0;
@@ -637,12 +661,18 @@ load_again:
   double ThingsTime = 0;
   double TranslTime = 0;
   double SidesTime = 0;
+  double HashWaitTime = 0;
   double DecalProcessingTime = 0;
   double FloodFixTime = 0;
+  double BlockMapCleanupTime = 0;
+  double BlockMapCleanupWaitTime = 0;
   double SectorListTime = 0;
   double MapHashingTime = 0;
 
   {
+    // map hashes are calculated in worker threads while we are parsing map lumps
+    // parsers don't need the hashes (but map fixer does)
+    VWorkPoolJob hashJob(2, 1, &HashMapLumps, &nfo);
     auto texLock = GTextureManager.LockMapLocalTextures();
 
     // begin processing map lumps
@@ -684,6 +714,52 @@ load_again:
       LoadSideDefs(nfo.SidesLump);
       SidesTime += Sys_Time();
     }
+
+    HashWaitTime = -Sys_Time();
+    hashJob.Finish();
+    HashWaitTime += Sys_Time();
+  }
+  nfo.hashData.clear();
+
+  {
+    vuint8 ripe[RIPEMD160_BYTES];
+    ripemd160_finish(&nfo.ripectx, ripe);
+    MapHash = VStr::buf2hex(ripe, RIPEMD160_BYTES);
+
+    vuint8 md5digest[MD5Context::DIGEST_SIZE];
+    nfo.md5ctx.Final(md5digest);
+    MapHashMD5 = VStr::buf2hex(md5digest, MD5Context::DIGEST_SIZE);
+
+    if (dbg_show_map_hash) {
+      GCon->Logf("map hash, md5: %s", *MapHashMD5);
+      GCon->Logf("map hash, ripemd-160: %s", *MapHash);
+    } else if (developer) {
+      GCon->Logf(NAME_Dev, "map hash, md5: %s", *MapHashMD5);
+      GCon->Logf(NAME_Dev, "map hash, ripemd-160: %s", *MapHash);
+    }
+    // BadApple.wad hack
+    // md5: 3cca5044d82cf1d1a91eca7933d5b4f6
+    if (MapHashMD5 == "3cca5044d82cf1d1a91eca7933d5b4f6") LevelFlags |= LF_IsBadApple;
+  }
+
+  bool cachedDataLoaded = false;
+  bool mapHashValid = true; //k8: i am too lazy to rename it
+
+  if (loader_cache_data && VCacheStore::IsAvailable()) {
+    cacheFileName = VStr("map_")+MapHash;
+  } else {
+    mapHashValid = false;
+  }
+
+  bool hasCacheFile = false;
+
+  //FIXME: load cache file into temp buffer, and process it later
+  if (mapHashValid) {
+    if (killCache) {
+      VCacheStore::Remove(cacheFileName);
+    } else {
+      hasCacheFile = VCacheStore::Has(cacheFileName);
+    }
   }
 
   // do it here, as it fixes bad two-sided lines and such
@@ -698,22 +774,18 @@ load_again:
   SetupThingsFromMapinfo();
 
   if (hasCacheFile) {
-    //GCon->Logf("using cache file: %s", *cacheFileName);
-    VStream *strm = FL_OpenSysFileRead(cacheFileName);
+    //GCon->Logf("using cache entry: %s", *cacheFileName);
+    VStream *strm = VCacheStore::OpenRead(cacheFileName);
     cachedDataLoaded = LoadCachedData(strm);
     if (!cachedDataLoaded) {
       GCon->Logf("cache data is obsolete or in invalid format");
       VStream::Destroy(strm);
-      Sys_FileDelete(cacheFileName);
+      VCacheStore::Remove(cacheFileName);
       ClearAllMapData();
       goto load_again;
     }
     VStream::Destroy(strm);
-    if (cachedDataLoaded) {
-      NeedNodesBuild = false;
-      // touch cache file, so it will survive longer
-      Sys_Touch(cacheFileName);
-    }
+    if (cachedDataLoaded) NeedNodesBuild = false;
   }
 
   bool forceNewBlockmap = false;
@@ -763,6 +835,7 @@ load_again:
     delete[] BlockLinks;
     BlockLinks = new VEntity *[count];
     memset(BlockLinks, 0, sizeof(VEntity *)*count);
+    AllocBlockProxies();
   }
   BlockMapTime += Sys_Time();
 
@@ -777,16 +850,13 @@ load_again:
 
   // update cache
   if (loader_cache_data && saveCachedData && mapHashValid && TotalTime+Sys_Time() > loader_cache_time_limit) {
-    VStream *strm = FL_OpenSysFileWrite(cacheFileName);
-    if (strm) {
-      bool err = !SaveCachedData(strm);
-      if (strm->IsError()) err = true;
-      if (!strm->Close()) err = true;
-      delete strm;
-      if (err) Sys_FileDelete(cacheFileName);
-    }
+    VMemoryStream *strm = new VMemoryStream(cacheFileName);
+    bool err = !SaveCachedData(strm);
+    if (strm->IsError()) err = true;
+    if (!err) err = !VCacheStore::Write(cacheFileName, strm);
+    delete strm;
+    if (err) VCacheStore::Remove(cacheFileName);
   }
-  doCacheCleanup();
 
 
   // ACS object code
@@ -891,18 +961,27 @@ load_again:
     W_CloseAuxiliary();
   }
 
-  // this will remove polyobject and invalid lines from blockmap
-  // it will also fill blockmap subsector info
-  CleanupBlockMap();
-
-  // do it here, so it won't touch sloped floors
-  // it will set `othersec` for sectors too
-  // also, it will detect "transparent door" sectors
-  FloodFixTime = -Sys_Time();
-  DetectHiddenSectors();
-  FixTransparentDoors();
-  FixDeepWaters();
-  FloodFixTime += Sys_Time();
+  {
+    // this will remove polyobject and invalid lines from blockmap
+    // it will also fill blockmap subsector info
+    // it touches only the blockmap, so it is done in parallel with the fixers
+    BlockMapCleanupInfo bmci(this);
+    VWorkPoolJob bmapJob(1, 1, &CleanupBlockMapJob, &bmci);
+
+    // do it here, so it won't touch sloped floors
+    // it will set `othersec` for sectors too
+    // also, it will detect "transparent door" sectors
+    FloodFixTime = -Sys_Time();
+    DetectHiddenSectors();
+    FixTransparentDoors();
+    FixDeepWaters();
+    FloodFixTime += Sys_Time();
+
+    BlockMapCleanupWaitTime = -Sys_Time();
+    bmapJob.Finish();
+    BlockMapCleanupWaitTime += Sys_Time();
+    BlockMapCleanupTime = bmci.time;
+  }
 
   // this must be called after deepwater fixes
   SectorListTime = -Sys_Time();
@@ -950,6 +1029,9 @@ load_again:
   AddLoadingTiming("Things", ThingsTime);
   AddLoadingTiming("Translation", TranslTime);
   AddLoadingTiming("Sides", SidesTime);
+  AddLoadingTiming("Map hashing (ripemd, parallel)", nfo.ripeTime);
+  AddLoadingTiming("Map hashing (md5, parallel)", nfo.md5Time);
+  AddLoadingTiming("Map hashing (waiting)", HashWaitTime);
   AddLoadingTiming("Error fixing", Lines2Time);
   AddLoadingTiming("Nodes", NodesTime);
   AddLoadingTiming("Blockmap", BlockMapTime);
@@ -966,8 +1048,12 @@ load_again:
   AddLoadingTiming("Decal processing", DecalProcessingTime);
   AddLoadingTiming("Sector min/max", MinMaxTime);
   AddLoadingTiming("Floodbug fixing", FloodFixTime);
+  AddLoadingTiming("Blockmap cleanup (parallel)", BlockMapCleanupTime);
+  AddLoadingTiming("Blockmap cleanup (waiting)", BlockMapCleanupWaitTime);
   AddLoadingTiming("Sector lists", SectorListTime);
   AddLoadingTiming("Map hashing", MapHashingTime);
+  // this is not on the critical path (except the "waiting" parts above)
+  AddLoadingTiming("Work done in parallel", nfo.ripeTime+nfo.md5Time+BlockMapCleanupTime);
 
   DumpLoadingTimings();
 
@@ -976,6 +1062,10 @@ load_again:
   RecalcWorldBBoxes();
 
   cacheFileBase = cacheFileName;
+  if (!cacheFileBase.isEmpty()) cacheFlags |= CacheFlag_Store;
+
+  // subsector PVS will be built in background
+  StartPVSBuilder(mapHashValid ? cacheFileName : VStr());
 
   #if 0
   // nope, some lines don't need fullsegs
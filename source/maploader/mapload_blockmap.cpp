@@ -32,6 +32,7 @@
 //
 //==========================================================================
 void VLevel::CreateBlockMap () {
+  VPROF_ZONE("mapload", "CreateBlockMap");
   GCon->Logf("creating new blockmap (%d lines)...", NumLines);
 
   // determine bounds of the map
@@ -65,6 +65,7 @@ int VLevel::GetNodesBuilder () const {
 //
 //==========================================================================
 void VLevel::BuildNodes () {
+  VPROF_ZONE("mapload", "BuildNodes");
 #ifdef CLIENT
   R_OSDMsgShowSecondary("BUILDING NODES");
   R_PBarReset();
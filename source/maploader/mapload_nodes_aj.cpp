@@ -38,6 +38,8 @@ static VCvarB ajbsp_roundoff_tree("ajbsp_roundoff_tree", false, "Roundoff vertic
 
 static VCvarB nodes_show_warnings("nodes_show_warnings", true, "Show various node builder warnings?", CVAR_Archive|CVAR_NoShadow);
 static VCvarB nodes_fast_mode("nodes_fast_mode", false, "Do faster rebuild, but generate worser BSP tree?", CVAR_Archive|CVAR_NoShadow);
+// used by zdbsp too
+VCvarB nodes_parallel("nodes_parallel", true, "Evaluate node builder split candidates on worker threads (the result is the same)?", CVAR_Archive|CVAR_NoShadow);
 
 
 namespace ajbsp {
@@ -587,6 +589,7 @@ void VLevel::BuildNodesAJ () {
   // set up glBSP build globals
   nodebuildinfo_t nb_info;
   nb_info.fast = nodes_fast_mode;
+  nb_info.parallel = nodes_parallel;
   nb_info.warnings = true; // not currently used, but meh
   nb_info.do_blockmap = true;
   nb_info.do_reject = true;
@@ -32,6 +32,8 @@
 
 #include "../bsp/zdbsp/nodebuild.h"
 
+extern VCvarB nodes_parallel;
+
 
 static inline int toFix (double val) { return (int)(val*(1<<16)); }
 static inline float fromFix (int val) { return (float)((double)val/(double)(1<<16)); }
@@ -223,6 +225,26 @@ void ZDProgress (int curr, int total) {
 }
 
 
+//==========================================================================
+//
+//  ZDThreadCount
+//
+//==========================================================================
+int ZDThreadCount () {
+  return (nodes_parallel ? VWorkPool::GetThreadCount() : 1);
+}
+
+
+//==========================================================================
+//
+//  ZDParallelFor
+//
+//==========================================================================
+void ZDParallelFor (int count, int batchSize, void (*fn) (void *udata, int start, int end, int worker), void *udata) {
+  VWorkPool::ParallelFor(count, batchSize, fn, udata);
+}
+
+
 //==========================================================================
 //
 //  VLevel::BuildNodesZD
@@ -45,6 +45,615 @@ enum {
 };
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// text of UDMF token
+// points into the lexer buffer (quoted strings are unescaped in-place), or
+// into the lexer scratch buffer. it is always zero-terminated, and valid
+// until the next token is read.
+struct VUdmfText {
+  const char *str;
+  int len;
+
+  VVA_FORCEINLINE VUdmfText () noexcept : str(""), len(0) {}
+
+  VVA_FORCEINLINE void clear () noexcept { str = ""; len = 0; }
+  VVA_FORCEINLINE bool isEmpty () const noexcept { return (len == 0); }
+  VVA_FORCEINLINE int length () const noexcept { return len; }
+  VVA_FORCEINLINE const char *operator * () const noexcept { return str; }
+
+  inline VStr toVStr () const noexcept { return VStr(str, len); }
+
+  // length is known at compile time, so most mismatches are rejected with one compare
+  template<size_t N> VVA_FORCEINLINE bool strEquCI (const char (&s)[N]) const noexcept {
+    return (len == (int)(N-1) && VStr::NICmp(str, s, N-1) == 0);
+  }
+
+  template<size_t N> VVA_FORCEINLINE bool startsWithCI (const char (&s)[N]) const noexcept {
+    return (len >= (int)(N-1) && VStr::NICmp(str, s, N-1) == 0);
+  }
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// dedicated TEXTMAP lexer
+// it works over the raw lump text, and never allocates per token. it is
+// compatible with C-mode `VScriptParser`, but it knows only the things UDMF
+// needs: identifiers, quoted strings, numbers, and single-char punctuation.
+class VUdmfLexer {
+public:
+  enum {
+    TK_None,
+    TK_Int,
+    TK_Float,
+    TK_String,
+    TK_Identifier,
+  };
+
+private:
+  VStr ScriptName;
+  char *Buf; // zero-terminated
+  char *Ptr;
+  char *EndPtr;
+  int Line;
+  int TokLine;
+  mutable int SrcIdx;
+  TArrayNC<char> Scratch;
+
+private:
+  void ParseQuotedString (const char qch);
+  void ParseUnquoted () noexcept;
+  VUdmfText &SetScratch (const char *s, const char *e, char prefix=0) noexcept;
+
+public:
+  // last token; set by `GetString()` and `GetValue()`
+  VUdmfText Token;
+  bool TokQuoted;
+  int Number;
+  float Float;
+
+public:
+  VV_DISABLE_COPY(VUdmfLexer)
+
+  VUdmfLexer (VStr name, VStream *Strm);
+  ~VUdmfLexer ();
+
+  void SkipBlanks () noexcept;
+
+  VVA_FORCEINLINE bool AtEnd () noexcept { SkipBlanks(); return (Ptr >= EndPtr); }
+
+  // `str` is either single punctuation char, or an identifier; case-insensitive
+  bool Check (const char *str) noexcept;
+  void Expect (const char *str);
+
+  bool GetString ();
+  void ExpectString ();
+
+  // reads key value, returns `TK_xxx`
+  // numbers are converted in-place; `Token` is their source text
+  int GetValue ();
+
+  // skips to the matching `}`; opening bracket should be eaten
+  void SkipBracketed ();
+
+  TLocation GetVCLoc () const noexcept;
+
+  void Message (const char *message);
+  void MessageErr (const char *message);
+  void HostError (const char *message);
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+static vuint8 udmfIdTerm[256]; // non-zero for C-like identifier terminators
+
+struct VUdmfCharClassInit {
+  VUdmfCharClassInit () noexcept {
+    memset(udmfIdTerm, 0, sizeof(udmfIdTerm));
+    for (const char *s = "`~!#$%^&*(){}[]/=\\?-+|;:<>,\"'."; *s; ++s) udmfIdTerm[(vuint8)*s] = 1;
+    // blanks will terminate too
+    for (int ch = 0; ch <= 32; ++ch) udmfIdTerm[ch] = 1;
+  }
+};
+
+static VUdmfCharClassInit udmfCharClassInit;
+
+static VVA_FORCEINLINE bool udmfIsIdTerm (char ch) noexcept { return udmfIdTerm[(vuint8)ch]; }
+static VVA_FORCEINLINE bool udmfIsDigit (char ch) noexcept { return (ch >= '0' && ch <= '9'); }
+
+
+//==========================================================================
+//
+//  udmfSkipNum
+//
+//==========================================================================
+static const char *udmfSkipNum (const char *s, const char *end, int base) noexcept {
+  if (s >= end || VStr::digitInBase(*s, base) < 0) return nullptr;
+  ++s;
+  while (s < end && (*s == '_' || VStr::digitInBase(*s, base) >= 0)) ++s;
+  return s;
+}
+
+
+//==========================================================================
+//
+//  udmfNumEnd
+//
+//  returns number end, or `nullptr` if definitely not a number
+//  accepts the same numbers as `VScriptParser` (without sign)
+//
+//==========================================================================
+static const char *udmfNumEnd (const char *s, const char *end) noexcept {
+  if (s >= end) return nullptr;
+  // hex number?
+  if (*s == '0' && s+2 < end && (s[1] == 'x' || s[1] == 'X')) return udmfSkipNum(s+2, end, 16);
+  if (*s != '.') {
+    // integral part
+    s = udmfSkipNum(s, end, 10);
+    if (!s || s >= end) return s;
+  } else {
+    // no integral part, so fractional part should have at least one digit
+    if (s+1 >= end || !udmfIsDigit(s[1])) return nullptr;
+  }
+  // fractional part
+  if (*s == '.') {
+    if (++s >= end) return s;
+    if (udmfIsDigit(*s)) {
+      s = udmfSkipNum(s, end, 10);
+      if (!s || s >= end) return s;
+    }
+  }
+  // exponent
+  if (*s != 'e' && *s != 'E') return s;
+  if (++s >= end) return nullptr;
+  if (*s == '+' || *s == '-') {
+    if (++s >= end) return nullptr;
+  }
+  return udmfSkipNum(s, end, 10);
+}
+
+
+//==========================================================================
+//
+//  udmfParseFloat
+//
+//  unsigned; the same rules as in silent `VScriptParser::CheckFloat()`
+//
+//==========================================================================
+static bool udmfParseFloat (const char *s, float *res) noexcept {
+  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+    float val = 0.0f;
+    for (s += 2; *s; ++s) {
+      const int dg = VStr::digitInBase(*s, 16);
+      if (dg < 0) return false;
+      if (val <= 1.0e12f) val = val*16.0f+(float)dg;
+    }
+    *res = val;
+    return true;
+  }
+  float ff = 0.0f;
+  if (!VStr::convertFloat(s, &ff)) {
+    // mo...dders from LCA loves numbers like "90000000000000000000000000000000000000000000000000"
+    while (udmfIsDigit(*s)) ++s;
+    if (*s) return false;
+    ff = 1.0e12f;
+  } else {
+    if (isNaNF(ff)) return false;
+    if (isInfF(ff) || ff > 1.0e12f) ff = 1.0e12f;
+  }
+  *res = ff;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::VUdmfLexer
+//
+//==========================================================================
+VUdmfLexer::VUdmfLexer (VStr name, VStream *Strm)
+  : ScriptName(name)
+  , Buf(nullptr)
+  , Line(1)
+  , TokLine(1)
+  , SrcIdx(-1)
+  , TokQuoted(false)
+  , Number(0)
+  , Float(0.0f)
+{
+  int size = 0;
+  if (Strm) {
+    if (!Strm->IsError()) size = Strm->TotalSize();
+    if (size < 0 || Strm->IsError()) { VStream::Destroy(Strm); Host_Error("cannot read UDMF map '%s'", *name); }
+  }
+  Buf = (char *)Z_Malloc(size+1);
+  if (size) Strm->Serialise(Buf, size);
+  Buf[size] = 0;
+  if (Strm) {
+    const bool err = Strm->IsError();
+    VStream::Destroy(Strm);
+    if (err) { Z_Free(Buf); Buf = nullptr; Host_Error("cannot read UDMF map '%s'", *name); }
+  }
+  Ptr = Buf;
+  EndPtr = Buf+size;
+  // skip garbage some editors add in the begining of UTF-8 files
+  if (size >= 3 && (vuint8)Ptr[0] == 0xef && (vuint8)Ptr[1] == 0xbb && (vuint8)Ptr[2] == 0xbf) Ptr += 3;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::~VUdmfLexer
+//
+//==========================================================================
+VUdmfLexer::~VUdmfLexer () {
+  Z_Free(Buf);
+  Buf = Ptr = EndPtr = nullptr;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::SkipBlanks
+//
+//==========================================================================
+void VUdmfLexer::SkipBlanks () noexcept {
+  while (Ptr < EndPtr) {
+    const char ch = *Ptr;
+    if ((vuint8)ch <= ' ') {
+      if (ch == '\n') ++Line;
+      ++Ptr;
+      continue;
+    }
+    if (ch != '/') break;
+    const char c1 = Ptr[1];
+    if (c1 == '/') {
+      // single-line comment
+      Ptr += 2;
+      while (Ptr < EndPtr && *Ptr != '\n') ++Ptr;
+      continue;
+    }
+    if (c1 == '*') {
+      // multiline comment
+      Ptr += 2;
+      while (Ptr < EndPtr) {
+        if (Ptr[0] == '*' && Ptr[1] == '/') { Ptr += 2; break; }
+        if (*Ptr++ == '\n') ++Line;
+      }
+      continue;
+    }
+    if (c1 == '+') {
+      // multiline nesting comment
+      int level = 1;
+      Ptr += 2;
+      while (Ptr < EndPtr) {
+        if (Ptr[0] == '/' && Ptr[1] == '+') { Ptr += 2; ++level; continue; }
+        if (Ptr[0] == '+' && Ptr[1] == '/') { Ptr += 2; if (--level == 0) break; continue; }
+        if (*Ptr++ == '\n') ++Line;
+      }
+      continue;
+    }
+    break;
+  }
+  if (Ptr > EndPtr) Ptr = EndPtr;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::SetScratch
+//
+//  copies text to the scratch buffer, omitting underscores, and sets `Token`
+//
+//==========================================================================
+VUdmfText &VUdmfLexer::SetScratch (const char *s, const char *e, char prefix) noexcept {
+  Scratch.setLengthReserve((int)(e-s)+2);
+  char *d = Scratch.ptr();
+  if (prefix) *d++ = prefix;
+  while (s < e) {
+    const char ch = *s++;
+    if (ch != '_') *d++ = ch;
+  }
+  *d = 0;
+  Token.str = Scratch.ptr();
+  Token.len = (int)(d-Scratch.ptr());
+  return Token;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::ParseQuotedString
+//
+//  starting quote is eaten; unescapes the string in-place
+//
+//==========================================================================
+void VUdmfLexer::ParseQuotedString (const char qch) {
+  char *dest = Ptr;
+  Token.str = dest;
+  TokQuoted = true;
+  while (Ptr < EndPtr) {
+    char ch = *Ptr++;
+    // quote char?
+    if (ch == qch) {
+      // double quote is string continuation
+      if (*Ptr != qch || (vuint8)Ptr[1] < ' ') break;
+      ++Ptr; // skip quote char
+      continue;
+    }
+    if (ch == '\n' || ch == '\r') HostError("Unterminated string constant");
+    // escape?
+    if (ch == '\\' && Ptr[0]) {
+      const char c1 = *Ptr++;
+      // continuation?
+      if (c1 == '\n' || c1 == '\r') {
+        ++Line;
+        if (c1 == '\r' && *Ptr == '\n') ++Ptr;
+        continue;
+      }
+      bool okescape = true;
+      switch (c1) {
+        case 'r': ch = '\r'; break;
+        case 'n': ch = '\n'; break;
+        case 'c': case 'C': ch = TEXT_COLOR_ESCAPE; break;
+        case 'e': ch = '\x1b'; break;
+        case '\t': ch = '\t'; break;
+        case '"': case '\'': case ' ': case '\\': case '`': ch = c1; break;
+        case 'x':
+          if (VStr::digitInBase(*Ptr, 16) < 0) {
+            okescape = false;
+          } else {
+            int n0 = VStr::digitInBase(*Ptr++, 16);
+            const int n1 = VStr::digitInBase(*Ptr, 16);
+            if (n1 >= 0) { n0 = n0*16+n1; ++Ptr; }
+            if (!n0) n0 = 32;
+            ch = n0;
+          }
+          break;
+        default: okescape = false; break;
+      }
+      // the result is never longer than the source, so this is safe
+      *dest++ = ch;
+      if (!okescape) *dest++ = c1;
+      continue;
+    }
+    *dest++ = ch;
+  }
+  Token.len = (int)(dest-Token.str);
+  *dest = 0;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::ParseUnquoted
+//
+//  number, identifier, or punctuation; `Ptr` should be at non-blank
+//
+//==========================================================================
+void VUdmfLexer::ParseUnquoted () noexcept {
+  const char *s = Ptr;
+  TokQuoted = false;
+  // number?
+  if (udmfIsDigit(*s) || (*s == '.' && udmfIsDigit(s[1]))) {
+    const char *ee = udmfNumEnd(s, EndPtr);
+    if (ee && (ee >= EndPtr || udmfIsIdTerm(*ee))) {
+      Ptr = (char *)ee;
+      (void)SetScratch(s, ee);
+      return;
+    }
+  }
+  // punctuation?
+  if (udmfIsIdTerm(*s)) {
+    ++Ptr;
+    Scratch.setLengthReserve(2);
+    Scratch[0] = *s;
+    Scratch[1] = 0;
+    Token.str = Scratch.ptr();
+    Token.len = 1;
+    return;
+  }
+  // identifier
+  ++Ptr;
+  while (Ptr < EndPtr) {
+    const char ch = *Ptr;
+    // eh... allow single quote inside an identifier
+    if (ch == '\'' && Ptr+1 < EndPtr && !udmfIsIdTerm(Ptr[1])) { ++Ptr; continue; }
+    if (udmfIsIdTerm(ch)) break;
+    ++Ptr;
+  }
+  Scratch.setLengthReserve((int)(Ptr-s)+1);
+  memcpy(Scratch.ptr(), s, (size_t)(Ptr-s));
+  Scratch[(int)(Ptr-s)] = 0;
+  Token.str = Scratch.ptr();
+  Token.len = (int)(Ptr-s);
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::Check
+//
+//==========================================================================
+bool VUdmfLexer::Check (const char *str) noexcept {
+  vassert(str && str[0]);
+  SkipBlanks();
+  TokLine = Line;
+  if (Ptr >= EndPtr) return false;
+  if (!str[1] && udmfIsIdTerm(str[0])) {
+    if (*Ptr != str[0]) return false;
+    ++Ptr;
+    return true;
+  }
+  const size_t len = strlen(str);
+  if ((size_t)(EndPtr-Ptr) < len || VStr::NICmp(Ptr, str, len) != 0) return false;
+  if (Ptr+len < EndPtr && !udmfIsIdTerm(Ptr[len])) return false;
+  Ptr += len;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::Expect
+//
+//==========================================================================
+void VUdmfLexer::Expect (const char *str) {
+  if (Check(str)) return;
+  if (Ptr >= EndPtr) HostError(va("`%s` expected", str));
+  VStr got;
+  if (*Ptr == '"' || *Ptr == '\'') {
+    got = "<string>";
+  } else {
+    ParseUnquoted();
+    got = Token.toVStr();
+  }
+  HostError(va("Bad syntax, `%s` expected, got `%s`.", str, *got.quote()));
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::GetString
+//
+//==========================================================================
+bool VUdmfLexer::GetString () {
+  SkipBlanks();
+  TokLine = Line;
+  if (Ptr >= EndPtr) { Token.clear(); TokQuoted = false; return false; }
+  if (*Ptr == '"' || *Ptr == '\'') {
+    const char qch = *Ptr++;
+    ParseQuotedString(qch);
+  } else {
+    ParseUnquoted();
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::ExpectString
+//
+//==========================================================================
+void VUdmfLexer::ExpectString () {
+  if (!GetString()) HostError("String expected");
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::GetValue
+//
+//==========================================================================
+int VUdmfLexer::GetValue () {
+  Number = 0;
+  Float = 0.0f;
+  SkipBlanks();
+  TokLine = Line;
+  if (Ptr >= EndPtr) HostError("String expected");
+
+  if (*Ptr == '"' || *Ptr == '\'') {
+    const char qch = *Ptr++;
+    ParseQuotedString(qch);
+    return TK_String;
+  }
+
+  // number with optional sign (there can be blanks after the sign)
+  char *start = Ptr;
+  const int startLine = Line;
+  char sign = 0;
+  if (*Ptr == '-' || *Ptr == '+') {
+    sign = *Ptr++;
+    SkipBlanks();
+  }
+  const char *s = Ptr;
+  if (Ptr < EndPtr && (udmfIsDigit(*s) || (*s == '.' && udmfIsDigit(s[1])))) {
+    const char *ee = udmfNumEnd(s, EndPtr);
+    if (ee && (ee >= EndPtr || udmfIsIdTerm(*ee))) {
+      // `Token` will have the sign, but we don't need it for conversion
+      (void)SetScratch(s, ee, sign);
+      const char *digits = Token.str+(sign ? 1 : 0);
+      if (VStr::convertInt(digits, &Number)) {
+        Ptr = (char *)ee;
+        if (sign == '-') Number = -Number;
+        return TK_Int;
+      }
+      if (udmfParseFloat(digits, &Float)) {
+        Ptr = (char *)ee;
+        if (sign == '-') Float = -Float;
+        return TK_Float;
+      }
+    }
+  }
+
+  // not a number; unget the sign
+  Ptr = start;
+  Line = startLine;
+  TokQuoted = false;
+  ParseUnquoted();
+  return TK_Identifier;
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::SkipBracketed
+//
+//==========================================================================
+void VUdmfLexer::SkipBracketed () {
+  int level = 1;
+  while (GetString()) {
+    if (TokQuoted || Token.len != 1) continue;
+    if (Token.str[0] == '{') {
+      ++level;
+    } else if (Token.str[0] == '}') {
+      if (--level == 0) return;
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::GetVCLoc
+//
+//==========================================================================
+TLocation VUdmfLexer::GetVCLoc () const noexcept {
+  if (SrcIdx == -1) SrcIdx = TLocation::AddSourceFile(ScriptName);
+  return TLocation(SrcIdx, TokLine, 1);
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::Message
+//
+//==========================================================================
+void VUdmfLexer::Message (const char *message) {
+  GCon->Logf(NAME_Warning, "%s:%d: %s", *ScriptName, TokLine, (message ? message : "Bad syntax."));
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::MessageErr
+//
+//==========================================================================
+void VUdmfLexer::MessageErr (const char *message) {
+  GCon->Logf(NAME_Error, "%s:%d: %s", *ScriptName, TokLine, (message ? message : "Bad syntax."));
+}
+
+
+//==========================================================================
+//
+//  VUdmfLexer::HostError
+//
+//==========================================================================
+void VUdmfLexer::HostError (const char *message) {
+  Host_Error("Script error at %s:%d: %s", *ScriptName, TokLine, (message ? message : "Bad syntax."));
+}
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 class VUdmfParser {
 public:
@@ -64,11 +673,11 @@ public:
   };
 
   enum {
-    TK_None,
-    TK_Int,
-    TK_Float,
-    TK_String,
-    TK_Identifier,
+    TK_None = VUdmfLexer::TK_None,
+    TK_Int = VUdmfLexer::TK_Int,
+    TK_Float = VUdmfLexer::TK_Float,
+    TK_String = VUdmfLexer::TK_String,
+    TK_Identifier = VUdmfLexer::TK_Identifier,
   };
 
   struct VValue {
@@ -131,16 +740,17 @@ public:
     TArray<VValue> userFields;
   };
 
-  VScriptParser sc;
+  VUdmfLexer sc;
   bool bExtended;
   bool bDoTranslation;
   vuint8 NS;
   VStr NamespaceStr;
-  VStr Key;
+  VUdmfText Key; // points to `KeyBuf`
+  TArrayNC<char> KeyBuf;
   int ValType;
   int ValInt;
   float ValFloat;
-  VStr Val;
+  VUdmfText Val; // valid until the next key is parsed
   TLocation KeyLoc;
   TArray<VParsedVertex> ParsedVertexes;
   TArray<VParsedSector> ParsedSectors;
@@ -253,31 +863,19 @@ void VUdmfParser::ParseKey () {
   // get key and value
   KeyLoc = sc.GetVCLoc();
   sc.ExpectString();
-  Key = sc.String;
+  // the value will reuse lexer scratch buffer, so copy the key
+  KeyBuf.setLengthReserve(sc.Token.len+1);
+  memcpy(KeyBuf.ptr(), sc.Token.str, (size_t)sc.Token.len+1);
+  Key.str = KeyBuf.ptr();
+  Key.len = sc.Token.len;
   sc.Expect("=");
 
-  ValType = TK_None;
-  ValInt = 0;
-  ValFloat = 0.0f;
-  Val.clear();
-
-  if (sc.CheckQuotedString()) {
-    ValType = TK_String;
-    Val = sc.String;
-  } else if (sc.CheckNumberWithSign()) {
-    ValType = TK_Int;
-    ValInt = sc.Number;
-    Val = VStr(ValInt);
-  } else if (sc.CheckFloatWithSign()) {
-    ValType = TK_Float;
-    ValFloat = sc.Float;
-    Val = VStr(ValFloat);
-  } else {
-    //sc.HostError(va("Cannot parse value '%s' for key '%s'", *sc.String, *Key));
-    sc.ExpectString();
-    ValType = TK_Identifier;
-    Val = sc.String;
-    if (Val == ";" || Val.isEmpty()) sc.HostError(va("Cannot parse value '%s' for key '%s'", *sc.String, *Key));
+  ValType = sc.GetValue();
+  ValInt = sc.Number;
+  ValFloat = sc.Float;
+  Val = sc.Token;
+  if (ValType == TK_Identifier && (Val.isEmpty() || (Val.len == 1 && Val.str[0] == ';'))) {
+    sc.HostError(va("Cannot parse value '%s' for key '%s'", *Val, *Key));
   }
 
   sc.Expect(";");
@@ -374,8 +972,8 @@ bool VUdmfParser::CheckBool () {
 //
 //==========================================================================
 VStr VUdmfParser::CheckString () {
-  if (ValType != TK_String) { sc.HostError(va("String value expected for key '%s'", *Key)); Val = VStr(); }
-  return Val;
+  if (ValType != TK_String) { sc.HostError(va("String value expected for key '%s'", *Key)); Val.clear(); }
+  return Val.toVStr();
 }
 
 
@@ -472,8 +1070,6 @@ bool VUdmfParser::CheckUserKey (TArray<VValue> &userFields) {
 //
 //==========================================================================
 void VUdmfParser::Parse (VLevel *Level, const VMapInfo &MInfo) {
-  sc.SetCMode(true);
-
   bExtended = false;
   bDoTranslation = true;
 
@@ -481,7 +1077,7 @@ void VUdmfParser::Parse (VLevel *Level, const VMapInfo &MInfo) {
   sc.Expect("namespace");
   sc.Expect("=");
   sc.ExpectString();
-  VStr Namespace = sc.String;
+  VStr Namespace = sc.Token.toVStr();
   sc.Expect(";");
 
   // Vavoom's namespace?
@@ -514,14 +1110,14 @@ void VUdmfParser::Parse (VLevel *Level, const VMapInfo &MInfo) {
     else {
       VStr slocstr = sc.GetVCLoc().toStringNoCol();
       if (!sc.GetString()) break;
-      VStr kn = sc.String;
+      VStr kn = sc.Token.toVStr();
       GCon->Logf(NAME_Error, "%s:UDMF ignoring wtfidontknow '%s'", *slocstr, *kn);
       if (sc.Check("=")) {
         sc.ExpectString();
         sc.Expect(";");
       } else {
         sc.Expect("{");
-        sc.SkipBracketed(true); // bracket eaten
+        sc.SkipBracketed(); // bracket eaten
       }
     }
   }
@@ -59,6 +59,7 @@ VThinkerChannel::VThinkerChannel (VNetConnection *AConnection, vint32 AIndex, vu
   , FieldCondValues(nullptr)
   , DrainTime(0)
   , bNeedToDrain(false)
+  , SyncedFrame(0)
   , GotOrigin(false)
   , LastUpdateFrame(0)
 {
@@ -220,6 +221,8 @@ void VThinkerChannel::SetThinker (VThinker *AThinker) {
   }
 
   Thinker = AThinker;
+  SyncedFields.reset();
+  SyncedFrame = 0;
 
   if (Thinker) {
     VClass *ThinkerClass = Thinker->GetClass();
@@ -272,7 +275,24 @@ void VThinkerChannel::Update () {
 
   //if (Thinker->ThinkerFlags&VThinker::TF_DetachSimulated) GCon->Logf(NAME_DevNet, "%s:%u: updating", Thinker->GetClass()->GetName(), Thinker->GetUniqueId());
 
+  const double updStartTime = Sys_Time();
+
   VEntity *Ent = Cast<VEntity>(Thinker);
+  VNetContext *Ctx = Connection->Context;
+
+  // get shared field changes; this should be done before changing any thinker fields
+  // player entities are excluded, because their angles are changed for each connection
+  VNetContext::ThinkerDelta *td = nullptr;
+  if (OpenedLocally && Ctx->IsServer() && !(Ent && Ent->IsPlayer())) td = Ctx->GetThinkerDelta(Thinker);
+  if (td) {
+    // after this, bit in `SyncedFields` is set if `OldData` value is identical to the current one
+    if (!NewObj && SyncedFrame && SyncedFrame == td->PrevFrame && SyncedFields.length() == td->Dirty.length()) {
+      for (int f = 0; f < SyncedFields.length(); ++f) SyncedFields[f] &= ~td->Dirty[f];
+    } else {
+      SyncedFields.setLength(td->Dirty.length());
+      for (auto &&v : SyncedFields) v = 0u;
+    }
+  }
 
   // set up thinker flags that can be used by field conditions
   // this is required both for the server and for the client
@@ -402,16 +422,29 @@ void VThinkerChannel::Update () {
     // set up pointer to the value and do swapping for the role fields
     bool forceSend = false;
     vuint8 *FieldValue = Data+F->Ofs;
-         if (F == Connection->Context->RoleField) { forceSend = (detachEntity || detachSimulated); FieldValue = Data+Connection->Context->RemoteRoleField->Ofs; }
-    else if (F == Connection->Context->RemoteRoleField) { forceSend = (detachEntity || detachSimulated); FieldValue = Data+Connection->Context->RoleField->Ofs; }
+         if (F == Ctx->RoleField) { forceSend = (detachEntity || detachSimulated); FieldValue = Data+Ctx->RemoteRoleField->Ofs; }
+    else if (F == Ctx->RemoteRoleField) { forceSend = (detachEntity || detachSimulated); FieldValue = Data+Ctx->RoleField->Ofs; }
     else if (NewObj && F == Connection->OriginField) forceSend = true;
 
+    // roles and some flags can be changed for each connection above, so always check them
+    const unsigned sfidx = ((unsigned)F->NetIndex)>>5;
+    const vuint32 sfbit = 1u<<(((unsigned)F->NetIndex)&31);
+    const bool canSync = (td && !Ctx->IsPerConnectionField(F));
+    if (canSync && !forceSend && (SyncedFields[sfidx]&sfbit)) {
+      ++Ctx->ThinkerStats.fieldsSkipped;
+      continue;
+    }
+    if (td) SyncedFields[sfidx] &= ~sfbit;
+    ++Ctx->ThinkerStats.fieldsCompared;
+
     if (!forceSend && VField::IdenticalValue(FieldValue, OldData+F->Ofs, F->Type, precise)) {
       //GCon->Logf(NAME_DevNet, "%s:%u: skipped field #%d (%s : %s)", Thinker->GetClass()->GetName(), Thinker->GetUniqueId(), F->NetIndex, F->GetName(), *F->Type.GetName());
+      if (canSync) SyncedFields[sfidx] |= sfbit;
       continue;
     }
 
     if (F->Type.Type == TYPE_Array) {
+      bool allSent = true;
       VFieldType IntType = F->Type;
       IntType.Type = F->Type.ArrayInnerType;
       int InnerSize = IntType.GetSize();
@@ -427,6 +460,7 @@ void VThinkerChannel::Update () {
         bool allowValueCopy = true;
         // if it's an object reference that cannot be serialised, send it as nullptr reference
         if (IntType.Type == TYPE_Reference && !Connection->ObjMap->CanSerialiseObject(*(VObject **)Val)) {
+          allSent = false;
           if (!*(VObject **)OldVal) continue; // already sent as nullptr
           Val = (vuint8 *)&NullObj;
           // resend
@@ -438,9 +472,12 @@ void VThinkerChannel::Update () {
         if (VField::NetSerialiseValue(strm, Connection->ObjMap, Val, IntType, precise)) {
           //GCon->Logf(NAME_DevNet, "%s:%u: sent array field #%d [%d] (%s : %s)", Thinker->GetClass()->GetName(), Thinker->GetUniqueId(), F->NetIndex, i, F->GetName(), *IntType.GetName());
           if (allowValueCopy) VField::CopyFieldValue(Val, OldVal, IntType);
+        } else {
+          allSent = false;
         }
         flushCount += PutStream(&Msg, strm);
       }
+      if (canSync && allSent) SyncedFields[sfidx] |= sfbit;
     } else {
       bool allowValueCopy = true;
       // if it's an object reference that cannot be serialised, send it as nullptr reference
@@ -455,11 +492,22 @@ void VThinkerChannel::Update () {
         allowValueCopy = false;
       }
 
+      // connection-independent values are serialised once per frame
+      const vuint8 *payload = nullptr;
+      int payloadBits = 0;
+      if (canSync && allowValueCopy && VNetContext::IsSharedPayloadType(F->Type)) {
+        payload = Ctx->GetSharedPayload(td, Thinker, F, precise, payloadBits);
+      }
+
       strm.WriteUInt((unsigned)F->NetIndex);
-      if (VField::NetSerialiseValue(strm, Connection->ObjMap, FieldValue, F->Type, precise)) {
+      if (payload) strm.SerialiseBits((void *)payload, payloadBits);
+      if (payload || VField::NetSerialiseValue(strm, Connection->ObjMap, FieldValue, F->Type, precise)) {
         //if (Thinker->RemoteRole == ROLE_SimulatedProxy) GCon->Logf(NAME_DevNet, "%s:%u: sent field #%d (%s : %s)", Thinker->GetClass()->GetName(), Thinker->GetUniqueId(), F->NetIndex, F->GetName(), *F->Type.GetName());
         //GCon->Logf(NAME_DevNet, "%s:%u: sent field #%d (%s : %s)", Thinker->GetClass()->GetName(), Thinker->GetUniqueId(), F->NetIndex, F->GetName(), *F->Type.GetName());
-        if (allowValueCopy) VField::CopyFieldValue(FieldValue, OldData+F->Ofs, F->Type);
+        if (allowValueCopy) {
+          VField::CopyFieldValue(FieldValue, OldData+F->Ofs, F->Type);
+          if (canSync) SyncedFields[sfidx] |= sfbit;
+        }
       }
 
       //HACK: send suids
@@ -494,6 +542,7 @@ void VThinkerChannel::Update () {
 
   // remember last update frame (this is used as "got updated" flag)
   LastUpdateFrame = Connection->UpdateFrameCounter;
+  SyncedFrame = (td ? td->Frame : 0);
 
   // clear temporary networking flags
   Thinker->ThinkerFlags &= ~(VThinker::TF_NetInitial|VThinker::TF_NetOwner);
@@ -514,6 +563,9 @@ void VThinkerChannel::Update () {
 
   NewObj = false;
 
+  ++Ctx->ThinkerStats.updates;
+  Ctx->ThinkerStats.time += Sys_Time()-updStartTime;
+
   // if this object becomes "dumb proxy", mark it as detached, and close the channel
   if (detachEntity) {
     if (net_dbg_dump_thinker_detach) GCon->Logf(NAME_DevNet, "%s:%u: became notick, closing channel%s", Thinker->GetClass()->GetName(), Thinker->GetUniqueId(), (OpenedLocally ? " (opened locally)" : ""));
@@ -54,6 +54,9 @@ static VCvarF net_timeout("net_timeout", "4", "Network timeout, in seconds.", CV
 // level will be updated twice as more times as this, until i wrote client-side interpolation code
 static VCvarF sv_fps("sv_fps", "35", "Server update frame rate (the server will use this to send updates to clients).", CVAR_NoShadow/*|CVAR_Archive*/);
 
+// the level PVS is conservative for plain geometry only
+static VCvarB net_use_pvs("net_use_pvs", false, "Skip subsectors that are not in the precomputed view PVS when replicating (experimental)?", CVAR_NoShadow);
+
 
 //==========================================================================
 //
@@ -976,6 +979,7 @@ void VNetConnection::SendMessage (VMessageOut *Msg) {
 //
 //==========================================================================
 void VNetConnection::Flush () {
+  VPROF_ZONE("net", "VNetConnection::Flush");
   Driver->UpdateNetTime();
 
   // if the connection is closed, discard the data
@@ -1121,6 +1125,7 @@ void VNetConnection::KeepaliveTick () {
 //
 //==========================================================================
 void VNetConnection::Tick () {
+  VPROF_ZONE("net", "VNetConnection::Tick");
   Driver->UpdateNetTime();
 
   if (IsClosed()) {
@@ -1312,8 +1317,13 @@ void VNetConnection::SetupFatPVS () {
   VLevel *Level = Context->GetLevel();
   if (!Level) return;
 
-  //LeafPvs = Level->LeafPVS(Owner->MO->SubSector);
+  // use precomputed PVS, if we have one (and if the view is not in the void)
+  // it doesn't know about portals, skyboxes and cameras, so it is off by default
   LeafPvs = nullptr;
+  if (net_use_pvs.asBool() && Level->HasPVS()) {
+    const subsector_t *viewsub = Level->PointInSubsector(Owner->ViewOrg);
+    if (Level->IsPointInSubsector2D(viewsub, Owner->ViewOrg)) LeafPvs = Level->LeafPVS(viewsub);
+  }
 
   // re-allocate PVS buffer if needed
   /*
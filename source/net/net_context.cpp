@@ -31,6 +31,10 @@
 
 extern VCvarB net_dbg_dump_thinker_detach; // from net_channel_thinker.cpp, sorry
 
+static VCvarB net_dbg_report_thinker_updates("net_dbg_report_thinker_updates", false, "Report thinker update times (server)?", CVAR_NoShadow);
+// with less clients, the shared snapshot costs more than it saves
+static VCvarI net_thinker_delta_min_clients("net_thinker_delta_min_clients", "4", "Share thinker field change detection if there are at least this number of clients (server).", CVAR_NoShadow);
+
 
 //==========================================================================
 //
@@ -40,14 +44,22 @@ extern VCvarB net_dbg_dump_thinker_detach; // from net_channel_thinker.cpp, sorr
 VNetContext::VNetContext ()
   : RoleField(nullptr)
   , RemoteRoleField(nullptr)
+  , NetInitialField(nullptr)
+  , NetDetachField(nullptr)
   , ServerConnection(nullptr)
+  , DeltaFrame(0)
+  , ThinkerStatsTime(0)
+  , PayloadStrm(MaxPayloadBits, false) // no expand
 {
+  memset((void *)&ThinkerStats, 0, sizeof(ThinkerStats));
   RoleField = VThinker::StaticClass()->FindFieldChecked("Role");
   RemoteRoleField = VThinker::StaticClass()->FindFieldChecked("RemoteRole");
   OwnerField = VEntity::StaticClass()->FindFieldChecked("Owner");
   TargetField = VEntity::StaticClass()->FindFieldChecked("Target");
   TracerField = VEntity::StaticClass()->FindFieldChecked("Tracer");
   MasterField = VEntity::StaticClass()->FindFieldChecked("Master");
+  NetInitialField = VThinker::StaticClass()->FindFieldChecked("bNetInitial");
+  NetDetachField = VEntity::StaticClass()->FindFieldChecked("bNetDetach");
 }
 
 
@@ -57,6 +69,147 @@ VNetContext::VNetContext ()
 //
 //==========================================================================
 VNetContext::~VNetContext () {
+  for (auto &&it : ThinkerDeltas.first()) FreeThinkerDelta(it.getValue());
+  ThinkerDeltas.clear();
+}
+
+
+//==========================================================================
+//
+//  VNetContext::FreeThinkerDelta
+//
+//==========================================================================
+void VNetContext::FreeThinkerDelta (ThinkerDelta *td) {
+  if (!td) return;
+  if (td->Data) {
+    for (VField *F = td->Class->NetFields; F; F = F->NextNetField) {
+      VField::DestructField(td->Data+F->Ofs, F->Type);
+    }
+    delete[] td->Data;
+  }
+  delete td;
+}
+
+
+//==========================================================================
+//
+//  VNetContext::ResetPayload
+//
+//==========================================================================
+void VNetContext::ResetPayload (ThinkerDelta *td) {
+  td->Payload.setLengthNoResize(0);
+  td->PayloadOfs.setLength(td->Class->NumNetFields);
+  td->PayloadBits.setLength(td->Class->NumNetFields);
+  for (auto &&v : td->PayloadOfs) v = -1;
+}
+
+
+//==========================================================================
+//
+//  VNetContext::GetThinkerDelta
+//
+//  compare thinker net fields with the snapshot from the previous frame.
+//  this is done once per frame, and then used by all client connections,
+//  so they don't have to compare unchanged fields with their `OldData`.
+//
+//==========================================================================
+VNetContext::ThinkerDelta *VNetContext::GetThinkerDelta (VThinker *Th) {
+  if (!Th || DeltaFrame == 0 || ClientConnections.length() < net_thinker_delta_min_clients.asInt()) return nullptr;
+  VClass *Class = Th->GetClass();
+
+  ThinkerDelta *td = ThinkerDeltas.findptr(Th);
+  if (td && (td->Class != Class || td->UniqueId != Th->GetUniqueId())) {
+    // the thinker was reused, or its memory was reused
+    ThinkerDeltas.del(Th);
+    FreeThinkerDelta(td);
+    td = nullptr;
+  }
+
+  if (!td) {
+    // first snapshot, everything is dirty
+    td = new ThinkerDelta;
+    td->Class = Class;
+    td->UniqueId = Th->GetUniqueId();
+    td->Frame = DeltaFrame;
+    td->PrevFrame = 0;
+    td->Data = new vuint8[Class->ClassSize];
+    memset(td->Data, 0, Class->ClassSize);
+    td->Dirty.setLength((Class->NumNetFields+31)/32);
+    for (auto &&v : td->Dirty) v = ~0u;
+    for (VField *F = Class->NetFields; F; F = F->NextNetField) {
+      VField::CopyFieldValue((const vuint8 *)Th+F->Ofs, td->Data+F->Ofs, F->Type);
+    }
+    ResetPayload(td);
+    ThinkerDeltas.put(Th, td);
+    return td;
+  }
+
+  if (td->Frame == DeltaFrame) return td; // already calculated
+
+  td->PrevFrame = td->Frame;
+  td->Frame = DeltaFrame;
+  ResetPayload(td);
+  for (auto &&v : td->Dirty) v = 0u;
+  for (VField *F = Class->NetFields; F; F = F->NextNetField) {
+    const vuint8 *val = (const vuint8 *)Th+F->Ofs;
+    vuint8 *snap = td->Data+F->Ofs;
+    if (VField::IdenticalValue(val, snap, F->Type, true)) continue;
+    td->Dirty[F->NetIndex>>5] |= 1u<<(F->NetIndex&31);
+    VField::CopyFieldValue(val, snap, F->Type);
+  }
+  return td;
+}
+
+
+//==========================================================================
+//
+//  VNetContext::GetSharedPayload
+//
+//  the thinker cannot change between connection updates in one frame,
+//  so the value serialised by the first connection can be sent to all
+//
+//==========================================================================
+const vuint8 *VNetContext::GetSharedPayload (ThinkerDelta *td, VThinker *Th, VField *F, bool precise, int &bits) {
+  const int idx = F->NetIndex;
+  if (td->PayloadOfs[idx] < 0) {
+    PayloadStrm.Clear();
+    VField::NetSerialiseValue(PayloadStrm, nullptr, (vuint8 *)Th+F->Ofs, F->Type, precise);
+    if (PayloadStrm.IsError()) return nullptr; // too long, will be tried again by the next connection
+    const int ofs = td->Payload.length();
+    const int size = PayloadStrm.GetNumBytes();
+    td->Payload.setLengthReserve(ofs+size);
+    if (size) memcpy(td->Payload.ptr()+ofs, PayloadStrm.GetData(), (size_t)size);
+    td->PayloadOfs[idx] = ofs;
+    td->PayloadBits[idx] = PayloadStrm.GetNumBits();
+  } else {
+    ++ThinkerStats.payloadsShared;
+  }
+  bits = td->PayloadBits[idx];
+  return td->Payload.ptr()+td->PayloadOfs[idx];
+}
+
+
+//==========================================================================
+//
+//  VNetContext::ReportThinkerStats
+//
+//==========================================================================
+void VNetContext::ReportThinkerStats () {
+  const double ctt = Sys_Time();
+  if (ThinkerStatsTime <= 0) ThinkerStatsTime = ctt;
+  if (ctt-ThinkerStatsTime < 1.0) return;
+  if (net_dbg_report_thinker_updates && ThinkerStats.frames > 0) {
+    const int ccount = max2(1, ClientConnections.length());
+    const double fmsec = ThinkerStats.time*1000.0/(double)ThinkerStats.frames;
+    const int total = ThinkerStats.fieldsCompared+ThinkerStats.fieldsSkipped;
+    GCon->Logf(NAME_DevNet, "thinker updates: %d client%s; %.3f msecs per frame; %.3f msecs per client; %d updates per frame; %d%% of %d fields skipped; %d values shared",
+      ClientConnections.length(), (ClientConnections.length() != 1 ? "s" : ""),
+      fmsec, fmsec/(double)ccount, ThinkerStats.updates/ThinkerStats.frames,
+      (total ? (int)((double)ThinkerStats.fieldsSkipped*100.0/(double)total) : 0), total,
+      ThinkerStats.payloadsShared);
+  }
+  memset((void *)&ThinkerStats, 0, sizeof(ThinkerStats));
+  ThinkerStatsTime = ctt;
 }
 
 
@@ -78,7 +231,13 @@ void VNetContext::ThinkerDestroyed (VThinker *Th) {
     ServerConnection->DetachedThinkers.del(Th);
     ServerConnection->SimulatedThinkers.del(Th);
   } else {
-    // server; remove thinker from all clients
+    // server; forget shared delta
+    ThinkerDelta *td = ThinkerDeltas.findptr(Th);
+    if (td) {
+      ThinkerDeltas.del(Th);
+      FreeThinkerDelta(td);
+    }
+    // remove thinker from all clients
     for (auto &&it : ClientConnections) {
       VThinkerChannel *chan = it->ThinkerChannels.findptr(Th);
       if (chan) {
@@ -104,6 +263,11 @@ void VNetContext::ThinkerDestroyed (VThinker *Th) {
 //
 //==========================================================================
 void VNetContext::Tick () {
+  VPROF_ZONE("net", "VNetContext::Tick");
+  // new frame for thinker deltas
+  if (++DeltaFrame == 0) DeltaFrame = 1;
+  ++ThinkerStats.frames;
+
   // backwards, in case some connection will remove itself
   for (int i = ClientConnections.length()-1; i >= 0; --i) {
     VNetConnection *Conn = ClientConnections[i];
@@ -148,6 +312,8 @@ void VNetContext::Tick () {
       SV_DropClient(Conn->Owner, true);
     }
   }
+
+  ReportThinkerStats();
 }
 
 
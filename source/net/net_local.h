@@ -179,6 +179,10 @@ public:
   virtual int SetSocketPort (sockaddr_t *addr, int port) = 0;
 
   virtual bool FindExternalAddress (sockaddr_t *addr) = 0;
+
+  // see `VNetworkPublic::BeginWriteBatch()`
+  virtual void BeginWriteBatch () = 0;
+  virtual void EndWriteBatch () = 0;
 };
 
 
@@ -72,6 +72,8 @@ public:
   virtual slist_t *GetSlist () override;
   virtual void UpdateMaster () override;
   virtual void QuitMaster () override;
+  virtual void BeginWriteBatch () override;
+  virtual void EndWriteBatch () override;
 
   // API only for network drivers!
   virtual void SchedulePollProcedure (VNetPollProcedure *, double) override;
@@ -738,6 +740,32 @@ void VNetwork::QuitMaster () {
 }
 
 
+//==========================================================================
+//
+//  VNetwork::BeginWriteBatch
+//
+//==========================================================================
+void VNetwork::BeginWriteBatch () {
+  for (int i = 0; i < NumLanDrivers; ++i) {
+    if (!LanDrivers[i]->initialised) continue;
+    LanDrivers[i]->BeginWriteBatch();
+  }
+}
+
+
+//==========================================================================
+//
+//  VNetwork::EndWriteBatch
+//
+//==========================================================================
+void VNetwork::EndWriteBatch () {
+  for (int i = 0; i < NumLanDrivers; ++i) {
+    if (!LanDrivers[i]->initialised) continue;
+    LanDrivers[i]->EndWriteBatch();
+  }
+}
+
+
 //==========================================================================
 //
 //  VSocketPublic::u64str
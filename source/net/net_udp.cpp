@@ -45,6 +45,11 @@
 # define closesocket close
 #endif
 
+// batched i/o with `recvmmsg()`/`sendmmsg()`
+#if defined(__linux__) && !defined(ANDROID)
+# define VV_UDP_MMSG
+#endif
+
 
 static int cli_NoUDP = 0;
 static const char *cli_IP = nullptr;
@@ -57,6 +62,40 @@ static const char *cli_IP = nullptr;
 
 static VCvarB net_dbg_dump_udp_inbuffer("net_dbg_dump_udp_inbuffer", false, "Dump UDP input buffer size?", CVAR_NoShadow);
 static VCvarB net_dbg_dump_udp_outbuffer("net_dbg_dump_udp_outbuffer", false, "Dump UDP output buffer size?", CVAR_NoShadow);
+#ifdef VV_UDP_MMSG
+static VCvarB net_udp_batch_io("net_udp_batch_io", true, "Read and write UDP datagrams in batches (recvmmsg/sendmmsg)?", CVAR_NoShadow);
+#endif
+
+
+#ifdef VV_UDP_MMSG
+enum {
+  UDP_BATCH_SIZE = 32, // datagrams per syscall
+  UDP_BATCH_BUFSIZE = 2048, // should be more than `MAX_DGRAM_SIZE`
+};
+
+// datagrams received by one `recvmmsg()` call, per socket
+struct VUdpRecvBatch {
+  int count; // number of received datagrams
+  int pos; // next datagram to return
+  mmsghdr hdrs[UDP_BATCH_SIZE];
+  iovec iovs[UDP_BATCH_SIZE];
+  sockaddr_t addrs[UDP_BATCH_SIZE];
+  vuint8 data[UDP_BATCH_SIZE][UDP_BATCH_BUFSIZE];
+};
+
+// datagrams queued for `sendmmsg()`
+// if a socket buffer was full, the unsent datagrams are kept at the queue
+// start for the next flush; the sockets of those datagrams are "blocked"
+struct VUdpSendQueue {
+  int count;
+  int pending; // number of datagrams left by the last flush
+  int sockets[UDP_BATCH_SIZE];
+  mmsghdr hdrs[UDP_BATCH_SIZE];
+  iovec iovs[UDP_BATCH_SIZE];
+  sockaddr_t addrs[UDP_BATCH_SIZE];
+  vuint8 data[UDP_BATCH_SIZE][UDP_BATCH_BUFSIZE];
+};
+#endif
 
 
 // ////////////////////////////////////////////////////////////////////////// //
@@ -100,6 +139,8 @@ public:
   virtual int GetSocketPort (const sockaddr_t *) override;
   virtual int SetSocketPort (sockaddr_t *, int) override;
   virtual bool FindExternalAddress (sockaddr_t *addr) override;
+  virtual void BeginWriteBatch () override;
+  virtual void EndWriteBatch () override;
 
 #ifdef WIN32
   static INT_PTR PASCAL FAR BlockingHook ();
@@ -110,6 +151,27 @@ public:
 
 private:
   static bool SetNonBlocking (int fd) noexcept;
+
+#ifdef VV_UDP_MMSG
+private:
+  TMapNC<int, VUdpRecvBatch *> recvBatches; // key is socket
+  VUdpSendQueue *sendQueue;
+  bool writeBatchActive;
+  bool mmsgFailed; // set if the kernel doesn't support batched i/o
+  int sendDropped; // number of queued datagrams that were never sent
+
+  // returns datagram length, or -2 if batch is empty
+  int ReadFromBatch (VUdpRecvBatch *batch, vuint8 *buf, int len, sockaddr_t *addr) noexcept;
+  // returns `Read()` result
+  int ReadBatched (int socket, vuint8 *buf, int len, sockaddr_t *addr);
+  // sends queued datagrams; datagrams for sockets with full buffers are kept
+  void FlushSendQueue ();
+  // is there any datagram for this socket left by the last flush?
+  bool IsSendBlocked (int socket) const noexcept;
+  // removes queued datagrams for this socket (counted as dropped)
+  void DropQueued (int socket);
+  void FreeBatches ();
+#endif
 };
 
 
@@ -135,6 +197,13 @@ VUdpDriver::VUdpDriver ()
   , winsock_initialised(0)
   , mGetLocAddrCalled(false)
 #endif
+#ifdef VV_UDP_MMSG
+  , recvBatches()
+  , sendQueue(nullptr)
+  , writeBatchActive(false)
+  , mmsgFailed(false)
+  , sendDropped(0)
+#endif
 {
 }
 
@@ -300,6 +369,9 @@ int VUdpDriver::Init () {
 void VUdpDriver::Shutdown () {
   Listen(false);
   CloseSocket(net_controlsocket);
+  #ifdef VV_UDP_MMSG
+  FreeBatches();
+  #endif
   #ifdef WIN32
   if (--winsock_initialised == 0) WSACleanup();
   #endif
@@ -496,6 +568,16 @@ int VUdpDriver::ConnectSocketTo (sockaddr_t * /*addr*/) {
 bool VUdpDriver::CloseSocket (int socket) {
   if (socket < 0) return true;
   if (socket == net_broadcastsocket) net_broadcastsocket = -1;
+  #ifdef VV_UDP_MMSG
+  // send queued datagrams, and drop unread ones
+  if (sendQueue && sendQueue->count) FlushSendQueue();
+  DropQueued(socket);
+  VUdpRecvBatch **bp = recvBatches.get(socket);
+  if (bp) {
+    delete *bp;
+    recvBatches.del(socket);
+  }
+  #endif
   return (closesocket(socket) == 0);
 }
 
@@ -508,6 +590,11 @@ bool VUdpDriver::CloseSocket (int socket) {
 int VUdpDriver::CheckNewConnections (bool /*rconOnly*/) {
   char buf[4096];
   if (net_acceptsocket == -1) return -1;
+  #ifdef VV_UDP_MMSG
+  // there may be datagrams already received by `recvmmsg()`
+  VUdpRecvBatch **bp = recvBatches.get(net_acceptsocket);
+  if (bp && (*bp)->pos < (*bp)->count) return net_acceptsocket;
+  #endif
   if (recvfrom(net_acceptsocket, buf, sizeof(buf), MSG_PEEK, nullptr, nullptr) >= 0) {
     return net_acceptsocket;
   }
@@ -532,6 +619,12 @@ int VUdpDriver::Read (int socket, vuint8 *buf, int len, sockaddr_t *addr) {
     if (ioctl(socket, FIONREAD, &value) == 0) GCon->Logf(NAME_DevNet, "VUdpDriver::Read: FIONREAD=%d", value);
   }
   #endif
+  #ifdef VV_UDP_MMSG
+  {
+    const int res = ReadBatched(socket, buf, len, addr);
+    if (res != -3) return res;
+  }
+  #endif
   socklen_t addrlen = sizeof(sockaddr_t);
   memset((void *)addr, 0, addrlen);
   int ret = recvfrom(socket, (char *)buf, len, 0, (sockaddr *)addr, &addrlen);
@@ -563,6 +656,28 @@ int VUdpDriver::Write (int socket, const vuint8 *buf, int len, sockaddr_t *addr)
     if (ioctl(socket, TIOCOUTQ, &value) == 0) GCon->Logf(NAME_DevNet, "VUdpDriver::Write:000: TIOCOUTQ=%d", value);
   }
   #endif
+  #ifdef VV_UDP_MMSG
+  if (writeBatchActive && !mmsgFailed && net_udp_batch_io.asBool() && len > 0 && len <= UDP_BATCH_BUFSIZE) {
+    if (!sendQueue) { sendQueue = new VUdpSendQueue; sendQueue->count = sendQueue->pending = 0; }
+    if (sendQueue->count == UDP_BATCH_SIZE) FlushSendQueue();
+    // the socket buffer was full on the last flush; report it like `sendto()` does
+    if (IsSendBlocked(socket)) return -2;
+    // if the queue is still full, it is full of datagrams for other sockets, so we can send this one directly
+    if (sendQueue->count < UDP_BATCH_SIZE) {
+      const int idx = sendQueue->count++;
+      sendQueue->sockets[idx] = socket;
+      memcpy((void *)&sendQueue->addrs[idx], (const void *)addr, sizeof(sockaddr_t));
+      memcpy(sendQueue->data[idx], buf, len);
+      sendQueue->iovs[idx].iov_len = (size_t)len;
+      return len;
+    }
+  }
+  // keep datagram order
+  if (sendQueue && sendQueue->count) {
+    FlushSendQueue();
+    if (IsSendBlocked(socket)) return -2;
+  }
+  #endif
   int ret = sendto(socket, (const char *)buf, len, 0, (sockaddr *)addr, sizeof(sockaddr));
   #if !defined(WIN32) && !defined(__SWITCH__) && !defined(__CYGWIN__)
   if (net_dbg_dump_udp_outbuffer) {
@@ -581,6 +696,236 @@ int VUdpDriver::Write (int socket, const vuint8 *buf, int len, sockaddr_t *addr)
 }
 
 
+#ifdef VV_UDP_MMSG
+//==========================================================================
+//
+//  VUdpDriver::ReadFromBatch
+//
+//==========================================================================
+int VUdpDriver::ReadFromBatch (VUdpRecvBatch *batch, vuint8 *buf, int len, sockaddr_t *addr) noexcept {
+  if (batch->pos >= batch->count) return -2;
+  const int idx = batch->pos++;
+  // `recvfrom()` silently truncates too
+  const int dlen = min2(len, (int)batch->hdrs[idx].msg_len);
+  if (dlen > 0) memcpy(buf, batch->data[idx], dlen);
+  memcpy((void *)addr, (const void *)&batch->addrs[idx], sizeof(sockaddr_t));
+  return dlen;
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::ReadBatched
+//
+//  returns `Read()` result, or -3 if batched i/o is not available
+//
+//==========================================================================
+int VUdpDriver::ReadBatched (int socket, vuint8 *buf, int len, sockaddr_t *addr) {
+  VUdpRecvBatch **bp = recvBatches.get(socket);
+  VUdpRecvBatch *batch = (bp ? *bp : nullptr);
+  // return previously received datagrams first, even if batching was turned off
+  if (batch && batch->pos < batch->count) return ReadFromBatch(batch, buf, len, addr);
+  if (mmsgFailed || !net_udp_batch_io.asBool()) return -3;
+
+  if (!batch) {
+    batch = new VUdpRecvBatch;
+    batch->count = batch->pos = 0;
+    recvBatches.put(socket, batch);
+  }
+
+  for (int f = 0; f < UDP_BATCH_SIZE; ++f) {
+    batch->iovs[f].iov_base = batch->data[f];
+    batch->iovs[f].iov_len = UDP_BATCH_BUFSIZE;
+    memset((void *)&batch->hdrs[f], 0, sizeof(batch->hdrs[f]));
+    batch->hdrs[f].msg_hdr.msg_name = &batch->addrs[f];
+    batch->hdrs[f].msg_hdr.msg_namelen = sizeof(sockaddr_t);
+    batch->hdrs[f].msg_hdr.msg_iov = &batch->iovs[f];
+    batch->hdrs[f].msg_hdr.msg_iovlen = 1;
+    memset((void *)&batch->addrs[f], 0, sizeof(sockaddr_t));
+  }
+
+  batch->count = batch->pos = 0;
+  const int res = recvmmsg(socket, batch->hdrs, UDP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+  if (res > 0) {
+    batch->count = res;
+    return ReadFromBatch(batch, buf, len, addr);
+  }
+  if (res == 0 || errno == EWOULDBLOCK || errno == EAGAIN) return -2;
+  if (errno == ENOSYS) {
+    GCon->Log(NAME_DevNet, "UDP: recvmmsg() is not supported, batched i/o disabled");
+    mmsgFailed = true;
+    return -3;
+  }
+  return -1;
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::IsSendBlocked
+//
+//==========================================================================
+bool VUdpDriver::IsSendBlocked (int socket) const noexcept {
+  const VUdpSendQueue *q = sendQueue;
+  if (!q) return false;
+  for (int f = 0; f < q->pending; ++f) if (q->sockets[f] == socket) return true;
+  return false;
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::DropQueued
+//
+//==========================================================================
+void VUdpDriver::DropQueued (int socket) {
+  VUdpSendQueue *q = sendQueue;
+  if (!q || !q->count) return;
+  int dest = 0, dropped = 0, pending = 0;
+  for (int f = 0; f < q->count; ++f) {
+    if (q->sockets[f] == socket) { ++dropped; continue; }
+    if (f < q->pending) ++pending;
+    if (dest != f) {
+      q->sockets[dest] = q->sockets[f];
+      memcpy((void *)&q->addrs[dest], (const void *)&q->addrs[f], sizeof(sockaddr_t));
+      memcpy(q->data[dest], q->data[f], q->iovs[f].iov_len);
+      q->iovs[dest].iov_len = q->iovs[f].iov_len;
+    }
+    ++dest;
+  }
+  q->count = dest;
+  q->pending = pending;
+  if (dropped) {
+    sendDropped += dropped;
+    GCon->Logf(NAME_DevNet, "UDP: dropped %d unsent datagram%s for closed socket (%d total)", dropped, (dropped != 1 ? "s" : ""), sendDropped);
+  }
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::FlushSendQueue
+//
+//  datagrams for the same socket usually come in runs (one connection
+//  flushes all its packets at once), and `sendmmsg()` can send a run
+//  with one syscall.
+//
+//  if the socket buffer is full, the rest of the run (and all later
+//  datagrams for that socket, to keep the order) stays in the queue, and
+//  will be sent on the next flush. meanwhile `Write()` returns -2 for that
+//  socket, so the connection knows that it is saturated.
+//
+//==========================================================================
+void VUdpDriver::FlushSendQueue () {
+  VUdpSendQueue *q = sendQueue;
+  if (!q || !q->count) return;
+  const int count = q->count;
+
+  for (int f = 0; f < count; ++f) {
+    q->iovs[f].iov_base = q->data[f];
+    memset((void *)&q->hdrs[f], 0, sizeof(q->hdrs[f]));
+    q->hdrs[f].msg_hdr.msg_name = &q->addrs[f];
+    q->hdrs[f].msg_hdr.msg_namelen = sizeof(sockaddr);
+    q->hdrs[f].msg_hdr.msg_iov = &q->iovs[f];
+    q->hdrs[f].msg_hdr.msg_iovlen = 1;
+  }
+
+  int kept = 0; // unsent datagrams are moved to the queue start
+  int dropped = 0;
+  int lastErr = 0;
+  int start = 0;
+  while (start < count) {
+    const int socket = q->sockets[start];
+    int end = start+1;
+    while (end < count && q->sockets[end] == socket) ++end;
+    // this socket was full earlier in this flush?
+    bool keep = false;
+    for (int f = 0; f < kept; ++f) if (q->sockets[f] == socket) { keep = true; break; }
+    // partial send is possible, so loop until the whole run is sent
+    while (!keep && start < end) {
+      const int res = sendmmsg(socket, &q->hdrs[start], (unsigned)(end-start), MSG_DONTWAIT);
+      if (res > 0) { start += res; continue; }
+      if (res < 0 && errno == ENOSYS) {
+        GCon->Log(NAME_DevNet, "UDP: sendmmsg() is not supported, batched i/o disabled");
+        mmsgFailed = true;
+        for (; start < end; ++start) sendto(socket, (const char *)q->data[start], q->iovs[start].iov_len, 0, (sockaddr *)&q->addrs[start], sizeof(sockaddr));
+        break;
+      }
+      if (res < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) { keep = true; break; }
+      // some other error; drop the datagram, it is UDP anyway
+      lastErr = errno;
+      ++dropped;
+      ++start;
+    }
+    // keep the unsent part of the run
+    for (; keep && start < end; ++start) {
+      if (kept != start) {
+        q->sockets[kept] = q->sockets[start];
+        memcpy((void *)&q->addrs[kept], (const void *)&q->addrs[start], sizeof(sockaddr_t));
+        memcpy(q->data[kept], q->data[start], q->iovs[start].iov_len);
+        q->iovs[kept].iov_len = q->iovs[start].iov_len;
+      }
+      ++kept;
+    }
+    start = end;
+  }
+  q->count = q->pending = kept;
+
+  if (dropped) {
+    sendDropped += dropped;
+    GCon->Logf(NAME_DevNet, "UDP: dropped %d queued datagram%s (errno=%d; %d total)", dropped, (dropped != 1 ? "s" : ""), lastErr, sendDropped);
+  }
+  if (kept && net_dbg_dump_udp_outbuffer) GCon->Logf(NAME_DevNet, "VUdpDriver::FlushSendQueue: %d datagram%s left for the next flush", kept, (kept != 1 ? "s" : ""));
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::FreeBatches
+//
+//==========================================================================
+void VUdpDriver::FreeBatches () {
+  FlushSendQueue();
+  if (sendQueue && sendQueue->count) {
+    sendDropped += sendQueue->count;
+    GCon->Logf(NAME_DevNet, "UDP: dropped %d unsent datagram%s on shutdown (%d total)", sendQueue->count, (sendQueue->count != 1 ? "s" : ""), sendDropped);
+  }
+  delete sendQueue;
+  sendQueue = nullptr;
+  writeBatchActive = false;
+  for (auto &&it : recvBatches.first()) delete it.getValue();
+  recvBatches.clear();
+}
+#endif
+
+
+//==========================================================================
+//
+//  VUdpDriver::BeginWriteBatch
+//
+//==========================================================================
+void VUdpDriver::BeginWriteBatch () {
+  #ifdef VV_UDP_MMSG
+  // this should not happen, but let's be safe
+  if (sendQueue && sendQueue->count) FlushSendQueue();
+  writeBatchActive = true;
+  #endif
+}
+
+
+//==========================================================================
+//
+//  VUdpDriver::EndWriteBatch
+//
+//==========================================================================
+void VUdpDriver::EndWriteBatch () {
+  #ifdef VV_UDP_MMSG
+  writeBatchActive = false;
+  FlushSendQueue();
+  #endif
+}
+
+
 //==========================================================================
 //
 //  VUdpDriver::CanBroadcast
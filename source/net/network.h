@@ -253,6 +253,11 @@ public:
   virtual void UpdateMaster () = 0;
   virtual void QuitMaster () = 0;
 
+  // datagrams written between these calls can be queued, and sent in batches at `EndWriteBatch()`
+  // batches cannot be nested; unbatched write will flush pending queue first
+  virtual void BeginWriteBatch () = 0;
+  virtual void EndWriteBatch () = 0;
+
   // call this to update current network time
   // used to avoid calls to `Sys_Time()` everywhere
   // should be called in connection ticker, in context ticker, and in `GetMessages()`
@@ -516,6 +521,11 @@ protected:
   double DrainTime;
   bool bNeedToDrain;
 
+  // server: bit is set if `OldData` value of the net field was identical to the thinker value
+  // after the update on `SyncedFrame` (see `VNetContext::ThinkerDelta`)
+  TArray<vuint32> SyncedFields;
+  vuint32 SyncedFrame; // 0 means "not synced"
+
 public:
   // set by the client when it gets `Origin` update
   bool GotOrigin;
@@ -749,13 +759,13 @@ public:
   TMapNC<vint32, bool> UpdatedSectors;
 
 private:
-  // `LeafPvs` was meant to point to glVIS info, but it is currently disabled
+  // precomputed PVS row for the view subsector (can be `nullptr`)
   const vuint8 *LeafPvs;
   VViewClipper Clipper;
   // this is used in `VNetConnection::UpdateLevel()`
   // temporary buffers, only valid in that method.
-  TArrayNC<VThinker *> PendingThinkers;
-  TArrayNC<VEntity *> PendingGoreEnts;
+  TFrameArray<VThinker *> PendingThinkers;
+  TFrameArray<VEntity *> PendingGoreEnts;
   TArrayNC<vint32> AliveGoreChans;
   TArrayNC<VThinker *> AliveThinkerChans;
 
@@ -901,6 +911,32 @@ protected:
 // ////////////////////////////////////////////////////////////////////////// //
 // class that provides access to client or server specific data
 class VNetContext {
+public:
+  // server: net field changes of one thinker, calculated once per frame, and shared by all connections
+  struct ThinkerDelta {
+    VClass *Class;
+    vuint32 UniqueId;
+    vuint32 Frame; // frame of `Data` snapshot
+    vuint32 PrevFrame; // frame of the previous snapshot (0 if there was none)
+    vuint8 *Data; // net field values on `Frame`
+    TArray<vuint32> Dirty; // bit is set if net field was changed between `PrevFrame` and `Frame`
+    // serialised values of connection-independent fields; built by the first connection
+    // that sends the field on `Frame`, and copied by all others
+    TArray<vuint8> Payload; // each value starts on a byte boundary
+    TArray<vint32> PayloadOfs; // for each net field: offset in `Payload`, or -1
+    TArray<vint32> PayloadBits; // for each net field: value size in bits
+  };
+
+  // thinker update stats, for benchmarking
+  struct ThinkerUpdateStats {
+    double time; // time spent in `VThinkerChannel::Update()`
+    int updates; // number of thinker channel updates
+    int fieldsCompared;
+    int fieldsSkipped; // skipped with the help of `ThinkerDelta`
+    int payloadsShared; // field values copied from `ThinkerDelta::Payload`
+    int frames;
+  };
+
 public:
   VField *RoleField;
   VField *RemoteRoleField;
@@ -908,9 +944,25 @@ public:
   VField *TargetField;
   VField *TracerField;
   VField *MasterField;
+  VField *NetInitialField; // `ThinkerFlags` bit
+  VField *NetDetachField; // `FlagsEx` bit
   VNetConnection *ServerConnection; // non-nullptr for clients (only)
   TArray<VNetConnection *> ClientConnections; // known clients for servers
 
+  vuint32 DeltaFrame; // server frame counter, used for `ThinkerDelta`
+  ThinkerUpdateStats ThinkerStats;
+  double ThinkerStatsTime; // last time the stats were reported
+
+protected:
+  enum { MaxPayloadBits = 512 }; // longer values (long strings) are serialised for each connection
+
+  TMapNC<VThinker *, ThinkerDelta *> ThinkerDeltas;
+  VBitStreamWriter PayloadStrm;
+
+  void FreeThinkerDelta (ThinkerDelta *td);
+  static void ResetPayload (ThinkerDelta *td);
+  void ReportThinkerStats ();
+
 public:
   VNetContext ();
   virtual ~VNetContext ();
@@ -918,6 +970,29 @@ public:
   inline bool IsClient () const noexcept { return (ServerConnection != nullptr); }
   inline bool IsServer () const noexcept { return (ServerConnection == nullptr); }
 
+  // server; returns delta for the current frame (calculates it if necessary)
+  ThinkerDelta *GetThinkerDelta (VThinker *Th);
+
+  // server; `VThinkerChannel::Update()` can change these fields for each connection:
+  // roles, and flag bools stored with `bNetInitial` or `bNetDetach`
+  inline bool IsPerConnectionField (const VField *F) const noexcept {
+    return (F == RoleField || F == RemoteRoleField ||
+            (F->Type.Type == TYPE_Bool && (F->Ofs == NetInitialField->Ofs || F->Ofs == NetDetachField->Ofs)));
+  }
+
+  // values of these types are serialised without the connection objects map
+  static inline bool IsSharedPayloadType (const VFieldType &Type) noexcept {
+    switch (Type.Type) {
+      case TYPE_Int: case TYPE_Byte: case TYPE_Bool: case TYPE_Float: case TYPE_Vector: case TYPE_String: return true;
+      default: break;
+    }
+    return false;
+  }
+
+  // server; returns serialised field value for the frame of `td`, or `nullptr` if it cannot be shared
+  // `F` should not be a per-connection field, and its type should pass `IsSharedPayloadType()`
+  const vuint8 *GetSharedPayload (ThinkerDelta *td, VThinker *Th, VField *F, bool precise, int &bits);
+
   // VNetContext interface
   virtual VLevel *GetLevel() = 0;
   void ThinkerDestroyed (VThinker *);
@@ -1030,4 +1105,14 @@ extern VNetworkPublic *GNet;
 extern VNetContext *GDemoRecordingContext;
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// queues outgoing datagrams until the end of the scope (see `VNetworkPublic::BeginWriteBatch()`)
+struct VNetWriteBatchScope {
+  VNetWriteBatchScope () { if (GNet) GNet->BeginWriteBatch(); }
+  ~VNetWriteBatchScope () { if (GNet) GNet->EndWriteBatch(); }
+  VNetWriteBatchScope (const VNetWriteBatchScope &) = delete;
+  VNetWriteBatchScope &operator = (const VNetWriteBatchScope &) = delete;
+};
+
+
 #endif
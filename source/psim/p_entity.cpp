@@ -49,6 +49,10 @@
 
 IMPLEMENT_CLASS(V, Entity);
 
+bool VEntityPhysTimer::Enabled = false;
+__thread int VEntityPhysTimer::Depth = 0;
+vuint64 VEntityPhysTimer::TotalNano = 0;
+
 
 // ////////////////////////////////////////////////////////////////////////// //
 //static VCvarB _decorate_dont_warn_about_invalid_labels("decorate_dont_warn_about_invalid_labels", false, "Don't do this!", CVAR_Archive|CVAR_PreInit|CVAR_Hidden|CVAR_NoShadow);
@@ -1166,85 +1170,123 @@ COMMAND_AC(dbg_slide_awake_all) {
 
 //==========================================================================
 //
-//  VEntity::Tick
+//  NoTickLifetimeStep
+//
+//  lifetime logic for `EFEX_NoTickGravLT` entities
+//  `lastMoveTime` is time before the next step
+//  `planeAlpha` is fadeout after the time expires:
+//    <=0: die immediately
+//     >0: fadeout step time
+//  it fades out by 0.016 per step; `faded` is set if it did any step
+//  returns `false` if the entity should die
 //
 //==========================================================================
-void VEntity::Tick (float deltaTime) {
-  ++dbgEntityTickTotal;
-  // advance it here, why not
-  // may be moved down later if some VC code will start using it
-  DataGameTime = XLevel->Time+deltaTime;
-  // skip ticker?
+static VVA_FORCEINLINE bool NoTickLifetimeStep (float deltaTime, float &lastMoveTime, const float planeAlpha, float &alpha, bool &faded) noexcept {
+  lastMoveTime -= deltaTime;
+  while (lastMoveTime <= 0) {
+    // die now
+    if (planeAlpha <= 0) return false;
+    lastMoveTime += planeAlpha;
+    alpha -= 0.016;
+    // did it faded out completely?
+    if (alpha <= 0.002f) return false;
+    faded = true;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VEntity::TickNoTickGrav
+//
+//  tick for `EFEX_NoTickGrav` entities; this is native code only
+//  it changes only this entity, and reads level geometry, so it is
+//  safe to call it from worker threads (see `VLevel::TickWorld()`)
+//  returns `false` if the entity should be destroyed
+//
+//==========================================================================
+bool VEntity::TickNoTickGrav (float deltaTime) {
   const unsigned eflagsex = FlagsEx;
-  if (eflagsex&EFEX_NoTickGrav) {
-    ++dbgEntityTickNoTick;
-    PrevTickOrigin = Origin; // it is not used in notick code
-    #ifdef CLIENT
-    //GCon->Logf(NAME_Debug, "*** %s ***", GetClass()->GetName());
-    #endif
-    // stick to floor or ceiling?
-    if (SubSector) {
-      if (eflagsex&(EFEX_StickToFloor|EFEX_StickToCeiling)) {
-        tmtrace_t tmtrace;
-        CheckRelPositionPoint(tmtrace, Origin);
-        if (eflagsex&EFEX_StickToFloor) {
-          Origin.z = tmtrace.FloorZ;
-        } else {
-          #ifdef CLIENT
-          //const float oldz = Origin.z;
-          #endif
-          //Origin.z = SV_GetHighestSolidPointZ(SubSector->sector, Origin, false)-Height; // don't ignore 3d floors
-          Origin.z = tmtrace.CeilingZ;
-          #ifdef CLIENT
-          //GCon->Logf(NAME_Debug, "*** %s ***: stick to ceiling; oldz=%g; newz=%g", GetClass()->GetName(), oldz, Origin.z);
-          #endif
-        }
-      } else if (!(EntityFlags&EF_NoGravity)) {
-        // it is always at floor level
-        tmtrace_t tmtrace;
-        CheckRelPositionPoint(tmtrace, Origin);
+  PrevTickOrigin = Origin; // it is not used in notick code
+  #ifdef CLIENT
+  //GCon->Logf(NAME_Debug, "*** %s ***", GetClass()->GetName());
+  #endif
+  // stick to floor or ceiling?
+  if (SubSector) {
+    if (eflagsex&(EFEX_StickToFloor|EFEX_StickToCeiling)) {
+      tmtrace_t tmtrace;
+      CheckRelPositionPoint(tmtrace, Origin);
+      if (eflagsex&EFEX_StickToFloor) {
+        Origin.z = tmtrace.FloorZ;
+      } else {
         #ifdef CLIENT
         //const float oldz = Origin.z;
         #endif
-        Origin.z = tmtrace.FloorZ;
+        //Origin.z = SV_GetHighestSolidPointZ(SubSector->sector, Origin, false)-Height; // don't ignore 3d floors
+        Origin.z = tmtrace.CeilingZ;
         #ifdef CLIENT
-        //GCon->Logf(NAME_Debug, "*** %s ***: down to earth; oldz=%g; newz=%g", GetClass()->GetName(), oldz, Origin.z);
+        //GCon->Logf(NAME_Debug, "*** %s ***: stick to ceiling; oldz=%g; newz=%g", GetClass()->GetName(), oldz, Origin.z);
         #endif
       }
-    }
-    // in MP games, there is no `GLevelInfo`
-    if (GLevelInfo && GLevelInfo->LevelInfoFlags2&VLevelInfo::LIF2_Frozen) return;
-    if (eflagsex&EFEX_NoTickGravLT) {
+    } else if (!(EntityFlags&EF_NoGravity)) {
+      // it is always at floor level
+      tmtrace_t tmtrace;
+      CheckRelPositionPoint(tmtrace, Origin);
       #ifdef CLIENT
-      //GCon->Logf(NAME_Debug, "  : %s lifetime (lmt=%g; %g : %f)", GetClass()->GetName(), LastMoveTime-deltaTime, LastMoveTime, deltaTime);
+      //const float oldz = Origin.z;
+      #endif
+      Origin.z = tmtrace.FloorZ;
+      #ifdef CLIENT
+      //GCon->Logf(NAME_Debug, "*** %s ***: down to earth; oldz=%g; newz=%g", GetClass()->GetName(), oldz, Origin.z);
       #endif
-      //GCon->Logf(NAME_Debug, "*** %s ***", GetClass()->GetName());
-      // perform lifetime logic
-      // LastMoveTime is time before the next step
-      // PlaneAlpha is fadeout after the time expires:
-      // if PlaneAlpha is:
-      //   <=0: die immediately
-      //    >0: fadeout step time
-      // it fades out by 0.016 per step
-      LastMoveTime -= deltaTime;
-      while (LastMoveTime <= 0) {
-        // die now
-        if (PlaneAlpha <= 0) {
-          //GCon->Logf(NAME_Debug, "%s: DIED!", GetClass()->GetName());
-          DestroyThinker();
-          return;
-        }
-        LastMoveTime += PlaneAlpha;
-        Alpha -= 0.016;
-        // did it faded out completely?
-        if (Alpha <= 0.002f) {
-          //GCon->Logf(NAME_Debug, "%s: FADED!", GetClass()->GetName());
-          DestroyThinker();
-          return;
-        }
-        if (RenderStyle == STYLE_Normal) RenderStyle = STYLE_Translucent;
-      }
     }
+  }
+  // in MP games, there is no `GLevelInfo`
+  if (GLevelInfo && GLevelInfo->LevelInfoFlags2&VLevelInfo::LIF2_Frozen) return true;
+  if (eflagsex&EFEX_NoTickGravLT) {
+    bool faded = false;
+    const bool alive = NoTickLifetimeStep(deltaTime, LastMoveTime, PlaneAlpha, Alpha, faded);
+    if (faded && RenderStyle == STYLE_Normal) RenderStyle = STYLE_Translucent;
+    return alive;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VEntity::NoTickGravWillDie
+//
+//  used to keep dying entities out of the parallel tick, because
+//  destroying them runs VM code
+//
+//==========================================================================
+bool VEntity::NoTickGravWillDie (float deltaTime) const noexcept {
+  if (!(FlagsEx&EFEX_NoTickGravLT)) return false;
+  if (GLevelInfo && GLevelInfo->LevelInfoFlags2&VLevelInfo::LIF2_Frozen) return false;
+  float lastMoveTime = LastMoveTime;
+  float alpha = Alpha;
+  bool faded = false;
+  return !NoTickLifetimeStep(deltaTime, lastMoveTime, PlaneAlpha, alpha, faded);
+}
+
+
+//==========================================================================
+//
+//  VEntity::Tick
+//
+//==========================================================================
+void VEntity::Tick (float deltaTime) {
+  ++dbgEntityTickTotal;
+  // advance it here, why not
+  // may be moved down later if some VC code will start using it
+  DataGameTime = XLevel->Time+deltaTime;
+  // skip ticker?
+  const unsigned eflagsex = FlagsEx;
+  if (eflagsex&EFEX_NoTickGrav) {
+    ++dbgEntityTickNoTick;
+    if (!TickNoTickGrav(deltaTime)) DestroyThinker();
     return;
   }
 
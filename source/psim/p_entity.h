@@ -122,6 +122,42 @@ extern VCvarB r_interpolate_thing_angles_models_monsters;
 extern VCvarB sv_decoration_block_projectiles;
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// time spent in native movement/collision code (used by the server benchmark)
+// nested calls are counted only once, by the outermost scope
+// only the main thread adds to the total: worker batches use `Mute`, and
+// the main thread times the whole parallel job instead
+class VEntityPhysTimer {
+public:
+  static bool Enabled;
+  static __thread int Depth;
+  static vuint64 TotalNano; // main thread only
+
+  // scopes on this thread are not counted while this is alive
+  class Mute {
+  public:
+    VV_DISABLE_COPY(Mute)
+    VVA_FORCEINLINE Mute () noexcept { ++Depth; }
+    VVA_FORCEINLINE ~Mute () noexcept { --Depth; }
+  };
+
+private:
+  vuint64 stime;
+  bool counted;
+
+public:
+  VV_DISABLE_COPY(VEntityPhysTimer)
+
+  VVA_FORCEINLINE VEntityPhysTimer () noexcept : stime(0), counted(Enabled) {
+    if (counted && Depth++ == 0) stime = Sys_GetTimeNano();
+  }
+
+  VVA_FORCEINLINE ~VEntityPhysTimer () noexcept {
+    if (counted && --Depth == 0) TotalNano += Sys_GetTimeNano()-stime;
+  }
+};
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 //WARNING: sync this with VC code!
 #define PHYS_MAXMOVE  (1050.0f*30.0f)  /* this is rougly equal to 900 in Vanilla speed */
@@ -489,6 +525,12 @@ public:
   virtual void RemovedFromLevel () override;
   virtual void Tick (float deltaTime) override;
 
+  // tick for `EFEX_NoTickGrav` entities; doesn't destroy the entity, returns `false` instead
+  // it can be called from worker threads
+  bool TickNoTickGrav (float deltaTime);
+  // will `TickNoTickGrav()` return `false`? this checks only the lifetime, and changes nothing
+  bool NoTickGravWillDie (float deltaTime) const noexcept;
+
   inline bool IsRenderable () const noexcept {
     return
       State && !IsGoingToDie() &&
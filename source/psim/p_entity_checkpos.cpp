@@ -51,6 +51,7 @@
 //
 //==========================================================================
 bool VEntity::CheckPosition (TVec Pos) {
+  VEntityPhysTimer physTimer;
   if (!(EntityFlags&(EF_ColideWithThings|EF_ColideWithWorld))) return true;
 
   tmtrace_t cptrace;
@@ -97,8 +98,8 @@ bool VEntity::CheckPosition (TVec Pos) {
     DeclareMakeBlockMapCoordsBBox2DMaxRadius(cptrace.BBox, xl, yl, xh, yh);
     for (int bx = xl; bx <= xh; ++bx) {
       for (int by = yl; by <= yh; ++by) {
-        for (auto &&it : XLevel->allBlockThings(bx, by)) {
-          VEntity *e = it.entity();
+        VEntity *e;
+        for (VBlockThingsNearIterator It(XLevel, bx, by, cptrace.End.x, cptrace.End.y, rad, &e); It.GetNext(); ) {
           if (!CheckThing(cptrace, e)) {
             #if 0
             GCon->Logf(NAME_Debug, "%s: collided with thing `%s`", GetClass()->GetName(), e->GetClass()->GetName());
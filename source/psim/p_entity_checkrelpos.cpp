@@ -67,6 +67,7 @@ static VCvarB mv_new_slope_code("mv_new_slope_code", true, "Use experimental slo
 //
 //==========================================================================
 bool VEntity::CheckRelPosition (tmtrace_t &tmtrace, TVec Pos, bool noPickups, bool ignoreMonsters, bool ignorePlayers) {
+  VEntityPhysTimer physTimer;
   //if (IsPlayer()) GCon->Logf(NAME_Debug, "*** CheckRelPosition: pos=(%g,%g,%g)", Pos.x, Pos.y, Pos.z);
   memset((void *)&tmtrace, 0, sizeof(tmtrace));
 
@@ -102,8 +103,8 @@ bool VEntity::CheckRelPosition (tmtrace_t &tmtrace, TVec Pos, bool noPickups, bo
     DeclareMakeBlockMapCoordsBBox2DMaxRadius(tmtrace.BBox, xl, yl, xh, yh);
     for (int bx = xl; bx <= xh; ++bx) {
       for (int by = yl; by <= yh; ++by) {
-        for (auto &&it : XLevel->allBlockThings(bx, by)) {
-          VEntity *ent = it.entity();
+        VEntity *ent;
+        for (VBlockThingsNearIterator It(XLevel, bx, by, tmtrace.End.x, tmtrace.End.y, rad, &ent); It.GetNext(); ) {
           if (ignoreMonsters || ignorePlayers) {
             if (ignorePlayers && ent->IsPlayer()) continue;
             if (ignoreMonsters && (ent->IsAnyMissile() || ent->IsMonster())) continue;
@@ -575,6 +576,7 @@ bool VEntity::CheckRelLine (tmtrace_t &tmtrace, line_t *ld, bool skipSpecials) {
 //
 //==========================================================================
 bool VEntity::CheckRelPositionPoint (tmtrace_t &tmtrace, TVec Pos) {
+  VEntityPhysTimer physTimer;
   memset((void *)&tmtrace, 0, sizeof(tmtrace));
 
   tmtrace.End = Pos;
@@ -36,6 +36,8 @@
 
 static VCvarB compat_better_sight("compat_better_sight", true, "Check more points in LOS calculations?", CVAR_Archive);
 static VCvarB dbg_disable_cansee("dbg_disable_cansee", false, "Disable CanSee processing (for debug)?", CVAR_PreInit|CVAR_NoShadow);
+static VCvarB sv_sight_pvs("sv_sight_pvs", false, "Reject sight checks early with precomputed subsector PVS (experimental)?", CVAR_NoShadow);
+static VCvarB dbg_sight_pvs_check("dbg_sight_pvs_check", false, "Trace sight checks rejected by PVS anyway, and report when the trace sees the target?", CVAR_NoShadow);
 
 //k8: for some reason, sight checks ignores base sector region
 //    i don't think that this is a right thing to do, so i removed that
@@ -112,6 +114,14 @@ bool VEntity::CanSeeEx (VEntity *Other, unsigned flags) {
     //if (!cbs) GCon->Logf(NAME_Debug, "%s: better sight forced to 'OFF', checking sight to '%s' (dist=%g)", GetClass()->GetName(), Other->GetClass()->GetName(), sqrtf(distSq));
   }
 
+  // "better sight" checks from the shifted points, so use PVS only for normal checks
+  // with `dbg_sight_pvs_check`, the full trace is done anyway, and its result is used
+  bool pvsRejected = false;
+  if (!cbs && (sv_sight_pvs.asBool() || dbg_sight_pvs_check.asBool())) {
+    pvsRejected = !XLevel->IsLeafPotentiallyVisible(BaseSubSector, Other->BaseSubSector);
+    if (pvsRejected && !dbg_sight_pvs_check.asBool()) return false;
+  }
+
   TVec dirF, dirR;
   if (cbs) {
     //dirR = YawVectorRight(Angles.yaw);
@@ -125,9 +135,14 @@ bool VEntity::CanSeeEx (VEntity *Other, unsigned flags) {
     dirF = dirR = TVec::ZeroVector;
   }
   //if (forShooting) dirR = TVec::ZeroVector; // just in case, lol
-  return XLevel->CastCanSee(BaseSubSector, Origin, Height, dirF, dirR, Other->Origin, Other->GetMoveRadius(), Other->Height,
-                            !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->BaseSubSector, /*alwaysBetter*/cbs,
-                            !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+  const bool res = XLevel->CastCanSee(BaseSubSector, Origin, Height, dirF, dirR, Other->Origin, Other->GetMoveRadius(), Other->Height,
+                                      !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->BaseSubSector, /*alwaysBetter*/cbs,
+                                      !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+  if (pvsRejected && res) {
+    GCon->Logf(NAME_Warning, "PVS rejected visible '%s' from '%s' (subsectors %d -> %d)", Other->GetClass()->GetName(), GetClass()->GetName(),
+               (int)(ptrdiff_t)(BaseSubSector-&XLevel->Subsectors[0]), (int)(ptrdiff_t)(Other->BaseSubSector-&XLevel->Subsectors[0]));
+  }
+  return res;
 }
 
 
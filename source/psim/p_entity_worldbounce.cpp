@@ -48,6 +48,7 @@
 //
 //============================================================================
 void VEntity::BounceWall (float DeltaTime, const line_t *blockline, float overbounce, float bouncefactor) {
+  VEntityPhysTimer physTimer;
   const line_t *BestSlideLine = nullptr; //blockline;
   #ifdef VV_DEBUG_BOUNCE
   GCon->Logf(NAME_Debug, "=======: BOUNCE %s:%u: START; line=%d; overbounce=%f; bouncefactor=%f", GetClass()->GetName(), GetUniqueId(), (blockline ? (intptr_t)(blockline-&XLevel->Lines[0]) : -666), overbounce, bouncefactor);
@@ -220,6 +220,7 @@ void VEntity::UnlinkFromWorld () {
 
   if (BlockMapCell) {
     // unlink from block map
+    XLevel->UnlinkBlockProxy(this, BlockMapCell-1);
     if (BlockMapNext) BlockMapNext->BlockMapPrev = BlockMapPrev;
     if (BlockMapPrev) {
       BlockMapPrev->BlockMapNext = BlockMapNext;
@@ -399,6 +400,7 @@ void VEntity::LinkToWorld (int properFloorCheck) {
       BlockMapNext = *link;
       if (*link) (*link)->BlockMapPrev = this;
       *link = this;
+      XLevel->LinkBlockProxy(this, BlockMapCell);
       BlockMapCell += 1;
     } else {
       // thing is off the map
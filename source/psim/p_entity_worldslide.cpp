@@ -941,6 +941,7 @@ void VEntity::SlideMoveQ3Like (float deltaTime, bool noPickups) {
 //
 //==========================================================================
 void VEntity::SlideMove (float deltaTime, bool noPickups) {
+  VEntityPhysTimer physTimer;
   const float oldvelz = Velocity.z;
   const int slideType = gm_slide_code.asInt();
        if (slideType >= 2) SlideMoveQ3Like(deltaTime, noPickups);
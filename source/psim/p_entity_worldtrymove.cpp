@@ -80,6 +80,7 @@ void VEntity::PushLine (const tmtrace_t &tmtrace, bool checkOnly) {
 //
 //==========================================================================
 bool VEntity::TryMove (tmtrace_t &tmtrace, TVec newPos, bool AllowDropOff, bool checkOnly, bool noPickups) {
+  VEntityPhysTimer physTimer;
   bool check;
   TVec oldorg(0, 0, 0);
   line_t *ld;
@@ -61,6 +61,16 @@
 static InterceptionList intercepts;
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// per-thread tracing state (see `VLevel::NewLightTraceContext()`)
+// lines are marked in `lineMarks` instead of `line_t::validcount`
+struct VLevel::LightTraceContext {
+  InterceptionList intercepts;
+  TArrayNC<vint32> lineMarks; // indexed by line number
+  vint32 markCount;
+};
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 struct SightTraceInfo {
   // the following should be set
@@ -76,6 +86,8 @@ struct SightTraceInfo {
   bool wallTextureCheck;
   bool collectIntercepts; // set if we'll do "better sight" checks
   bool wasBlocked; // for `collectIntercepts`
+  VLevel::LightTraceContext *Ctx; // `nullptr`: use global state
+  InterceptionList *Intercepts;
   // the following are working vars, and should not be set
   bool Hit1S; // `true` means "hit one-sided wall"
   TVec Delta; // End-Start
@@ -86,6 +98,7 @@ struct SightTraceInfo {
   inline SightTraceInfo (VLevel *alevel, const TVec &org, const TVec &dest, const subsector_t *sstart, const subsector_t *send) noexcept {
     memset((void *)this, 0, sizeof(SightTraceInfo));
     Level = alevel;
+    Intercepts = &intercepts;
     Start = org;
     End = dest;
     #if 0
@@ -435,8 +448,8 @@ static bool SightPass2SLine (SightTraceInfo &trace, int iidx, const line_t *line
       // if we're entering a 3d pobj, no need to do more checks
       // but if we have no 3d pobj exit point, perform a check
       // (because it means that we stopped inside the pobj)
-      const intercept_t *it = intercepts.list+iidx;
-      for (++iidx; iidx < (int)intercepts.count(); ++iidx, ++it) {
+      const intercept_t *it = trace.Intercepts->list+iidx;
+      for (++iidx; iidx < (int)trace.Intercepts->count(); ++iidx, ++it) {
         const line_t *exitld = it->line;
         if (exitld && exitld->pobj() == po && it->side == 1) {
           //GCon->Logf(NAME_Debug, "pobj #%d line #%d will be checked on exit", po->tag, (int)(ptrdiff_t)(line-&trace.Level->Lines[0]));
@@ -454,7 +467,7 @@ static bool SightPass2SLine (SightTraceInfo &trace, int iidx, const line_t *line
       // to do this, we have to find a previous 3d pobj line
       // if plane hit is inside previous frac, and current frac, we hit pobj flat
       // if there is no previous 3d pobj plane, assume that previous frac is 0.0
-      const intercept_t *ilist = intercepts.list;
+      const intercept_t *ilist = trace.Intercepts->list;
       float prevfrac = 0.0f;
       while (--iidx >= 0) {
         line_t *prevld = ilist[iidx].line;
@@ -616,9 +629,14 @@ static bool SightPassSectorPlanes (SightTraceInfo &trace, int iidx, const line_t
 //
 //==========================================================================
 static bool SightPassLine (SightTraceInfo &trace, line_t *ld) {
-  if (ld->validcount == validcount) return true;
-
-  ld->validcount = validcount;
+  if (trace.Ctx) {
+    vint32 *mark = trace.Ctx->lineMarks.ptr()+(ptrdiff_t)(ld-&trace.Level->Lines[0]);
+    if (*mark == trace.Ctx->markCount) return true;
+    *mark = trace.Ctx->markCount;
+  } else {
+    if (ld->validcount == validcount) return true;
+    ld->validcount = validcount;
+  }
 
   // signed distances from the line points to the trace line plane
   const float ldot1 = trace.Plane.PointDistance(*ld->v1);
@@ -699,7 +717,7 @@ static bool SightPassLine (SightTraceInfo &trace, line_t *ld) {
   }
 
   // store the line for later intersection testing
-  intercept_t *icept = intercepts.insert(frac);
+  intercept_t *icept = trace.Intercepts->insert(frac);
   icept->Flags = intercept_t::IF_IsALine; // just in case
   icept->line = ld;
   icept->side = (dot1 < 0.0f); // was <=
@@ -726,7 +744,13 @@ static bool SightPassBlockLines (SightTraceInfo &trace, int x, int y) {
 
   for (polyblock_t *polyLink = trace.Level->PolyBlockMap[offset]; polyLink; polyLink = polyLink->next) {
     polyobj_t *pobj = polyLink->polyobj;
-    if (pobj && pobj->validcount != validcount) {
+    if (!pobj) continue;
+    if (trace.Ctx) {
+      // lines are marked in the context, so we don't need to mark pobjs
+      for (auto &&sit : pobj->LineFirst()) {
+        if (!SightPassLine(trace, sit.line())) return false;
+      }
+    } else if (pobj->validcount != validcount) {
       pobj->validcount = validcount;
       for (auto &&sit : pobj->LineFirst()) {
         line_t *ld = sit.line();
@@ -756,11 +780,11 @@ static bool SightPassBlockLines (SightTraceInfo &trace, int x, int y) {
 //==========================================================================
 static bool SightPassIntercepts (SightTraceInfo &trace) {
   float prevfrac = 0.0f;
-  if (!intercepts.isEmpty()) {
+  if (!trace.Intercepts->isEmpty()) {
     // go through in order
-    const intercept_t *scan = intercepts.list;
+    const intercept_t *scan = trace.Intercepts->list;
     int iidx = 0;
-    for (unsigned i = intercepts.count(); i--; ++scan, ++iidx) {
+    for (unsigned i = trace.Intercepts->count(); i--; ++scan, ++iidx) {
       if (!SightPassSectorPlanes(trace, iidx, scan->line, scan->side, prevfrac, scan->frac)) return false; // don't bother going further
       // ignore polyobject lines
       if (!scan->line->pobj()) prevfrac = scan->frac;
@@ -834,7 +858,7 @@ static bool SightPassStartingPObj (SightTraceInfo &trace) {
 static bool SightPassPath (SightTraceInfo &trace) {
   VBlockMapWalker walker;
 
-  intercepts.reset();
+  trace.Intercepts->reset();
 
   trace.Delta = trace.End-trace.Start;
   trace.Hit1S = false;
@@ -864,7 +888,14 @@ static bool SightPassPath (SightTraceInfo &trace) {
 
   if (walker.start(trace.Level, trace.Start.x, trace.Start.y, trace.End.x, trace.End.y)) {
     trace.Plane.SetPointDirXY(trace.Start, trace.Delta);
-    trace.Level->IncrementValidCount();
+    if (trace.Ctx) {
+      if (++trace.Ctx->markCount == MAX_VINT32) {
+        trace.Ctx->markCount = 1;
+        for (auto &&mk : trace.Ctx->lineMarks) mk = 0;
+      }
+    } else {
+      trace.Level->IncrementValidCount();
+    }
     int mapx, mapy;
     while (walker.next(mapx, mapy)) {
       if (!SightPassBlockLines(trace, mapx, mapy)) return false;
@@ -1018,7 +1049,7 @@ bool VLevel::CastCanSee (const subsector_t *SubSector, const TVec &org, float my
       // check middle
       trace.End.z += height*0.5f;
       if (SightPassPath(trace)) return true;
-      if (trace.Hit1S || intercepts.isEmpty() == 0) continue;
+      if (trace.Hit1S || trace.Intercepts->isEmpty() == 0) continue;
 
       // check eyes (roughly)
       trace.End = dest;
@@ -1042,7 +1073,7 @@ bool VLevel::CastCanSee (const subsector_t *SubSector, const TVec &org, float my
 //  returns `true` if no hit was detected
 //
 //==========================================================================
-bool VLevel::CastLightRay (bool /*textureCheck*/, const subsector_t *startSubSector, const TVec &org, const TVec &dest, const subsector_t *endSubSector) {
+bool VLevel::CastLightRay (bool /*textureCheck*/, const subsector_t *startSubSector, const TVec &org, const TVec &dest, const subsector_t *endSubSector, LightTraceContext *ctx) {
   // if starting or ending point is out of blockmap bounds, don't bother tracing
   // we can get away with this, because nothing can see anything beyound the map extents
   if (isNotInsideBM(org, this)) return false;
@@ -1051,6 +1082,10 @@ bool VLevel::CastLightRay (bool /*textureCheck*/, const subsector_t *startSubSec
   if ((org-dest).lengthSquared() <= 2.0f) return true;
 
   SightTraceInfo trace(this, org, dest, startSubSector, endSubSector);
+  if (ctx) {
+    trace.Ctx = ctx;
+    trace.Intercepts = &ctx->intercepts;
+  }
   trace.lightCheck = true;
   trace.flatTextureCheck = true;
   trace.wallTextureCheck = true;
@@ -1069,6 +1104,30 @@ bool VLevel::CastLightRay (bool /*textureCheck*/, const subsector_t *startSubSec
 }
 
 
+//==========================================================================
+//
+//  VLevel::NewLightTraceContext
+//
+//==========================================================================
+VLevel::LightTraceContext *VLevel::NewLightTraceContext () {
+  LightTraceContext *ctx = new LightTraceContext;
+  ctx->lineMarks.setLength(max2(1, NumLines));
+  for (auto &&mk : ctx->lineMarks) mk = 0;
+  ctx->markCount = 0;
+  return ctx;
+}
+
+
+//==========================================================================
+//
+//  VLevel::DeleteLightTraceContext
+//
+//==========================================================================
+void VLevel::DeleteLightTraceContext (LightTraceContext *ctx) {
+  delete ctx;
+}
+
+
 //==========================================================================
 //
 //  Script natives
@@ -32,9 +32,18 @@
 #include "../gamedefs.h"
 #include "p_entity.h"
 #include "p_world.h"
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 //#define VV_DEBUG_TRAVERSER
 
+// proxies are rejected only if they are further than this from the
+// collision box. snapshots are exact, this only covers float rounding.
+#define BLOCK_PROXY_SLACK  (1.0f)
+
+static VCvarB sv_blockmap_proxies("sv_blockmap_proxies", true, "Use compact blockmap proxies to reject far things in collision checks?", CVAR_NoShadow);
+
 
 
 //==========================================================================
@@ -75,6 +84,213 @@ bool VBlockPObjIterator::GetNext () {
 
 
 
+//==========================================================================
+//
+//  VLevel::AllocBlockProxies
+//
+//  called after blockmap is created; cells are allocated on demand
+//
+//==========================================================================
+void VLevel::AllocBlockProxies () {
+  FreeBlockProxies();
+  const int count = BlockMapWidth*BlockMapHeight;
+  if (count <= 0) return;
+  BlockProxies = (VBlockThingProxies *)Z_Calloc(sizeof(VBlockThingProxies)*(size_t)count);
+  BlockProxyCount = count;
+}
+
+
+//==========================================================================
+//
+//  VLevel::FreeBlockProxies
+//
+//==========================================================================
+void VLevel::FreeBlockProxies () {
+  if (BlockProxies) {
+    for (int f = 0; f < BlockProxyCount; ++f) Z_Free(BlockProxies[f].OrgX);
+    Z_Free(BlockProxies);
+    BlockProxies = nullptr;
+  }
+  BlockProxyCount = 0;
+}
+
+
+//==========================================================================
+//
+//  VLevel::LinkBlockProxy
+//
+//  appends the proxy, because new entities are inserted at chain head
+//
+//==========================================================================
+void VLevel::LinkBlockProxy (VEntity *e, unsigned cell) {
+  if (!BlockProxies || cell >= (unsigned)BlockProxyCount) return;
+  VBlockThingProxies *bp = &BlockProxies[cell];
+  if (bp->Count == bp->Alloted) {
+    // grow; all arrays live in one memory block
+    const int newsize = (bp->Alloted ? bp->Alloted*2 : 8);
+    vassert((newsize&3) == 0);
+    vuint8 *mem = (vuint8 *)Z_Calloc((size_t)newsize*(sizeof(float)*3+sizeof(VEntity *)));
+    float *nx = (float *)mem;
+    float *ny = nx+newsize;
+    float *nr = ny+newsize;
+    VEntity **ne = (VEntity **)(nr+newsize);
+    if (bp->Count) {
+      memcpy(nx, bp->OrgX, (size_t)bp->Count*sizeof(float));
+      memcpy(ny, bp->OrgY, (size_t)bp->Count*sizeof(float));
+      memcpy(nr, bp->Radius, (size_t)bp->Count*sizeof(float));
+      memcpy(ne, bp->Ents, (size_t)bp->Count*sizeof(VEntity *));
+    }
+    Z_Free(bp->OrgX);
+    bp->OrgX = nx;
+    bp->OrgY = ny;
+    bp->Radius = nr;
+    bp->Ents = ne;
+    bp->Alloted = newsize;
+  }
+  const int idx = bp->Count++;
+  bp->OrgX[idx] = e->Origin.x;
+  bp->OrgY[idx] = e->Origin.y;
+  bp->Radius[idx] = e->GetMoveRadius();
+  bp->Ents[idx] = e;
+}
+
+
+//==========================================================================
+//
+//  VLevel::UnlinkBlockProxy
+//
+//  keeps the order, so iterators will return things in chain order
+//
+//==========================================================================
+void VLevel::UnlinkBlockProxy (VEntity *e, unsigned cell) {
+  if (!BlockProxies || cell >= (unsigned)BlockProxyCount) return;
+  VBlockThingProxies *bp = &BlockProxies[cell];
+  // recently linked things are moved more often, so search from the end
+  int idx = bp->Count-1;
+  while (idx >= 0 && bp->Ents[idx] != e) --idx;
+  if (idx < 0) return;
+  const int tail = bp->Count-idx-1;
+  if (tail) {
+    memmove(bp->OrgX+idx, bp->OrgX+idx+1, (size_t)tail*sizeof(float));
+    memmove(bp->OrgY+idx, bp->OrgY+idx+1, (size_t)tail*sizeof(float));
+    memmove(bp->Radius+idx, bp->Radius+idx+1, (size_t)tail*sizeof(float));
+    memmove(bp->Ents+idx, bp->Ents+idx+1, (size_t)tail*sizeof(VEntity *));
+  }
+  --bp->Count;
+}
+
+
+
+//==========================================================================
+//
+//  VBlockThingsNearIterator::VBlockThingsNearIterator
+//
+//==========================================================================
+VBlockThingsNearIterator::VBlockThingsNearIterator (VLevel *Level, int bx, int by, float x, float y, float rad, VEntity **AEntPtr)
+  : EntPtr(AEntPtr)
+  , Ent(nullptr)
+  , CellId(0)
+  , CandPos(0)
+  , CandCount(0)
+  , Cands(Inline)
+  , Started(false)
+{
+  if (bx < 0 || bx >= Level->BlockMapWidth || by < 0 || by >= Level->BlockMapHeight) return;
+  const unsigned cell = (unsigned)by*(unsigned)Level->BlockMapWidth+(unsigned)bx;
+  if (Level->BlockProxies && sv_blockmap_proxies.asBool()) {
+    CellId = cell+1;
+    Collect(&Level->BlockProxies[cell], x, y, rad);
+  } else {
+    Ent = Level->BlockLinks[cell];
+  }
+}
+
+
+//==========================================================================
+//
+//  VBlockThingsNearIterator::Collect
+//
+//  scans all proxies of the cell, four at a time, and copies candidates
+//  the test is the one from `CheckThing()`/`CheckRelThing()`, with some slack:
+//  thing is rejected if `fabsf(org-pos) >= otherrad+rad+BLOCK_PROXY_SLACK` for any axis
+//  scripts can change `Origin` or `Radius` without relinking, so snapshots
+//  are refreshed from their things right before the test. the refresh reads
+//  only a few fields, and unlike the chain walk, the reads do not depend on
+//  each other. the exact test is still done by the caller.
+//
+//  the caller can unlink things, and `UnlinkBlockProxy()` shifts the
+//  arrays, so nothing is read from the proxies after this
+//
+//==========================================================================
+void VBlockThingsNearIterator::Collect (VBlockThingProxies *Prx, float x, float y, float rad) {
+  int pos = Prx->Count;
+  if (pos > MaxInline) {
+    Overflow.setLength(pos);
+    Cands = Overflow.ptr();
+  }
+  #if defined(__SSE2__)
+  const __m128 px = _mm_set1_ps(x);
+  const __m128 py = _mm_set1_ps(y);
+  const __m128 prad = _mm_set1_ps(rad+BLOCK_PROXY_SLACK);
+  const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  #endif
+  while (pos > 0) {
+    // arrays are padded to four items, and the padding is initialised
+    const int base = (pos-1)&~3;
+    for (int f = base; f < pos; ++f) {
+      const VEntity *e = Prx->Ents[f];
+      Prx->OrgX[f] = e->Origin.x;
+      Prx->OrgY[f] = e->Origin.y;
+      Prx->Radius[f] = e->GetMoveRadius();
+    }
+    #if defined(__SSE2__)
+    const __m128 dx = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(Prx->OrgX+base), px), absmask);
+    const __m128 dy = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(Prx->OrgY+base), py), absmask);
+    const __m128 bd = _mm_add_ps(_mm_loadu_ps(Prx->Radius+base), prad);
+    const int farMask = _mm_movemask_ps(_mm_or_ps(_mm_cmpge_ps(dx, bd), _mm_cmpge_ps(dy, bd)));
+    #else
+    int farMask = 0;
+    for (int f = 0; f < 4; ++f) {
+      const float bd = Prx->Radius[base+f]+rad+BLOCK_PROXY_SLACK;
+      if (fabsf(Prx->OrgX[base+f]-x) >= bd || fabsf(Prx->OrgY[base+f]-y) >= bd) farMask |= 1<<f;
+    }
+    #endif
+    // chain order is reversed
+    for (int f = pos-1-base; f >= 0; --f) {
+      if (!(farMask&(1<<f))) Cands[CandCount++] = Prx->Ents[base+f];
+    }
+    pos = base;
+  }
+}
+
+
+//==========================================================================
+//
+//  VBlockThingsNearIterator::GetNext
+//
+//==========================================================================
+bool VBlockThingsNearIterator::GetNext () {
+  if (!CellId) {
+    // old code path; advance after the caller is done with the thing, as `allBlockThings()` does
+    if (Started && Ent) Ent = Ent->BlockMapNext;
+    Started = true;
+    while (Ent && Ent->IsGoingToDie()) Ent = Ent->BlockMapNext;
+    if (!Ent) return false;
+    *EntPtr = Ent;
+    return true;
+  }
+  while (CandPos < CandCount) {
+    VEntity *e = Cands[CandPos++];
+    // the caller may unlink things (via touch events, for example)
+    if (e->BlockMapCell != CellId || e->IsGoingToDie()) continue;
+    *EntPtr = e;
+    return true;
+  }
+  return false;
+}
+
+
+
 //==========================================================================
 //
 //  VRadiusThingsIterator::VRadiusThingsIterator
@@ -57,6 +57,45 @@ public:
 };
 
 
+//==========================================================================
+//
+//  VBlockThingsNearIterator
+//
+//  Returns things from the given blockmap cell which can touch the box
+//  centered at (x,y), with `rad` half-size. Things are returned in the same
+//  order as `VLevel::allBlockThings()` returns them. Far things are rejected
+//  using blockmap proxies, so the caller never sees them. With
+//  `sv_blockmap_proxies` turned off, all things in the cell are returned.
+//
+//  The candidate list is collected before the first thing is returned, so
+//  the caller can link and unlink things while iterating.
+//
+//==========================================================================
+class VBlockThingsNearIterator {
+private:
+  enum { MaxInline = 32 };
+
+  VEntity **EntPtr;
+  VEntity *Ent; // for the old code path
+  vuint32 CellId; // cell index+1, as in `VEntity::BlockMapCell`; 0 for the old code path
+  int CandPos;
+  int CandCount;
+  VEntity **Cands; // points to `Inline` or to `Overflow`
+  VEntity *Inline[MaxInline];
+  TArrayNC<VEntity *> Overflow; // used only for crowded cells
+  bool Started;
+
+private:
+  void Collect (VBlockThingProxies *Prx, float x, float y, float rad);
+
+public:
+  VV_DISABLE_COPY(VBlockThingsNearIterator)
+
+  VBlockThingsNearIterator (VLevel *Level, int bx, int by, float x, float y, float rad, VEntity **AEntPtr);
+  bool GetNext ();
+};
+
+
 //==========================================================================
 //
 //  VRadiusThingsIterator
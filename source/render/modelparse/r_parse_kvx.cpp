@@ -25,11 +25,10 @@
 //**************************************************************************
 #include "../../gamedefs.h"
 #include "../r_local.h"
-#include "../../filesys/files.h"
+#include "../../filesys/cachestore.h"
 #include "voxelib.h"
 
 VCvarB vox_cache_enabled("vox_cache_enabled", true, "Enable caching of converted voxel models?", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
-static VCvarI vox_cache_compression_level("vox_cache_compression_level", "9", "Voxel cache file compression level [0..9].", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
 static VCvarB vox_verbose_conversion("vox_verbose_conversion", false, "Show info messages from voxel converter?", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
 static VCvarI vox_optimisation("vox_optimisation", "3", "Voxel loader optimisation (higher is better, but with more Space Ants) [0..3].", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
 static VCvarB vox_fix_faces("vox_fix_faces", true, "Fix voxel face visibility info?", CVAR_PreInit|CVAR_Archive|CVAR_NoShadow);
@@ -40,7 +39,7 @@ static VCvarB vox_mip_lowquality("vox_mip_lowquality", false, "Lower quality for
 #define VOX_ENABLE_INVARIANT_CHECK
 
 
-#define VOX_CACHE_SIGNATURE  "k8vavoom voxel model cache file, version 5\n"
+#define VOX_CACHE_SIGNATURE  "k8vavoom voxel model cache file, version 6\n"
 
 #ifdef VAVOOM_GLMODEL_32BIT_VIDX
 # define BreakIndex  (6553500)
@@ -405,10 +404,9 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
   this->voxHollowFill = vox_fix_faces.asBool();
 
   VStr ccname = GenKVXCacheName(Data, DataSize);
-  VStr cacheFileName = VStr("voxmdl_")+ccname+".cache";
-  cacheFileName = FL_GetVoxelCacheDir()+"/"+cacheFileName;
+  VStr cacheFileName = VStr("vox_")+ccname; // cache store entry name
 
-  VStream *strm = FL_OpenSysFileRead(cacheFileName);
+  VStream *strm = (vox_cache_enabled.asBool() ? VCacheStore::OpenRead(cacheFileName) : nullptr);
   if (strm) {
     if (vox_cache_enabled.asBool()) {
       char tbuf[128];
@@ -436,13 +434,7 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
         *strm << hollow;
         if (ok && (hollow > 1 || this->voxHollowFill != hollow)) ok = false;
       }
-      if (ok) {
-        VZLibStreamReader *zstrm = new VZLibStreamReader(true, strm);
-        ok = Load_KVXCache(zstrm);
-        if (ok) ok = !zstrm->IsError();
-        zstrm->Close();
-        delete zstrm;
-      }
+      if (ok) ok = Load_KVXCache(strm);
       if (ok) ok = !strm->IsError();
       VStream::Destroy(strm);
       if (ok) {
@@ -456,7 +448,7 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
         //GCon->Logf(NAME_Init, "voxel model '%s' loaded from cache file '%s'", *this->Name, *ccname);
         return;
       }
-      Sys_FileDelete(cacheFileName);
+      VCacheStore::Remove(cacheFileName);
       Skins.clear();
       Frames.clear();
       AllVerts.clear();
@@ -480,9 +472,6 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
       GCon->Logf(NAME_Init, "failed to load cached voxel model '%s', regenerating...", *this->Name);
     } else {
       VStream::Destroy(strm);
-      #if 0
-      Sys_FileDelete(cacheFileName);
-      #endif
     }
   }
 
@@ -663,8 +652,9 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
   vox.clear();
 
   if (vox_cache_enabled.asBool()) {
-    strm = FL_OpenSysFileWrite(cacheFileName);
-    if (strm) {
+    VMemoryStream *mstrm = new VMemoryStream(cacheFileName);
+    strm = mstrm;
+    {
       if (vox_verbose_conversion.asBool()) GCon->Logf(NAME_Init, "...writing cache to '%s'...", *ccname);
       strm->Serialise(VOX_CACHE_SIGNATURE, (int)strlen(VOX_CACHE_SIGNATURE));
       *strm << this->Name;
@@ -674,16 +664,12 @@ void VMeshModel::Load_KVX (const vuint8 *Data, int DataSize) {
       *strm << tjunk;
       vuint8 hollow = (this->voxHollowFill ? 1 : 0);
       *strm << hollow;
-      VZLibStreamWriter *zstrm = new VZLibStreamWriter(strm, vox_cache_compression_level.asInt());
-      Save_KVXCache(zstrm);
-      bool ok = !zstrm->IsError();
-      if (!zstrm->Close()) ok = false;
-      delete zstrm;
-      strm->Flush();
-      if (ok) ok = !strm->IsError();
-      if (!strm->Close()) ok = false;
+      // the data is not compressed here, the cache store will do it
+      Save_KVXCache(strm);
+      bool ok = !strm->IsError();
+      if (ok) ok = VCacheStore::Write(cacheFileName, mstrm);
       delete strm;
-      if (!ok) Sys_FileDelete(cacheFileName);
+      if (!ok) VCacheStore::Remove(cacheFileName);
     }
   }
 
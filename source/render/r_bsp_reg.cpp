@@ -30,6 +30,9 @@
 #include "../gamedefs.h"
 #include "r_local.h"
 
+extern VCvarB r_lmap_bake_parallel;
+extern VCvarB r_lmap_bsp_trace_static;
+
 
 //==========================================================================
 //
@@ -45,8 +48,17 @@ void VRenderLevelLightmap::QueueWorldSurface (surface_t *surf) {
   // check if static lightmap recalc requested
   if (surf->drawflags&surface_t::DF_CALC_LMAP) {
     //GCon->Logf("%p: Need to calculate static lightmap for subsector %p!", surf, surf->subsector);
-    LightFaceTimeCheckedFreeCaches(surf);
-    lightmaped = (surf->lightmap != nullptr || surf->dlightframe == currDLightFrame);
+    if (r_lmap_bake_parallel.asBool() && !r_lmap_bsp_trace_static.asBool() && CanFaceBeStaticallyLit(surf)) {
+      // defer it; all queued surfaces will be baked in parallel in `ProcessCachedSurfaces()`
+      // the flag will be restored if the surface wasn't processed due to the time limit
+      surf->drawflags &= ~surface_t::DF_CALC_LMAP;
+      LMRelightList.append(surf);
+      // surfaces without lightmaps will be moved to normal queue after baking
+      lightmaped = true;
+    } else {
+      LightFaceTimeCheckedFreeCaches(surf);
+      lightmaped = (surf->lightmap != nullptr || surf->dlightframe == currDLightFrame);
+    }
   }
 
   if (lightmaped) {
@@ -64,6 +64,7 @@ static VCvarB r_lmap_lowfilter("r_lmap_lowfilter", false, "Filter lightmaps with
 static VCvarI r_lmap_atlas_limit("r_lmap_atlas_limit", "14", "Nuke lightmap cache if it reached this number of atlases.", CVAR_Archive);
 
 VCvarB r_lmap_bsp_trace_static("r_lmap_bsp_trace_static", false, "Trace static lightmaps with BSP tree instead of blockmap?", CVAR_Archive|CVAR_NoShadow);
+VCvarB r_lmap_bake_parallel("r_lmap_bake_parallel", true, "Bake static lightmaps with worker threads?", CVAR_Archive|CVAR_NoShadow);
 VCvarB r_lmap_bsp_trace_dynamic("r_lmap_bsp_trace_dynamic", false, "Trace dynamic lightmaps with BSP tree instead of blockmap?", CVAR_Archive|CVAR_NoShadow);
 
 extern VCvarB dbg_adv_light_notrace_mark;
@@ -75,7 +76,7 @@ enum { MaxSurfPoints = VRenderLevelLightmap::LMapTraceInfo::MaxSurfPoints };
 
 static_assert((Filter4X ? (MaxSurfPoints >= GridSize*GridSize*16) : (MaxSurfPoints >= GridSize*GridSize*4)), "invalid grid size");
 
-struct LightmapTracer {
+struct VRenderLevelLightmap::LightmapTracer {
   vuint32 blocklightsr[GridSize*GridSize];
   vuint32 blocklightsg[GridSize*GridSize];
   vuint32 blocklightsb[GridSize*GridSize];
@@ -93,6 +94,8 @@ struct LightmapTracer {
   float lightmapr[MaxSurfPoints];
   float lightmapg[MaxSurfPoints];
   float lightmapb[MaxSurfPoints];
+  // scratch buffer for `FilterLightmap()`
+  float filterTemp[MaxSurfPoints];
   // set in lightmap merge code
   bool hasOverbright; // has overbright component?
   bool isColored; // is lightmap colored?
@@ -100,7 +103,8 @@ struct LightmapTracer {
 
 
 int light_mem = 0;
-static LightmapTracer lmtracer;
+// used by the main thread
+static VRenderLevelLightmap::LightmapTracer lmtracer;
 
 
 //==========================================================================
@@ -193,7 +197,7 @@ bool VRenderLevelLightmap::IsStaticLightmapTimeLimitExpired () {
 //  `p1` is light origin
 //
 //==========================================================================
-bool VRenderLevelLightmap::CastStaticRay (float *dist, const subsector_t *srcsubsector, const TVec &p1, const subsector_t *destsubsector, const TVec &p2, const float squaredist, const bool allowTextureCheck) {
+bool VRenderLevelLightmap::CastStaticRay (float *dist, const subsector_t *srcsubsector, const TVec &p1, const subsector_t *destsubsector, const TVec &p2, const float squaredist, const bool allowTextureCheck, VLevel::LightTraceContext *traceCtx) {
   const TVec delta = p2-p1;
   const float t = delta.dot(delta);
   if (t >= squaredist) {
@@ -216,7 +220,7 @@ bool VRenderLevelLightmap::CastStaticRay (float *dist, const subsector_t *srcsub
   }
 
   if (!r_lmap_bsp_trace_static) {
-    if (!Level->CastLightRay((allowTextureCheck && r_lmap_texture_check_static.asBool()), destsubsector, p2, p1, srcsubsector)) {
+    if (!Level->CastLightRay((allowTextureCheck && r_lmap_texture_check_static.asBool()), destsubsector, p2, p1, srcsubsector, traceCtx)) {
       // ray was blocked
       if (dist) *dist = 0.0f;
       return false;
@@ -418,7 +422,7 @@ void VRenderLevelLightmap::CalcPoints (LMapTraceInfo &lmi, const surface_t *surf
           // calculate texture point
           *spt = lmi.calcTexPoint(us, ut);
           //!if (Level->TraceLine(Trace, facemid, *spt, SPF_NOBLOCKSIGHT)) break; // got it
-          if (CastStaticRay(nullptr, facesubsec, facemid, surf->subsector, *spt, 999999.0f, false)) { // do not check textures
+          if (CastStaticRay(nullptr, facesubsec, facemid, surf->subsector, *spt, 999999.0f, false, lmi.traceCtx)) { // do not check textures
             //found = true;
             // move the point 1 unit above the surface (this seems to be done in `CalcFaceVectors()`)
             //const TVec pp = surf->plane.Project(*spt)+surf->plane.normal;
@@ -463,16 +467,12 @@ void VRenderLevelLightmap::CalcPoints (LMapTraceInfo &lmi, const surface_t *surf
 //
 //  FilterLightmap
 //
+//  `lmnew` is a scratch buffer of at least `wdt*hgt` items
+//
 //==========================================================================
-template<typename T> void FilterLightmap (T *lmap, const int wdt, const int hgt) {
+template<typename T> void FilterLightmap (T *lmap, const int wdt, const int hgt, T *lmnew) {
   if (!r_lmap_lowfilter) return;
   if (!lmap || (wdt < 2 && hgt < 2)) return;
-  static T *lmnew = nullptr;
-  static int lmnewSize = 0;
-  if (wdt*hgt > lmnewSize) {
-    lmnewSize = wdt*hgt;
-    lmnew = (T *)Z_Realloc(lmnew, lmnewSize*sizeof(T));
-  }
   for (int y = 0; y < hgt; ++y) {
     for (int x = 0; x < wdt; ++x) {
       int count = 0;
@@ -496,7 +496,7 @@ template<typename T> void FilterLightmap (T *lmap, const int wdt, const int hgt)
       lmnew[y*wdt+x] = sum;
     }
   }
-  if (lmnewSize) memcpy(lmap, lmnew, lmnewSize*sizeof(T));
+  memcpy(lmap, lmnew, wdt*hgt*sizeof(T));
 }
 
 
@@ -511,6 +511,8 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
   if (surf->count < 3) return; // wtf?!
   if (!light->active || light->radius < 2) return;
 
+  LightmapTracer &tracer = *lmi.tracer;
+
   // check bounding box
   if (light->origin.x+light->radius < lmi.smins.x ||
       light->origin.x-light->radius > lmi.smaxs.x ||
@@ -542,19 +544,19 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
     if (!CalcFaceVectors(lmi, surf)) {
       GCon->Logf(NAME_Warning, "cannot calculate lightmap vectors");
       lmi.numsurfpt = 0;
-      memset(lmtracer.lightmapMono, 0, sizeof(lmtracer.lightmapMono));
-      memset(lmtracer.lightmapr, 0, sizeof(lmtracer.lightmapr));
-      memset(lmtracer.lightmapg, 0, sizeof(lmtracer.lightmapg));
-      memset(lmtracer.lightmapb, 0, sizeof(lmtracer.lightmapb));
+      memset(tracer.lightmapMono, 0, sizeof(tracer.lightmapMono));
+      memset(tracer.lightmapr, 0, sizeof(tracer.lightmapr));
+      memset(tracer.lightmapg, 0, sizeof(tracer.lightmapg));
+      memset(tracer.lightmapb, 0, sizeof(tracer.lightmapb));
       return;
     }
 
     CalcPoints(lmi, surf, false);
     lmi.pointsCalced = true;
-    memset(lmtracer.lightmapMono, 0, lmi.numsurfpt*sizeof(lmtracer.lightmapMono[0]));
-    memset(lmtracer.lightmapr, 0, lmi.numsurfpt*sizeof(lmtracer.lightmapr[0]));
-    memset(lmtracer.lightmapg, 0, lmi.numsurfpt*sizeof(lmtracer.lightmapg[0]));
-    memset(lmtracer.lightmapb, 0, lmi.numsurfpt*sizeof(lmtracer.lightmapb[0]));
+    memset(tracer.lightmapMono, 0, lmi.numsurfpt*sizeof(tracer.lightmapMono[0]));
+    memset(tracer.lightmapr, 0, lmi.numsurfpt*sizeof(tracer.lightmapr[0]));
+    memset(tracer.lightmapg, 0, lmi.numsurfpt*sizeof(tracer.lightmapg[0]));
+    memset(tracer.lightmapb, 0, lmi.numsurfpt*sizeof(tracer.lightmapb[0]));
   }
 
   // check it for real
@@ -569,7 +571,7 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
   int h = (surf->extents[1]>>4)+1;
 
   bool doMidFilter = (!lmi.didExtra && r_lmap_filtering > 0);
-  if (doMidFilter && lmi.numsurfpt) memset(lmtracer.lightmapHit, 0, /*w*h*/lmi.numsurfpt);
+  if (doMidFilter && lmi.numsurfpt) memset(tracer.lightmapHit, 0, /*w*h*/lmi.numsurfpt);
 
   bool wasAnyHit = false;
   const TVec lnormal = surf->GetNormal();
@@ -591,7 +593,7 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
 
     float raydist;
     if (doCastRay) {
-      if (!CastStaticRay(&raydist, srcsubsector, lorg+lnormal, surf->subsector, (*spt)+lnormal, squaredist, true)) { // allow texture check
+      if (!CastStaticRay(&raydist, srcsubsector, lorg+lnormal, surf->subsector, (*spt)+lnormal, squaredist, true, lmi.traceCtx)) { // allow texture check
         // light ray is blocked
         continue;
       }
@@ -605,9 +607,9 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
     if (!incoming.isZero()) {
       incoming.normaliseInPlace();
       if (!incoming.isValid()) {
-        lmtracer.lightmapMono[c] += 255.0f;
-        lmtracer.lightmapr[c] += 255.0f;
-        lmtracer.isColored = true;
+        tracer.lightmapMono[c] += 255.0f;
+        tracer.lightmapr[c] += 255.0f;
+        tracer.isColored = true;
         lmi.light_hit = true;
         continue;
       }
@@ -621,23 +623,23 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
     // without this, lights with huge radius will overbright everything
     if (add > 255.0f) add = 255.0f;
 
-    if (doMidFilter) { wasAnyHit = true; lmtracer.lightmapHit[c] = 1; }
+    if (doMidFilter) { wasAnyHit = true; tracer.lightmapHit[c] = 1; }
 
-    lmtracer.lightmapMono[c] += add;
-    lmtracer.lightmapr[c] += add*rmul;
-    lmtracer.lightmapg[c] += add*gmul;
-    lmtracer.lightmapb[c] += add*bmul;
+    tracer.lightmapMono[c] += add;
+    tracer.lightmapr[c] += add*rmul;
+    tracer.lightmapg[c] += add*gmul;
+    tracer.lightmapb[c] += add*bmul;
     // ignore really tiny lights
-    if (lmtracer.lightmapMono[c] > 1) {
+    if (tracer.lightmapMono[c] > 1) {
       lmi.light_hit = true;
-      if (light->color != 0xffffffff) lmtracer.isColored = true;
+      if (light->color != 0xffffffff) tracer.isColored = true;
     }
   }
 
   if (doCastRay && doMidFilter && wasAnyHit) {
     //GCon->Logf("w=%d; h=%d; num=%d; cnt=%d", w, h, w*h, lmi.numsurfpt);
    again:
-    const vuint8 *lht = lmtracer.lightmapHit;
+    const vuint8 *lht = tracer.lightmapHit;
     for (int y = 0; y < h; ++y) {
       for (int x = 0; x < w; ++x, ++lht) {
         const int laddr = y*w+x;
@@ -649,7 +651,7 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
         for (int dy = -1; dy < 2; ++dy) {
           const int sy = y+dy;
           if (sy < 0 || sy >= h) continue;
-          const vuint8 *row = lmtracer.lightmapHit+(sy*w);
+          const vuint8 *row = tracer.lightmapHit+(sy*w);
           for (int dx = -1; dx < 2; ++dx) {
             if ((dx|dy) == 0) continue;
             const int sx = x+dx;
@@ -665,7 +667,7 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
             for (int dx = -1; dx < 2; ++dx) {
               for (int dz = -1; dz < 2; ++dz) {
                 if ((dx|dy|dz) == 0) continue;
-                if (CastStaticRay(&raydist, srcsubsector, lorg+lnormal, surf->subsector, pt+TVec(4*dx, 4*dy, 4*dz), squaredist, true)) goto donetrace; // allow texture check
+                if (CastStaticRay(&raydist, srcsubsector, lorg+lnormal, surf->subsector, pt+TVec(4*dx, 4*dy, 4*dz), squaredist, true, lmi.traceCtx)) goto donetrace; // allow texture check
               }
             }
           }
@@ -687,16 +689,16 @@ void VRenderLevelLightmap::SingleLightFace (LMapTraceInfo &lmi, light_t *light,
           // without this, lights with huge radius will overbright everything
           if (add > 255.0f) add = 255.0f;
 
-          lmtracer.lightmapMono[laddr] += add;
-          lmtracer.lightmapr[laddr] += add*rmul;
-          lmtracer.lightmapg[laddr] += add*gmul;
-          lmtracer.lightmapb[laddr] += add*bmul;
+          tracer.lightmapMono[laddr] += add;
+          tracer.lightmapr[laddr] += add*rmul;
+          tracer.lightmapg[laddr] += add*gmul;
+          tracer.lightmapb[laddr] += add*bmul;
           // ignore really tiny lights
-          if (lmtracer.lightmapMono[laddr] > 1) {
+          if (tracer.lightmapMono[laddr] > 1) {
             lmi.light_hit = true;
-            if (light->color != 0xffffffff) lmtracer.isColored = true;
+            if (light->color != 0xffffffff) tracer.isColored = true;
           }
-          lmtracer.lightmapHit[laddr] = 1;
+          tracer.lightmapHit[laddr] = 1;
           if (r_lmap_filtering == 2) goto again;
         }
       }
@@ -788,12 +790,66 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
   const bool accountTime = (lmapStaticRecalcTimeLeft > 0);
   double stt = (accountTime ? -Sys_Time() : 0.0);
 
+  LightFacePrepare(surf);
+  LightFaceCompute(surf, lmtracer, nullptr);
+
+  if (accountTime) {
+    stt += Sys_Time();
+    if ((lmapStaticRecalcTimeLeft -= stt) <= 0) lmapStaticRecalcTimeLeft = 0;
+  }
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::LightFacePrepare
+//
+//  update visible surface lists for non-shadowing static lights
+//  this uses the BSP collector, so it cannot be done in worker threads
+//
+//==========================================================================
+void VRenderLevelLightmap::LightFacePrepare (surface_t *surf) {
+  if (!r_static_lights) return;
+  if (surf->subsector->isAnyPObj()) return;
+  const int snum = (int)(ptrdiff_t)(surf->subsector-&Level->Subsectors[0]);
+  if (snum < 0 || snum >= SubStaticLights.length()) return;
+  SubStaticLigtInfo *sli = SubStaticLights.ptr()+snum;
+  for (auto it : sli->touchedStatic.first()) {
+    light_t *stl = &Lights[it.getKey()];
+    if (stl->radius <= 2.0f) continue;
+    if ((stl->flags&(dlight_t::NoShadow|dlight_t::NoGeoClip)) != dlight_t::NoShadow) continue;
+    if (stl->litSurfacesValidFrame == updateWorldFrame) continue;
+    //GCon->Logf(NAME_Debug, "updating static light #%d (frm=%u)", it.getKey(), updateWorldFrame);
+    stl->litSurfacesValidFrame = updateWorldFrame;
+    // `CurrLightPos` and `CurrLightRadius` should be set
+    CurrLightPos = stl->origin;
+    CurrLightRadius = stl->radius;
+    CurrLightNoGeoClip = false;
+    stl->litSurfaces.reset();
+    CollectRegLightSurfaces(stl->litSurfaces);
+    //GCon->Logf(NAME_Debug, "updated static light #%d (frm=%u); %d surfaces found", it.getKey(), updateWorldFrame, stl->litSurfaces.length());
+  }
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::LightFaceCompute
+//
+//  calculates static lightmap for a surface
+//  `LightFacePrepare()` should be called first
+//  can be called from worker threads (with `traceCtx` set)
+//
+//==========================================================================
+void VRenderLevelLightmap::LightFaceCompute (surface_t *surf, LightmapTracer &tracer, VLevel::LightTraceContext *traceCtx) {
   LMapTraceInfo lmi;
   //lmi.points_calculated = false;
   vassert(!lmi.pointsCalced);
 
   lmi.light_hit = false;
-  lmtracer.isColored = false;
+  lmi.tracer = &tracer;
+  lmi.traceCtx = traceCtx;
+  tracer.isColored = false;
 
   CalcMinMaxs(lmi, surf);
 
@@ -814,19 +870,8 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
           //FIXME: make this faster!
           const bool doCastRay = !(stl->flags&dlight_t::NoShadow);
           if (!doCastRay && !surf->subsector->isAnyPObj()) {
-            // check if this surface is visible
+            // check if this surface is visible (the list is updated in `LightFacePrepare()`)
             if ((stl->flags&dlight_t::NoGeoClip) == 0) {
-              if (stl->litSurfacesValidFrame != updateWorldFrame) {
-                //GCon->Logf(NAME_Debug, "updating static light #%d (frm=%u)", it.getKey(), updateWorldFrame);
-                stl->litSurfacesValidFrame = updateWorldFrame;
-                // `CurrLightPos` and `CurrLightRadius` should be set
-                CurrLightPos = stl->origin;
-                CurrLightRadius = stl->radius;
-                CurrLightNoGeoClip = false;
-                stl->litSurfaces.reset();
-                CollectRegLightSurfaces(stl->litSurfaces);
-                //GCon->Logf(NAME_Debug, "updated static light #%d (frm=%u); %d surfaces found", it.getKey(), updateWorldFrame, stl->litSurfaces.length());
-              }
               if (!stl->litSurfaces.has(surf)) continue;
             }
           }
@@ -840,10 +885,6 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
   if (!lmi.light_hit) {
     // no light hit it, no need to have lightmaps
     surf->FreeLightmaps();
-    if (accountTime) {
-      stt += Sys_Time();
-      if ((lmapStaticRecalcTimeLeft -= stt) <= 0) lmapStaticRecalcTimeLeft = 0;
-    }
     return;
   }
 
@@ -854,16 +895,16 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
 
   // if the surface already has a static lightmap, we will reuse it,
   // otherwise we must allocate a new one
-  if (lmtracer.isColored) {
+  if (tracer.isColored) {
     // need colored lightmap
     int sz = w*h*(int)sizeof(surf->lightmap_rgb[0]);
     surf->ReserveRGBLightmap(sz);
 
     if (!lmi.didExtra) {
       if (w*h <= MaxSurfPoints) {
-        FilterLightmap(lmtracer.lightmapr, w, h);
-        FilterLightmap(lmtracer.lightmapg, w, h);
-        FilterLightmap(lmtracer.lightmapb, w, h);
+        FilterLightmap(tracer.lightmapr, w, h, tracer.filterTemp);
+        FilterLightmap(tracer.lightmapg, w, h, tracer.filterTemp);
+        FilterLightmap(tracer.lightmapb, w, h, tracer.filterTemp);
       } else {
         GCon->Logf(NAME_Warning, "skipped filter for lightmap of size %dx%d", w, h);
       }
@@ -879,25 +920,25 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
         float total;
         if (lmi.didExtra) {
           // filtered sample
-          FILTER_LMAP_EXTRA(lmtracer.lightmapr);
+          FILTER_LMAP_EXTRA(tracer.lightmapr);
         } else {
-          total = lmtracer.lightmapr[i];
+          total = tracer.lightmapr[i];
         }
         surf->lightmap_rgb[i].r = clampToByte((int)total);
 
         if (lmi.didExtra) {
           // filtered sample
-          FILTER_LMAP_EXTRA(lmtracer.lightmapg);
+          FILTER_LMAP_EXTRA(tracer.lightmapg);
         } else {
-          total = lmtracer.lightmapg[i];
+          total = tracer.lightmapg[i];
         }
         surf->lightmap_rgb[i].g = clampToByte((int)total);
 
         if (lmi.didExtra) {
           // filtered sample
-          FILTER_LMAP_EXTRA(lmtracer.lightmapb);
+          FILTER_LMAP_EXTRA(tracer.lightmapb);
         } else {
-          total = lmtracer.lightmapb[i];
+          total = tracer.lightmapb[i];
         }
         surf->lightmap_rgb[i].b = clampToByte((int)total);
       }
@@ -914,7 +955,7 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
 
     if (!lmi.didExtra) {
       if (w*h <= MaxSurfPoints) {
-        FilterLightmap(lmtracer.lightmapMono, w, h);
+        FilterLightmap(tracer.lightmapMono, w, h, tracer.filterTemp);
       } else {
         GCon->Logf(NAME_Warning, "skipped filter for lightmap of size %dx%d", w, h);
       }
@@ -930,19 +971,186 @@ void VRenderLevelLightmap::LightFace (surface_t *surf) {
         float total;
         if (lmi.didExtra) {
           // filtered sample
-          FILTER_LMAP_EXTRA(lmtracer.lightmapMono);
+          FILTER_LMAP_EXTRA(tracer.lightmapMono);
         } else {
-          total = lmtracer.lightmapMono[i];
+          total = tracer.lightmapMono[i];
         }
         surf->lightmap[i] = clampToByte((int)total);
       }
     }
   }
 
-  if (accountTime) {
-    stt += Sys_Time();
-    if ((lmapStaticRecalcTimeLeft -= stt) <= 0) lmapStaticRecalcTimeLeft = 0;
+}
+
+
+//**************************************************************************
+//**
+//**  PARALLEL STATIC LIGHTMAP BAKER
+//**
+//**************************************************************************
+
+struct LightBakeJob {
+  VRenderLevelLightmap *rdr;
+  surface_t **surfs;
+  VRenderLevelLightmap::LightmapTracer **tracers;
+  VLevel::LightTraceContext **traceCtx;
+};
+
+
+//==========================================================================
+//
+//  lightBakeBatch
+//
+//==========================================================================
+static void lightBakeBatch (void *udata, int start, int end, int worker) {
+  VPROF_ZONE("light", "lightBakeBatch");
+  LightBakeJob *job = (LightBakeJob *)udata;
+  for (int f = start; f < end; ++f) {
+    job->rdr->LightFaceCompute(job->surfs[f], *job->tracers[worker], job->traceCtx[worker]);
+  }
+}
+
+
+//==========================================================================
+//
+//  precacheTraceTexture
+//
+//==========================================================================
+static inline void precacheTraceTexture (int texid) {
+  if (texid <= 0) return;
+  VTexture *tex = GTextureManager.getIgnoreAnim(texid);
+  if (tex && tex->Type != TEXTYPE_Null) (void)tex->GetPixels();
+  tex = GTextureManager(texid);
+  if (tex && tex->Type != TEXTYPE_Null) (void)tex->GetPixels();
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::PrecacheLightTraceTextures
+//
+//==========================================================================
+void VRenderLevelLightmap::PrecacheLightTraceTextures () {
+  if (!r_lmap_texture_check_static.asBool()) return;
+  for (auto &&side : Level->allSides()) {
+    precacheTraceTexture(side.MidTexture);
+    precacheTraceTexture(side.TopTexture);
+  }
+  for (auto &&sec : Level->allSectors()) {
+    precacheTraceTexture(sec.floor.pic);
+    precacheTraceTexture(sec.ceiling.pic);
+  }
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::FreeLightBakers
+//
+//==========================================================================
+void VRenderLevelLightmap::FreeLightBakers () {
+  for (auto &&tr : lmBakeTracers) delete tr;
+  for (auto &&ctx : lmBakeTraceCtx) VLevel::DeleteLightTraceContext(ctx);
+  lmBakeTracers.clear();
+  lmBakeTraceCtx.clear();
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::LightFacesParallel
+//
+//  `surfs` array will be modified (surfaces without static lights are
+//  removed from it). the surfaces should be unique.
+//
+//==========================================================================
+void VRenderLevelLightmap::LightFacesParallel (surface_t **surfs, int count) {
+  if (!surfs || count <= 0) return;
+  VPROF_ZONE("light", "LightFacesParallel");
+
+  // main thread part
+  int jobCount = 0;
+  for (int f = 0; f < count; ++f) {
+    surface_t *surf = surfs[f];
+    if (!surf) continue;
+    surf->drawflags &= ~surface_t::DF_CALC_LMAP;
+    if (surf->count < 3 || !CanFaceBeStaticallyLit(surf)) {
+      surf->FreeLightmaps(); // just in case
+      continue;
+    }
+    LightFacePrepare(surf);
+    surfs[jobCount++] = surf;
+  }
+  if (jobCount == 0) return;
+
+  const int tcount = VWorkPool::GetThreadCount();
+  // BSP tracer uses global validcount
+  if (jobCount < 2 || tcount < 2 || !r_lmap_bake_parallel.asBool() || r_lmap_bsp_trace_static.asBool()) {
+    for (int f = 0; f < jobCount; ++f) LightFaceCompute(surfs[f], lmtracer, nullptr);
+    return;
+  }
+
+  // lazy texture loading is not thread-safe
+  PrecacheLightTraceTextures();
+
+  while (lmBakeTracers.length() < tcount) {
+    lmBakeTracers.append(new LightmapTracer);
+    lmBakeTraceCtx.append(Level->NewLightTraceContext());
+  }
+
+  LightBakeJob job;
+  job.rdr = this;
+  job.surfs = surfs;
+  job.tracers = lmBakeTracers.ptr();
+  job.traceCtx = lmBakeTraceCtx.ptr();
+  VWorkPool::ParallelFor(jobCount, 2, &lightBakeBatch, &job);
+}
+
+
+//==========================================================================
+//
+//  VRenderLevelLightmap::ProcessRelightList
+//
+//  bake surfaces queued by `QueueWorldSurface()`
+//  unprocessed surfaces will be requeued on the next frame
+//
+//==========================================================================
+void VRenderLevelLightmap::ProcessRelightList () {
+  const int total = LMRelightList.length();
+  if (total == 0) return;
+  VPROF_ZONE("light", "ProcessRelightList");
+
+  const int chunk = max2(8, VWorkPool::GetThreadCount()*4);
+  int done = 0;
+  while (done < total && !IsStaticLightmapTimeLimitExpired()) {
+    const int count = min2(chunk, total-done);
+    const bool accountTime = (lmapStaticRecalcTimeLeft > 0);
+    double stt = (accountTime ? -Sys_Time() : 0.0);
+    for (int f = 0; f < count; ++f) {
+      surface_t *surf = LMRelightList[done+f];
+      if (surf->CacheSurf) FreeSurfCache(surf->CacheSurf);
+    }
+    LightFacesParallel(LMRelightList.ptr()+done, count);
+    done += count;
+    if (accountTime) {
+      stt += Sys_Time();
+      if ((lmapStaticRecalcTimeLeft -= stt) <= 0) lmapStaticRecalcTimeLeft = 0;
+    }
   }
+  for (int f = done; f < total; ++f) LMRelightList[f]->drawflags |= surface_t::DF_CALC_LMAP;
+  LMRelightList.reset();
+
+  // surfaces without lightmaps should be rendered as normal ones
+  int dest = 0;
+  for (int f = 0; f < LMSurfList.length(); ++f) {
+    surface_t *surf = LMSurfList[f];
+    if (!surf->lightmap && surf->dlightframe != currDLightFrame) {
+      QueueSimpleSurf(surf);
+    } else {
+      LMSurfList[dest++] = surf;
+    }
+  }
+  LMSurfList.setLengthNoResize(dest);
 }
 
 
@@ -1607,6 +1815,9 @@ bool VRenderLevelLightmap::BuildSurfaceLightmap (surface_t *surface) {
 //
 //==========================================================================
 void VRenderLevelLightmap::ProcessCachedSurfaces () {
+  // recalc static lightmaps first, this can remove some surfaces from the list
+  ProcessRelightList();
+
   if (LMSurfList.length() == 0) return; // nothing to do here
 
   if (nukeLightmapsOnNextFrame) {
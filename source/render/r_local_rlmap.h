@@ -47,6 +47,10 @@ public:
 // ////////////////////////////////////////////////////////////////////////// //
 // lightmapped renderer
 class VRenderLevelLightmap : public VRenderLevelShared {
+public:
+  // per-thread lightmap accumulators (defined in "r_light_reg.cpp")
+  struct LightmapTracer;
+
 private:
   // light chain bookkeeping
   struct LCEntry {
@@ -73,6 +77,12 @@ private:
   // list of all surfaces with lightmaps; used only in `ProcessCachedSurfaces()`
   // surfaces from this list will be put either to lightmap chains, or to normal lists
   TArrayNC<surface_t *> LMSurfList;
+  // surfaces queued for static lightmap recalc by the BSP renderer
+  // they are baked in parallel in `ProcessCachedSurfaces()`
+  TArrayNC<surface_t *> LMRelightList;
+  // per-worker state for the parallel baker (allocated on demand)
+  TArrayNC<LightmapTracer *> lmBakeTracers;
+  TArrayNC<VLevel::LightTraceContext *> lmBakeTraceCtx;
   bool nukeLightmapsOnNextFrame;
 
   bool invalidateRelight;
@@ -116,6 +126,9 @@ public:
     bool spotLight;
     float coneAngle;
     TVec coneDir;
+    // accumulators and ray tracing context for the current thread
+    LightmapTracer *tracer;
+    VLevel::LightTraceContext *traceCtx; // `nullptr` means "use global validcount"
 
   public:
     VV_DISABLE_COPY(LMapTraceInfo)
@@ -194,7 +207,8 @@ protected:
   // cast light ray
   // returns `false` if cannot reach
   //   `dist` will be set to distance (zero means "too far away"); can be `nullptr`
-  bool CastStaticRay (float *dist, const subsector_t *srcsubsector, const TVec &p1, const subsector_t *destsubsector, const TVec &p2, const float squaredist, const bool allowTextureCheck);
+  //   `traceCtx` must be set when called from a worker thread
+  bool CastStaticRay (float *dist, const subsector_t *srcsubsector, const TVec &p1, const subsector_t *destsubsector, const TVec &p2, const float squaredist, const bool allowTextureCheck, VLevel::LightTraceContext *traceCtx=nullptr);
   static void CalcMinMaxs (LMapTraceInfo &lmi, const surface_t *surf);
   static bool CalcFaceVectors (LMapTraceInfo &lmi, const surface_t *surf);
   void CalcPoints (LMapTraceInfo &lmi, const surface_t *surf, bool lowres); // for dynlights, set `lowres` to `true`
@@ -214,6 +228,13 @@ protected:
 
   void RelightMap (bool recalcNow, bool onlyMarked);
 
+  // loads pixels for all textures that can be checked by the static light tracer
+  // (lazy texture loading is not thread-safe)
+  void PrecacheLightTraceTextures ();
+  // processes `LMRelightList`, respecting the time limit
+  void ProcessRelightList ();
+  void FreeLightBakers ();
+
   // used to check surface visibility for non-shadowing static lights
   // we can collect surfaces for lighting and shadowing in one pass
   // don't forget to reset `shadowSurfaces` and `lightSurfaces`
@@ -241,8 +262,19 @@ public:
   // you can use `surf->NeedRecalcStaticLightmap()` to check success
   void LightFaceTimeCheckedFreeCaches (surface_t *surf);
 
+  // `LightFace()` is split to these two parts for the parallel baker
+  // main thread part: updates visible surface lists for non-shadowing lights
+  void LightFacePrepare (surface_t *surf);
+  // this can be called from worker threads; doesn't touch anything except `surf` lightmaps
+  void LightFaceCompute (surface_t *surf, LightmapTracer &tracer, VLevel::LightTraceContext *traceCtx);
+
+  // bakes static lightmaps for the given surfaces, using the worker pool
+  // doesn't do any time accounting
+  void LightFacesParallel (surface_t **surfs, int count);
+
 public:
   VRenderLevelLightmap (VLevel *);
+  ~VRenderLevelLightmap ();
 
   virtual void PreRender () override;
 
@@ -251,7 +283,7 @@ public:
   virtual void ResetLightmaps (bool recalcNow) override;
 
   virtual bool isNeedLightmapCache () const noexcept override;
-  virtual void saveLightmaps (VStream *strm) override;
+  virtual void saveLightmaps (VStream *strm, bool packed=true) override;
   virtual bool loadLightmaps (VStream *strm) override;
 
 private:
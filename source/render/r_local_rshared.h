@@ -195,6 +195,7 @@ protected:
   bool CurrLightNoGeoClip;
   TVec CurrLightUnstuckPos; // set in `CalcLightVis()` if `CurrLightCalcUnstuck` is `true`
   vuint32 CurrLightBit; // tag (bitor) subsectors with this in lightvis builder
+  const vuint8 *CurrLightPVS; // level PVS row for the light subsector, set in `CalcLightVis()`; can be `nullptr`
 
   // for spotlights
   bool CurrLightSpot; // is current light a spotlight?
@@ -1158,7 +1159,7 @@ public:
   virtual bool IsShadowMapRenderer () const noexcept override;
 
   virtual bool isNeedLightmapCache () const noexcept override;
-  virtual void saveLightmaps (VStream *strm) override;
+  virtual void saveLightmaps (VStream *strm, bool packed=true) override;
   virtual bool loadLightmaps (VStream *strm) override;
 
 public: // automap
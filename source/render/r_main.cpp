@@ -2681,7 +2681,7 @@ bool VRenderLevelShared::isNeedLightmapCache () const noexcept {
 //  VRenderLevelShared::saveLightmaps
 //
 //==========================================================================
-void VRenderLevelShared::saveLightmaps (VStream * /*strm*/) {
+void VRenderLevelShared::saveLightmaps (VStream * /*strm*/, bool /*packed*/) {
 }
 
 
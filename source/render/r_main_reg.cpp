@@ -131,6 +131,16 @@ VRenderLevelLightmap::VRenderLevelLightmap (VLevel *ALevel)
 }
 
 
+//==========================================================================
+//
+//  VRenderLevelLightmap::~VRenderLevelLightmap
+//
+//==========================================================================
+VRenderLevelLightmap::~VRenderLevelLightmap () {
+  FreeLightBakers();
+}
+
+
 //==========================================================================
 //
 //  VRenderLevelLightmap::releaseAtlas
@@ -163,6 +173,7 @@ void VRenderLevelLightmap::allocAtlas (vuint32 aid) noexcept {
 void VRenderLevelLightmap::ClearQueues () {
   VRenderLevelShared::ClearQueues();
   LMSurfList.reset();
+  LMRelightList.reset();
   advanceCacheFrame();
 }
 
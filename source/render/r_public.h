@@ -121,7 +121,8 @@ public:
   virtual void FullWorldUpdate (bool forceClientOrigin) = 0;
 
   virtual bool isNeedLightmapCache () const noexcept = 0;
-  virtual void saveLightmaps (VStream *strm) = 0;
+  // `packed`: compress data with zlib (the cache store compresses entries by itself)
+  virtual void saveLightmaps (VStream *strm, bool packed=true) = 0;
   virtual bool loadLightmaps (VStream *strm) = 0;
 
   // `dflags` is `VDrawer::ELFlag_XXX` set
@@ -24,17 +24,22 @@
 //**
 //**************************************************************************
 #include "../gamedefs.h"
+#include "../mapinfo.h"
 #include "../text.h"
 #include "../server/server.h"
 #include "../client/client.h"
+#include "../filesys/cachestore.h"
 #include "r_local.h"
 
 
 // ////////////////////////////////////////////////////////////////////////// //
 static int constexpr cestlen (const char *s, int pos=0) noexcept { return (s && s[pos] ? 1+cestlen(s, pos+1) : 0); }
 static constexpr const char *LMAP_CACHE_DATA_SIGNATURE = "VAVOOM CACHED LMAP VERSION 002.\n";
+// unpacked data, used for cache store entries
+static constexpr const char *LMAP_CACHE_DATA_SIGNATURE_RAW = "VAVOOM CACHED LMAP VERSION 002R\n";
 enum { CDSLEN = cestlen(LMAP_CACHE_DATA_SIGNATURE) };
 static_assert(CDSLEN == 32, "oops!");
+static_assert(cestlen(LMAP_CACHE_DATA_SIGNATURE_RAW) == CDSLEN, "oops!");
 
 
 // ////////////////////////////////////////////////////////////////////////// //
@@ -55,6 +60,12 @@ static VCvarB dbg_cache_lightmap_dump_missing("dbg_cache_lightmap_dump_missing",
 // ////////////////////////////////////////////////////////////////////////// //
 extern int light_mem;
 
+// offline lightmap baker state (see `LightmapCacheBake` command)
+static TArray<VName> lmapBakeQueue; // maps left to bake
+static bool lmapBakeActive = false; // force relight and cache writing in `PreRender()`
+static int lmapBakeCount = 0;
+static double lmapBakeTime = 0.0;
+
 
 //**************************************************************************
 //
@@ -391,8 +402,13 @@ void VRenderLevelLightmap::saveLightmapsInternal (VStream *strm) {
 //  VRenderLevelLightmap::saveLightmaps
 //
 //==========================================================================
-void VRenderLevelLightmap::saveLightmaps (VStream *strm) {
+void VRenderLevelLightmap::saveLightmaps (VStream *strm, bool packed) {
   if (!strm) return;
+  if (!packed) {
+    strm->Serialise(LMAP_CACHE_DATA_SIGNATURE_RAW, CDSLEN);
+    saveLightmapsInternal(strm);
+    return;
+  }
   strm->Serialise(LMAP_CACHE_DATA_SIGNATURE, CDSLEN);
   VZLibStreamWriter *zipstrm = new VZLibStreamWriter(strm, (int)loader_cache_compression_level_lightmap);
   saveLightmapsInternal(zipstrm);
@@ -728,12 +744,21 @@ bool VRenderLevelLightmap::loadLightmaps (VStream *strm) {
   }
   char sign[CDSLEN];
   strm->Serialise(sign, CDSLEN);
-  if (strm->IsError() || memcmp(sign, LMAP_CACHE_DATA_SIGNATURE, CDSLEN) != 0) {
+  bool packed = true;
+  if (!strm->IsError() && memcmp(sign, LMAP_CACHE_DATA_SIGNATURE_RAW, CDSLEN) == 0) {
+    packed = false;
+  } else if (strm->IsError() || memcmp(sign, LMAP_CACHE_DATA_SIGNATURE, CDSLEN) != 0) {
     GCon->Logf(NAME_Error, "invalid lightmap cache file signature");
     lmcacheUnknownSurfaceCount = CountAllSurfaces();
     return false;
   }
   lmcacheUnknownSurfaceCount = 0;
+  if (!packed) {
+    bool ok = loadLightmapsInternal(strm);
+    if (!ok && !lmcacheUnknownSurfaceCount) lmcacheUnknownSurfaceCount = CountAllSurfaces();
+    if (ok && lmcacheUnknownSurfaceCount > 0 && lmcacheUnknownSurfaceCount == CountAllSurfaces()) ok = false; // totally wrong
+    return ok;
+  }
   /*VZLibStreamReader*/VStream *zipstrm = new VZLibStreamReader(true, strm, VZLibStreamReader::UNKNOWN_SIZE, VZLibStreamReader::UNKNOWN_SIZE/*Map->DecompressedSize*/);
   bool ok = loadLightmapsInternal(zipstrm);
   VStream::Destroy(zipstrm);
@@ -743,25 +768,75 @@ bool VRenderLevelLightmap::loadLightmaps (VStream *strm) {
 }
 
 
+//==========================================================================
+//
+//  WriteLightmapCache
+//
+//  returns `false` on error
+//  with `toStore`, `ccfname` is a cache store entry name
+//
+//==========================================================================
+static bool WriteLightmapCache (VRenderLevelPublic *rdr, VStr ccfname, bool toStore) {
+  if (toStore) {
+    GCon->Logf("writing lightmap cache to '%s'", *ccfname);
+    VMemoryStream *lmc = new VMemoryStream(ccfname);
+    rdr->saveLightmaps(lmc, false);
+    bool err = lmc->IsError();
+    if (!err) err = !VCacheStore::Write(ccfname, lmc);
+    delete lmc;
+    if (err) {
+      GCon->Logf(NAME_Warning, "cannot write lightmap cache '%s'", *ccfname);
+      VCacheStore::Remove(ccfname);
+      return false;
+    }
+    return true;
+  }
+
+  VStream *lmc = FL_OpenSysFileWrite(ccfname);
+  if (!lmc) {
+    GCon->Logf(NAME_Warning, "cannot create lightmap cache file '%s'", *ccfname);
+    return false;
+  }
+  GCon->Logf("writing lightmap cache to '%s'", *ccfname);
+  rdr->saveLightmaps(lmc);
+  bool err = lmc->IsError();
+  lmc->Close();
+  err = (err || lmc->IsError());
+  delete lmc;
+  if (err) {
+    GCon->Logf(NAME_Warning, "removed broken lightmap cache '%s'", *ccfname);
+    Sys_FileDelete(ccfname);
+    return false;
+  }
+  return true;
+}
+
+
 //**************************************************************************
 //
 // calculate static lightmaps
 //
 //**************************************************************************
 
+// static lightmaps are baked in chunks of this size
+enum { LightBakeChunk = 1024 };
+
+
 //==========================================================================
 //
 //  LightSurfaces
 //
+//  with `recalcNow`, surfaces are appended to `list`, and baked later
+//
 //==========================================================================
-static int LightSurfaces (VRenderLevelLightmap *rdr, surface_t *s, bool recalcNow, bool onlyMarked) {
+static int LightSurfaces (TArrayNC<surface_t *> &list, surface_t *s, bool recalcNow, bool onlyMarked) {
   int res = 0;
   if (recalcNow) {
     for (; s; s = s->next) {
       ++res;
       if (onlyMarked && (s->drawflags&surface_t::DF_CALC_LMAP) == 0) continue;
       s->drawflags &= ~surface_t::DF_CALC_LMAP;
-      if (s->count >= 3) rdr->LightFace(s);
+      if (s->count >= 3) list.append(s);
     }
   } else {
     for (; s; s = s->next) {
@@ -783,19 +858,32 @@ static int LightSurfaces (VRenderLevelLightmap *rdr, surface_t *s, bool recalcNo
 //  LightSegSurfaces
 //
 //==========================================================================
-static int LightSegSurfaces (VRenderLevelLightmap *rdr, segpart_t *sp, bool recalcNow, bool onlyMarked) {
+static int LightSegSurfaces (TArrayNC<surface_t *> &list, segpart_t *sp, bool recalcNow, bool onlyMarked) {
   int res = 0;
-  for (; sp; sp = sp->next) res += LightSurfaces(rdr, sp->surfs, recalcNow, onlyMarked);
+  for (; sp; sp = sp->next) res += LightSurfaces(list, sp->surfs, recalcNow, onlyMarked);
   return res;
 }
 
 
+//==========================================================================
+//
+//  BakeSurfaces
+//
+//==========================================================================
+static void BakeSurfaces (VRenderLevelLightmap *rdr, TArrayNC<surface_t *> &list, bool force) {
+  if (list.length() == 0 || (!force && list.length() < LightBakeChunk)) return;
+  rdr->LightFacesParallel(list.ptr(), list.length());
+  list.reset();
+}
+
+
 //==========================================================================
 //
 //  VRenderLevelLightmap::RelightMap
 //
 //==========================================================================
 void VRenderLevelLightmap::RelightMap (bool recalcNow, bool onlyMarked) {
+  VPROF_ZONE("light", "RelightMap");
   vuint32 surfCount = 0;
 
   if (recalcNow) {
@@ -804,29 +892,38 @@ void VRenderLevelLightmap::RelightMap (bool recalcNow, bool onlyMarked) {
     R_PBarUpdate("Lightmaps", 0, (int)surfCount);
   }
 
+  TArrayNC<surface_t *> list;
   int processed = 0;
   for (auto &&sub : Level->allSubsectors()) {
     for (subregion_t *r = sub.regions; r != nullptr; r = r->next) {
-      if (r->realfloor != nullptr) processed += LightSurfaces(this, r->realfloor->surfs, recalcNow, onlyMarked);
-      if (r->realceil != nullptr) processed += LightSurfaces(this, r->realceil->surfs, recalcNow, onlyMarked);
-      if (r->fakefloor != nullptr) processed += LightSurfaces(this, r->fakefloor->surfs, recalcNow, onlyMarked);
-      if (r->fakeceil != nullptr) processed += LightSurfaces(this, r->fakeceil->surfs, recalcNow, onlyMarked);
+      if (r->realfloor != nullptr) processed += LightSurfaces(list, r->realfloor->surfs, recalcNow, onlyMarked);
+      if (r->realceil != nullptr) processed += LightSurfaces(list, r->realceil->surfs, recalcNow, onlyMarked);
+      if (r->fakefloor != nullptr) processed += LightSurfaces(list, r->fakefloor->surfs, recalcNow, onlyMarked);
+      if (r->fakeceil != nullptr) processed += LightSurfaces(list, r->fakeceil->surfs, recalcNow, onlyMarked);
+    }
+    if (recalcNow) {
+      BakeSurfaces(this, list, false);
+      R_PBarUpdate("Lightmaps", processed, (int)surfCount);
     }
-    if (recalcNow) R_PBarUpdate("Lightmaps", processed, (int)surfCount);
   }
 
   for (auto &&seg : Level->allSegs()) {
     drawseg_t *ds = seg.drawsegs;
     if (ds) {
-      processed += LightSegSurfaces(this, ds->top, recalcNow, onlyMarked);
-      processed += LightSegSurfaces(this, ds->mid, recalcNow, onlyMarked);
-      processed += LightSegSurfaces(this, ds->bot, recalcNow, onlyMarked);
-      processed += LightSegSurfaces(this, ds->topsky, recalcNow, onlyMarked);
-      processed += LightSegSurfaces(this, ds->extra, recalcNow, onlyMarked);
-      if (recalcNow) R_PBarUpdate("Lightmaps", processed, (int)surfCount);
+      processed += LightSegSurfaces(list, ds->top, recalcNow, onlyMarked);
+      processed += LightSegSurfaces(list, ds->mid, recalcNow, onlyMarked);
+      processed += LightSegSurfaces(list, ds->bot, recalcNow, onlyMarked);
+      processed += LightSegSurfaces(list, ds->topsky, recalcNow, onlyMarked);
+      processed += LightSegSurfaces(list, ds->extra, recalcNow, onlyMarked);
+      if (recalcNow) {
+        BakeSurfaces(this, list, false);
+        R_PBarUpdate("Lightmaps", processed, (int)surfCount);
+      }
     }
   }
 
+  BakeSurfaces(this, list, true);
+
   if (recalcNow) R_PBarUpdate("Lightmaps", (int)surfCount, (int)surfCount, true);
 }
 
@@ -863,7 +960,14 @@ void VRenderLevelLightmap::PreRender () {
   Level->cacheFlags &= ~VLevel::CacheFlag_Ignore;
 
   bool doPrecalc = (r_precalc_static_lights_override >= 0 ? !!r_precalc_static_lights_override : r_precalc_static_lights);
+  if (lmapBakeActive) {
+    // offline baker: always relight, and always write the cache
+    doPrecalc = true;
+    doReadCache = false;
+    doWriteCache = !Level->cacheFileBase.isEmpty();
+  }
   VStr ccfname = (Level->cacheFileBase.isEmpty() ? VStr::EmptyString : Level->cacheFileBase+".lmap");
+  const bool inStore = ((Level->cacheFlags&VLevel::CacheFlag_Store) != 0);
   if (ccfname.isEmpty()) { doReadCache = doWriteCache = false; }
   if (!doPrecalc) doWriteCache = false;
 
@@ -874,12 +978,14 @@ void VRenderLevelLightmap::PreRender () {
 
     bool recalcLight = true;
     if (doReadCache) {
-      VStream *lmc = FL_OpenSysFileRead(ccfname);
+      VStream *lmc = (inStore ? VCacheStore::OpenRead(ccfname) : FL_OpenSysFileRead(ccfname));
       if (lmc) {
         recalcLight = !loadLightmaps(lmc);
         if (lmc->IsError()) recalcLight = true;
         VStream::Destroy(lmc);
-        if (recalcLight) {
+        if (inStore) {
+          if (recalcLight) VCacheStore::Remove(ccfname);
+        } else if (recalcLight) {
           Sys_FileDelete(ccfname);
         } else {
           // touch cache file, so it will survive longer
@@ -902,21 +1008,10 @@ void VRenderLevelLightmap::PreRender () {
       if (doWriteCache) {
         const float tlim = loader_cache_time_limit_lightmap.asFloat();
         // if our lightmap cache is partially valid, rewrite it unconditionally
-        if (dbg_cache_lightmap_always || lmcacheUnknownSurfaceCount || stt >= tlim) {
-          VStream *lmc = FL_OpenSysFileWrite(ccfname);
-          if (lmc) {
-            GCon->Logf("writing lightmap cache to '%s'", *ccfname);
-            saveLightmaps(lmc);
-            bool err = lmc->IsError();
-            lmc->Close();
-            err = (err || lmc->IsError());
-            delete lmc;
-            if (err) {
-              GCon->Logf(NAME_Warning, "removed broken lightmap cache '%s'", *ccfname);
-              Sys_FileDelete(ccfname);
-            }
-          } else {
-            GCon->Logf(NAME_Warning, "cannot create lightmap cache file '%s'", *ccfname);
+        if (lmapBakeActive || dbg_cache_lightmap_always || lmcacheUnknownSurfaceCount || stt >= tlim) {
+          if (WriteLightmapCache(this, ccfname, inStore) && lmapBakeActive) {
+            ++lmapBakeCount;
+            lmapBakeTime += stt;
           }
         }
       }
@@ -928,6 +1023,18 @@ void VRenderLevelLightmap::PreRender () {
   GCon->Logf("%d subdivides", c_subdivides);
   GCon->Logf("%d seg subdivides", c_seg_div);
   GCon->Logf("%dk light mem", light_mem/1024);
+
+  // offline baker: load the next map
+  if (lmapBakeActive) {
+    if (lmapBakeQueue.length()) {
+      VName mapname = lmapBakeQueue[0];
+      lmapBakeQueue.removeAt(0);
+      GCmdBuf << "map \"" << VStr(*mapname).quote() << "\"\n";
+    } else {
+      lmapBakeActive = false;
+      GCon->Logf("lightmap baking complete: %d map%s baked in %d.%d seconds", lmapBakeCount, (lmapBakeCount != 1 ? "s" : ""), (int)lmapBakeTime, (int)(lmapBakeTime*1000)%1000);
+    }
+  }
 }
 
 
@@ -969,3 +1076,65 @@ COMMAND_AC(LightmapsReset) {
   list.append("defer");
   return AutoCompleteFromListCmd(prefix, list);
 }
+
+
+//==========================================================================
+//
+//  COMMAND LightmapCacheBake
+//
+//  LightmapCacheBake         -- rebake current map, and write its cache
+//  LightmapCacheBake all     -- load and bake all known maps
+//  LightmapCacheBake map...  -- load and bake the given maps
+//
+//  the lightmapped renderer lives in the client, so the maps are loaded
+//  with the usual `map` command, and baked in `PreRender()`
+//
+//==========================================================================
+COMMAND_WITH_AC(LightmapCacheBake) {
+  if (Args.length() < 2) {
+    if (!GClLevel || !GClLevel->Renderer) { GCon->Log("no map loaded"); return; }
+    if (!GClLevel->Renderer->isNeedLightmapCache()) { GCon->Log("current renderer doesn't use lightmaps"); return; }
+    if (GClLevel->cacheFileBase.isEmpty()) { GCon->Log("lightmap cache is not available for this map"); return; }
+    GCon->Log("baking lightmaps");
+    double stt = -Sys_Time();
+    GClLevel->Renderer->ResetLightmaps(true);
+    stt += Sys_Time();
+    GCon->Logf("static lighting calculated in %d.%d seconds (%s mode)", (int)stt, (int)(stt*1000)%1000, (r_lmap_bsp_trace_static ? "BSP" : "blockmap"));
+    (void)WriteLightmapCache(GClLevel->Renderer, GClLevel->cacheFileBase+".lmap", ((GClLevel->cacheFlags&VLevel::CacheFlag_Store) != 0));
+    GClLevel->Renderer->NukeLightmapCache();
+    return;
+  }
+
+  if (!loader_cache_data.asBool()) { GCon->Log("loader cache is disabled (see `loader_cache_data`)"); return; }
+
+  lmapBakeQueue.clear();
+  if (Args.length() == 2 && Args[1].strEquCI("all")) {
+    for (int f = 0; f < P_GetNumMaps(); ++f) {
+      VName mapname = P_GetMapLumpName(f);
+      if (mapname != NAME_None && IsMapPresent(mapname)) lmapBakeQueue.append(mapname);
+    }
+  } else {
+    for (int f = 1; f < Args.length(); ++f) {
+      VName mapname = VName(*Args[f], VName::AddLower8);
+      if (!IsMapPresent(mapname)) { GCon->Logf(NAME_Warning, "map '%s' not found", *Args[f]); continue; }
+      lmapBakeQueue.append(mapname);
+    }
+  }
+  if (lmapBakeQueue.length() == 0) { GCon->Log("no maps to bake"); return; }
+
+  GCon->Logf("baking lightmaps for %d map%s", lmapBakeQueue.length(), (lmapBakeQueue.length() != 1 ? "s" : ""));
+  lmapBakeActive = true;
+  lmapBakeCount = 0;
+  lmapBakeTime = 0.0;
+  VName mapname = lmapBakeQueue[0];
+  lmapBakeQueue.removeAt(0);
+  GCmdBuf << "map \"" << VStr(*mapname).quote() << "\"\n";
+}
+
+COMMAND_AC(LightmapCacheBake) {
+  if (aidx != 1) return VStr::EmptyString;
+  VStr prefix = (aidx < args.length() ? args[aidx] : VStr());
+  TArray<VStr> list;
+  list.append("all");
+  return AutoCompleteFromListCmd(prefix, list);
+}
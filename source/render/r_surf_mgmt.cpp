@@ -33,6 +33,10 @@
 static VCvarB r_tj_proper_centroids("r_tj_proper_centroids", true, "Use \"proper\" centroids instead of fast? (DO NOT CHANGE!)", CVAR_Archive|CVAR_NoShadow);
 
 
+// static lightmaps can be baked by worker threads
+static inline void lightMemAdd (int delta) noexcept { if (delta) (void)__atomic_add_fetch(&light_mem, delta, __ATOMIC_RELAXED); }
+
+
 //==========================================================================
 //
 //  surface_t::FreeLightmaps
@@ -40,13 +44,13 @@ static VCvarB r_tj_proper_centroids("r_tj_proper_centroids", true, "Use \"proper
 //==========================================================================
 void surface_t::FreeLightmaps () noexcept {
   if (lightmap) {
-    light_mem -= lmsize;
+    lightMemAdd(-lmsize);
     Z_Free(lightmap);
     lightmap = nullptr;
     lmsize = 0;
   }
   if (lightmap_rgb) {
-    light_mem -= lmrgbsize;
+    lightMemAdd(-lmrgbsize);
     Z_Free(lightmap_rgb);
     lightmap_rgb = nullptr;
     lmrgbsize = 0;
@@ -61,7 +65,7 @@ void surface_t::FreeLightmaps () noexcept {
 //==========================================================================
 void surface_t::FreeRGBLightmap () noexcept {
   if (lightmap_rgb) {
-    light_mem -= lmrgbsize;
+    lightMemAdd(-lmrgbsize);
     Z_Free(lightmap_rgb);
     lightmap_rgb = nullptr;
     lmrgbsize = 0;
@@ -77,8 +81,7 @@ void surface_t::FreeRGBLightmap () noexcept {
 void surface_t::ReserveMonoLightmap (int sz) noexcept {
   vassert(sz > 0);
   if (lmsize < sz) {
-    light_mem -= lmsize;
-    light_mem += sz;
+    lightMemAdd(sz-lmsize);
     lightmap = (vuint8 *)Z_Realloc(lightmap, sz);
     lmsize = sz;
   }
@@ -93,8 +96,7 @@ void surface_t::ReserveMonoLightmap (int sz) noexcept {
 void surface_t::ReserveRGBLightmap (int sz) noexcept {
   vassert(sz > 0);
   if (lmrgbsize < sz) {
-    light_mem -= lmrgbsize;
-    light_mem += sz;
+    lightMemAdd(sz-lmrgbsize);
     lmrgbsize = sz;
     lightmap_rgb = (rgb_t *)Z_Realloc(lightmap_rgb, sz);
   }
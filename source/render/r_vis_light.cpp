@@ -103,6 +103,8 @@ void VRenderLevelShared::CalcLightVisUnstuckLightSubsector (const subsector_t *s
 void VRenderLevelShared::CalcLightVisCheckSubsector (const unsigned subidx) {
   subsector_t *sub = &Level->Subsectors[subidx];
   if (sub->isAnyPObj()) return;
+  // no line of sight from the light subsector?
+  if (CurrLightPVS && !(CurrLightPVS[subidx>>3]&(1u<<(subidx&7)))) return;
 
   if (!LightClip.ClipLightCheckSubsector(sub, false)) {
     if (!IsGeoClip()) return;
@@ -291,6 +293,13 @@ bool VRenderLevelShared::CalcLightVis (const TVec &org, const float radius, cons
   //CurrLightRadius = radius;
   CurrLightBit = (dlnum >= 0 ? 1u<<dlnum : 0u);
 
+  // use level PVS only with geometry clipping, and only if the light is not in the void
+  CurrLightPVS = nullptr;
+  if (IsGeoClip() && Level->HasPVS()) {
+    const subsector_t *lsub = Level->PointInSubsector(CurrLightPos);
+    if (Level->IsPointInSubsector2D(lsub, CurrLightPos)) CurrLightPVS = Level->LeafPVS(lsub);
+  }
+
   /*LightSubs.reset();*/ // all affected subsectors
   /*LightVisSubs.reset();*/ // visible affected subsectors
   LitSurfaceHit = false;
@@ -725,6 +725,7 @@ void SCR_SignalWipeStart () {
 //
 //==========================================================================
 void SCR_Update (bool fullUpdate) {
+  VPROF_ZONE("render", "SCR_Update");
   CheckResolutionChange();
 
   if (Drawer) Drawer->IncUpdateFrame();
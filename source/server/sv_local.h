@@ -88,11 +88,41 @@ struct VAcsInfo;
 // ////////////////////////////////////////////////////////////////////////// //
 class VAcsLevel {
 private:
+  // dynamic string slot states
+  enum {
+    STRS_Free,
+    STRS_Live, // reclaimed if not referenced from ACS variables
+    STRS_Pinned, // the handle was passed to VC code, never reclaimed
+  };
+
+  // dynamic strings; handles are slot indicies, so they are stable
+  // unreferenced slots are reclaimed by `CollectStrings()`
   TMap<VStr, int> stringMapByStr;
   TArray<VStr> stringList;
+  TArrayNC<vuint8> stringState; // STRS_xxx
+  TArrayNC<int> stringFree; // free slots
+  TArrayNC<vuint8> stringMarks; // used only in `CollectStrings()`
+  vint32 stringLastGCTic;
+  // statistics
+  vuint32 stringGCCount;
+  vuint32 stringGCFreed;
+  double stringGCTime;
   TMapNC<int, bool> unknownScripts;
 
+  // script lookup index for all loaded objects
+  struct ScriptRef {
+    int ObjIdx; // in `LoadedObjects`
+    int ScriptIdx; // in object scripts
+    inline ScriptRef () noexcept : ObjIdx(0), ScriptIdx(0) {}
+    inline ScriptRef (int aobj, int ascript) noexcept : ObjIdx(aobj), ScriptIdx(ascript) {}
+  };
+  TMapNC<int, ScriptRef> scriptsByNumber;
+  TMapNC<int, ScriptRef> scriptsByName; // key is name index
+  int scriptIndexObjCount; // number of objects in the index, or -1
+
 private:
+  bool UpdateScriptIndex ();
+  void MarkScriptVars (const vint32 *vars, int count) noexcept;
   bool AddToACSStore (int Type, VName Map, int Number, int Arg1, int Arg2, int Arg3, int Arg4, VEntity *Activator);
 
 public:
@@ -130,6 +160,17 @@ public:
   VName GetNewLowerName (int idx);
   int PutNewString (VStr str);
 
+  // reclaims dynamic strings that are not referenced from ACS variables, and not pinned
+  // should not be called while some script is running
+  // without `force`, it does nothing if the pool is small
+  void CollectStrings (bool force=false);
+  // used by `CollectStrings()`
+  void MarkStringHandle (int handle) noexcept;
+  // call this for any value that leaves ACS variables (action special args, user vars, etc.)
+  // VC code can store it anywhere, so the string (if it is a string) should never be reclaimed
+  void PinStringHandle (int handle) noexcept;
+  void DumpStringPoolStats ();
+
 public: // debug
   static VStr GenScriptName (int Number);
 };
@@ -148,6 +189,8 @@ public:
   inline void SetElemVal (int index, int value) { values.put(index, value); }
   inline int GetElemVal (int index) const { auto vp = values.get(index); return (vp ? *vp : 0); }
 
+  template<typename CB> inline void forEachValue (CB cb) { for (auto it = values.first(); it; ++it) cb(it.getValue()); }
+
   void Serialise (VStream &Strm);
 };
 
@@ -197,6 +240,9 @@ public:
 
   VStr GetGlobalVarStr (VAcsLevel *level, int index) const;
 
+  // marks dynamic string handles in all variables and arrays
+  void MarkStrings (VAcsLevel *level);
+
   int GetGlobalVarInt (int index) const;
   float GetGlobalVarFloat (int index) const;
   void SetGlobalVarInt (int index, int value);
@@ -622,6 +622,7 @@ void SV_LoadMods () {
 void SV_CompileScripts () {
   // just in case; DECORATE should not left uncompiled things, but...
   VPackage::StaticEmitPackages();
+  VClass::StaticRenumberHierarchy();
 
   GGameInfo->eventPostDecorateInit();
 
@@ -2046,6 +2047,9 @@ void SV_DropClient (VBasePlayer *Player, bool crash) {
 //
 //==========================================================================
 void SV_ShutdownGame () {
+  // finish the pending save before the game state is gone
+  SV_WaitSaveJob(true);
+
   #ifdef CLIENT
   // so we could minimize uniqueid
   MN_DeactivateMenu();
@@ -2547,6 +2551,7 @@ void NET_SendNetworkHeartbeat (bool forced) {
 //
 //==========================================================================
 void SV_ServerFrame () {
+  VPROF_ZONE("server", "SV_ServerFrame");
   const bool haveClients = SV_CheckForNewClients();
 
   // there is no need to tick if we have no active clients
@@ -2562,6 +2567,231 @@ void SV_ServerFrame () {
 
   SV_SendClientMessages(); // full
   SV_UpdateMaster();
+
+  SV_PollSaveJob();
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// headless simulation benchmark
+// ////////////////////////////////////////////////////////////////////////// //
+extern VCvarB dbg_world_think_vm_time;
+extern double worldThinkTimeVM;
+
+static VCvarI sv_bench_seed("sv_bench_seed", "1", "Random seed for `SimBench` command.", CVAR_NoShadow);
+static VCvarI sv_bench_gc_tics("sv_bench_gc_tics", "17", "Run GC every this number of tics in `SimBench` command.", CVAR_NoShadow);
+
+enum {
+  SBT_Total,
+  SBT_Clients, // player and bot input, player ticks
+  SBT_World, // whole `TickWorld()`
+  SBT_VM, // thinker ticks, without native movement code
+  SBT_Physics, // native movement and collision code
+  SBT_Net,
+  SBT_GC,
+  SBT_MAX,
+};
+
+static const char *sbtNames[SBT_MAX] = {
+  "total",
+  "clients",
+  "world",
+  "vm",
+  "physics",
+  "net",
+  "gc",
+};
+
+
+//==========================================================================
+//
+//  SV_CalcWorldStateHash
+//
+//  hash of the state that should be the same in deterministic runs
+//
+//==========================================================================
+static vuint32 SV_CalcWorldStateHash (VLevel *Level) {
+  XXH32_state_t xx32;
+  XXH32_reset(&xx32, (vuint32)Level->TicTime);
+  for (VThinker *th = Level->ThinkerHead; th; th = th->Next) {
+    if (th->IsGoingToDie()) continue;
+    VEntity *e = Cast<VEntity>(th);
+    if (!e) continue;
+    const char *cname = e->GetClass()->GetName();
+    XXH32_update(&xx32, cname, strlen(cname));
+    const float fv[9] = {
+      e->Origin.x, e->Origin.y, e->Origin.z,
+      e->Velocity.x, e->Velocity.y, e->Velocity.z,
+      e->Angles.pitch, e->Angles.yaw, e->Angles.roll,
+    };
+    XXH32_update(&xx32, fv, sizeof(fv));
+    const vint32 iv[3] = {
+      (e->State ? e->State->InClassIndex : -1),
+      e->Health,
+      (vint32)e->EntityFlags,
+    };
+    XXH32_update(&xx32, iv, sizeof(iv));
+  }
+  for (int f = 0; f < Level->NumSectors; ++f) {
+    const sector_t *sec = &Level->Sectors[f];
+    const float fv[2] = { sec->floor.dist, sec->ceiling.dist };
+    XXH32_update(&xx32, fv, sizeof(fv));
+  }
+  return XXH32_digest(&xx32);
+}
+
+
+//==========================================================================
+//
+//  SBTimeCmp
+//
+//==========================================================================
+static int SBTimeCmp (const void *a, const void *b, void * /*udata*/) {
+  if (a == b) return 0;
+  const double ta = *(const double *)a;
+  const double tb = *(const double *)b;
+  return (ta < tb ? -1 : ta > tb ? 1 : 0);
+}
+
+
+//==========================================================================
+//
+//  COMMAND SimBench
+//
+//  loads the map with the fixed random seed, and runs the given number of
+//  tics as fast as possible. the world state hash is calculated after each
+//  tic, so two runs can be compared for determinism.
+//
+//==========================================================================
+COMMAND(SimBench) {
+  if (Args.length() < 3 || Args.length() > 5) {
+    GCon->Log("simbench <map> <tics> [bots [hashfile]] : run headless simulation benchmark");
+    return;
+  }
+
+  if (GGameInfo->NetMode == NM_Client) {
+    GCon->Log(NAME_Error, "simbench: cannot run benchmark on client");
+    return;
+  }
+
+  int tics = 0, bots = 0;
+  if (!Args[2].convertInt(&tics) || tics < 1) {
+    GCon->Logf(NAME_Error, "simbench: invalid number of tics: '%s'", *Args[2]);
+    return;
+  }
+  if (Args.length() > 3 && (!Args[3].convertInt(&bots) || bots < 0 || bots > MAXPLAYERS)) {
+    GCon->Logf(NAME_Error, "simbench: invalid number of bots: '%s'", *Args[3]);
+    return;
+  }
+
+  VStream *hashStrm = nullptr;
+  if (Args.length() > 4) {
+    hashStrm = CreateDiskStreamWrite(Args[4]);
+    if (!hashStrm) {
+      GCon->Logf(NAME_Error, "simbench: cannot create hash file \"%s\"", *Args[4]);
+      return;
+    }
+  }
+
+  // seed before loading, so spawning will be reproducible too
+  const vuint32 seed = (vuint32)sv_bench_seed.asInt();
+  pcg3264_seedU32(&g_pcg3264_ctx, seed);
+  VCommand::ExecuteString(VStr("map \"")+Args[1]+"\"", VCommand::SRC_Command, nullptr);
+  if (!GLevel || GGameInfo->NetMode == NM_None) {
+    GCon->Logf(NAME_Error, "simbench: cannot load map \"%s\"", *Args[1]);
+    delete hashStrm;
+    return;
+  }
+
+  int botCount = 0;
+  for (int i = 0; i < MAXPLAYERS; ++i) {
+    VBasePlayer *Player = GGameInfo->Players[i];
+    if (Player && (Player->PlayerFlags&VBasePlayer::PF_IsBot)) ++botCount;
+  }
+  while (botCount < bots && svs.num_connected < svs.max_clients) {
+    SV_ConnectBot(va("bench%d", botCount));
+    ++botCount;
+  }
+
+  TArray<double> times[SBT_MAX];
+  for (auto &&arr : times) arr.setLength(tics);
+
+  const bool oldVMTime = dbg_world_think_vm_time.asBool();
+  dbg_world_think_vm_time = true;
+  VEntityPhysTimer::Enabled = true;
+  const float savedFrameTime = host_frametime;
+  const int gcTics = max2(1, sv_bench_gc_tics.asInt());
+
+  XXH32_state_t runHash;
+  XXH32_reset(&runHash, seed);
+
+  int ran = 0;
+  const double stt = Sys_Time();
+  for (; ran < tics; ++ran) {
+    if (sv.intermission || completed || mapteleport_issued) {
+      GCon->Logf(NAME_Warning, "simbench: level ended at tic %d", ran);
+      break;
+    }
+    VFrameArena::NewFrame();
+    GGameInfo->frametime = FrameTime;
+    host_frametime = FrameTime;
+
+    const vuint64 physStart = VEntityPhysTimer::TotalNano;
+    const double t0 = Sys_Time();
+    SV_RunClients();
+    const vuint64 physWorld = VEntityPhysTimer::TotalNano;
+    const double t1 = Sys_Time();
+    GLevel->TickWorld(host_frametime, /*allowVCPause*/true);
+    const double t2 = Sys_Time();
+    const vuint64 physEnd = VEntityPhysTimer::TotalNano;
+    SV_SendClientMessages();
+    const double t3 = Sys_Time();
+    if ((ran+1)%gcTics == 0) Host_CollectGarbage(true);
+    const double t4 = Sys_Time();
+
+    times[SBT_Total][ran] = t4-t0;
+    times[SBT_Clients][ran] = t1-t0;
+    times[SBT_World][ran] = t2-t1;
+    times[SBT_VM][ran] = max2(0.0, worldThinkTimeVM-(double)(physEnd-physWorld)/1000000000.0);
+    times[SBT_Physics][ran] = (double)(physEnd-physStart)/1000000000.0;
+    times[SBT_Net][ran] = t3-t2;
+    times[SBT_GC][ran] = t4-t3;
+
+    const vuint32 hash = SV_CalcWorldStateHash(GLevel);
+    XXH32_update(&runHash, &hash, sizeof(hash));
+    if (hashStrm) {
+      VStr line = va("%d %08x\n", GLevel->TicTime, hash);
+      hashStrm->Serialise(line.getCStr(), line.length());
+    }
+  }
+  const double ett = Sys_Time()-stt;
+
+  host_frametime = savedFrameTime;
+  VEntityPhysTimer::Enabled = false;
+  dbg_world_think_vm_time = oldVMTime;
+
+  if (hashStrm) {
+    bool err = hashStrm->IsError();
+    if (!hashStrm->Close()) err = true;
+    delete hashStrm;
+    if (err) GCon->Logf(NAME_Error, "simbench: cannot write hash file \"%s\"", *Args[4]);
+  }
+
+  if (ran == 0) return;
+
+  GCon->Logf("simbench: map '%s', seed %u, %d bot%s; %d tics in %.3f sec (%.1f tics/sec); state hash: %08x",
+    *Args[1], seed, botCount, (botCount != 1 ? "s" : ""), ran, ett, (double)ran/ett, XXH32_digest(&runHash));
+  GCon->Log("simbench: per-tic times, in msecs:");
+  for (int f = 0; f < SBT_MAX; ++f) {
+    TArray<double> &arr = times[f];
+    arr.setLength(ran);
+    double sum = 0.0;
+    for (double v : arr) sum += v;
+    smsort_r(arr.ptr(), ran, sizeof(double), &SBTimeCmp, nullptr);
+    auto pcnt = [&arr, ran](int p) -> double { return arr[min2(ran-1, (ran-1)*p/100)]*1000.0; };
+    GCon->Logf("  %-8s p50:%8.3f  p90:%8.3f  p99:%8.3f  max:%8.3f  avg:%8.3f",
+      sbtNames[f], pcnt(50), pcnt(90), pcnt(99), arr[ran-1]*1000.0, sum*1000.0/(double)ran);
+  }
 }
 
 
@@ -112,6 +112,7 @@ static VCvarI save_compression_level("save_compression_level", "1", "Save file c
 static VCvarB sv_new_map_autosave("sv_new_map_autosave", true, "Autosave when entering new map (except first one)?", CVAR_PreInit|CVAR_NoShadow/*|CVAR_Archive*/);
 
 static VCvarB sv_save_messages("sv_save_messages", true, "Show messages on save/load?", CVAR_Archive|CVAR_NoShadow);
+static VCvarB sv_save_async("sv_save_async", true, "Compress and write save files in background thread?", CVAR_Archive|CVAR_NoShadow);
 
 //static VCvarB loader_recalc_z("loader_recalc_z", true, "Recalculate Z on load (this should help with some edge cases)?", CVAR_Archive|CVAR_NoShadow);
 static VCvarB loader_ignore_kill_on_unarchive("loader_ignore_kill_on_unarchive", false, "Ignore 'Kill On Unarchive' flag when loading a game?", CVAR_PreInit|CVAR_NoShadow/*|CVAR_Archive*/);
@@ -297,14 +298,20 @@ public:
   // only for old format
   vuint8 Compressed;
   vint32 DecompressedSize;
+  // only for new format: `false` if `Data` is an uncompressed snapshot
+  // the background save writer will replace it with the packed one
+  bool Packed;
+  vuint32 SnapshotId;
 
 public:
-  VSavedMap (bool asNewFormat) : Compressed(asNewFormat ? 69 : 0), DecompressedSize(0) {}
+  VSavedMap (bool asNewFormat) : Compressed(asNewFormat ? 69 : 0), DecompressedSize(0), Packed(true), SnapshotId(0) {}
 
   inline void ClearData (bool asNewFormat) {
     Data.clear();
     Compressed = (asNewFormat ? 69 : 0);
     DecompressedSize = 0;
+    Packed = true;
+    SnapshotId = 0;
   }
 
   //inline void SetNewFormat () noexcept { Compressed = 69; }
@@ -327,6 +334,27 @@ public:
 };
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+struct TTimeVal {
+  int secs; // actually, unsigned
+  int usecs;
+  // for 2030+
+  int secshi;
+
+  inline bool operator < (const TTimeVal &tv) const {
+    if (secshi < tv.secshi) return true;
+    if (secshi > tv.secshi) return false;
+    if (secs < tv.secs) return true;
+    if (secs > tv.secs) return false;
+    return false;
+  }
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+class VSaveSlotJob;
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 // save slot may contain several maps for hub saves
 // also, some maps may be overwritten time and time again (hub)
@@ -365,12 +393,86 @@ public:
   bool LoadSlot (int Slot);
   bool SaveToSlot (int Slot);
 
+  // new format only; creates the slot file, and copies everything
+  // `VSaveSlotJob::Write()` needs; returns `nullptr` on error
+  VSaveSlotJob *CreateSaveJob (int Slot);
+
   VSavedMap *FindMap (VName Name);
 };
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// new format save file writer
+// it doesn't reference any game state, so it can be run on any thread
+class VSaveSlotJob {
+public:
+  struct MapInfo {
+    VName MapName;
+    VStr Name;
+    VStr VWadName;
+    TArrayNC<vuint8> Data;
+    bool Packed; // `false` means "uncompressed snapshot"
+    vuint32 SnapshotId;
+  };
+
+public:
+  int Slot;
+  VStr Description;
+  VStr CurrentMap;
+  VStr DateStr;
+  TTimeVal DateVal;
+  TArray<VStr> WadList;
+  TArray<MapInfo *> Maps; // if there are no maps, it is a checkpoint
+  TArrayNC<vuint8> CheckPoint; // serialised checkpoint
+  vint32 SavedSkill;
+  int CompLevel;
+  VStream *ArcStrm; // temporary slot file; owned
+  VStr ArcFileName;
+  VStr FileBase; // `saveFileBase` for this save
+  // lightmap cache to write after the save file (if `HasLightmaps` is set)
+  bool HasLightmaps;
+  TArrayNC<vuint8> Lightmaps;
+  // for the async writer
+  bool IsAutosave;
+  bool IsCheckpoint;
+  VStr DoneMessage;
+  double SnapshotTime; // time spent on the game thread, in seconds
+  double ArchiveTime; // part of `SnapshotTime` spent in serialising the map (thinkers, world, etc.)
+  double WriteTime; // time spent in `Write()`, in seconds
+  mythread Thread;
+  atomic_int Done;
+  // result
+  bool Result;
+  VStr ErrorMsg;
+
+public:
+  VV_DISABLE_COPY(VSaveSlotJob)
+
+  VSaveSlotJob ()
+    : Slot(0), SavedSkill(-1), CompLevel(VWADWR_COMP_FAST), ArcStrm(nullptr)
+    , HasLightmaps(false), IsAutosave(false), IsCheckpoint(false)
+    , SnapshotTime(0), ArchiveTime(0), WriteTime(0), Done(0), Result(false)
+  {}
+
+  ~VSaveSlotJob () {
+    for (auto &&mi : Maps) delete mi;
+    Maps.clear();
+    if (ArcStrm) VStream::Destroy(ArcStrm);
+  }
+
+  // writes the save file, and the lightmap cache; sets `Result`
+  bool Write ();
+
+private:
+  bool PackMap (MapInfo *mi);
+  bool WriteArchive ();
+};
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 static VSaveSlot BaseSlot;
+static VSaveSlotJob *saveJob = nullptr; // pending background save
+static vuint32 saveSnapshotId = 0;
 
 
 // ////////////////////////////////////////////////////////////////////////// //
@@ -810,6 +912,8 @@ public:
   TMapNC<vuint32, vint32> ObjectsMap; // key: object uid; value: internal index
   TArray</*VLevelScriptThinker*/VSerialisable *> AcsExports;
   bool skipPlayers;
+  // write everything uncompressed; the background writer will pack it later
+  bool Snapshot;
 
 private:
   inline VStream *GetCurrStream () const {
@@ -863,11 +967,13 @@ private:
 
   void Init () {
     bLoading = false;
+    Snapshot = false;
     NamesMap.setLength(VName::GetNumNames());
     for (int i = 0; i < VName::GetNumNames(); ++i) NamesMap[i] = -1;
   }
 
-  static int GetCompressionLevel (VStr fname) {
+  int GetCompressionLevel (VStr fname) const {
+    if (Snapshot) return VWADWR_COMP_DISABLE;
     int level = save_compression_level.asInt();
     if (level < VWADWR_COMP_DISABLE || level > VWADWR_COMP_BEST) {
       level = VWADWR_COMP_FAST;
@@ -1048,12 +1154,7 @@ public:
       }
       if (!err) {
         if (strMapper) {
-          int level = save_compression_level.asInt();
-          if (level < VWADWR_COMP_DISABLE || level > VWADWR_COMP_BEST) {
-            level = VWADWR_COMP_FAST;
-            save_compression_level = level;
-          }
-          VStream *wo = vwad->CreateFileDirect(NEWFMT_FNAME_MAP_STRTBL, level);
+          VStream *wo = vwad->CreateFileDirect(NEWFMT_FNAME_MAP_STRTBL, GetCompressionLevel(NEWFMT_FNAME_MAP_STRTBL));
           if (wo) {
             strMapper->WriteStrings(wo);
             err = !wo->Close();
@@ -1509,6 +1610,9 @@ static VStr GetSaveSlotBaseFileName (int slot) {
 //
 //==========================================================================
 static VStream *SV_OpenSlotFileRead (int slot) {
+  // pending background save may be writing this slot; the file is replaced when the job is finished
+  if (saveJob && saveJob->Slot == slot) SV_WaitSaveJob();
+
   saveFileBase.clear();
   if (isBadSlotIndex(slot)) return nullptr;
 
@@ -1632,9 +1736,10 @@ static VStream *SV_OpenSlotFileReadWithFmt (int Slot, VVWadArchive *&vwad) {
 //
 //  user can rename file to different case
 //  kill 'em all!
+//  if `keepLightmaps` is set, lightmap cache for `keepFileName` is kept too
 //
 //==========================================================================
-static bool removeSlotSaveFiles (int slot, VStr keepFileName) {
+static bool removeSlotSaveFiles (int slot, VStr keepFileName, bool keepLightmaps=false) {
   TArray<VStr> tokill;
   if (isBadSlotIndex(slot)) return false;
 
@@ -1651,7 +1756,7 @@ static bool removeSlotSaveFiles (int slot, VStr keepFileName) {
            fname.endsWithNoCase(".lmap")))
       {
         VStr fn = svdir.appendPath(fname);
-        if (fn != keepFileName) tokill.append(fn);
+        if (fn != keepFileName && (!keepLightmaps || fn != keepFileName+".lmap")) tokill.append(fn);
       } else if (fname.endsWith(".$$$")) {
         // various broken temp saves
         VStr fn = svdir.appendPath(fname);
@@ -1740,7 +1845,7 @@ static void SV_SaveFailed (VStr fname, int Slot) {
 //  call this to properly close the stream, and rename temp file
 //
 //==========================================================================
-static void SV_SaveSuccess (VStr fname, int Slot) {
+static void SV_SaveSuccess (VStr fname, int Slot, bool keepLightmaps=false) {
   vassert(!fname.IsEmpty());
   vassert(!saveFileBase.IsEmpty());
   if (fname != saveFileBase) {
@@ -1752,7 +1857,7 @@ static void SV_SaveSuccess (VStr fname, int Slot) {
       return;
     }
   }
-  removeSlotSaveFiles(Slot, saveFileBase);
+  removeSlotSaveFiles(Slot, saveFileBase, keepLightmaps);
   UpdateSaveDirWadList();
 }
 
@@ -1770,23 +1875,6 @@ static bool SV_DeleteSlotFile (int slot) {
 #endif
 
 
-// ////////////////////////////////////////////////////////////////////////// //
-struct TTimeVal {
-  int secs; // actually, unsigned
-  int usecs;
-  // for 2030+
-  int secshi;
-
-  inline bool operator < (const TTimeVal &tv) const {
-    if (secshi < tv.secshi) return true;
-    if (secshi > tv.secshi) return false;
-    if (secs < tv.secs) return true;
-    if (secs > tv.secs) return false;
-    return false;
-  }
-};
-
-
 //==========================================================================
 //
 //  GetTimeOfDay
@@ -2427,47 +2515,155 @@ bool VSaveSlot::SaveToSlotOld (int Slot, VStr &savefilename) {
 
 #define CREATE_VWAD_FILE(xxfname)  do { \
   vassert(Strm == nullptr); \
-  int level = save_compression_level.asInt(); \
-  if (level < VWADWR_COMP_DISABLE || level > VWADWR_COMP_BEST) { \
-    level = VWADWR_COMP_FAST; \
-    save_compression_level = level; \
-  } \
   VStr xyname = VStr(xxfname); \
-  if (xyname.endsWithNoCase(".vwad")) level = VWADWR_COMP_DISABLE; \
-  Strm = vmain->CreateFileDirect(xyname, level); \
+  Strm = vmain->CreateFileDirect(xyname, (xyname.endsWithNoCase(".vwad") ? VWADWR_COMP_DISABLE : CompLevel)); \
   vassert(Strm != nullptr); \
 } while (0)
 
 
 //==========================================================================
 //
-//  VSaveSlot::SaveToSlotNew
+//  VSaveSlot::CreateSaveJob
 //
 //==========================================================================
-bool VSaveSlot::SaveToSlotNew (int Slot, VStr &savefilename) {
-  TTimeVal tv;
-  GetTimeOfDay(&tv);
+VSaveSlotJob *VSaveSlot::CreateSaveJob (int Slot) {
+  vassert(IsNewFormat());
 
   saveFileBase.clear();
-  savefilename.clear();
 
   VStream *ArcStrm = SV_CreateSlotFileWrite(Slot, Description, true);
   if (!ArcStrm) {
     GCon->Logf(NAME_Error, "cannot save to slot %d!", Slot);
+    return nullptr;
+  }
+
+  VSaveSlotJob *job = new VSaveSlotJob();
+  job->Slot = Slot;
+  job->ArcStrm = ArcStrm;
+  job->ArcFileName = ArcStrm->GetName();
+  job->FileBase = saveFileBase;
+
+  GetTimeOfDay(&job->DateVal);
+  job->DateStr = TimeVal2Str(&job->DateVal);
+  job->Description = Description;
+  job->CurrentMap = VStr(CurrentMap);
+  job->WadList = FL_GetWadPk3ListSmall();
+
+  int level = save_compression_level.asInt();
+  if (level < VWADWR_COMP_DISABLE || level > VWADWR_COMP_BEST) {
+    level = VWADWR_COMP_FAST;
+    save_compression_level = level;
+  }
+  job->CompLevel = level;
+
+  for (int i = 0; i < Maps.length(); ++i) {
+    VSavedMap *Map = Maps[i];
+    vassert(Map->Index == i);
+    vassert(Map->IsNewFormat());
+    vassert(Map->Data.length() >= 16);
+    VSaveSlotJob::MapInfo *mi = new VSaveSlotJob::MapInfo();
+    mi->MapName = Map->Name;
+    mi->Name = VStr(Map->Name);
+    mi->VWadName = Map->GenVWadName();
+    mi->Data.setLength(Map->Data.length());
+    memcpy(mi->Data.ptr(), Map->Data.ptr(), Map->Data.length());
+    mi->Packed = Map->Packed;
+    mi->SnapshotId = Map->SnapshotId;
+    job->Maps.append(mi);
+  }
+
+  //HACK: if there are no maps, we're saving a checkpoint
+  if (Maps.length() == 0) {
+    // save players inventory
+    VSavedCheckpoint &cp = CheckPoint;
+    VArrayStream *cps = new VArrayStream("<checkpoint>", job->CheckPoint);
+    cps->BeginWrite();
+    cp.Serialise(cps);
+    delete cps;
+    SavedSkill = cp.Skill;
+  } else {
+    CheckPoint.Clear();
+  }
+  job->SavedSkill = SavedSkill;
+
+  return job;
+}
+
+
+//==========================================================================
+//
+//  VSaveSlotJob::PackMap
+//
+//  repacks uncompressed map snapshot with the proper compression level
+//
+//==========================================================================
+bool VSaveSlotJob::PackMap (MapInfo *mi) {
+  VMemoryStreamRO *mst = new VMemoryStreamRO("<savemap:snapshot>", mi->Data.ptr(), mi->Data.length());
+  VVWadArchive *vsrc = new VVWadArchive("<savemap:snapshot>", mst, true);
+  if (!vsrc->IsOpen()) {
+    delete vsrc;
     return false;
   }
-  savefilename = ArcStrm->GetName();
 
+  VMemoryStream *OutStrm = new VMemoryStream();
+  VVWadNewArchive *vdest = new VVWadNewArchive("<map-data>", "k8vavoom engine", "saved map data",
+                                               OutStrm, false/*not owned*/);
+  bool err = vdest->IsError();
+
+  TArrayNC<vuint8> buf;
+  for (int f = 0; !err && f < vsrc->GetFilesCount(); ++f) {
+    VStr fname = vsrc->GetFileName(f);
+    VStream *rd = vsrc->OpenFile(fname);
+    if (!rd) { err = true; break; }
+    const int size = rd->TotalSize();
+    buf.setLength(size);
+    if (size > 0) rd->Serialise(buf.ptr(), size);
+    err = rd->IsError();
+    VStream::Destroy(rd);
+    if (err) break;
+    VStream *wr = vdest->CreateFileDirect(fname, (fname.endsWithNoCase(".vwad") ? VWADWR_COMP_DISABLE : CompLevel));
+    if (!wr) { err = true; break; }
+    if (size > 0) wr->Serialise(buf.ptr(), size);
+    if (!wr->Close()) err = true;
+    VStream::Destroy(wr);
+  }
+
+  if (!err) err = !vdest->Close();
+  delete vdest;
+  delete vsrc;
+
+  if (!err) {
+    TArrayNC<vuint8> &Buf = OutStrm->GetArray();
+    mi->Data.setLength(Buf.length());
+    if (Buf.length()) memcpy(mi->Data.ptr(), Buf.ptr(), Buf.length());
+    mi->Packed = true;
+  }
+  delete OutStrm;
+
+  return !err;
+}
+
+
+//==========================================================================
+//
+//  VSaveSlotJob::WriteArchive
+//
+//==========================================================================
+bool VSaveSlotJob::WriteArchive () {
+  vassert(ArcStrm);
   VVWadNewArchive *vmain = new VVWadNewArchive("<main-save>",
                                                NEWFMT_VWAD_AUTHOR,
-                                               Description + " | "+TimeVal2Str(&tv),
+                                               Description + " | "+DateStr,
                                                ArcStrm, true/*owned*/);
+  ArcStrm = nullptr; // the archive owns it now
   if (vmain->IsError()) {
     delete vmain;
-    GCon->Logf(NAME_Error, "cannot create save archive for slot %d!", Slot);
+    ErrorMsg = va("cannot create save archive for slot %d!", Slot);
     return false;
   }
 
+  ErrorMsg = va("error saving to slot %d, savegame is corrupted!", Slot);
+
   VStream *Strm = nullptr;
 
   // version
@@ -2483,26 +2679,24 @@ bool VSaveSlot::SaveToSlotNew (int Slot, VStr &savefilename) {
   // extended data: date value and date string
   // date value
   CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_DATE);
-  *Strm << tv.secs << tv.usecs << tv.secshi;
+  *Strm << DateVal.secs << DateVal.usecs << DateVal.secshi;
   // date string (unused, but nice to have)
-  VStr dstr = TimeVal2Str(&tv);
-  *Strm << dstr;
+  *Strm << DateStr;
   CLOSE_VWAD_FILE();
 
   // write list of loaded modules
   {
     CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_WADLIST);
-    auto wadlist = FL_GetWadPk3ListSmall();
-    vint32 wcount = wadlist.length();
+    vint32 wcount = WadList.length();
     *Strm << wcount;
-    for (int f = 0; f < wcount; ++f) *Strm << wadlist[f];
+    for (int f = 0; f < wcount; ++f) *Strm << WadList[f];
     CLOSE_VWAD_FILE();
 
     // write human-readable list of loaded modules
     // (it is purely informative)
     VStr sres;
     sres = "# automatically generated, and purely informational\n";
-    for (VStr w : wadlist) { sres += w; sres += "\n"; }
+    for (VStr w : WadList) { sres += w; sres += "\n"; }
     CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_HWADLIST);
     Strm->Serialise((void *)sres.getCStr(), sres.length());
     CLOSE_VWAD_FILE();
@@ -2510,46 +2704,31 @@ bool VSaveSlot::SaveToSlotNew (int Slot, VStr &savefilename) {
 
   // write current map name
   CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_CURRMAP);
-  VStr TmpName(CurrentMap);
-  *Strm << TmpName;
+  *Strm << CurrentMap;
   CLOSE_VWAD_FILE();
 
   // write map list
   CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_MAPLIST);
   vint32 NumMaps = Maps.length();
   *Strm << STRM_INDEX(NumMaps);
-  for (int i = 0; i < Maps.length(); ++i) {
-    VSavedMap *Map = Maps[i];
-    vassert(Map->Index == i);
-    vassert(Map->IsNewFormat());
-    TmpName = VStr(Map->Name);
-    *Strm << TmpName;
-  }
+  for (int i = 0; i < Maps.length(); ++i) *Strm << Maps[i]->Name;
   CLOSE_VWAD_FILE();
 
   // write map vwads
   for (int i = 0; i < NumMaps; ++i) {
-    VSavedMap *Map = Maps[i];
-    vassert(Map->Index == i);
-    vassert(Map->IsNewFormat());
-    vassert(Map->Data.length() >= 16);
-    VStr vname = Map->GenVWadName();
-    CREATE_VWAD_FILE(vname);
-    Strm->Serialise(Map->Data.Ptr(), Map->Data.length());
+    MapInfo *mi = Maps[i];
+    CREATE_VWAD_FILE(mi->VWadName);
+    Strm->Serialise(mi->Data.Ptr(), mi->Data.length());
     CLOSE_VWAD_FILE();
   }
 
-  //HACK: if `NumMaps` is 0, we're loading a checkpoint
+  //HACK: if `NumMaps` is 0, we're saving a checkpoint
   if (NumMaps == 0) {
     // save players inventory
-    VSavedCheckpoint &cp = CheckPoint;
     CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_CPOINT);
-    cp.Serialise(Strm);
+    Strm->Serialise(CheckPoint.ptr(), CheckPoint.length());
     CLOSE_VWAD_FILE();
-    SavedSkill = cp.Skill;
   } else {
-    VSavedCheckpoint &cp = CheckPoint;
-    cp.Clear();
     // write skill level
     if (SavedSkill >= 0 && SavedSkill < 32) {
       CREATE_VWAD_FILE(NEWFMT_FNAME_SAVE_SKILL);
@@ -2563,13 +2742,73 @@ bool VSaveSlot::SaveToSlotNew (int Slot, VStr &savefilename) {
   const bool xres = vmain->Close();
   delete vmain;
   #if 0
-  GCon->Logf(NAME_Debug, "finished VWAD archive! xres=%d (%s)", (int)xres, *ArcStrm->GetName());
+  GCon->Logf(NAME_Debug, "finished VWAD archive! xres=%d (%s)", (int)xres, *ArcFileName);
   #endif
   if (!xres) {
-    GCon->Logf(NAME_Error, "cannot finalize savegame archive");
+    ErrorMsg = "cannot finalize savegame archive";
+    return false;
+  }
+
+  ErrorMsg.clear();
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VSaveSlotJob::Write
+//
+//  this should not use `GCon`, as it may be called from the writer thread
+//
+//==========================================================================
+bool VSaveSlotJob::Write () {
+  const double stt = Sys_Time();
+  Result = false;
+
+  for (auto &&mi : Maps) {
+    if (!mi->Packed && !PackMap(mi)) {
+      ErrorMsg = va("cannot compress saved map '%s'", *mi->Name);
+      WriteTime = Sys_Time()-stt;
+      return false;
+    }
+  }
+
+  Result = WriteArchive();
+
+  // lightmap cache is not critical, so ignore any errors here
+  if (Result && HasLightmaps) {
+    VStr ccfname = FileBase+".lmap";
+    VStream *lmc = FL_OpenSysFileWrite(ccfname);
+    bool err = !lmc;
+    if (lmc) {
+      lmc->Serialise(Lightmaps.ptr(), Lightmaps.length());
+      err = lmc->IsError();
+      lmc->Close();
+      err = (err || lmc->IsError());
+      delete lmc;
+    }
+    if (err) Sys_FileDelete(ccfname);
   }
 
-  return xres;
+  WriteTime = Sys_Time()-stt;
+  return Result;
+}
+
+
+//==========================================================================
+//
+//  VSaveSlot::SaveToSlotNew
+//
+//==========================================================================
+bool VSaveSlot::SaveToSlotNew (int Slot, VStr &savefilename) {
+  savefilename.clear();
+  VSaveSlotJob *job = CreateSaveJob(Slot);
+  if (!job) return false;
+  savefilename = job->ArcFileName;
+  const bool res = job->Write();
+  if (!res) GCon->Log(NAME_Error, job->ErrorMsg);
+  delete job;
+  return res;
 }
 
 
@@ -3244,8 +3483,11 @@ static void UnarchiveSounds (VSaveLoaderStream *Loader) {
 //
 //  SV_SaveMap
 //
+//  with `asSnapshot`, new format map data is stored uncompressed, and
+//  will be packed by the save writer
+//
 //==========================================================================
-static void SV_SaveMap (bool savePlayers) {
+static void SV_SaveMap (bool savePlayers, bool asSnapshot=false) {
   // make sure we don't have any garbage
   Host_CollectGarbage(true);
 
@@ -3353,6 +3595,7 @@ static void SV_SaveMap (bool savePlayers) {
 
     // create saver
     Saver = new VSaveWriterStream(vwad);
+    Saver->Snapshot = asSnapshot;
 
     // write the level timer
     if (Saver->CreateFileDirect(NEWFMT_FNAME_MAP_GINFO)) {
@@ -3375,6 +3618,8 @@ static void SV_SaveMap (bool savePlayers) {
       Map->Data.Clear();
       Map->Data.setLength(Buf.length());
       if (Buf.length()) memcpy(Map->Data.ptr(), Buf.ptr(), Buf.length());
+      Map->Packed = !asSnapshot;
+      Map->SnapshotId = (asSnapshot ? ++saveSnapshotId : 0);
       delete InStrm;
     } else {
       Map->Data.Clear();
@@ -3659,12 +3904,123 @@ static bool SV_LoadMap (VName MapName, bool allowCheckpoints, bool hubTeleport)
 }
 
 
+//==========================================================================
+//
+//  BroadcastSaveText
+//
+//==========================================================================
+static void BroadcastSaveText (const char *msg) {
+  if (!msg || !msg[0]) return;
+  if (sv_save_messages) {
+    for (int i = 0; i < MAXPLAYERS; ++i) {
+      VBasePlayer *plr = GGameInfo->Players[i];
+      if (!plr) continue;
+      if ((plr->PlayerFlags&VBasePlayer::PF_Spawned) == 0) continue;
+      plr->eventClientPrint(msg);
+    }
+  } else {
+    GCon->Log(msg);
+  }
+}
+
+
+//==========================================================================
+//
+//  saveWriterThread
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE saveWriterThread (void *ajob) {
+  VSaveSlotJob *job = (VSaveSlotJob *)ajob;
+  job->Write();
+  atomic_store(&job->Done, 1);
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  SV_FinishSaveJob
+//
+//  renames the written file, and reports the result
+//  deletes the job
+//  `quiet` means "don't call any VM code" (used on shutdown)
+//
+//==========================================================================
+static void SV_FinishSaveJob (VSaveSlotJob *job, bool quiet=false) {
+  saveFileBase = job->FileBase;
+  if (job->Result) {
+    SV_SaveSuccess(job->ArcFileName, job->Slot, job->HasLightmaps);
+    // replace map snapshots with the packed data, if they are still actual
+    for (auto &&mi : job->Maps) {
+      if (!mi->SnapshotId) continue;
+      VSavedMap *Map = BaseSlot.FindMap(mi->MapName);
+      if (Map && !Map->Packed && Map->SnapshotId == mi->SnapshotId) {
+        Map->Data = mi->Data;
+        Map->Packed = true;
+        Map->SnapshotId = 0;
+      }
+    }
+    GCon->Logf("saved game to slot %d (%d msecs in game thread (%d msecs serialising the map), %d msecs in background)", job->Slot,
+               (int)(job->SnapshotTime*1000.0), (int)(job->ArchiveTime*1000.0), (int)(job->WriteTime*1000.0));
+    if (!quiet) {
+      SV_SendAfterSaveEvent(job->IsAutosave, job->IsCheckpoint);
+      BroadcastSaveText(*job->DoneMessage);
+    }
+  } else {
+    if (!job->ErrorMsg.isEmpty()) GCon->Log(NAME_Error, job->ErrorMsg);
+    SV_SaveFailed(job->ArcFileName, job->Slot);
+    saveFileBase.clear();
+    if (!quiet) BroadcastSaveText("Error saving game!");
+  }
+  delete job;
+}
+
+
+//==========================================================================
+//
+//  SV_PollSaveJob
+//
+//==========================================================================
+void SV_PollSaveJob () {
+  if (saveJob && atomic_get(&saveJob->Done)) {
+    VSaveSlotJob *job = saveJob;
+    saveJob = nullptr;
+    mythread_join(job->Thread);
+    SV_FinishSaveJob(job);
+  }
+}
+
+
+//==========================================================================
+//
+//  SV_WaitSaveJob
+//
+//==========================================================================
+void SV_WaitSaveJob (bool quiet) {
+  if (saveJob) {
+    VSaveSlotJob *job = saveJob;
+    saveJob = nullptr;
+    mythread_join(job->Thread);
+    SV_FinishSaveJob(job, quiet);
+  }
+}
+
+
 //==========================================================================
 //
 //  SV_SaveGame
 //
+//  `doneMsg` will be broadcasted when the save file is written
+//
 //==========================================================================
-static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAutosave) {
+static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAutosave, VStr doneMsg) {
+  // only one save can be in progress
+  SV_WaitSaveJob();
+
+  const double stt = Sys_Time();
+  // with background writer, we only need a snapshot of the map here
+  const bool asSnapshot = sv_save_async.asBool();
+
   BaseSlot.Description = Description;
   BaseSlot.CurrentMap = GLevel->MapName;
   BaseSlot.SavedSkill = GGameInfo->WorldInfo->GameSkill;
@@ -3689,16 +4045,61 @@ static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAut
 
   SV_SendBeforeSaveEvent(isAutosave, checkpoint);
 
+  double archiveTime = -Sys_Time();
   if (checkpoint) {
     // player state save
     if (!SV_SaveCheckpoint()) {
       GCon->Logf("AUTOSAVE: cannot use checkpoints, perform a full save sequence (this is not a bug!)");
       checkpoint = false;
-      SV_SaveMap(true); // true = save player info
+      SV_SaveMap(true, asSnapshot); // true = save player info
     }
   } else {
     // full save
-    SV_SaveMap(true); // true = save player info
+    SV_SaveMap(true, asSnapshot); // true = save player info
+  }
+  archiveTime += Sys_Time();
+
+  #ifdef CLIENT
+  bool doPrecalc = (r_precalc_static_lights_override >= 0 ? !!r_precalc_static_lights_override : r_precalc_static_lights);
+  const bool saveLMap = (!checkpoint && GLevel->Renderer && GLevel->Renderer->isNeedLightmapCache() && loader_cache_data && doPrecalc);
+  #endif
+
+  // compress and write the data in background thread
+  if (asSnapshot && BaseSlot.IsNewFormat()) {
+    VSaveSlotJob *job = BaseSlot.CreateSaveJob(slot);
+    if (!job) {
+      saveFileBase.clear();
+      BroadcastSaveText("Error saving game!");
+      Host_ResetSkipFrames();
+      return;
+    }
+    job->IsAutosave = isAutosave;
+    job->IsCheckpoint = checkpoint;
+    job->DoneMessage = doneMsg;
+    #ifdef CLIENT
+    // lightmaps are owned by the renderer, so serialise them here
+    if (saveLMap) {
+      GLevel->cacheFileBase = saveFileBase;
+      GLevel->cacheFlags &= ~(VLevel::CacheFlag_Ignore|VLevel::CacheFlag_Store);
+      VArrayStream *lmc = new VArrayStream("<lmapcache>", job->Lightmaps);
+      lmc->BeginWrite();
+      GLevel->Renderer->saveLightmaps(lmc);
+      job->HasLightmaps = !lmc->IsError();
+      delete lmc;
+    }
+    #endif
+    job->SnapshotTime = Sys_Time()-stt;
+    job->ArchiveTime = archiveTime;
+    if (mythread_create(&job->Thread, &saveWriterThread, job)) {
+      // no thread, write it right here
+      GCon->Logf(NAME_Warning, "cannot create save writer thread");
+      job->Write();
+      SV_FinishSaveJob(job);
+    } else {
+      saveJob = job;
+    }
+    Host_ResetSkipFrames();
+    return;
   }
 
   // write data to destination slot
@@ -3707,17 +4108,12 @@ static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAut
     if (!checkpoint && !saveFileBase.isEmpty()) {
       VStr ccfname = saveFileBase+".lmap";
       #ifdef CLIENT
-      bool doPrecalc = (r_precalc_static_lights_override >= 0 ? !!r_precalc_static_lights_override : r_precalc_static_lights);
-      #else
-      enum { doPrecalc = false };
-      #endif
-      #ifdef CLIENT
-      if (!GLevel->Renderer || !GLevel->Renderer->isNeedLightmapCache() || !loader_cache_data || !doPrecalc) {
+      if (!saveLMap) {
         // no rendered usually means that this is some kind of server (the thing that should not be, but...)
         Sys_FileDelete(ccfname);
       } else {
         GLevel->cacheFileBase = saveFileBase;
-        GLevel->cacheFlags &= ~VLevel::CacheFlag_Ignore;
+        GLevel->cacheFlags &= ~(VLevel::CacheFlag_Ignore|VLevel::CacheFlag_Store);
         VStream *lmc = FL_OpenSysFileWrite(ccfname);
         if (lmc) {
           GCon->Logf("writing lightmap cache to '%s'", *ccfname);
@@ -3739,6 +4135,7 @@ static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAut
     SV_SendAfterSaveEvent(isAutosave, checkpoint);
   }
 
+  BroadcastSaveText(*doneMsg);
   Host_ResetSkipFrames();
 }
 
@@ -3768,7 +4165,7 @@ static void SV_LoadGame (int slot) {
   if (!SV_LoadMap(BaseSlot.CurrentMap, true/*allowCheckpoints*/, false/*hubTeleport*/)) {
     // not a checkpoint
     GLevel->cacheFileBase = saveFileBase;
-    GLevel->cacheFlags &= ~VLevel::CacheFlag_Ignore;
+    GLevel->cacheFlags &= ~(VLevel::CacheFlag_Ignore|VLevel::CacheFlag_Store);
     //GCon->Logf(NAME_Debug, "**********************: <%s>", *GLevel->cacheFileBase);
     #ifdef CLIENT
     if (GGameInfo->NetMode != NM_DedicatedServer) CL_SetupLocalPlayer();
@@ -4011,26 +4408,6 @@ static bool CheckIfSaveIsAllowed () {
 }
 
 
-//==========================================================================
-//
-//  BroadcastSaveText
-//
-//==========================================================================
-static void BroadcastSaveText (const char *msg) {
-  if (!msg || !msg[0]) return;
-  if (sv_save_messages) {
-    for (int i = 0; i < MAXPLAYERS; ++i) {
-      VBasePlayer *plr = GGameInfo->Players[i];
-      if (!plr) continue;
-      if ((plr->PlayerFlags&VBasePlayer::PF_Spawned) == 0) continue;
-      plr->eventClientPrint(msg);
-    }
-  } else {
-    GCon->Log(msg);
-  }
-}
-
-
 //==========================================================================
 //
 //  SV_AutoSave
@@ -4053,10 +4430,8 @@ void SV_AutoSave (bool checkpoint) {
   GetTimeOfDay(&tv);
   VStr svname = TimeVal2Str(&tv, true)+": "+VStr("AUTO: ")+(*GLevel->MapName);
 
-  SV_SaveGame(aslot, svname, checkpoint, true);
+  SV_SaveGame(aslot, svname, checkpoint, true, va("Game autosaved to slot #%d", -aslot));
   Host_ResetSkipFrames();
-
-  BroadcastSaveText(va("Game autosaved to slot #%d", -aslot));
 }
 
 
@@ -4083,10 +4458,8 @@ void SV_AutoSaveOnLevelExit () {
   GetTimeOfDay(&tv);
   VStr svname = TimeVal2Str(&tv, true)+": "+VStr("OUT: ")+(*GLevel->MapName);
 
-  SV_SaveGame(aslot, svname, false, true); // not a checkpoint, obviously
+  SV_SaveGame(aslot, svname, false, true, va("Game autosaved to slot #%d", -aslot)); // not a checkpoint, obviously
   Host_ResetSkipFrames();
-
-  BroadcastSaveText(va("Game autosaved to slot #%d", -aslot));
 }
 
 
@@ -4112,10 +4485,8 @@ COMMAND(Save) {
 
   Draw_SaveIcon();
 
-  SV_SaveGame(VStr::atoi(*Args[1]), Args[2], false, false); // not a checkpoint
+  SV_SaveGame(VStr::atoi(*Args[1]), Args[2], false, false, "Game saved."); // not a checkpoint
   Host_ResetSkipFrames();
-
-  BroadcastSaveText("Game saved.");
 }
 
 
@@ -4131,6 +4502,8 @@ COMMAND(DeleteSavedGame) {
 
   if (!CheckIfLoadIsAllowed()) return;
 
+  SV_WaitSaveJob();
+
   VStr numstr = Args[1].xstrip();
   if (numstr.isEmpty()) return;
 
@@ -4184,6 +4557,9 @@ COMMAND(Load) {
 
   if (!CheckIfLoadIsAllowed()) return;
 
+  // the pending background save may be writing this slot
+  SV_WaitSaveJob();
+
   int slot = VStr::atoi(*Args[1]);
   VStr desc;
   if (!SV_GetSaveString(slot, desc)) {
@@ -4211,10 +4587,8 @@ COMMAND(QuickSave) {
 
   Draw_SaveIcon();
 
-  SV_SaveGame(QUICKSAVE_SLOT, "quicksave", false, false); // not a checkpoint
+  SV_SaveGame(QUICKSAVE_SLOT, "quicksave", false, false, "Game quicksaved."); // not a checkpoint
   Host_ResetSkipFrames();
-
-  BroadcastSaveText("Game quicksaved.");
 }
 
 
@@ -4226,6 +4600,9 @@ COMMAND(QuickSave) {
 COMMAND(QuickLoad) {
   if (!CheckIfLoadIsAllowed()) return;
 
+  // the pending background save may be writing this slot
+  SV_WaitSaveJob();
+
   VStr desc;
   if (!SV_GetSaveString(QUICKSAVE_SLOT, desc)) {
     BroadcastSaveText("Empty quicksave slot");
@@ -4263,10 +4640,8 @@ COMMAND(AutoSaveEnter) {
   GetTimeOfDay(&tv);
   VStr svname = TimeVal2Str(&tv, true)+": "+(*GLevel->MapName);
 
-  SV_SaveGame(aslot, svname, sv_autoenter_checkpoints, true);
+  SV_SaveGame(aslot, svname, sv_autoenter_checkpoints, true, va("Game autosaved to slot #%d", -aslot));
   Host_ResetSkipFrames();
-
-  BroadcastSaveText(va("Game autosaved to slot #%d", -aslot));
 }
 
 
@@ -37,5 +37,12 @@ extern void SV_AutoSave (bool checkpoint);
 // returns hash of savegame directory
 extern VStr SV_GetSaveHash ();
 
+// save files are written in background thread (see `sv_save_async`)
+// call this once per frame to finish the pending save
+extern void SV_PollSaveJob ();
+// blocks until the pending save is written
+// `quiet` means "don't call any VM code" (used on shutdown)
+extern void SV_WaitSaveJob (bool quiet=false);
+
 
 #endif
@@ -177,6 +177,7 @@ public:
   VScriptParser *clone () const noexcept;
 
   inline int GetScriptSize () const noexcept { return ScriptSize; }
+  inline const char *GetScriptBuffer () const noexcept { return ScriptBuffer; }
 
   bool IsText () noexcept;
   bool IsAtEol () noexcept;
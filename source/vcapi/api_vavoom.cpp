@@ -49,6 +49,42 @@
 
 VStream *VPackage::OpenFileStreamRO (VStr fname) { return FL_OpenFileRead(fname); }
 
+
+//==========================================================================
+//
+//  VPackage::OpenProgsCacheFile
+//
+//==========================================================================
+VStream *VPackage::OpenProgsCacheFile (VStr fname, bool forWriting) {
+  VStr cpath = FL_GetProgsCacheDir();
+  if (cpath.isEmpty()) return nullptr;
+  cpath += "/";
+  cpath += fname;
+  if (forWriting) return FL_OpenSysFileWrite(cpath);
+  if (!Sys_FileExists(cpath)) return nullptr;
+  return FL_OpenSysFileRead(cpath);
+}
+
+
+//==========================================================================
+//
+//  VPackage::GetProgsCacheBuildTag
+//
+//  any engine rebuild should invalidate progs cache, because
+//  native class layouts and builtins can be changed
+//
+//==========================================================================
+VStr VPackage::GetProgsCacheBuildTag () {
+  #ifdef _WIN32
+  char exename[MAX_PATH+1];
+  memset(exename, 0, sizeof(exename));
+  GetModuleFileNameA(nullptr, exename, MAX_PATH);
+  #else
+  const char *exename = "/proc/self/exe";
+  #endif
+  return VStr(va("%s %s|%d", __DATE__, __TIME__, Sys_FileTime(exename)));
+}
+
 void __attribute__((noreturn)) __declspec(noreturn) VPackage::HostErrorBuiltin (VStr msg) { Host_Error("%s", *msg); }
 void __attribute__((noreturn)) __declspec(noreturn) VPackage::SysErrorBuiltin (VStr msg) { Sys_Error("%s", *msg); }
 void __attribute__((noreturn)) __declspec(noreturn) VPackage::AssertErrorBuiltin (VStr msg) { Sys_Error("Assertion failure: %s", *msg); }
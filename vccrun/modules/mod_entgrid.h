@@ -312,7 +312,7 @@ public:
 
 // ////////////////////////////////////////////////////////////////////////// //
 class VEntityGridBase : public VObject {
-  DECLARE_CLASS(VEntityGridBase, VObject, 0)
+  DECLARE_CLASS(VEntityGridBase, VObject, CLASS_NativeReferences)
   NO_DEFAULT_CONSTRUCTOR(VEntityGridBase)
 
 protected:
@@ -29,6 +29,10 @@
 
 VStream *VPackage::OpenFileStreamRO (VStr fname) { return fsysOpenFileSimple(fname); }
 
+// vccrun scripts are usually small, so there is no need to cache them
+VStream *VPackage::OpenProgsCacheFile (VStr /*fname*/, bool /*forWriting*/) { return nullptr; }
+VStr VPackage::GetProgsCacheBuildTag () { return VStr(); }
+
 
 //==========================================================================
 //
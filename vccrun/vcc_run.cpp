@@ -839,6 +839,8 @@ static void ProcessArgs (int ArgCount, char **ArgVector) {
       if (strcmp(text, "vc-case-insensitive-fields") == 0) { VObject::cliCaseSensitiveFields = 0; continue; }
       if (strcmp(text, "vc-case-sensitive-locals") == 0) { VObject::cliCaseSensitiveLocals = 1; continue; }
       if (strcmp(text, "vc-case-sensitive-fields") == 0) { VObject::cliCaseSensitiveFields = 1; continue; }
+      if (strcmp(text, "vc-no-jit") == 0) { VMethod::jitEnabled = 0; continue; }
+      if (strcmp(text, "vc-jit") == 0) { VMethod::jitEnabled = 1; continue; }
       const char option = *text++;
       switch (option) {
         case 'd': DebugMode = true; if (*text) OpenDebugFile(text); break;